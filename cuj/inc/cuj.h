@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cuj/core/hash.h>
 #include <cuj/cstd/cstd.h>
 #include <cuj/dsl/dsl.h>
 #include <cuj/gen/gen.h>
@@ -23,9 +23,15 @@ struct SaveArrayIntoLocalAlloc;
 struct ArrayAddrToFirstElemAddr;
 struct Binary;
 struct Unary;
+struct Select;
 struct CallFunc;
 struct GlobalVarAddr;
 struct GlobalConstAddr;
+struct MakeVector;
+struct VectorExtract;
+struct VectorInsert;
+struct VectorShuffle;
+struct VectorReduce;
 
 using Expr = Variant<
     FuncArgAddr,
@@ -44,9 +50,15 @@ using Expr = Variant<
     ArrayAddrToFirstElemAddr,
     Binary,
     Unary,
+    Select,
     CallFunc,
     GlobalVarAddr,
-    GlobalConstAddr>;
+    GlobalConstAddr,
+    MakeVector,
+    VectorExtract,
+    VectorInsert,
+    VectorShuffle,
+    VectorReduce>;
 
 struct FuncArgAddr
 {
@@ -90,6 +102,7 @@ struct NullPtr
     const Type *ptr_type;
 };
 
+// applied elementwise to vectors
 struct ArithmeticCast
 {
     const Type *dst_type;
@@ -151,6 +164,7 @@ struct ArrayAddrToFirstElemAddr
     RC<Expr>    array_ptr;
 };
 
+// applied elementwise to vectors, where comparisons produce bool vectors
 struct Binary
 {
     enum class Op
@@ -183,6 +197,7 @@ struct Binary
     const Type *rhs_type;
 };
 
+// applied elementwise to vectors
 struct Unary
 {
     enum class Op
@@ -197,6 +212,16 @@ struct Unary
     const Type *val_type;
 };
 
+// evaluates both values. a bool vector condition selects per lane
+struct Select
+{
+    const Type *cond_type;
+    const Type *val_type;
+    RC<Expr>    cond;
+    RC<Expr>    true_val;
+    RC<Expr>    false_val;
+};
+
 struct CallFunc
 {
     RC<Func>  contextless_func;
@@ -231,4 +256,56 @@ struct GlobalConstAddr
     std::vector<unsigned char> data;
 };
 
+struct MakeVector
+{
+    const Type *vector_type;
+
+    // one element for each lane, or a single element broadcast to all lanes
+    std::vector<RC<Expr>> elements;
+};
+
+struct VectorExtract
+{
+    const Type *vector_type;
+    RC<Expr>    vector;
+    RC<Expr>    index; // u32
+};
+
+struct VectorInsert
+{
+    const Type *vector_type;
+    RC<Expr>    vector;
+    RC<Expr>    index; // u32
+    RC<Expr>    element;
+};
+
+struct VectorShuffle
+{
+    const Type *dst_type;
+    const Type *src_type;
+    RC<Expr>    lhs;
+    RC<Expr>    rhs;
+
+    // indices in [0, 2 * src size). indices >= src size select from rhs
+    std::vector<int> indices;
+};
+
+struct VectorReduce
+{
+    enum class Op
+    {
+        Add,
+        Mul,
+        Min,
+        Max,
+        BitwiseAnd,
+        BitwiseOr,
+        BitwiseXOr,
+    };
+
+    Op          op;
+    const Type *vector_type;
+    RC<Expr>    vector;
+};
+
 CUJ_NAMESPACE_END(cuj::core)
@@ -10,6 +10,10 @@ struct Func
     {
         const Type *type  = nullptr;
         bool is_reference = false;
+
+        // memory accessed through this pointer/reference is not accessed
+        // through any other argument during the call
+        bool is_restrict  = false;
     };
 
     enum FuncType
@@ -18,8 +22,21 @@ struct Func
         Kernel,
     };
 
+    // optimization hints, stored as a bit set
+    enum class Attribute : uint32_t
+    {
+        AlwaysInline = 1 << 0,
+        NoInline     = 1 << 1,
+        Cold         = 1 << 2,
+        Hot          = 1 << 3,
+        ReadNone     = 1 << 4, // doesn't access memory
+        ReadOnly     = 1 << 5, // doesn't write memory
+        NoUnwind     = 1 << 6,
+    };
+
     std::string name;
-    FuncType    type = Regular;
+    FuncType    type       = Regular;
+    uint32_t    attributes = 0;
 
     RC<TypeSet> type_set;
 
@@ -30,6 +47,11 @@ struct Func
     RC<Block>                 root_block;
 
     bool is_declaration = true;
+
+    bool has_attribute(Attribute attrib) const
+    {
+        return (attributes & static_cast<uint32_t>(attrib)) != 0;
+    }
 };
 
 CUJ_NAMESPACE_END(cuj::core)
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cuj/core/prog.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::core)
+
+// structural hash & equality of traced programs.
+// types are compared by structure instead of address, and auto-generated
+// function names (__cuj_auto_function_name_N) are ignored, so that tracing
+// the same function twice gives equal results.
+// hash values are stable across runs of the same build
+
+uint64_t structural_hash(const Prog &prog);
+uint64_t structural_hash(const Func &func);
+uint64_t structural_hash(const Block &block);
+uint64_t structural_hash(const Stat &stat);
+uint64_t structural_hash(const Expr &expr);
+uint64_t structural_hash(const GlobalConstAddr &global_const);
+uint64_t structural_hash(const Type *type);
+
+bool structural_equal(const Prog &a, const Prog &b);
+bool structural_equal(const Func &a, const Func &b);
+bool structural_equal(const Block &a, const Block &b);
+bool structural_equal(const Stat &a, const Stat &b);
+bool structural_equal(const Expr &a, const Expr &b);
+bool structural_equal(const GlobalConstAddr &a, const GlobalConstAddr &b);
+bool structural_equal(const Type *a, const Type *b);
+
+bool is_auto_function_name(const std::string &name);
+
+CUJ_NAMESPACE_END(cuj::core)
@@ -15,4 +15,24 @@ enum class Intrinsic : int32_t
 
 const char *intrinsic_name(Intrinsic intrinsic);
 
+// memory order and scope of atomic intrinsics.
+// passed as the last two arguments (i32 immediates) of each atomic intrinsic
+
+enum class MemoryOrder : int32_t
+{
+    Relaxed,
+    Acquire,
+    Release,
+    AcqRel,
+    SeqCst
+};
+
+// scopes other than Device only affect ptx
+enum class MemoryScope : int32_t
+{
+    Block,
+    Device,
+    System
+};
+
 CUJ_NAMESPACE_END(cuj::core)
@@ -58,15 +58,44 @@ struct Return
 
 struct If
 {
-    RC<Block> calc_cond;
-    Expr      cond;
-    RC<Stat>  then_body;
-    RC<Stat>  else_body;
+    // expected value of cond
+    enum class Likelihood
+    {
+        Unknown,
+        Likely,
+        Unlikely,
+    };
+
+    RC<Block>  calc_cond;
+    Expr       cond;
+    RC<Stat>   then_body;
+    RC<Stat>   else_body;
+    Likelihood likelihood = Likelihood::Unknown;
 };
 
 struct Loop
 {
+    // optimization hints. zero or false means unspecified
+    struct Hints
+    {
+        uint32_t unroll_count     = 0;
+        bool     unroll_full      = false;
+        bool     unroll_disable   = false;
+        uint32_t vectorize_width  = 0;
+        uint32_t interleave_count = 0;
+
+        // iterations have no memory dependencies on each other
+        bool independent = false;
+
+        // trip count is a multiple of this. only used by $forrange, which
+        // turns it into an assumption on the iteration range
+        uint32_t trip_count_multiple = 0;
+
+        bool operator==(const Hints &) const = default;
+    };
+
     RC<Block> body;
+    Hints     hints;
 };
 
 struct Break
@@ -72,12 +72,14 @@ constexpr Builtin arithmetic_to_builtin_v = ArithmeticToBuiltinType<T>::value;
 struct Struct;
 struct Array;
 struct Pointer;
+struct Vector;
 
 using Type = Variant<
     Builtin,
     Struct,
     Array,
-    Pointer>;
+    Pointer,
+    Vector>;
 
 struct Struct
 {
@@ -108,6 +110,17 @@ struct Pointer
     bool operator==(const Pointer &rhs) const;
 };
 
+// simd vector of arithmetic builtin elements
+struct Vector
+{
+    const Type *element = nullptr;
+    size_t      size    = 0;
+
+    std::strong_ordering operator<=>(const Vector &rhs) const;
+
+    bool operator==(const Vector &rhs) const;
+};
+
 struct TypeSet
 {
     std::map<std::type_index, RC<Type>>     index_to_type;
@@ -42,9 +42,15 @@ public:
     void visit(const ArrayAddrToFirstElemAddr    &expr);
     void visit(const Binary                      &expr);
     void visit(const Unary                       &expr);
+    void visit(const Select                      &expr);
     void visit(const CallFunc                    &expr);
     void visit(const GlobalVarAddr               &expr);
     void visit(const GlobalConstAddr             &expr);
+    void visit(const MakeVector                  &expr);
+    void visit(const VectorExtract               &expr);
+    void visit(const VectorInsert                &expr);
+    void visit(const VectorShuffle               &expr);
+    void visit(const VectorReduce                &expr);
 
     std::function<void(const Stat &)>         on_stat;
     std::function<void(const Store &)>        on_store;
@@ -78,9 +84,15 @@ public:
     std::function<void(const ArrayAddrToFirstElemAddr    &)> on_array_ptr_to_first_elem_ptr;
     std::function<void(const Binary                      &)> on_binary;
     std::function<void(const Unary                       &)> on_unary;
+    std::function<void(const Select                      &)> on_select;
     std::function<void(const CallFunc                    &)> on_call_func;
     std::function<void(const GlobalVarAddr               &)> on_global_var_addr;
     std::function<void(const GlobalConstAddr             &)> on_global_const_addr;
+    std::function<void(const MakeVector                  &)> on_make_vector;
+    std::function<void(const VectorExtract               &)> on_vector_extract;
+    std::function<void(const VectorInsert                &)> on_vector_insert;
+    std::function<void(const VectorShuffle               &)> on_vector_shuffle;
+    std::function<void(const VectorReduce                &)> on_vector_reduce;
 };
 
 CUJ_NAMESPACE_END(cuj::core)
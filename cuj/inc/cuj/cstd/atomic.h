@@ -4,16 +4,73 @@
 
 CUJ_NAMESPACE_BEGIN(cuj::cstd)
 
-i32 atomic_add(ptr<i32> dst, i32 val);
+using MemoryOrder = core::MemoryOrder;
+using MemoryScope = core::MemoryScope;
 
-u32 atomic_add(ptr<u32> dst, u32 val);
+// all read-modify-write operations return the old value.
+// by default, atomic operations are sequentially consistent at device scope
 
-f32 atomic_add(ptr<f32> dst, f32 val);
+i32 atomic_load(ptr<i32> addr, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+u32 atomic_load(ptr<u32> addr, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+i64 atomic_load(ptr<i64> addr, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+u64 atomic_load(ptr<u64> addr, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+f32 atomic_load(ptr<f32> addr, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+f64 atomic_load(ptr<f64> addr, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
 
-i32 atomic_cmpxchg(ptr<i32> addr, i32 cmp, i32 new_val);
+void atomic_store(ptr<i32> addr, i32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+void atomic_store(ptr<u32> addr, u32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+void atomic_store(ptr<i64> addr, i64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+void atomic_store(ptr<u64> addr, u64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+void atomic_store(ptr<f32> addr, f32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+void atomic_store(ptr<f64> addr, f64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
 
-u32 atomic_cmpxchg(ptr<u32> addr, u32 cmp, u32 new_val);
+i32 atomic_exchange(ptr<i32> addr, i32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+u32 atomic_exchange(ptr<u32> addr, u32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+i64 atomic_exchange(ptr<i64> addr, i64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+u64 atomic_exchange(ptr<u64> addr, u64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+f32 atomic_exchange(ptr<f32> addr, f32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+f64 atomic_exchange(ptr<f64> addr, f64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
 
-u64 atomic_cmpxchg(ptr<u64> addr, u64 cmp, u64 new_val);
+// stores new_val when *addr == cmp, and returns the old value.
+// a failed comparison only uses the acquire part of order
+i32 atomic_cmpxchg(ptr<i32> addr, i32 cmp, i32 new_val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+u32 atomic_cmpxchg(ptr<u32> addr, u32 cmp, u32 new_val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+i64 atomic_cmpxchg(ptr<i64> addr, i64 cmp, i64 new_val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+u64 atomic_cmpxchg(ptr<u64> addr, u64 cmp, u64 new_val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+
+i32 atomic_add(ptr<i32> dst, i32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+u32 atomic_add(ptr<u32> dst, u32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+i64 atomic_add(ptr<i64> dst, i64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+u64 atomic_add(ptr<u64> dst, u64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+f32 atomic_add(ptr<f32> dst, f32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+f64 atomic_add(ptr<f64> dst, f64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+
+i32 atomic_min(ptr<i32> dst, i32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+u32 atomic_min(ptr<u32> dst, u32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+i64 atomic_min(ptr<i64> dst, i64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+u64 atomic_min(ptr<u64> dst, u64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+
+i32 atomic_max(ptr<i32> dst, i32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+u32 atomic_max(ptr<u32> dst, u32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+i64 atomic_max(ptr<i64> dst, i64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+u64 atomic_max(ptr<u64> dst, u64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+
+i32 atomic_and(ptr<i32> dst, i32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+u32 atomic_and(ptr<u32> dst, u32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+i64 atomic_and(ptr<i64> dst, i64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+u64 atomic_and(ptr<u64> dst, u64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+
+i32 atomic_or(ptr<i32> dst, i32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+u32 atomic_or(ptr<u32> dst, u32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+i64 atomic_or(ptr<i64> dst, i64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+u64 atomic_or(ptr<u64> dst, u64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+
+i32 atomic_xor(ptr<i32> dst, i32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+u32 atomic_xor(ptr<u32> dst, u32 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+i64 atomic_xor(ptr<i64> dst, i64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+u64 atomic_xor(ptr<u64> dst, u64 val, MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
+
+// order must not be MemoryOrder::Relaxed
+void atomic_fence(MemoryOrder order = MemoryOrder::SeqCst, MemoryScope scope = MemoryScope::Device);
 
 CUJ_NAMESPACE_END(cuj::cstd)
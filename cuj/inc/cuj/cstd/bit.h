@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cuj/dsl/dsl.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::cstd)
+
+// number of set bits
+i32 popcount(i8  x);
+i32 popcount(i16 x);
+i32 popcount(i32 x);
+i32 popcount(i64 x);
+i32 popcount(u8  x);
+i32 popcount(u16 x);
+i32 popcount(u32 x);
+i32 popcount(u64 x);
+
+// count leading/trailing zero bits. returns bit width of x when x == 0
+i32 clz(i8  x);
+i32 clz(i16 x);
+i32 clz(i32 x);
+i32 clz(i64 x);
+i32 clz(u8  x);
+i32 clz(u16 x);
+i32 clz(u32 x);
+i32 clz(u64 x);
+
+i32 ctz(i8  x);
+i32 ctz(i16 x);
+i32 ctz(i32 x);
+i32 ctz(i64 x);
+i32 ctz(u8  x);
+i32 ctz(u16 x);
+i32 ctz(u32 x);
+i32 ctz(u64 x);
+
+// reverse byte order
+i16 bswap(i16 x);
+i32 bswap(i32 x);
+i64 bswap(i64 x);
+u16 bswap(u16 x);
+u32 bswap(u32 x);
+u64 bswap(u64 x);
+
+// rotate bits. n is taken modulo bit width of x
+i8  rotl(i8  x, i32 n);
+i16 rotl(i16 x, i32 n);
+i32 rotl(i32 x, i32 n);
+i64 rotl(i64 x, i32 n);
+u8  rotl(u8  x, i32 n);
+u16 rotl(u16 x, i32 n);
+u32 rotl(u32 x, i32 n);
+u64 rotl(u64 x, i32 n);
+
+i8  rotr(i8  x, i32 n);
+i16 rotr(i16 x, i32 n);
+i32 rotr(i32 x, i32 n);
+i64 rotr(i64 x, i32 n);
+u8  rotr(u8  x, i32 n);
+u16 rotr(u16 x, i32 n);
+u32 rotr(u32 x, i32 n);
+u64 rotr(u64 x, i32 n);
+
+// high half of the full-width product a * b
+i8  mul_hi(i8  a, i8  b);
+i16 mul_hi(i16 a, i16 b);
+i32 mul_hi(i32 a, i32 b);
+i64 mul_hi(i64 a, i64 b);
+u8  mul_hi(u8  a, u8  b);
+u16 mul_hi(u16 a, u16 b);
+u32 mul_hi(u32 a, u32 b);
+u64 mul_hi(u64 a, u64 b);
+
+// a + b, clamped to the range of the operand type
+i8  add_sat(i8  a, i8  b);
+i16 add_sat(i16 a, i16 b);
+i32 add_sat(i32 a, i32 b);
+i64 add_sat(i64 a, i64 b);
+u8  add_sat(u8  a, u8  b);
+u16 add_sat(u16 a, u16 b);
+u32 add_sat(u32 a, u32 b);
+u64 add_sat(u64 a, u64 b);
+
+// a * b + c with a single rounding
+f32 fma(f32 a, f32 b, f32 c);
+f64 fma(f64 a, f64 b, f64 c);
+
+CUJ_NAMESPACE_END(cuj::cstd)
@@ -2,6 +2,7 @@
 
 #include <cuj/cstd/assert.h>
 #include <cuj/cstd/atomic.h>
+#include <cuj/cstd/bit.h>
 #include <cuj/cstd/math.h>
 #include <cuj/cstd/memory.h>
 #include <cuj/cstd/ptx.h>
@@ -0,0 +1,154 @@
+#pragma once
+
+CUJ_NAMESPACE_BEGIN(cuj::cstd)
+
+namespace cstd_detail
+{
+
+    template<typename T, size_t N>
+    vec<T, N> create_masked_read(
+        core::Intrinsic intrinsic, std::vector<RC<core::Expr>> args)
+    {
+        static_assert(!std::is_same_v<T, bool>);
+        return vec<T, N>::_from_expr(core::CallFunc{
+            .intrinsic = intrinsic,
+            .args      = std::move(args)
+        });
+    }
+
+    template<typename T, size_t N>
+    void create_masked_write(
+        core::Intrinsic intrinsic, std::vector<RC<core::Expr>> args)
+    {
+        static_assert(!std::is_same_v<T, bool>);
+        dsl::FunctionContext::get_func_context()->append_statement(
+            core::CallFuncStat{
+                .call_expr = core::CallFunc{
+                    .intrinsic = intrinsic,
+                    .args      = std::move(args)
+                }
+            });
+    }
+
+} // namespace cstd_detail
+
+template<typename T, size_t N>
+vec<T, N> masked_load(
+    ptr<num<T>> addr, const vec<bool, N> &mask, const vec<T, N> &passthru)
+{
+    return cstd_detail::create_masked_read<T, N>(
+        core::Intrinsic::masked_load, {
+            newRC<core::Expr>(addr._load()),
+            newRC<core::Expr>(mask._load()),
+            newRC<core::Expr>(passthru._load())
+        });
+}
+
+template<typename T, size_t N>
+vec<T, N> masked_load(ptr<num<T>> addr, const vec<bool, N> &mask)
+{
+    return cstd::masked_load(addr, mask, vec<T, N>(T(0)));
+}
+
+template<typename T, size_t N>
+void masked_store(
+    ptr<num<T>> addr, const vec<bool, N> &mask, const vec<T, N> &val)
+{
+    cstd_detail::create_masked_write<T, N>(
+        core::Intrinsic::masked_store, {
+            newRC<core::Expr>(addr._load()),
+            newRC<core::Expr>(mask._load()),
+            newRC<core::Expr>(val._load())
+        });
+}
+
+template<typename T, size_t N>
+vec<T, N> gather(
+    ptr<num<T>>            base,
+    const vec<int32_t, N> &indices,
+    const vec<bool, N>    &mask,
+    const vec<T, N>       &passthru)
+{
+    return cstd_detail::create_masked_read<T, N>(
+        core::Intrinsic::gather, {
+            newRC<core::Expr>(base._load()),
+            newRC<core::Expr>(indices._load()),
+            newRC<core::Expr>(mask._load()),
+            newRC<core::Expr>(passthru._load())
+        });
+}
+
+template<typename T, size_t N>
+vec<T, N> gather(
+    ptr<num<T>> base, const vec<int32_t, N> &indices, const vec<bool, N> &mask)
+{
+    return cstd::gather(base, indices, mask, vec<T, N>(T(0)));
+}
+
+template<typename T, size_t N>
+void scatter(
+    ptr<num<T>>            base,
+    const vec<int32_t, N> &indices,
+    const vec<bool, N>    &mask,
+    const vec<T, N>       &val)
+{
+    cstd_detail::create_masked_write<T, N>(
+        core::Intrinsic::scatter, {
+            newRC<core::Expr>(base._load()),
+            newRC<core::Expr>(indices._load()),
+            newRC<core::Expr>(mask._load()),
+            newRC<core::Expr>(val._load())
+        });
+}
+
+template<typename T>
+void prefetch(ptr<T> addr, int locality, bool write)
+{
+    if(locality < 0 || locality > 3)
+        throw CujException("prefetch locality must be in [0, 3]");
+    dsl::FunctionContext::get_func_context()->append_statement(
+        core::CallFuncStat{
+            .call_expr = core::CallFunc{
+                .intrinsic = core::Intrinsic::prefetch,
+                .args      = {
+                    newRC<core::Expr>(addr._load()),
+                    newRC<core::Expr>(core::Immediate{
+                        .value = static_cast<int32_t>(locality) }),
+                    newRC<core::Expr>(core::Immediate{
+                        .value = static_cast<int32_t>(write ? 1 : 0) })
+                }
+            }
+        });
+}
+
+template<typename T> requires dsl::is_cuj_arithmetic_v<T> || dsl::is_cuj_vector_v<T>
+void store_nontemporal(ptr<T> addr, const std::type_identity_t<T> &val)
+{
+    dsl::FunctionContext::get_func_context()->append_statement(
+        core::CallFuncStat{
+            .call_expr = core::CallFunc{
+                .intrinsic = core::Intrinsic::store_nontemporal,
+                .args      = {
+                    newRC<core::Expr>(addr._load()),
+                    newRC<core::Expr>(val._load())
+                }
+            }
+        });
+}
+
+template<typename T>
+ptr<T> assume_aligned(ptr<T> addr, size_t alignment)
+{
+    if(!alignment || (alignment & (alignment - 1)))
+        throw CujException("assumed alignment must be a power of 2");
+    return ptr<T>::_from_expr(core::CallFunc{
+        .intrinsic = core::Intrinsic::assume_aligned,
+        .args      = {
+            newRC<core::Expr>(addr._load()),
+            newRC<core::Expr>(core::Immediate{
+                .value = static_cast<uint32_t>(alignment) })
+        }
+    });
+}
+
+CUJ_NAMESPACE_END(cuj::cstd)
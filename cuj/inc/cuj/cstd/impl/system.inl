@@ -61,4 +61,15 @@ inline void unreachable()
     });
 }
 
+inline void assume(const num<bool> &cond)
+{
+    auto func = dsl::FunctionContext::get_func_context();
+    func->append_statement(core::CallFuncStat{
+        .call_expr = core::CallFunc{
+            .intrinsic = core::Intrinsic::assume,
+            .args      = { newRC<core::Expr>(cond._load()) }
+        }
+    });
+}
+
 CUJ_NAMESPACE_END(cuj::cstd)
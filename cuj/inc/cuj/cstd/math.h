@@ -84,22 +84,44 @@ i64 clamp(i64 x, i64 minv, i64 maxv);
 f32 saturate(f32 v);
 f64 saturate(f64 v);
 
+namespace cstd_detail
+{
+
+    template<typename C, typename T>
+    T create_select(const C &cond, const T &a, const T &b)
+    {
+        auto type_ctx = dsl::FunctionContext::get_func_context()
+            ->get_type_context();
+        return T::_from_expr(core::Select{
+            .cond_type = type_ctx->get_type<C>(),
+            .val_type  = type_ctx->get_type<T>(),
+            .cond      = newRC<core::Expr>(cond._load()),
+            .true_val  = newRC<core::Expr>(a._load()),
+            .false_val = newRC<core::Expr>(b._load())
+        });
+    }
+
+} // namespace cstd_detail
+
+// both a and b are evaluated, and no branch is generated
 template<typename T> requires dsl::is_cuj_var_v<T>
 T select(
     const boolean &cond,
     const T       &a,
     const T       &b)
 {
-    T ret;
-    $if(cond)
+    if constexpr(dsl::is_cuj_arithmetic_v<T> ||
+                 dsl::is_cuj_pointer_v<T> ||
+                 dsl::is_cuj_vector_v<T>)
     {
-        ret = a;
+        return cstd_detail::create_select(cond, a, b);
     }
-    $else
+    else
     {
-        ret = b;
-    };
-    return ret;
+        // classes and arrays are selected by address
+        T ret = *cstd_detail::create_select(cond, a.address(), b.address());
+        return ret;
+    }
 }
 
 template<typename T>
@@ -108,16 +130,8 @@ T select(
     const var<T>  &a,
     const var<T>  &b)
 {
-    T ret;
-    $if(cond)
-    {
-        ret = a;
-    }
-    $else
-    {
-        ret = b;
-    };
-    return ret;
+    return cstd::select(
+        cond, static_cast<const T &>(a), static_cast<const T &>(b));
 }
 
 template<typename T>
@@ -126,18 +140,17 @@ ref<T> select(
     const ref<T>  &a,
     const ref<T>  &b)
 {
-    var pa = a.address();
-    var pb = b.address();
-    ptr<T> pr;
-    $if(cond)
-    {
-        pr = pa;
-    }
-    $else
-    {
-        pr = pb;
-    };
-    return *pr;
+    return *cstd_detail::create_select(cond, a.address(), b.address());
+}
+
+// per-lane selection
+template<typename T, size_t N>
+vec<T, N> select(
+    const vec<bool, N> &mask,
+    const vec<T, N>    &a,
+    const vec<T, N>    &b)
+{
+    return cstd_detail::create_select(mask, a, b);
 }
 
 CUJ_NAMESPACE_END(cuj::cstd)
@@ -28,6 +28,56 @@ void load_f32x2(ptr<f32> addr, ref<f32> a, ref<f32> b);
 void load_u32x2(ptr<u32> addr, ref<u32> a, ref<u32> b);
 void load_i32x2(ptr<i32> addr, ref<i32> a, ref<i32> b);
 
+// mask[i] ? addr[i] : passthru[i]
+template<typename T, size_t N>
+vec<T, N> masked_load(
+    ptr<num<T>> addr, const vec<bool, N> &mask, const vec<T, N> &passthru);
+
+// mask[i] ? addr[i] : 0
+template<typename T, size_t N>
+vec<T, N> masked_load(ptr<num<T>> addr, const vec<bool, N> &mask);
+
+// if(mask[i]) addr[i] = val[i]
+template<typename T, size_t N>
+void masked_store(
+    ptr<num<T>> addr, const vec<bool, N> &mask, const vec<T, N> &val);
+
+// mask[i] ? base[indices[i]] : passthru[i]
+template<typename T, size_t N>
+vec<T, N> gather(
+    ptr<num<T>>            base,
+    const vec<int32_t, N> &indices,
+    const vec<bool, N>    &mask,
+    const vec<T, N>       &passthru);
+
+// mask[i] ? base[indices[i]] : 0
+template<typename T, size_t N>
+vec<T, N> gather(
+    ptr<num<T>> base, const vec<int32_t, N> &indices, const vec<bool, N> &mask);
+
+// if(mask[i]) base[indices[i]] = val[i]
+template<typename T, size_t N>
+void scatter(
+    ptr<num<T>>            base,
+    const vec<int32_t, N> &indices,
+    const vec<bool, N>    &mask,
+    const vec<T, N>       &val);
+
+// hint that *addr will be accessed soon. locality ranges from 0 (no temporal
+// locality) to 3 (keep in all cache levels). ignored on ptx
+template<typename T>
+void prefetch(ptr<T> addr, int locality = 3, bool write = false);
+
+// store that is not expected to be read again soon, bypassing caches when
+// the target supports it. T is deduced from addr only, so that val can be
+// a reference or an expression convertible to T
+template<typename T> requires dsl::is_cuj_arithmetic_v<T> || dsl::is_cuj_vector_v<T>
+void store_nontemporal(ptr<T> addr, const std::type_identity_t<T> &val);
+
+// returns addr, which the backend may assume to be a multiple of alignment
+template<typename T>
+ptr<T> assume_aligned(ptr<T> addr, size_t alignment);
+
 void _memcpy_impl(ptr<u8> dst, ptr<u8> src, u64 bytes);
 
 template<typename A, typename B>
@@ -37,3 +87,5 @@ void memcpy(ptr<A> dst, ptr<B> src, u64 bytes)
 }
 
 CUJ_NAMESPACE_END(cuj::cstd)
+
+#include <cuj/cstd/impl/memory.inl>
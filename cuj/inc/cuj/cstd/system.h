@@ -9,6 +9,9 @@ i32 print(const std::string &format_string, Args...args);
 
 inline void unreachable();
 
+// the backend may assume cond to be true. behavior is undefined otherwise
+inline void assume(const num<bool> &cond);
+
 CUJ_NAMESPACE_END(cuj::cstd)
 
 #include <cuj/cstd/impl/system.inl>
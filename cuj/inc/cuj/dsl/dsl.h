@@ -12,6 +12,7 @@
 #include <cuj/dsl/global_var.h>
 #include <cuj/dsl/if.h>
 #include <cuj/dsl/inline_asm.h>
+#include <cuj/dsl/logical.h>
 #include <cuj/dsl/loop.h>
 #include <cuj/dsl/module.h>
 #include <cuj/dsl/pointer.h>
@@ -21,6 +22,8 @@
 #include <cuj/dsl/switch.h>
 #include <cuj/dsl/type_context.h>
 #include <cuj/dsl/variable.h>
+#include <cuj/dsl/vector.h>
+#include <cuj/dsl/vector_reference.h>
 #include <cuj/gen/gen.h>
 
 #include <cuj/dsl/impl/arithmetic.inl>
@@ -35,12 +38,15 @@
 #include <cuj/dsl/impl/global_var.inl>
 #include <cuj/dsl/impl/if.inl>
 #include <cuj/dsl/impl/inline_asm.inl>
+#include <cuj/dsl/impl/logical.inl>
 #include <cuj/dsl/impl/loop.inl>
 #include <cuj/dsl/impl/pointer.inl>
 #include <cuj/dsl/impl/pointer_reference.inl>
 #include <cuj/dsl/impl/return.inl>
 #include <cuj/dsl/impl/switch.inl>
 #include <cuj/dsl/impl/type_context.inl>
+#include <cuj/dsl/impl/vector.inl>
+#include <cuj/dsl/impl/vector_reference.inl>
 
 CUJ_NAMESPACE_BEGIN(cuj)
 
@@ -61,6 +67,8 @@ using boolean = dsl::num<bool>;
 using char_t = dsl::num<char>;
 
 using dsl::Function;
+using dsl::FunctionAttribute;
+using dsl::LoopHints;
 using dsl::Module;
 using dsl::ScopedModule;
 
@@ -70,6 +78,7 @@ using dsl::ref;
 using dsl::ptr;
 using dsl::num;
 using dsl::arr;
+using dsl::vec;
 using dsl::cxx;
 
 using dsl::bitcast;
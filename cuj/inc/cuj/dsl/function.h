@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <functional>
 #include <stack>
 
@@ -81,6 +82,8 @@ namespace function_detail
 
 } // namespace function_detail
 
+using FunctionAttribute = core::Func::Attribute;
+
 class FunctionContext :
     public Uncopyable, public std::enable_shared_from_this<FunctionContext>
 {
@@ -104,8 +107,12 @@ public:
 
     void set_type(core::Func::FuncType type);
 
+    void add_attribute(core::Func::Attribute attrib);
+
     void add_argument(const core::Type *type, bool is_reference);
 
+    void set_argument_restrict(size_t index, bool is_restrict);
+
     void set_return(const core::Type *type, bool is_reference);
 
     const core::Func::Argument &get_return() const;
@@ -134,6 +141,10 @@ public:
 
     void mark_as_non_declaration();
 
+    // only the outermost definition is recorded,
+    // as it includes nested ones
+    void add_trace_time(double seconds);
+
 private:
 
     RC<core::Func>  func_;
@@ -171,6 +182,11 @@ public:
 
     void set_type(core::Func::FuncType type);
 
+    // argument index must refer to a pointer or reference
+    void set_argument_restrict(size_t index, bool is_restrict = true);
+
+    void add_attribute(core::Func::Attribute attrib);
+
     template<typename F>
     void define(F &&body_func);
 
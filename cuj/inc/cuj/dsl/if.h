@@ -1,17 +1,39 @@
 #pragma once
 
+#include <cuj/core/stat.h>
 #include <cuj/dsl/arithmetic.h>
 #include <cuj/utils/uncopyable.h>
 
 CUJ_NAMESPACE_BEGIN(cuj::dsl)
 
+// condition with a branch probability hint
+template<typename F>
+struct HintedCond
+{
+    F                     cond_func;
+    core::If::Likelihood likelihood;
+};
+
+template<typename T>
+constexpr bool is_hinted_cond_v = false;
+
+template<typename F>
+constexpr bool is_hinted_cond_v<HintedCond<F>> = true;
+
+template<typename F>
+HintedCond<std::remove_cvref_t<F>> likely_cond(F &&cond_func);
+
+template<typename F>
+HintedCond<std::remove_cvref_t<F>> unlikely_cond(F &&cond_func);
+
 class IfBuilder : public Uncopyable
 {
     struct ThenUnit
     {
-        RC<core::Block> cond_calc;
-        core::Expr      cond;
-        RC<core::Stat>  body;
+        RC<core::Block>      cond_calc;
+        core::Expr           cond;
+        RC<core::Stat>       body;
+        core::If::Likelihood likelihood;
     };
 
     std::vector<ThenUnit> then_units_;
@@ -38,8 +60,26 @@ public:
     *[&]()->::cuj::dsl::num<bool>{return (COND);}/[&]()->void
 #define CUJ_ELSE -[&]()->void
 
+#define CUJ_IF_HINTED(HINT, COND)                                               \
+    ::cuj::dsl::IfBuilder()                                                     \
+    *::cuj::dsl::HINT([&]()->::cuj::dsl::num<bool>{return (COND);})             \
+    /[&]()->void
+#define CUJ_ELIF_HINTED(HINT, COND)                                             \
+    *::cuj::dsl::HINT([&]()->::cuj::dsl::num<bool>{return (COND);})             \
+    /[&]()->void
+
+#define CUJ_IF_LIKELY(COND)     CUJ_IF_HINTED(likely_cond, COND)
+#define CUJ_IF_UNLIKELY(COND)   CUJ_IF_HINTED(unlikely_cond, COND)
+#define CUJ_ELIF_LIKELY(COND)   CUJ_ELIF_HINTED(likely_cond, COND)
+#define CUJ_ELIF_UNLIKELY(COND) CUJ_ELIF_HINTED(unlikely_cond, COND)
+
 #define $if   CUJ_IF
 #define $elif CUJ_ELIF
 #define $else CUJ_ELSE
 
+#define $if_likely     CUJ_IF_LIKELY
+#define $if_unlikely   CUJ_IF_UNLIKELY
+#define $elif_likely   CUJ_ELIF_LIKELY
+#define $elif_unlikely CUJ_ELIF_UNLIKELY
+
 CUJ_NAMESPACE_END(cuj::dsl)
@@ -114,6 +114,14 @@ void Function<Ret(Args...)>::define_impl(F &&body_func)
         decltype(std::function{ std::forward<F>(body_func) })>;
 
     FunctionContext &func_ctx = *context_;
+
+    const auto trace_start = std::chrono::steady_clock::now();
+    CUJ_SCOPE_EXIT
+    {
+        func_ctx.add_trace_time(std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - trace_start).count());
+    };
+
     FunctionContext::push_func_context(&func_ctx);
     CUJ_SCOPE_EXIT{ FunctionContext::pop_func_context(); };
 
@@ -224,6 +232,18 @@ void Function<Ret(Args...)>::set_type(core::Func::FuncType type)
     context_->set_type(type);
 }
 
+template<typename Ret, typename...Args>
+void Function<Ret(Args...)>::set_argument_restrict(size_t index, bool is_restrict)
+{
+    context_->set_argument_restrict(index, is_restrict);
+}
+
+template<typename Ret, typename...Args>
+void Function<Ret(Args...)>::add_attribute(core::Func::Attribute attrib)
+{
+    context_->add_attribute(attrib);
+}
+
 template<typename Ret, typename...Args>
 template<typename F>
 void Function<Ret(Args...)>::define(F &&body_func)
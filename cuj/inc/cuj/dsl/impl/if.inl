@@ -9,6 +9,18 @@
 
 CUJ_NAMESPACE_BEGIN(cuj::dsl)
 
+template<typename F>
+HintedCond<std::remove_cvref_t<F>> likely_cond(F &&cond_func)
+{
+    return { std::forward<F>(cond_func), core::If::Likelihood::Likely };
+}
+
+template<typename F>
+HintedCond<std::remove_cvref_t<F>> unlikely_cond(F &&cond_func)
+{
+    return { std::forward<F>(cond_func), core::If::Likelihood::Unlikely };
+}
+
 inline IfBuilder::~IfBuilder()
 {
     assert(then_units_.size());
@@ -19,6 +31,7 @@ inline IfBuilder::~IfBuilder()
         last_stat->calc_cond = then_units_[i].cond_calc;
         last_stat->cond      = then_units_[i].cond;
         last_stat->then_body = then_units_[i].body;
+        last_stat->likelihood = then_units_[i].likelihood;
         if(i < then_units_.size() - 1)
         {
             last_stat->else_body = newRC<core::Stat>(core::If{});
@@ -40,13 +53,20 @@ IfBuilder &IfBuilder::operator*(F &&cond_func)
     auto func = FunctionContext::get_func_context();
     auto cond_calc = newRC<core::Block>();
     num<bool> cond;
+    auto likelihood = core::If::Likelihood::Unknown;
     {
         func->push_block(cond_calc);
         CUJ_SCOPE_EXIT{ func->pop_block(); };
-        cond = cond_func();
+        if constexpr(is_hinted_cond_v<std::remove_cvref_t<F>>)
+        {
+            cond = cond_func.cond_func();
+            likelihood = cond_func.likelihood;
+        }
+        else
+            cond = cond_func();
     }
     then_units_.push_back(ThenUnit{
-        std::move(cond_calc), cond._load(), {} });
+        std::move(cond_calc), cond._load(), {}, likelihood });
     return *this;
 }
 
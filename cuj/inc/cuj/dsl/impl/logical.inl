@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cuj/dsl/if.h>
+#include <cuj/dsl/logical.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::dsl)
+
+template<typename L, typename R>
+num<bool> logical_and(L &&lhs_func, R &&rhs_func)
+{
+    num<bool> result = std::forward<L>(lhs_func)();
+    $if(result)
+    {
+        result = std::forward<R>(rhs_func)();
+    };
+    return result;
+}
+
+template<typename L, typename R>
+num<bool> logical_or(L &&lhs_func, R &&rhs_func)
+{
+    num<bool> result = std::forward<L>(lhs_func)();
+    $if(!result)
+    {
+        result = std::forward<R>(rhs_func)();
+    };
+    return result;
+}
+
+CUJ_NAMESPACE_END(cuj::dsl)
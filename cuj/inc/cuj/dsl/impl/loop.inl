@@ -7,6 +7,25 @@
 
 CUJ_NAMESPACE_BEGIN(cuj::dsl)
 
+namespace loop_detail
+{
+
+    inline void check_hints(const LoopHints &hints)
+    {
+        if(hints.unroll_disable && (hints.unroll_full || hints.unroll_count))
+            throw CujException("conflicting loop unroll hints");
+        if(hints.unroll_full && hints.unroll_count)
+            throw CujException("conflicting loop unroll hints");
+    }
+
+} // namespace loop_detail
+
+inline LoopBuilder::LoopBuilder(const LoopHints &hints)
+    : hints_(hints)
+{
+    loop_detail::check_hints(hints_);
+}
+
 template<typename F>
 void LoopBuilder::operator+(F &&body_func)
 {
@@ -18,20 +37,29 @@ void LoopBuilder::operator+(F &&body_func)
         std::forward<F>(body_func)();
     }
     func->append_statement(newRC<core::Stat>(core::Loop{
-        .body = std::move(block)
+        .body  = std::move(block),
+        .hints = hints_
     }));
 }
 
 template<typename F>
     requires (!std::is_same_v<WhileBuilder, std::remove_cvref_t<F>>)
-WhileBuilder::WhileBuilder(F &&cond_func)
+WhileBuilder::WhileBuilder(F &&cond_func, const LoopHints &hints)
+    : hints_(hints)
 {
+    loop_detail::check_hints(hints_);
     auto func = FunctionContext::get_func_context();
     cond_block_ = newRC<core::Block>();
     {
         func->push_block(cond_block_);
         CUJ_SCOPE_EXIT{ func->pop_block(); };
-        cond_ = std::forward<F>(cond_func)()._load();
+        if constexpr(is_hinted_cond_v<std::remove_cvref_t<F>>)
+        {
+            cond_ = cond_func.cond_func()._load();
+            likelihood_ = cond_func.likelihood;
+        }
+        else
+            cond_ = std::forward<F>(cond_func)()._load();
     }
 }
 
@@ -50,20 +78,24 @@ void WhileBuilder::operator+(F &&body_func)
             .calc_cond = std::move(cond_block_),
             .cond      = std::move(cond_),
             .then_body = newRC<core::Stat>(std::move(*body)),
-            .else_body = newRC<core::Stat>(core::Break{})
+            .else_body = newRC<core::Stat>(core::Break{}),
+            .likelihood = likelihood_
         })
     };
     func->append_statement(core::Loop{
         .body = newRC<core::Block>(core::Block{
             .stats = std::move(body_stats)
-        })
+        }),
+        .hints = hints_
     });
 }
 
 template<typename IT>
-ForRangeBuilder<IT>::ForRangeBuilder(IT &idx, IT beg, IT end)
-    : idx_(idx)
+ForRangeBuilder<IT>::ForRangeBuilder(
+    IT &idx, IT beg, IT end, const LoopHints &hints)
+    : idx_(idx), hints_(hints)
 {
+    loop_detail::check_hints(hints_);
     beg_ = beg;
     end_ = end;
 }
@@ -72,8 +104,28 @@ template<typename IT>
 template<typename F>
 void ForRangeBuilder<IT>::operator+(F &&body_func)
 {
+    // end - beg is a multiple of trip_count_multiple
+    if(hints_.trip_count_multiple > 1)
+    {
+        using T = typename IT::RawType;
+        if constexpr(std::is_integral_v<T>)
+        {
+            const IT multiple(static_cast<T>(hints_.trip_count_multiple));
+            FunctionContext::get_func_context()->append_statement(
+                core::CallFuncStat{
+                    .call_expr = core::CallFunc{
+                        .intrinsic = core::Intrinsic::assume,
+                        .args      = { newRC<core::Expr>(
+                            ((end_ - beg_) % multiple == IT(0))._load()) }
+                    }
+                });
+        }
+        else
+            throw CujException("trip count multiple requires an integral range");
+    }
+
     IT next_idx = beg_;
-    $loop
+    LoopBuilder(hints_) + [&]
     {
         idx_ = next_idx;
         $if(idx_ >= end_)
@@ -40,6 +40,12 @@ const TypeContext::Type *TypeContext::get_type()
         *it->second = core::Array{ element, T::ElementCount };
     }
 
+    if constexpr(is_cuj_vector_v<T>)
+    {
+        auto element = get_type<num<typename T::ElementType>>();
+        *it->second = core::Vector{ element, T::ElementCount };
+    }
+
     if constexpr(is_cuj_class_v<T>)
     {
         std::vector<const core::Type *> members;
@@ -0,0 +1,512 @@
+#pragma once
+
+#include <cuj/dsl/arithmetic.h>
+#include <cuj/dsl/function.h>
+#include <cuj/dsl/pointer.h>
+#include <cuj/dsl/vector.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::dsl)
+
+template<typename T, size_t N>
+const core::Type *vec<T, N>::type()
+{
+    return FunctionContext::get_func_context()
+        ->get_type_context()->get_type<vec>();
+}
+
+template<typename T, size_t N>
+vec<T, N>::vec()
+{
+    auto func_ctx = FunctionContext::get_func_context();
+    alloc_index_ = func_ctx->alloc_local_var(type());
+}
+
+template<typename T, size_t N>
+vec<T, N>::vec(T value)
+    : vec(num<T>(value))
+{
+
+}
+
+template<typename T, size_t N>
+vec<T, N>::vec(const num<T> &value)
+    : vec()
+{
+    std::vector<RC<core::Expr>> elements;
+    elements.push_back(newRC<core::Expr>(value._load()));
+    core::Store store = {
+        .dst_addr = _addr(),
+        .val      = core::MakeVector{
+            .vector_type = type(),
+            .elements    = std::move(elements)
+        }
+    };
+    auto func_ctx = FunctionContext::get_func_context();
+    func_ctx->append_statement(newRC<core::Stat>(std::move(store)));
+}
+
+template<typename T, size_t N>
+vec<T, N>::vec(const ref<num<T>> &value)
+    : vec(num<T>(value))
+{
+
+}
+
+template<typename T, size_t N>
+template<typename...Es>
+    requires (sizeof...(Es) == N) && (std::is_convertible_v<Es, num<T>> && ...)
+vec<T, N>::vec(const Es &...elements)
+    : vec()
+{
+    std::vector<RC<core::Expr>> element_exprs;
+    ((element_exprs.push_back(newRC<core::Expr>(num<T>(elements)._load()))), ...);
+    core::Store store = {
+        .dst_addr = _addr(),
+        .val      = core::MakeVector{
+            .vector_type = type(),
+            .elements    = std::move(element_exprs)
+        }
+    };
+    auto func_ctx = FunctionContext::get_func_context();
+    func_ctx->append_statement(newRC<core::Stat>(std::move(store)));
+}
+
+template<typename T, size_t N>
+vec<T, N>::vec(const ref<vec<T, N>> &ref)
+    : vec()
+{
+    *this = vec::_from_expr(ref._load());
+}
+
+template<typename T, size_t N>
+vec<T, N>::vec(const vec &other)
+    : vec()
+{
+    *this = other;
+}
+
+template<typename T, size_t N>
+vec<T, N>::vec(vec &&other) noexcept
+    : alloc_index_(other.alloc_index_)
+{
+
+}
+
+template<typename T, size_t N>
+vec<T, N> &vec<T, N>::operator=(const vec &other)
+{
+    if(other.alloc_index_ == alloc_index_)
+        return *this;
+    core::Store store = {
+        .dst_addr = _addr(),
+        .val      = other._load()
+    };
+    auto func_ctx = FunctionContext::get_func_context();
+    func_ctx->append_statement(newRC<core::Stat>(std::move(store)));
+    return *this;
+}
+
+template<typename T, size_t N>
+template<typename U> requires is_cuj_vector_v<U> && (U::ElementCount == N)
+U vec<T, N>::as() const
+{
+    auto dst_type = FunctionContext::get_func_context()
+        ->get_type_context()->get_type<U>();
+    core::ArithmeticCast cast = {
+        .dst_type = dst_type,
+        .src_type = type(),
+        .src_val  = newRC<core::Expr>(_load())
+    };
+    return U::_from_expr(cast);
+}
+
+template<typename T, size_t N>
+template<typename U> requires std::is_integral_v<U>
+num<T> vec<T, N>::operator[](const num<U> &idx) const
+{
+    num<uint32_t> index = idx.template as<num<uint32_t>>();
+    return num<T>::_from_expr(core::VectorExtract{
+        .vector_type = type(),
+        .vector      = newRC<core::Expr>(_load()),
+        .index       = newRC<core::Expr>(index._load())
+    });
+}
+
+template<typename T, size_t N>
+template<typename U> requires std::is_integral_v<U>
+num<T> vec<T, N>::operator[](const ref<num<U>> &idx) const
+{
+    return this->operator[](num<U>(idx));
+}
+
+template<typename T, size_t N>
+template<typename U> requires std::is_integral_v<U>
+num<T> vec<T, N>::operator[](U idx) const
+{
+    return this->operator[](num(idx));
+}
+
+template<typename T, size_t N>
+template<typename U> requires std::is_integral_v<U>
+void vec<T, N>::set(const num<U> &idx, const num<T> &value)
+{
+    num<uint32_t> index = idx.template as<num<uint32_t>>();
+    core::Store store = {
+        .dst_addr = _addr(),
+        .val      = core::VectorInsert{
+            .vector_type = type(),
+            .vector      = newRC<core::Expr>(_load()),
+            .index       = newRC<core::Expr>(index._load()),
+            .element     = newRC<core::Expr>(value._load())
+        }
+    };
+    auto func_ctx = FunctionContext::get_func_context();
+    func_ctx->append_statement(newRC<core::Stat>(std::move(store)));
+}
+
+template<typename T, size_t N>
+template<typename U> requires std::is_integral_v<U>
+void vec<T, N>::set(const ref<num<U>> &idx, const num<T> &value)
+{
+    this->set(num<U>(idx), value);
+}
+
+template<typename T, size_t N>
+template<typename U> requires std::is_integral_v<U>
+void vec<T, N>::set(U idx, const num<T> &value)
+{
+    this->set(num(idx), value);
+}
+
+template<typename T, size_t N>
+template<size_t...Is>
+vec<T, sizeof...(Is)> vec<T, N>::shuffle() const
+{
+    static_assert(((Is < N) && ...), "shuffle index out of range");
+    return this->template shuffle<Is...>(*this);
+}
+
+template<typename T, size_t N>
+template<size_t...Is>
+vec<T, sizeof...(Is)> vec<T, N>::shuffle(const vec &other) const
+{
+    static_assert(((Is < 2 * N) && ...), "shuffle index out of range");
+    using Result = vec<T, sizeof...(Is)>;
+    auto dst_type = FunctionContext::get_func_context()
+        ->get_type_context()->get_type<Result>();
+    return Result::_from_expr(core::VectorShuffle{
+        .dst_type = dst_type,
+        .src_type = type(),
+        .lhs      = newRC<core::Expr>(_load()),
+        .rhs      = newRC<core::Expr>(other._load()),
+        .indices  = { static_cast<int>(Is)... }
+    });
+}
+
+template<typename T, size_t N>
+num<T> vec<T, N>::reduce_add() const
+{
+    static_assert(!std::is_same_v<T, bool>);
+    return _reduce(core::VectorReduce::Op::Add);
+}
+
+template<typename T, size_t N>
+num<T> vec<T, N>::reduce_mul() const
+{
+    static_assert(!std::is_same_v<T, bool>);
+    return _reduce(core::VectorReduce::Op::Mul);
+}
+
+template<typename T, size_t N>
+num<T> vec<T, N>::reduce_min() const
+{
+    static_assert(!std::is_same_v<T, bool>);
+    return _reduce(core::VectorReduce::Op::Min);
+}
+
+template<typename T, size_t N>
+num<T> vec<T, N>::reduce_max() const
+{
+    static_assert(!std::is_same_v<T, bool>);
+    return _reduce(core::VectorReduce::Op::Max);
+}
+
+template<typename T, size_t N>
+num<T> vec<T, N>::reduce_and() const
+{
+    static_assert(std::is_integral_v<T>);
+    return _reduce(core::VectorReduce::Op::BitwiseAnd);
+}
+
+template<typename T, size_t N>
+num<T> vec<T, N>::reduce_or() const
+{
+    static_assert(std::is_integral_v<T>);
+    return _reduce(core::VectorReduce::Op::BitwiseOr);
+}
+
+template<typename T, size_t N>
+num<T> vec<T, N>::reduce_xor() const
+{
+    static_assert(std::is_integral_v<T>);
+    return _reduce(core::VectorReduce::Op::BitwiseXOr);
+}
+
+template<typename T, size_t N>
+num<bool> vec<T, N>::any() const
+{
+    static_assert(std::is_same_v<T, bool>);
+    return _reduce(core::VectorReduce::Op::BitwiseOr);
+}
+
+template<typename T, size_t N>
+num<bool> vec<T, N>::all() const
+{
+    static_assert(std::is_same_v<T, bool>);
+    return _reduce(core::VectorReduce::Op::BitwiseAnd);
+}
+
+template<typename T, size_t N>
+vec<T, N> vec<T, N>::operator-() const
+{
+    static_assert(!std::is_same_v<T, bool>);
+    return _from_expr(core::Unary{
+        .op       = core::Unary::Op::Neg,
+        .val      = newRC<core::Expr>(_load()),
+        .val_type = type()
+    });
+}
+
+template<typename T, size_t N>
+vec<T, N> vec<T, N>::operator+(const vec &rhs) const
+{
+    static_assert(!std::is_same_v<T, bool>);
+    return _binary(core::Binary::Op::Add, rhs);
+}
+
+template<typename T, size_t N>
+vec<T, N> vec<T, N>::operator-(const vec &rhs) const
+{
+    static_assert(!std::is_same_v<T, bool>);
+    return _binary(core::Binary::Op::Sub, rhs);
+}
+
+template<typename T, size_t N>
+vec<T, N> vec<T, N>::operator*(const vec &rhs) const
+{
+    static_assert(!std::is_same_v<T, bool>);
+    return _binary(core::Binary::Op::Mul, rhs);
+}
+
+template<typename T, size_t N>
+vec<T, N> vec<T, N>::operator/(const vec &rhs) const
+{
+    static_assert(!std::is_same_v<T, bool>);
+    return _binary(core::Binary::Op::Div, rhs);
+}
+
+template<typename T, size_t N>
+vec<T, N> vec<T, N>::operator%(const vec &rhs) const
+{
+    static_assert(!std::is_same_v<T, bool>);
+    static_assert(std::is_integral_v<T>);
+    return _binary(core::Binary::Op::Mod, rhs);
+}
+
+template<typename T, size_t N>
+vec<bool, N> vec<T, N>::operator==(const vec &rhs) const
+{
+    return _compare(core::Binary::Op::Equal, rhs);
+}
+
+template<typename T, size_t N>
+vec<bool, N> vec<T, N>::operator!=(const vec &rhs) const
+{
+    return _compare(core::Binary::Op::NotEqual, rhs);
+}
+
+template<typename T, size_t N>
+vec<bool, N> vec<T, N>::operator<(const vec &rhs) const
+{
+    return _compare(core::Binary::Op::Less, rhs);
+}
+
+template<typename T, size_t N>
+vec<bool, N> vec<T, N>::operator<=(const vec &rhs) const
+{
+    return _compare(core::Binary::Op::LessEqual, rhs);
+}
+
+template<typename T, size_t N>
+vec<bool, N> vec<T, N>::operator>(const vec &rhs) const
+{
+    return _compare(core::Binary::Op::Greater, rhs);
+}
+
+template<typename T, size_t N>
+vec<bool, N> vec<T, N>::operator>=(const vec &rhs) const
+{
+    return _compare(core::Binary::Op::GreaterEqual, rhs);
+}
+
+template<typename T, size_t N>
+vec<T, N> vec<T, N>::operator>>(const vec &rhs) const
+{
+    static_assert(std::is_integral_v<T> && !std::is_signed_v<T>);
+    return _binary(core::Binary::Op::RightShift, rhs);
+}
+
+template<typename T, size_t N>
+vec<T, N> vec<T, N>::operator<<(const vec &rhs) const
+{
+    static_assert(std::is_integral_v<T>);
+    return _binary(core::Binary::Op::LeftShift, rhs);
+}
+
+template<typename T, size_t N>
+vec<T, N> vec<T, N>::operator&(const vec &rhs) const
+{
+    static_assert(std::is_integral_v<T>);
+    return _binary(core::Binary::Op::BitwiseAnd, rhs);
+}
+
+template<typename T, size_t N>
+vec<T, N> vec<T, N>::operator|(const vec &rhs) const
+{
+    static_assert(std::is_integral_v<T>);
+    return _binary(core::Binary::Op::BitwiseOr, rhs);
+}
+
+template<typename T, size_t N>
+vec<T, N> vec<T, N>::operator^(const vec &rhs) const
+{
+    static_assert(std::is_integral_v<T>);
+    return _binary(core::Binary::Op::BitwiseXOr, rhs);
+}
+
+template<typename T, size_t N>
+vec<T, N> vec<T, N>::operator~() const
+{
+    static_assert(std::is_integral_v<T>);
+    return _from_expr(core::Unary{
+        .op       = core::Unary::Op::BitwiseNot,
+        .val      = newRC<core::Expr>(_load()),
+        .val_type = type()
+    });
+}
+
+template<typename T, size_t N>
+ptr<vec<T, N>> vec<T, N>::address() const
+{
+    ptr<vec> ret;
+    core::Store store = {
+        .dst_addr = ret._addr(),
+        .val      = _addr()
+    };
+    auto func_ctx = FunctionContext::get_func_context();
+    func_ctx->append_statement(std::move(store));
+    return ret;
+}
+
+template<typename T, size_t N>
+vec<T, N> vec<T, N>::_from_expr(core::Expr expr)
+{
+    vec ret;
+    core::Store store = {
+        .dst_addr = ret._addr(),
+        .val      = std::move(expr)
+    };
+    auto func_ctx = FunctionContext::get_func_context();
+    func_ctx->append_statement(newRC<core::Stat>(std::move(store)));
+    return ret;
+}
+
+template<typename T, size_t N>
+core::Load vec<T, N>::_load() const
+{
+    return core::Load{
+        .val_type = type(),
+        .src_addr = newRC<core::Expr>(_addr())
+    };
+}
+
+template<typename T, size_t N>
+core::LocalAllocAddr vec<T, N>::_addr() const
+{
+    return core::LocalAllocAddr{
+        .alloc_type  = type(),
+        .alloc_index = alloc_index_
+    };
+}
+
+template<typename T, size_t N>
+vec<T, N> vec<T, N>::_binary(core::Binary::Op op, const vec &rhs) const
+{
+    return _from_expr(core::Binary{
+        .op       = op,
+        .lhs      = newRC<core::Expr>(_load()),
+        .rhs      = newRC<core::Expr>(rhs._load()),
+        .lhs_type = type(),
+        .rhs_type = type()
+    });
+}
+
+template<typename T, size_t N>
+vec<bool, N> vec<T, N>::_compare(core::Binary::Op op, const vec &rhs) const
+{
+    return vec<bool, N>::_from_expr(core::Binary{
+        .op       = op,
+        .lhs      = newRC<core::Expr>(_load()),
+        .rhs      = newRC<core::Expr>(rhs._load()),
+        .lhs_type = type(),
+        .rhs_type = type()
+    });
+}
+
+template<typename T, size_t N>
+num<T> vec<T, N>::_reduce(core::VectorReduce::Op op) const
+{
+    return num<T>::_from_expr(core::VectorReduce{
+        .op          = op,
+        .vector_type = type(),
+        .vector      = newRC<core::Expr>(_load())
+    });
+}
+
+template<typename T, size_t N>
+vec<T, N> operator+(T lhs, const vec<T, N> &rhs)
+{
+    return vec<T, N>(lhs) + rhs;
+}
+
+template<typename T, size_t N>
+vec<T, N> operator-(T lhs, const vec<T, N> &rhs)
+{
+    return vec<T, N>(lhs) - rhs;
+}
+
+template<typename T, size_t N>
+vec<T, N> operator*(T lhs, const vec<T, N> &rhs)
+{
+    return vec<T, N>(lhs) * rhs;
+}
+
+template<typename T, size_t N>
+vec<T, N> operator/(T lhs, const vec<T, N> &rhs)
+{
+    return vec<T, N>(lhs) / rhs;
+}
+
+template<size_t N>
+vec<bool, N> operator!(const vec<bool, N> &val)
+{
+    auto type = FunctionContext::get_func_context()
+        ->get_type_context()->get_type<vec<bool, N>>();
+    return vec<bool, N>::_from_expr(core::Unary{
+        .op       = core::Unary::Op::Not,
+        .val      = newRC<core::Expr>(val._load()),
+        .val_type = type
+    });
+}
+
+CUJ_NAMESPACE_END(cuj::dsl)
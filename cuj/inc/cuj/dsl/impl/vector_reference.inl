@@ -0,0 +1,326 @@
+#pragma once
+
+#include <cuj/core/stat.h>
+#include <cuj/dsl/function.h>
+#include <cuj/dsl/vector.h>
+#include <cuj/dsl/vector_reference.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::dsl)
+
+template<typename T, size_t N>
+ref<vec<T, N>>::ref(const vec<T, N> &var)
+{
+    addr_ = var.address();
+}
+
+template<typename T, size_t N>
+ref<vec<T, N>>::ref(const ref &other)
+{
+    addr_ = other.address();
+}
+
+template<typename T, size_t N>
+ref<vec<T, N>>::ref(ref &&other) noexcept
+    : addr_(std::move(other.addr_))
+{
+
+}
+
+template<typename T, size_t N>
+ref<vec<T, N>> &ref<vec<T, N>>::operator=(const ref &other)
+{
+    core::Store store = {
+        .dst_addr = addr_._load(),
+        .val      = other._load()
+    };
+    auto func_ctx = FunctionContext::get_func_context();
+    func_ctx->append_statement(std::move(store));
+    return *this;
+}
+
+template<typename T, size_t N>
+ref<vec<T, N>> &ref<vec<T, N>>::operator=(const vec<T, N> &other)
+{
+    core::Store store = {
+        .dst_addr = addr_._load(),
+        .val      = other._load()
+    };
+    auto func_ctx = FunctionContext::get_func_context();
+    func_ctx->append_statement(std::move(store));
+    return *this;
+}
+
+template<typename T, size_t N>
+template<typename U> requires is_cuj_vector_v<U> && (U::ElementCount == N)
+U ref<vec<T, N>>::as() const
+{
+    return vec<T, N>(*this).template as<U>();
+}
+
+template<typename T, size_t N>
+template<typename U> requires std::is_integral_v<U>
+num<T> ref<vec<T, N>>::operator[](const num<U> &idx) const
+{
+    return vec<T, N>(*this)[idx];
+}
+
+template<typename T, size_t N>
+template<typename U> requires std::is_integral_v<U>
+num<T> ref<vec<T, N>>::operator[](const ref<num<U>> &idx) const
+{
+    return vec<T, N>(*this)[idx];
+}
+
+template<typename T, size_t N>
+template<typename U> requires std::is_integral_v<U>
+num<T> ref<vec<T, N>>::operator[](U idx) const
+{
+    return vec<T, N>(*this)[idx];
+}
+
+template<typename T, size_t N>
+template<typename U> requires std::is_integral_v<U>
+void ref<vec<T, N>>::set(const num<U> &idx, const num<T> &value) const
+{
+    vec<T, N> v(*this);
+    v.set(idx, value);
+    core::Store store = {
+        .dst_addr = addr_._load(),
+        .val      = v._load()
+    };
+    auto func_ctx = FunctionContext::get_func_context();
+    func_ctx->append_statement(std::move(store));
+}
+
+template<typename T, size_t N>
+template<typename U> requires std::is_integral_v<U>
+void ref<vec<T, N>>::set(const ref<num<U>> &idx, const num<T> &value) const
+{
+    vec<T, N> v(*this);
+    v.set(idx, value);
+    core::Store store = {
+        .dst_addr = addr_._load(),
+        .val      = v._load()
+    };
+    auto func_ctx = FunctionContext::get_func_context();
+    func_ctx->append_statement(std::move(store));
+}
+
+template<typename T, size_t N>
+template<typename U> requires std::is_integral_v<U>
+void ref<vec<T, N>>::set(U idx, const num<T> &value) const
+{
+    vec<T, N> v(*this);
+    v.set(idx, value);
+    core::Store store = {
+        .dst_addr = addr_._load(),
+        .val      = v._load()
+    };
+    auto func_ctx = FunctionContext::get_func_context();
+    func_ctx->append_statement(std::move(store));
+}
+
+template<typename T, size_t N>
+template<size_t...Is>
+vec<T, sizeof...(Is)> ref<vec<T, N>>::shuffle() const
+{
+    return vec<T, N>(*this).template shuffle<Is...>();
+}
+
+template<typename T, size_t N>
+template<size_t...Is>
+vec<T, sizeof...(Is)> ref<vec<T, N>>::shuffle(const vec<T, N> &other) const
+{
+    return vec<T, N>(*this).template shuffle<Is...>(other);
+}
+
+template<typename T, size_t N>
+num<T> ref<vec<T, N>>::reduce_add() const
+{
+    return vec<T, N>(*this).reduce_add();
+}
+
+template<typename T, size_t N>
+num<T> ref<vec<T, N>>::reduce_mul() const
+{
+    return vec<T, N>(*this).reduce_mul();
+}
+
+template<typename T, size_t N>
+num<T> ref<vec<T, N>>::reduce_min() const
+{
+    return vec<T, N>(*this).reduce_min();
+}
+
+template<typename T, size_t N>
+num<T> ref<vec<T, N>>::reduce_max() const
+{
+    return vec<T, N>(*this).reduce_max();
+}
+
+template<typename T, size_t N>
+num<T> ref<vec<T, N>>::reduce_and() const
+{
+    return vec<T, N>(*this).reduce_and();
+}
+
+template<typename T, size_t N>
+num<T> ref<vec<T, N>>::reduce_or() const
+{
+    return vec<T, N>(*this).reduce_or();
+}
+
+template<typename T, size_t N>
+num<T> ref<vec<T, N>>::reduce_xor() const
+{
+    return vec<T, N>(*this).reduce_xor();
+}
+
+template<typename T, size_t N>
+num<bool> ref<vec<T, N>>::any() const
+{
+    return vec<T, N>(*this).any();
+}
+
+template<typename T, size_t N>
+num<bool> ref<vec<T, N>>::all() const
+{
+    return vec<T, N>(*this).all();
+}
+
+template<typename T, size_t N>
+vec<T, N> ref<vec<T, N>>::operator-() const
+{
+    return -vec<T, N>(*this);
+}
+
+template<typename T, size_t N>
+vec<T, N> ref<vec<T, N>>::operator~() const
+{
+    return ~vec<T, N>(*this);
+}
+
+template<typename T, size_t N>
+vec<T, N> ref<vec<T, N>>::operator+(const vec<T, N> &rhs) const
+{
+    return vec<T, N>(*this) + rhs;
+}
+
+template<typename T, size_t N>
+vec<T, N> ref<vec<T, N>>::operator-(const vec<T, N> &rhs) const
+{
+    return vec<T, N>(*this) - rhs;
+}
+
+template<typename T, size_t N>
+vec<T, N> ref<vec<T, N>>::operator*(const vec<T, N> &rhs) const
+{
+    return vec<T, N>(*this) * rhs;
+}
+
+template<typename T, size_t N>
+vec<T, N> ref<vec<T, N>>::operator/(const vec<T, N> &rhs) const
+{
+    return vec<T, N>(*this) / rhs;
+}
+
+template<typename T, size_t N>
+vec<T, N> ref<vec<T, N>>::operator%(const vec<T, N> &rhs) const
+{
+    return vec<T, N>(*this) % rhs;
+}
+
+template<typename T, size_t N>
+vec<bool, N> ref<vec<T, N>>::operator==(const vec<T, N> &rhs) const
+{
+    return vec<T, N>(*this) == rhs;
+}
+
+template<typename T, size_t N>
+vec<bool, N> ref<vec<T, N>>::operator!=(const vec<T, N> &rhs) const
+{
+    return vec<T, N>(*this) != rhs;
+}
+
+template<typename T, size_t N>
+vec<bool, N> ref<vec<T, N>>::operator<(const vec<T, N> &rhs) const
+{
+    return vec<T, N>(*this) < rhs;
+}
+
+template<typename T, size_t N>
+vec<bool, N> ref<vec<T, N>>::operator<=(const vec<T, N> &rhs) const
+{
+    return vec<T, N>(*this) <= rhs;
+}
+
+template<typename T, size_t N>
+vec<bool, N> ref<vec<T, N>>::operator>(const vec<T, N> &rhs) const
+{
+    return vec<T, N>(*this) > rhs;
+}
+
+template<typename T, size_t N>
+vec<bool, N> ref<vec<T, N>>::operator>=(const vec<T, N> &rhs) const
+{
+    return vec<T, N>(*this) >= rhs;
+}
+
+template<typename T, size_t N>
+vec<T, N> ref<vec<T, N>>::operator>>(const vec<T, N> &rhs) const
+{
+    return vec<T, N>(*this) >> rhs;
+}
+
+template<typename T, size_t N>
+vec<T, N> ref<vec<T, N>>::operator<<(const vec<T, N> &rhs) const
+{
+    return vec<T, N>(*this) << rhs;
+}
+
+template<typename T, size_t N>
+vec<T, N> ref<vec<T, N>>::operator&(const vec<T, N> &rhs) const
+{
+    return vec<T, N>(*this) & rhs;
+}
+
+template<typename T, size_t N>
+vec<T, N> ref<vec<T, N>>::operator|(const vec<T, N> &rhs) const
+{
+    return vec<T, N>(*this) | rhs;
+}
+
+template<typename T, size_t N>
+vec<T, N> ref<vec<T, N>>::operator^(const vec<T, N> &rhs) const
+{
+    return vec<T, N>(*this) ^ rhs;
+}
+
+template<typename T, size_t N>
+ptr<vec<T, N>> ref<vec<T, N>>::address() const
+{
+    ptr<vec<T, N>> ret;
+    ret = addr_;
+    return ret;
+}
+
+template<typename T, size_t N>
+core::Load ref<vec<T, N>>::_load() const
+{
+    auto type = FunctionContext::get_func_context()->get_type_context()
+        ->get_type<vec<T, N>>();
+    return core::Load{
+        .val_type = type,
+        .src_addr = newRC<core::Expr>(addr_._load())
+    };
+}
+
+template<typename T, size_t N>
+ref<vec<T, N>> ref<vec<T, N>>::_from_ptr(const ptr<vec<T, N>> &ptr)
+{
+    ref ret;
+    ret.addr_ = ptr;
+    return ret;
+}
+
+CUJ_NAMESPACE_END(cuj::dsl)
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cuj/dsl/arithmetic.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::dsl)
+
+// short-circuit evaluation. rhs_func is traced into a conditional block,
+// so its calls and memory accesses are skipped when the result is already
+// known from lhs_func
+
+template<typename L, typename R>
+num<bool> logical_and(L &&lhs_func, R &&rhs_func);
+
+template<typename L, typename R>
+num<bool> logical_or(L &&lhs_func, R &&rhs_func);
+
+#define CUJ_AND(LHS, RHS)                                                       \
+    ::cuj::dsl::logical_and(                                                    \
+        [&]()->::cuj::dsl::num<bool>{return (LHS);},                            \
+        [&]()->::cuj::dsl::num<bool>{return (RHS);})
+#define CUJ_OR(LHS, RHS)                                                        \
+    ::cuj::dsl::logical_or(                                                     \
+        [&]()->::cuj::dsl::num<bool>{return (LHS);},                            \
+        [&]()->::cuj::dsl::num<bool>{return (RHS);})
+
+#define $and CUJ_AND
+#define $or  CUJ_OR
+
+CUJ_NAMESPACE_END(cuj::dsl)
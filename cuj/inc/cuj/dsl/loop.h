@@ -3,28 +3,39 @@
 #include <type_traits>
 
 #include <cuj/dsl/arithmetic.h>
+#include <cuj/dsl/if.h>
 #include <cuj/utils/uncopyable.h>
 
 CUJ_NAMESPACE_BEGIN(cuj::dsl)
 
+using LoopHints = core::Loop::Hints;
+
 class LoopBuilder : public Uncopyable
 {
+    LoopHints hints_;
+
 public:
 
+    LoopBuilder() = default;
+
+    explicit LoopBuilder(const LoopHints &hints);
+
     template<typename F>
     void operator+(F &&body_func);
 };
 
 class WhileBuilder : public Uncopyable
 {
-    RC<core::Block> cond_block_;
-    core::Expr      cond_;
+    RC<core::Block>      cond_block_;
+    core::Expr           cond_;
+    core::If::Likelihood likelihood_ = core::If::Likelihood::Unknown;
+    LoopHints            hints_;
 
 public:
 
     template<typename F>
         requires (!std::is_same_v<WhileBuilder, std::remove_cvref_t<F>>)
-    explicit WhileBuilder(F &&cond_func);
+    explicit WhileBuilder(F &&cond_func, const LoopHints &hints = {});
 
     template<typename F>
     void operator+(F &&body_func);
@@ -36,10 +47,11 @@ class ForRangeBuilder : public Uncopyable
     static_assert(is_cuj_arithmetic_v<IT>);
 
     IT &idx_, beg_, end_;
+    LoopHints hints_;
 
 public:
 
-    ForRangeBuilder(IT &idx, IT beg, IT end);
+    ForRangeBuilder(IT &idx, IT beg, IT end, const LoopHints &hints = {});
 
     template<typename F>
     void operator+(F &&body_func);
@@ -70,10 +82,35 @@ inline void _add_continue_statement();
         ::cuj::dsl::ForRangeBuilder<decltype(_cuj_for_var)>                     \
             (_cuj_for_var, BEG, END)+[&, &I = _cuj_for_var]
 
+#define CUJ_LOOP_WITH_HINTS(...)                                                \
+    ::cuj::dsl::LoopBuilder(__VA_ARGS__)+[&]()->void
+#define CUJ_WHILE_WITH_HINTS(COND, ...)                                         \
+    ::cuj::dsl::WhileBuilder(                                                   \
+        [&]()->::cuj::dsl::num<bool>{return(COND);}, __VA_ARGS__)+[&]()->void
+#define CUJ_FORRANGE_WITH_HINTS(I, BEG, END, ...)                               \
+    for(auto [_cuj_for_var, _cuj_for_cond] = std::tuple{                        \
+        ::cuj::dsl::remove_var_wrapper_t<decltype(::cuj::dsl::var(BEG))>(BEG),  \
+        ::cuj::dsl::ForRangeCondVar{ true } }; _cuj_for_cond;)                  \
+        ::cuj::dsl::ForRangeBuilder<decltype(_cuj_for_var)>                     \
+            (_cuj_for_var, BEG, END, __VA_ARGS__)+[&, &I = _cuj_for_var]
+
+#define CUJ_WHILE_HINTED(HINT, COND)                                            \
+    ::cuj::dsl::WhileBuilder(::cuj::dsl::HINT(                                  \
+        [&]()->::cuj::dsl::num<bool>{return(COND);}))+[&]()->void
+#define CUJ_WHILE_LIKELY(COND)   CUJ_WHILE_HINTED(likely_cond, COND)
+#define CUJ_WHILE_UNLIKELY(COND) CUJ_WHILE_HINTED(unlikely_cond, COND)
+
 #define $loop CUJ_LOOP
 #define $while CUJ_WHILE
 #define $forrange CUJ_FORRANGE
 
+#define $while_likely   CUJ_WHILE_LIKELY
+#define $while_unlikely CUJ_WHILE_UNLIKELY
+
+#define $loop_with_hints     CUJ_LOOP_WITH_HINTS
+#define $while_with_hints    CUJ_WHILE_WITH_HINTS
+#define $forrange_with_hints CUJ_FORRANGE_WITH_HINTS
+
 #define CUJ_BREAK    (::cuj::dsl::_add_break_statement())
 #define CUJ_CONTINUE (::cuj::dsl::_add_continue_statement())
 #define $break    CUJ_BREAK
@@ -36,6 +36,11 @@ public:
 
     core::Prog _generate_prog() const;
 
+    void _add_trace_time(double seconds);
+
+    // total seconds spent in tracing function bodies
+    double get_trace_time() const;
+
 private:
 
     std::vector<RC<FunctionContext>> functions_;
@@ -44,6 +49,8 @@ private:
 
     std::set<RC<core::GlobalVar>> global_vars_;
     int                           auto_global_memory_index_;
+
+    double trace_time_;
 };
 
 template<typename T>
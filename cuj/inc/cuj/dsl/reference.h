@@ -4,6 +4,7 @@
 #include <cuj/dsl/array_reference.h>
 #include <cuj/dsl/class.h>
 #include <cuj/dsl/pointer_reference.h>
+#include <cuj/dsl/vector_reference.h>
 
 CUJ_NAMESPACE_BEGIN(cuj::dsl)
 
@@ -22,6 +23,9 @@ ref(ptr<T>)->ref<ptr<T>>;
 template<typename T, size_t N>
 ref(arr<T, N>)->ref<arr<T, N>>;
 
+template<typename T, size_t N>
+ref(vec<T, N>)->ref<vec<T, N>>;
+
 template<typename T> requires is_cuj_class_v<T>
 ref(var<T>)->ref<T>;
 
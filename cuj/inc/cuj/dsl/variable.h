@@ -3,6 +3,7 @@
 #include <cuj/dsl/arithmetic.h>
 #include <cuj/dsl/array.h>
 #include <cuj/dsl/pointer.h>
+#include <cuj/dsl/vector.h>
 
 CUJ_NAMESPACE_BEGIN(cuj::dsl)
 
@@ -59,6 +60,16 @@ public:
     var(arr<T, N> other) : arr<T, N>(std::move(other)) { }
 };
 
+template<typename T, size_t N>
+class var<vec<T, N>> : public vec<T, N>
+{
+public:
+
+    using vec<T, N>::vec;
+
+    var(vec<T, N> other) : vec<T, N>(std::move(other)) { }
+};
+
 template<typename T> requires is_cuj_class_v<T>
 class var<T> : public T
 {
@@ -84,6 +95,9 @@ var(ptr<T>)->var<ptr<T>>;
 template<typename T, size_t N>
 var(arr<T, N>)->var<arr<T, N>>;
 
+template<typename T, size_t N>
+var(vec<T, N>)->var<vec<T, N>>;
+
 template<typename T> requires is_cuj_class_v<T>
 var(T)->var<T>;
 
@@ -99,6 +113,9 @@ var(ref<ptr<T>>)->var<ptr<T>>;
 template<typename T, size_t N>
 var(ref<arr<T, N>>)->var<arr<T, N>>;
 
+template<typename T, size_t N>
+var(ref<vec<T, N>>)->var<vec<T, N>>;
+
 template<typename T> requires is_cuj_class_v<T>
 var(ref<T>)->var<T>;
 
@@ -48,6 +48,20 @@ struct IsCujArray<arr<T, N>> : std::true_type { };
 template<typename T>
 constexpr bool is_cuj_array_v = IsCujArray<T>::value;
 
+// vector
+
+template<typename T, size_t N>
+class vec;
+
+template<typename T>
+struct IsCujVector : std::false_type { };
+
+template<typename T, size_t N>
+struct IsCujVector<vec<T, N>> : std::true_type { };
+
+template<typename T>
+constexpr bool is_cuj_vector_v = IsCujVector<T>::value;
+
 // class
 
 template<typename T>
@@ -65,6 +79,7 @@ constexpr bool is_cuj_var_v =
     is_cuj_pointer_v<T>        ||
     std::is_same_v<T, CujVoid> ||
     is_cuj_array_v<T>          ||
+    is_cuj_vector_v<T>         ||
     is_cuj_class_v<T>;
 
 // reference
@@ -108,6 +123,15 @@ struct IsCujArrayReference<ref<arr<T, N>>> : std::true_type { };
 template<typename T>
 constexpr bool is_cuj_array_reference_v = IsCujArrayReference<T>::value;
 
+template<typename T>
+struct IsCujVectorReference : std::false_type { };
+
+template<typename T, size_t N>
+struct IsCujVectorReference<ref<vec<T, N>>> : std::true_type { };
+
+template<typename T>
+constexpr bool is_cuj_vector_reference_v = IsCujVectorReference<T>::value;
+
 template<typename T>
 struct IsCujClassReference : std::false_type { };
 
@@ -123,6 +147,7 @@ constexpr bool is_cuj_ref_v =
     is_cuj_arithmetic_reference_v<T> ||
     is_cuj_pointer_reference_v<T>    ||
     is_cuj_array_reference_v<T>      ||
+    is_cuj_vector_reference_v<T>     ||
     is_cuj_class_reference_v<T>;
 
 // trivial
@@ -139,6 +164,9 @@ struct IsTriviallyCopyable<ptr<T>> : std::true_type { };
 template<typename T, size_t N>
 struct IsTriviallyCopyable<arr<T, N>> : IsTriviallyCopyable<T> { };
 
+template<typename T, size_t N>
+struct IsTriviallyCopyable<vec<T, N>> : std::true_type { };
+
 template<typename T>
     requires is_cuj_class_v<T> &&
              ((!requires { typename T::NoneTriviallyCopyableTag; }) &&
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cuj/core/expr.h>
+#include <cuj/dsl/variable_forward.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::dsl)
+
+// simd vector of N arithmetic values.
+// operators are applied elementwise, and comparisons produce vec<bool, N>
+template<typename T, size_t N>
+class vec
+{
+    static_assert(std::is_arithmetic_v<T>);
+    static_assert(2 <= N && N <= 16);
+
+    size_t alloc_index_;
+
+    static const core::Type *type();
+
+public:
+
+    using ElementType = T;
+
+    static constexpr size_t ElementCount = N;
+
+    vec();
+
+    // broadcast
+
+    vec(T value);
+
+    vec(const num<T> &value);
+
+    vec(const ref<num<T>> &value);
+
+    template<typename...Es>
+        requires (sizeof...(Es) == N) && (std::is_convertible_v<Es, num<T>> && ...)
+    vec(const Es &...elements);
+
+    vec(const ref<vec<T, N>> &ref);
+
+    vec(const vec &other);
+
+    vec(vec &&other) noexcept;
+
+    vec &operator=(const vec &other);
+
+    template<typename U> requires is_cuj_vector_v<U> && (U::ElementCount == N)
+    U as() const;
+
+    constexpr size_t size() const { return N; }
+
+    template<typename U> requires std::is_integral_v<U>
+    num<T> operator[](const num<U> &idx) const;
+
+    template<typename U> requires std::is_integral_v<U>
+    num<T> operator[](const ref<num<U>> &idx) const;
+
+    template<typename U> requires std::is_integral_v<U>
+    num<T> operator[](U idx) const;
+
+    template<typename U> requires std::is_integral_v<U>
+    void set(const num<U> &idx, const num<T> &value);
+
+    template<typename U> requires std::is_integral_v<U>
+    void set(const ref<num<U>> &idx, const num<T> &value);
+
+    template<typename U> requires std::is_integral_v<U>
+    void set(U idx, const num<T> &value);
+
+    // result[i] = this[Is[i]]
+    template<size_t...Is>
+    vec<T, sizeof...(Is)> shuffle() const;
+
+    // result[i] = Is[i] < N ? this[Is[i]] : other[Is[i] - N]
+    template<size_t...Is>
+    vec<T, sizeof...(Is)> shuffle(const vec &other) const;
+
+    // floating-point sums and products may be evaluated in any order
+    num<T> reduce_add() const;
+    num<T> reduce_mul() const;
+    num<T> reduce_min() const;
+    num<T> reduce_max() const;
+    num<T> reduce_and() const;
+    num<T> reduce_or()  const;
+    num<T> reduce_xor() const;
+
+    num<bool> any() const;
+    num<bool> all() const;
+
+    vec operator-() const;
+
+    vec operator+(const vec &rhs) const;
+    vec operator-(const vec &rhs) const;
+    vec operator*(const vec &rhs) const;
+    vec operator/(const vec &rhs) const;
+    vec operator%(const vec &rhs) const;
+
+    vec<bool, N> operator==(const vec &rhs) const;
+    vec<bool, N> operator!=(const vec &rhs) const;
+    vec<bool, N> operator< (const vec &rhs) const;
+    vec<bool, N> operator<=(const vec &rhs) const;
+    vec<bool, N> operator> (const vec &rhs) const;
+    vec<bool, N> operator>=(const vec &rhs) const;
+
+    vec operator>>(const vec &rhs) const;
+    vec operator<<(const vec &rhs) const;
+
+    vec operator&(const vec &rhs) const;
+    vec operator|(const vec &rhs) const;
+    vec operator^(const vec &rhs) const;
+
+    vec operator~() const;
+
+    ptr<vec> address() const;
+
+    static vec _from_expr(core::Expr expr);
+
+    core::Load _load() const;
+
+    core::LocalAllocAddr _addr() const;
+
+private:
+
+    vec _binary(core::Binary::Op op, const vec &rhs) const;
+
+    vec<bool, N> _compare(core::Binary::Op op, const vec &rhs) const;
+
+    num<T> _reduce(core::VectorReduce::Op op) const;
+};
+
+template<typename T, size_t N>
+vec<T, N> operator+(T lhs, const vec<T, N> &rhs);
+template<typename T, size_t N>
+vec<T, N> operator-(T lhs, const vec<T, N> &rhs);
+template<typename T, size_t N>
+vec<T, N> operator*(T lhs, const vec<T, N> &rhs);
+template<typename T, size_t N>
+vec<T, N> operator/(T lhs, const vec<T, N> &rhs);
+
+template<size_t N>
+vec<bool, N> operator!(const vec<bool, N> &val);
+
+CUJ_NAMESPACE_END(cuj::dsl)
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cuj/dsl/pointer.h>
+#include <cuj/dsl/variable_forward.h>
+#include <cuj/dsl/vector.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::dsl)
+
+template<typename T, size_t N>
+class ref<vec<T, N>>
+{
+    ptr<vec<T, N>> addr_;
+
+    ref() = default;
+
+public:
+
+    using ElementType = T;
+
+    static constexpr size_t ElementCount = N;
+
+    ref(const vec<T, N> &var);
+
+    ref(const ref &other);
+
+    ref(ref &&other) noexcept;
+
+    ref &operator=(const ref &other);
+
+    ref &operator=(const vec<T, N> &other);
+
+    template<typename U> requires is_cuj_vector_v<U> && (U::ElementCount == N)
+    U as() const;
+
+    constexpr size_t size() const { return N; }
+
+    template<typename U> requires std::is_integral_v<U>
+    num<T> operator[](const num<U> &idx) const;
+
+    template<typename U> requires std::is_integral_v<U>
+    num<T> operator[](const ref<num<U>> &idx) const;
+
+    template<typename U> requires std::is_integral_v<U>
+    num<T> operator[](U idx) const;
+
+    template<typename U> requires std::is_integral_v<U>
+    void set(const num<U> &idx, const num<T> &value) const;
+
+    template<typename U> requires std::is_integral_v<U>
+    void set(const ref<num<U>> &idx, const num<T> &value) const;
+
+    template<typename U> requires std::is_integral_v<U>
+    void set(U idx, const num<T> &value) const;
+
+    template<size_t...Is>
+    vec<T, sizeof...(Is)> shuffle() const;
+
+    template<size_t...Is>
+    vec<T, sizeof...(Is)> shuffle(const vec<T, N> &other) const;
+
+    num<T> reduce_add() const;
+    num<T> reduce_mul() const;
+    num<T> reduce_min() const;
+    num<T> reduce_max() const;
+    num<T> reduce_and() const;
+    num<T> reduce_or()  const;
+    num<T> reduce_xor() const;
+
+    num<bool> any() const;
+    num<bool> all() const;
+
+    vec<T, N> operator-() const;
+
+    vec<T, N> operator+(const vec<T, N> &rhs) const;
+    vec<T, N> operator-(const vec<T, N> &rhs) const;
+    vec<T, N> operator*(const vec<T, N> &rhs) const;
+    vec<T, N> operator/(const vec<T, N> &rhs) const;
+    vec<T, N> operator%(const vec<T, N> &rhs) const;
+
+    vec<bool, N> operator==(const vec<T, N> &rhs) const;
+    vec<bool, N> operator!=(const vec<T, N> &rhs) const;
+    vec<bool, N> operator< (const vec<T, N> &rhs) const;
+    vec<bool, N> operator<=(const vec<T, N> &rhs) const;
+    vec<bool, N> operator> (const vec<T, N> &rhs) const;
+    vec<bool, N> operator>=(const vec<T, N> &rhs) const;
+
+    vec<T, N> operator>>(const vec<T, N> &rhs) const;
+    vec<T, N> operator<<(const vec<T, N> &rhs) const;
+
+    vec<T, N> operator&(const vec<T, N> &rhs) const;
+    vec<T, N> operator|(const vec<T, N> &rhs) const;
+    vec<T, N> operator^(const vec<T, N> &rhs) const;
+
+    vec<T, N> operator~() const;
+
+    ptr<vec<T, N>> address() const;
+
+    core::Load _load() const;
+
+    static ref _from_ptr(const ptr<vec<T, N>> &ptr);
+};
+
+CUJ_NAMESPACE_END(cuj::dsl)
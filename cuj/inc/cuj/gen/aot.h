@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+
+#include <cuj/dsl/module.h>
+#include <cuj/gen/option.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+// compile module into native code loadable without cuj and llvm.
+// code is optimized for the cpu specified in options, which defaults to
+// host cpu. use "generic" cpu for code distributed to other machines
+class AOTCompiler : public Uncopyable
+{
+public:
+
+    void set_options(const Options &opts);
+
+    void generate(const dsl::Module &mod);
+
+    // optimized llvm ir
+    const std::string &get_llvm_string() const;
+
+    // relocatable object file content
+    const std::vector<char> &get_object() const;
+
+    // declarations of exported functions and global variables
+    const std::string &get_c_header() const;
+
+    void write_object(const std::string &filename) const;
+
+    void write_static_library(const std::string &filename) const;
+
+    // link with system c compiler driver (cc).
+    // objects and static libraries compiled with VectorMathLibrary::LibMVec
+    // must be linked with -lmvec by users
+    void write_shared_library(const std::string &filename) const;
+
+    void write_c_header(const std::string &filename) const;
+
+private:
+
+    Options           opts_;
+    std::string       llvm_ir_;
+    std::vector<char> object_;
+    std::string       c_header_;
+};
+
+CUJ_NAMESPACE_END(cuj::gen)
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+#include <cuj/common.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+struct CompileStats
+{
+    // wall time of each phase in seconds.
+    // phases of parallel partitions are summed up
+
+    double trace_time         = 0; // tracing function bodies into the module
+    double generate_prog_time = 0; // dsl::Module::_generate_prog
+    double ir_generation_time = 0; // LLVMIRGenerator, excluding _generate_prog
+    double function_pass_time = 0; // function pass manager
+    double module_pass_time   = 0; // module pass manager
+    double codegen_time       = 0; // machine code/ptx emission and linking
+    double total_time         = 0; // the whole generate call
+
+    // counts are equal when optimization is skipped by object caching
+    size_t ir_instruction_count_before_opt = 0;
+    size_t ir_instruction_count_after_opt  = 0;
+
+    size_t local_alloca_count = 0;
+
+    // symbol name -> bytes of machine code. empty for ptx
+    std::map<std::string, size_t> function_code_sizes;
+
+    // peak resident memory of the process in bytes. 0 if unknown
+    size_t peak_memory = 0;
+};
+
+CUJ_NAMESPACE_END(cuj::gen)
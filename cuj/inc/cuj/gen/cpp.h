@@ -117,12 +117,24 @@ private:
 
     std::string generate(const core::Unary &e) const;
 
+    std::string generate(const core::Select &e) const;
+
     std::string generate(const core::CallFunc &e) const;
 
     std::string generate(const core::GlobalVarAddr &e) const;
 
     std::string generate(const core::GlobalConstAddr &e) const;
 
+    std::string generate(const core::MakeVector &e) const;
+
+    std::string generate(const core::VectorExtract &e) const;
+
+    std::string generate(const core::VectorInsert &e) const;
+
+    std::string generate(const core::VectorShuffle &e) const;
+
+    std::string generate(const core::VectorReduce &e) const;
+
     std::string generate_intrinsic_call(const core::CallFunc &e) const;
 
     Target target_ = Target::Native;
@@ -147,6 +159,7 @@ private:
     mutable size_t local_temp_index_ = 0;
 
     const core::Prog *prog_ = nullptr;
+    const core::Func *func_ = nullptr;
 };
 
 CUJ_NAMESPACE_END(cuj::gen)
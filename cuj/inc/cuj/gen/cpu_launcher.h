@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+#include <cuj/common.h>
+#include <cuj/utils/uncopyable.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+// the first argument of kernels compiled for native target.
+// each call of a kernel runs all threads of one block
+struct CPUBlockInfo
+{
+    int32_t block_idx[3];
+    int32_t block_dim[3];
+};
+
+template<typename...Args>
+using CPUKernelFunction = void(const CPUBlockInfo *, Args...);
+
+// runs kernels compiled for native target on a work-stealing thread pool.
+// blocks are distributed over threads, and threads in a block are executed
+// sequentially by the thread running the block
+class CPULauncher : public Unmovable
+{
+public:
+
+    struct Dim3 { int x = 1, y = 1, z = 1; };
+
+    // thread_count = 0 means using the number of hardware threads.
+    // the thread calling launch is one of them
+    explicit CPULauncher(int thread_count = 0);
+
+    ~CPULauncher();
+
+    int get_thread_count() const;
+
+    // returns after all blocks are finished.
+    // concurrent launches are serialized
+    template<typename...KernelArgs, typename...Args>
+    void launch(
+        CPUKernelFunction<KernelArgs...> *kernel,
+        const Dim3                       &block_cnt,
+        const Dim3                       &block_size,
+        Args                           ...kernel_args);
+
+private:
+
+    using BlockFunction = void(*)(const void *, const CPUBlockInfo &);
+
+    void launch_impl(
+        const Dim3   &block_cnt,
+        const Dim3   &block_size,
+        BlockFunction block_func,
+        const void   *block_func_data);
+
+    struct CPULauncherData;
+
+    CPULauncherData *data_ = nullptr;
+};
+
+CUJ_NAMESPACE_END(cuj::gen)
+
+#include <cuj/gen/impl/cpu_launcher.inl>
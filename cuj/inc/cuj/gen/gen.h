@@ -1,20 +1,39 @@
 #pragma once
 
+#include <cuj/gen/aot.h>
+#include <cuj/gen/compile_stats.h>
 #include <cuj/gen/cpp.h>
+#include <cuj/gen/cpu_launcher.h>
+#include <cuj/gen/jit_service.h>
 #include <cuj/gen/llvm.h>
 #include <cuj/gen/mcjit.h>
 #include <cuj/gen/nvrtc.h>
+#include <cuj/gen/object_cache.h>
+#include <cuj/gen/orc.h>
 #include <cuj/gen/ptx.h>
+#include <cuj/gen/specialization_cache.h>
 
 CUJ_NAMESPACE_BEGIN(cuj)
 
 using gen::Options;
+using gen::MathPrecision;
+using gen::VectorMathLibrary;
 using gen::OptimizationLevel;
+using gen::CompileStats;
 
+using gen::AOTCompiler;
 using gen::CPPCodeGenerator;
+using gen::CPULauncher;
+using gen::CPUBlockInfo;
 using gen::LLVMIRGenerator;
 using gen::MCJIT;
+using gen::CompiledModule;
+using gen::JITService;
+using gen::OrcJIT;
+using gen::ObjectCache;
+using gen::DirectoryObjectCache;
 using gen::PTXGenerator;
+using gen::SpecializationCache;
 
 #ifdef CUJ_ENABLE_CUDA
 using gen::NVRTC;
@@ -0,0 +1,29 @@
+#pragma once
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+template<typename...KernelArgs, typename...Args>
+void CPULauncher::launch(
+    CPUKernelFunction<KernelArgs...> *kernel,
+    const Dim3                       &block_cnt,
+    const Dim3                       &block_size,
+    Args                           ...kernel_args)
+{
+    static_assert(sizeof...(KernelArgs) == sizeof...(Args),
+                  "kernel argument count doesn't match");
+
+    auto run_block = [&](const CPUBlockInfo &block_info)
+    {
+        kernel(&block_info, kernel_args...);
+    };
+    using RunBlock = decltype(run_block);
+
+    this->launch_impl(
+        block_cnt, block_size,
+        [](const void *data, const CPUBlockInfo &block_info)
+    {
+        (*static_cast<const RunBlock *>(data))(block_info);
+    }, &run_block);
+}
+
+CUJ_NAMESPACE_END(cuj::gen)
@@ -171,6 +171,18 @@ auto MCJIT::get_function(const dsl::Function<Ret(Args...)> &func) const
     return this->get_function<CFunctionType>(func);
 }
 
+template<typename Ret, typename...Args>
+auto MCJIT::get_kernel(const dsl::Function<Ret(Args...)> &func) const
+{
+    static_assert(std::is_same_v<Ret, dsl::CujVoid>,
+                  "kernel function must return void");
+    using KernelType = CPUKernelFunction<
+        typename mcjit_detail::ArgToCArg<Args>::Type...>;
+    auto core_func = func._get_context()->get_core_func();
+    assert(core_func->type == core::Func::Kernel);
+    return reinterpret_cast<KernelType *>(get_function_impl(core_func->name));
+}
+
 template<typename T>
 T *MCJIT::get_global_variable(const std::string &symbol_name) const
 {
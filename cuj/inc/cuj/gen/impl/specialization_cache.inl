@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cuj/utils/scope_guard.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+template<typename Key, typename Signature>
+    requires std::is_function_v<Signature>
+SpecializationCache<Key, Signature>::SpecializationCache(size_t capacity)
+    : capacity_(capacity)
+{
+    
+}
+
+template<typename Key, typename Signature>
+    requires std::is_function_v<Signature>
+void SpecializationCache<Key, Signature>::set_options(const Options &opts)
+{
+    std::lock_guard lock(mutex_);
+    opts_ = opts;
+}
+
+template<typename Key, typename Signature>
+    requires std::is_function_v<Signature>
+void SpecializationCache<Key, Signature>::set_object_cache(
+    RC<ObjectCache> cache)
+{
+    std::lock_guard lock(mutex_);
+    object_cache_ = std::move(cache);
+}
+
+template<typename Key, typename Signature>
+    requires std::is_function_v<Signature>
+template<typename F>
+Signature *SpecializationCache<Key, Signature>::get(const Key &key, F &&trace)
+{
+    std::unique_lock lock(mutex_);
+
+    if(auto it = key_to_entry_.find(key); it != key_to_entry_.end())
+    {
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->function;
+    }
+
+    // the key is being compiled by another thread
+
+    if(auto it = in_flight_.find(key); it != in_flight_.end())
+    {
+        auto future = it->second;
+        lock.unlock();
+        return future.get();
+    }
+
+    std::promise<Signature *> promise;
+    in_flight_.insert({ key, promise.get_future().share() });
+
+    Entry entry{ key };
+    entry.mcjit.set_options(opts_);
+    entry.mcjit.set_object_cache(object_cache_);
+    lock.unlock();
+
+    try
+    {
+        dsl::Module mod;
+        auto old_mod = dsl::Module::get_current_module();
+        dsl::Module::set_current_module(&mod);
+        CUJ_SCOPE_EXIT{ dsl::Module::set_current_module(old_mod); };
+
+        auto func = std::forward<F>(trace)();
+        entry.mcjit.generate(mod);
+        entry.function = entry.mcjit.template get_function<Signature>(func);
+
+        if(!entry.function)
+            throw CujException("failed to compile specialized function");
+    }
+    catch(...)
+    {
+        promise.set_exception(std::current_exception());
+        lock.lock();
+        in_flight_.erase(key);
+        throw;
+    }
+
+    lock.lock();
+    in_flight_.erase(key);
+    entries_.push_front(std::move(entry));
+    key_to_entry_.insert({ key, entries_.begin() });
+    auto result = entries_.front().function;
+    shrink_to_capacity();
+    lock.unlock();
+
+    promise.set_value(result);
+    return result;
+}
+
+template<typename Key, typename Signature>
+    requires std::is_function_v<Signature>
+Signature *SpecializationCache<Key, Signature>::find(const Key &key)
+{
+    std::lock_guard lock(mutex_);
+    auto it = key_to_entry_.find(key);
+    if(it == key_to_entry_.end())
+        return nullptr;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->function;
+}
+
+template<typename Key, typename Signature>
+    requires std::is_function_v<Signature>
+void SpecializationCache<Key, Signature>::set_capacity(size_t capacity)
+{
+    std::lock_guard lock(mutex_);
+    capacity_ = capacity;
+    shrink_to_capacity();
+}
+
+template<typename Key, typename Signature>
+    requires std::is_function_v<Signature>
+size_t SpecializationCache<Key, Signature>::size() const
+{
+    std::lock_guard lock(mutex_);
+    return entries_.size();
+}
+
+template<typename Key, typename Signature>
+    requires std::is_function_v<Signature>
+void SpecializationCache<Key, Signature>::clear()
+{
+    std::lock_guard lock(mutex_);
+    key_to_entry_.clear();
+    entries_.clear();
+}
+
+template<typename Key, typename Signature>
+    requires std::is_function_v<Signature>
+void SpecializationCache<Key, Signature>::shrink_to_capacity()
+{
+    // the most recently added entry is always kept
+    while(entries_.size() > (std::max)(capacity_, size_t(1)))
+    {
+        key_to_entry_.erase(entries_.back().key);
+        entries_.pop_back();
+    }
+}
+
+CUJ_NAMESPACE_END(cuj::gen)
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <future>
+#include <stop_token>
+
+#include <cuj/gen/mcjit.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+using CompiledModule = MCJIT;
+
+// compiles modules with MCJIT on background threads.
+// tasks with higher priority are started first, and tasks with the same
+// priority are started in submission order
+class JITService : public Unmovable
+{
+public:
+
+    enum class Priority
+    {
+        Low,
+        Normal,
+        High
+    };
+
+    // thread_count = 0 means using the number of hardware threads
+    explicit JITService(int thread_count = 0);
+
+    // pending tasks are cancelled. running tasks are waited for
+    ~JITService();
+
+    // module must be completely traced, and is owned by the service until
+    // its compilation is finished. requesting a stop through cancel_token
+    // before the task is started cancels it, in which case the future
+    // throws CujException
+    std::future<CompiledModule> submit(
+        dsl::Module   &&mod,
+        const Options  &opts         = {},
+        Priority        priority     = Priority::Normal,
+        std::stop_token cancel_token = {});
+
+    // number of tasks not started yet
+    size_t get_pending_task_count() const;
+
+private:
+
+    struct JITServiceData;
+
+    JITServiceData *data_ = nullptr;
+};
+
+CUJ_NAMESPACE_END(cuj::gen)
@@ -1,11 +1,14 @@
 #pragma once
 
 #include <cuj/dsl/module.h>
+#include <cuj/gen/option.h>
 
 namespace llvm
 {
 
+    class BasicBlock;
     class LLVMContext;
+    class MDNode;
     class DataLayout;
     class Function;
     class FunctionType;
@@ -17,6 +20,8 @@ namespace llvm
 
 CUJ_NAMESPACE_BEGIN(cuj::gen)
 
+class SPMDKernelGenerator;
+
 class LLVMIRGenerator : public Uncopyable
 {
 public:
@@ -37,12 +42,18 @@ public:
 
     void use_approx_math_func();
 
+    void set_native_math_precision(MathPrecision precision);
+
+    void set_cpu_kernel_simd_width(int width);
+
     void disable_assert();
 
     void set_data_layout(llvm::DataLayout *data_layout);
 
     void generate(const dsl::Module &mod);
 
+    void generate(core::Prog program);
+
     llvm::Module *get_llvm_module() const;
 
     std::pair<Box<llvm::LLVMContext>, Box<llvm::Module>> get_data_ownership();
@@ -51,12 +62,27 @@ public:
 
 private:
 
+    friend class SPMDKernelGenerator;
+
     void generate_global_variables();
 
     llvm::FunctionType *get_function_type(const core::Func &func);
 
+    void add_argument_attributes(
+        llvm::Function *llvm_func, const core::Func &func, unsigned first_arg);
+
+    void add_function_attributes(
+        llvm::Function *llvm_func, const core::Func &func);
+
     void declare_function(const core::Func *func);
 
+    void declare_native_kernel(const core::Func *func);
+
+    void generate_native_kernel_entry(
+        llvm::Function *entry_func,
+        llvm::Function *thread_func,
+        llvm::Function *spmd_func);
+
     void define_function(const core::Func *func);
 
     void clear_temp_function_data();
@@ -65,6 +91,13 @@ private:
 
     void generate_default_ret(const core::Func *func);
 
+    llvm::MDNode *get_branch_weights(core::If::Likelihood likelihood);
+
+    void add_loop_metadata(
+        const core::Loop::Hints &hints,
+        llvm::BasicBlock        *header,
+        llvm::BasicBlock        *exit_block);
+
     void generate(const core::Stat &stat);
 
     void generate(const core::Store &store);
@@ -127,20 +160,59 @@ private:
 
     llvm::Value *generate(const core::Unary &expr);
 
+    llvm::Value *generate(const core::Select &expr);
+
     llvm::Value *generate(const core::CallFunc &expr);
 
     llvm::Value *generate(const core::GlobalVarAddr &expr);
 
     llvm::Value *generate(const core::GlobalConstAddr &expr);
 
+    llvm::Value *generate(const core::MakeVector &expr);
+
+    llvm::Value *generate(const core::VectorExtract &expr);
+
+    llvm::Value *generate(const core::VectorInsert &expr);
+
+    llvm::Value *generate(const core::VectorShuffle &expr);
+
+    llvm::Value *generate(const core::VectorReduce &expr);
+
     llvm::Value *process_intrinsic_call(
         const core::CallFunc &call, const std::vector<llvm::Value *> &args);
 
-    Target            target_           = Target::Native;
-    bool              fast_math_        = false;
-    bool              approx_math_func_ = false;
-    bool              enable_assert_    = true;
-    llvm::DataLayout *data_layout_      = nullptr;
+    // returns nullptr if intrinsic is not a bit manipulation or fused
+    // arithmetic intrinsic
+    llvm::Value *process_bit_intrinsic(
+        core::Intrinsic intrinsic, const std::vector<llvm::Value *> &args);
+
+    llvm::Value *process_native_kernel_index(core::Intrinsic intrinsic);
+
+    // shared by scalar and spmd code. values can be llvm vectors
+
+    llvm::Value *create_arithmetic_cast(
+        core::Builtin src_type, core::Builtin dst_type,
+        llvm::Value *src_val, llvm::Type *dst_llvm_type);
+
+    llvm::Value *create_bitwise_cast(llvm::Value *src_val, llvm::Type *dst_type);
+
+    llvm::Value *create_binary(
+        core::Binary::Op op, core::Builtin lhs_type,
+        llvm::Value *lhs, llvm::Value *rhs);
+
+    llvm::Value *create_unary(
+        core::Unary::Op op, core::Builtin val_type, llvm::Value *val);
+
+    llvm::Value *create_vector_reduce(
+        core::VectorReduce::Op op, core::Builtin elem_type, llvm::Value *vec);
+
+    Target            target_                = Target::Native;
+    bool              fast_math_             = false;
+    bool              approx_math_func_      = false;
+    bool              enable_assert_         = true;
+    MathPrecision     math_precision_        = MathPrecision::Library;
+    int               cpu_kernel_simd_width_ = 0;
+    llvm::DataLayout *data_layout_           = nullptr;
 
     LLVMData *llvm_ = nullptr;
 };
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cuj/gen/compile_stats.h>
+#include <cuj/gen/cpu_launcher.h>
+#include <cuj/gen/object_cache.h>
 #include <cuj/gen/option.h>
 
 CUJ_NAMESPACE_BEGIN(cuj::dsl)
@@ -20,14 +23,34 @@ public:
 
     MCJIT &operator=(MCJIT &&other) noexcept;
 
+    // with tiered compilation, blocks until background compilation is done
     ~MCJIT();
 
     void set_options(const Options &opts);
 
-    void generate(const dsl::Module &mod);
+    // reuse compiled objects across processes.
+    // nullptr disables object caching.
+    // with tiered compilation, the cache is also called from the background
+    // compilation thread
+    void set_object_cache(RC<ObjectCache> cache);
 
+    // with tiered compilation, returned stats describe the unoptimized code
+    CompileStats generate(const dsl::Module &mod);
+
+    // returns ir of optimized code when tiered compilation is done.
+    // empty when all objects are loaded from the object cache
     const std::string &get_llvm_string() const;
 
+    // whether optimized code is in use.
+    // always true when tiered compilation is disabled.
+    // stays false when background compilation failed
+    bool is_optimized() const;
+
+    // blocks until background compilation is done.
+    // rethrows its exception on failure, in which case unoptimized code
+    // is kept in use
+    void wait_for_optimization() const;
+
     template<typename T>
         requires std::is_function_v<T>
     T *get_function(const std::string &symbol_name) const;
@@ -40,6 +63,11 @@ public:
         requires (!std::is_function_v<Ret>)
     auto get_function(const dsl::Function<Ret(Args...)> &func) const;
 
+    // kernels take CPUBlockInfo as an extra first argument,
+    // and are launched with CPULauncher
+    template<typename Ret, typename...Args>
+    auto get_kernel(const dsl::Function<Ret(Args...)> &func) const;
+
     template<typename T>
     T *get_global_variable(const std::string &symbol_name) const;
 
@@ -57,8 +85,9 @@ private:
 
     void *get_global_variable_impl(const std::string &symbol_name) const;
 
-    Options    opts_;
-    MCJITData *llvm_data_ = nullptr;
+    Options          opts_;
+    RC<ObjectCache>  object_cache_;
+    MCJITData       *llvm_data_ = nullptr;
 };
 
 CUJ_NAMESPACE_END(cuj::gen)
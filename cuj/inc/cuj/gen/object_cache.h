@@ -0,0 +1,40 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <cuj/common.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+// storage of compiled object files.
+// keys consist of [0-9a-f] only
+class ObjectCache
+{
+public:
+
+    virtual ~ObjectCache() = default;
+
+    virtual std::optional<std::vector<char>> load(const std::string &key) = 0;
+
+    virtual void store(const std::string &key, const char *data, size_t size) = 0;
+};
+
+// store each object as <directory>/<key>.o
+class DirectoryObjectCache : public ObjectCache
+{
+public:
+
+    explicit DirectoryObjectCache(std::string directory);
+
+    std::optional<std::vector<char>> load(const std::string &key) override;
+
+    void store(const std::string &key, const char *data, size_t size) override;
+
+private:
+
+    std::string directory_;
+};
+
+CUJ_NAMESPACE_END(cuj::gen)
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 #include <cuj/common.h>
 
 CUJ_NAMESPACE_BEGIN(cuj::gen)
@@ -12,12 +14,57 @@ enum class OptimizationLevel
     O3
 };
 
+enum class MathPrecision
+{
+    Library, // c library functions
+    Precise, // in-ir implementation. error is within a few ulps
+    Fast     // in-ir implementation. relative error is about 1e-5 for f32
+             // and 1e-10 for f64
+};
+
+enum class VectorMathLibrary
+{
+    None,    // calls to math functions in vectorized loops are scalarized
+    Builtin, // vector functions defined in llvm ir by cuj
+    LibMVec  // glibc vector math library. x86-64 linux only
+};
+
 struct Options
 {
     OptimizationLevel opt_level        = OptimizationLevel::O3;
     bool              fast_math        = false;
     bool              approx_math_func = false;
 
+    // cpu name and feature string (e.g. "+avx2,+fma") of native target.
+    // empty values mean detecting them from host machine.
+    // use "generic" cpu for reproducible machine code
+    std::string native_cpu;
+    std::string native_cpu_features;
+
+    // implementation of tan, asin, acos, atan, atan2, exp10 and rsqrt on
+    // native target. in-ir implementations can be inlined and vectorized
+    MathPrecision native_math_precision = MathPrecision::Library;
+
+    // vector variants of sin, cos, exp, exp2, log, log2, log10 and pow
+    // used by loop and slp vectorizers on native target
+    VectorMathLibrary vector_math_library = VectorMathLibrary::None;
+
+    // number of lanes of kernels compiled in spmd form on native target.
+    // threads with consecutive thread_idx_x run in lanes of llvm vectors, and
+    // divergent $if/$while/$switch are executed with masks. functions are
+    // called lane by lane, and kernels containing inline asm stay scalar.
+    // 0 or 1 runs one thread per iteration of the thread loop
+    int cpu_kernel_simd_width = 0;
+
+    // number of partitions optimized and compiled in parallel by MCJIT.
+    // functions are not inlined across partitions
+    int codegen_threads = 1;
+
+    // MCJIT generates unoptimized code first, and switches to optimized
+    // code when it is compiled in background. function pointers are valid
+    // before and after the switch
+    bool tiered_compilation = false;
+
 #if defined(DEBUG) || defined(_DEBUG)
     bool enable_assert = true;
 #else
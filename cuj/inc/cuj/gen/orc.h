@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cuj/gen/mcjit.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+// jit backend based on llvm orc.
+// functions are optimized and compiled on their first call
+class OrcJIT : public Uncopyable
+{
+public:
+
+    OrcJIT() = default;
+
+    OrcJIT(OrcJIT &&other) noexcept;
+
+    OrcJIT &operator=(OrcJIT &&other) noexcept;
+
+    ~OrcJIT();
+
+    void set_options(const Options &opts);
+
+    void generate(const dsl::Module &mod);
+
+    // unoptimized llvm ir
+    const std::string &get_llvm_string() const;
+
+    template<typename T>
+        requires std::is_function_v<T>
+    T *get_function(const std::string &symbol_name) const;
+
+    template<typename T, typename Ret, typename...Args>
+        requires std::is_function_v<T>
+    T *get_function(const dsl::Function<Ret(Args...)> &func) const;
+
+    template<typename Ret, typename...Args>
+        requires (!std::is_function_v<Ret>)
+    auto get_function(const dsl::Function<Ret(Args...)> &func) const;
+
+    template<typename T>
+    T *get_global_variable(const std::string &symbol_name) const;
+
+    template<typename T>
+    auto get_global_variable(const dsl::GlobalVariable<T> &var) const;
+
+    template<typename T, typename U>
+    auto get_global_variable(const dsl::GlobalVariable<U> &var) const;
+
+private:
+
+    struct OrcJITData;
+
+    void *get_function_impl(const std::string &symbol_name) const;
+
+    void *get_global_variable_impl(const std::string &symbol_name) const;
+
+    Options     opts_;
+    OrcJITData *llvm_data_ = nullptr;
+};
+
+CUJ_NAMESPACE_END(cuj::gen)
+
+#include <cuj/gen/impl/orc.inl>
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cuj/gen/compile_stats.h>
 #include <cuj/gen/option.h>
 #include <cuj/dsl/module.h>
 
@@ -11,7 +12,7 @@ public:
 
     void set_options(const Options &opts);
 
-    void generate(const dsl::Module &mod);
+    CompileStats generate(const dsl::Module &mod);
 
     const std::string &get_llvm_ir() const;
 
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <future>
+#include <list>
+#include <map>
+#include <mutex>
+
+#include <cuj/dsl/module.h>
+#include <cuj/gen/mcjit.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+// compiled functions specialized by runtime parameters.
+// on cache miss, the tracing function is called with a private module as
+// current module and must return the dsl::Function to be compiled.
+// least recently used entries are released when capacity is exceeded,
+// invalidating function pointers returned for them.
+// tracing and compilation are done without holding the cache lock. concurrent
+// misses on the same key wait for the first one instead of compiling again
+template<typename Key, typename Signature>
+    requires std::is_function_v<Signature>
+class SpecializationCache : public Uncopyable
+{
+public:
+
+    explicit SpecializationCache(size_t capacity = 64);
+
+    void set_options(const Options &opts);
+
+    void set_object_cache(RC<ObjectCache> cache);
+
+    template<typename F>
+    Signature *get(const Key &key, F &&trace);
+
+    // nullptr when the key is not cached
+    Signature *find(const Key &key);
+
+    void set_capacity(size_t capacity);
+
+    size_t size() const;
+
+    void clear();
+
+private:
+
+    struct Entry
+    {
+        Key        key;
+        MCJIT      mcjit;
+        Signature *function = nullptr;
+    };
+
+    using EntryIterator = typename std::list<Entry>::iterator;
+
+    void shrink_to_capacity();
+
+    Options         opts_;
+    RC<ObjectCache> object_cache_;
+    size_t          capacity_;
+
+    mutable std::mutex                             mutex_;
+    std::list<Entry>                               entries_; // most recently used first
+    std::map<Key, EntryIterator>                   key_to_entry_;
+    std::map<Key, std::shared_future<Signature *>> in_flight_;
+};
+
+CUJ_NAMESPACE_END(cuj::gen)
+
+#include <cuj/gen/impl/specialization_cache.inl>
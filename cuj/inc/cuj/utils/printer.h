@@ -117,6 +117,7 @@ private:
     void print(TextBuilder &b, const core::Binary &binary);
 
     void print(TextBuilder &b, const core::Unary &unary);
+    void print(TextBuilder &b, const core::Select &select);
 
     void print(TextBuilder &b, const core::CallFunc &call);
 
@@ -124,6 +125,16 @@ private:
 
     void print(TextBuilder &b, const core::GlobalConstAddr &global_const_addr);
 
+    void print(TextBuilder &b, const core::MakeVector &make);
+
+    void print(TextBuilder &b, const core::VectorExtract &extract);
+
+    void print(TextBuilder &b, const core::VectorInsert &insert);
+
+    void print(TextBuilder &b, const core::VectorShuffle &shuffle);
+
+    void print(TextBuilder &b, const core::VectorReduce &reduce);
+
     // type
 
     void print(TextBuilder &b, const core::Type &type);
@@ -135,6 +146,8 @@ private:
     void print(TextBuilder &b, const core::Array &a);
 
     void print(TextBuilder &b, const core::Pointer &p);
+
+    void print(TextBuilder &b, const core::Vector &v);
 };
 
 template<typename...Args>
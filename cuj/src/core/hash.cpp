@@ -0,0 +1,1138 @@
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <cuj/core/hash.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::core)
+
+namespace
+{
+
+    constexpr char AUTO_FUNCTION_NAME_PREFIX[] = "__cuj_auto_function_name_";
+
+    uint64_t mix(uint64_t x)
+    {
+        x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ull;
+        x ^= x >> 27; x *= 0x94d049bb133111ebull;
+        x ^= x >> 31;
+        return x;
+    }
+
+    uint64_t combine(uint64_t seed, uint64_t value)
+    {
+        return mix(seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6)));
+    }
+
+    uint64_t hash_bytes(const void *data, size_t size)
+    {
+        // fnv-1a
+        uint64_t result = 0xcbf29ce484222325ull;
+        auto bytes = static_cast<const unsigned char *>(data);
+        for(size_t i = 0; i < size; ++i)
+        {
+            result ^= bytes[i];
+            result *= 0x100000001b3ull;
+        }
+        return mix(result ^ size);
+    }
+
+    uint64_t hash_str(const std::string &str)
+    {
+        return hash_bytes(str.data(), str.size());
+    }
+
+    uint64_t immediate_bits(const Immediate &imm)
+    {
+        return imm.value.match([](auto v)
+        {
+            uint64_t bits = 0;
+            std::memcpy(&bits, &v, sizeof(v));
+            return bits;
+        });
+    }
+
+    bool is_void(const Type *type)
+    {
+        auto builtin = type ? type->as_if<Builtin>() : nullptr;
+        return builtin && *builtin == Builtin::Void;
+    }
+
+    std::vector<const GlobalVar *> sorted_global_vars(const Prog &prog)
+    {
+        std::vector<const GlobalVar *> result;
+        for(auto &var : prog.global_vars)
+            result.push_back(var.get());
+        std::sort(result.begin(), result.end(), [](auto a, auto b)
+        {
+            return a->symbol_name < b->symbol_name;
+        });
+        return result;
+    }
+
+    // depth-first visitor of possibly recursive structs and functions.
+    // a node met again on the stack is a back reference, identified by its
+    // distance from the top of the stack. result of a node depends on the
+    // enclosing nodes only when some back reference reaches its frame or
+    // below, so other results are cached for any context, and results of
+    // top-level nodes are cached for top-level visits
+    template<typename Node, typename Result>
+    class RecursionStack
+    {
+    public:
+
+        const Result *find_cached(const Node &node) const
+        {
+            if(auto it = context_free_.find(node); it != context_free_.end())
+                return &it->second;
+            if(stack_.empty())
+            {
+                if(auto it = top_level_.find(node); it != top_level_.end())
+                    return &it->second;
+            }
+            return nullptr;
+        }
+
+        bool is_top_level() const
+        {
+            return stack_.empty();
+        }
+
+        // returns 0 when no node on the stack satisfies pred
+        template<typename Pred>
+        size_t find_back_reference(const Pred &pred)
+        {
+            for(size_t i = 0; i < stack_.size(); ++i)
+            {
+                if(pred(stack_[i]))
+                {
+                    lowest_reference_ = (std::min)(lowest_reference_, i);
+                    return stack_.size() - i;
+                }
+            }
+            return 0;
+        }
+
+        // incomplete visits (such as failed comparisons) may miss back
+        // references, so their results are not cached
+        template<typename F>
+        Result visit(const Node &node, const F &f)
+        {
+            const size_t frame = stack_.size();
+            const size_t outer_lowest_reference =
+                std::exchange(lowest_reference_, SIZE_MAX);
+
+            stack_.push_back(node);
+            auto [result, is_complete] = f();
+            stack_.pop_back();
+
+            if(is_complete)
+            {
+                if(lowest_reference_ > frame)
+                    context_free_.insert({ node, result });
+                else if(frame == 0)
+                    top_level_.insert({ node, result });
+            }
+            lowest_reference_ =
+                (std::min)(lowest_reference_, outer_lowest_reference);
+            return result;
+        }
+
+    private:
+
+        std::vector<Node>      stack_;
+        size_t                 lowest_reference_ = SIZE_MAX;
+        std::map<Node, Result> context_free_;
+        std::map<Node, Result> top_level_;
+    };
+
+    class Hasher
+    {
+    public:
+
+        uint64_t hash(const Prog &prog)
+        {
+            uint64_t result = mix(prog.funcs.size());
+            for(auto var : sorted_global_vars(prog))
+            {
+                result = combine(result, hash_str(var->symbol_name));
+                result = combine(result, static_cast<uint64_t>(var->memory_type));
+                result = combine(result, hash(var->type));
+            }
+            for(auto &func : prog.funcs)
+                result = combine(result, hash(*func));
+            return result;
+        }
+
+        uint64_t hash(const Func &func)
+        {
+            if(auto cached = funcs_.find_cached(&func))
+                return *cached;
+
+            // recursive call through contextless functions is hashed as
+            // a back reference
+
+            const size_t ref = funcs_.find_back_reference(
+                [&](const Func *f) { return f == &func; });
+            if(ref)
+                return combine(mix(0xf0), ref);
+
+            return funcs_.visit(&func, [&]
+            {
+                return std::pair{ hash_under_recursion(func), true };
+            });
+        }
+
+        uint64_t hash_under_recursion(const Func &func)
+        {
+            uint64_t result = mix(func.type);
+            result = combine(result, func.attributes);
+            if(!is_auto_function_name(func.name))
+                result = combine(result, hash_str(func.name));
+            result = combine(result, func.is_declaration);
+
+            result = combine(result, func.argument_types.size());
+            for(auto &arg : func.argument_types)
+            {
+                result = combine(result, hash(arg.type));
+                result = combine(result, arg.is_reference);
+                result = combine(result, arg.is_restrict);
+            }
+            result = combine(result, hash(func.return_type.type));
+            result = combine(result, func.return_type.is_reference);
+
+            result = combine(result, func.local_alloc_types.size());
+            for(auto type : func.local_alloc_types)
+                result = combine(result, hash(type));
+
+            if(func.root_block)
+                result = combine(result, hash(*func.root_block));
+            return result;
+        }
+
+        // statements
+
+        uint64_t hash(const Stat &s)
+        {
+            return combine(s.index(), s.match([&](auto &_s) { return hash(_s); }));
+        }
+
+        uint64_t hash(const Store &store)
+        {
+            return combine(hash(store.dst_addr), hash(store.val));
+        }
+
+        uint64_t hash(const Copy &copy)
+        {
+            return combine(hash(copy.dst_addr), hash(copy.src_addr));
+        }
+
+        uint64_t hash(const Block &block)
+        {
+            uint64_t result = mix(block.stats.size());
+            for(auto &s : block.stats)
+                result = combine(result, hash(*s));
+            return result;
+        }
+
+        uint64_t hash(const Return &ret)
+        {
+            // val is left uninitialized when returning void
+            uint64_t result = hash(ret.return_type);
+            if(!is_void(ret.return_type))
+                result = combine(result, hash(ret.val));
+            return result;
+        }
+
+        uint64_t hash(const If &stat)
+        {
+            uint64_t result = hash(stat.cond);
+            result = combine(result, static_cast<uint64_t>(stat.likelihood));
+            if(stat.calc_cond)
+                result = combine(result, hash(*stat.calc_cond));
+            result = combine(result, hash(*stat.then_body));
+            if(stat.else_body)
+                result = combine(result, hash(*stat.else_body));
+            return result;
+        }
+
+        uint64_t hash(const Loop &stat)
+        {
+            uint64_t result = hash(*stat.body);
+            result = combine(result, stat.hints.unroll_count);
+            result = combine(result, stat.hints.unroll_full);
+            result = combine(result, stat.hints.unroll_disable);
+            result = combine(result, stat.hints.vectorize_width);
+            result = combine(result, stat.hints.interleave_count);
+            result = combine(result, stat.hints.independent);
+            result = combine(result, stat.hints.trip_count_multiple);
+            return result;
+        }
+
+        uint64_t hash(const Break &)
+        {
+            return 0;
+        }
+
+        uint64_t hash(const Continue &)
+        {
+            return 0;
+        }
+
+        uint64_t hash(const Switch &stat)
+        {
+            uint64_t result = hash(stat.value);
+            for(auto &branch : stat.branches)
+            {
+                result = combine(result, hash(branch.cond));
+                result = combine(result, hash(*branch.body));
+                result = combine(result, branch.fallthrough);
+            }
+            if(stat.default_body)
+                result = combine(result, hash(*stat.default_body));
+            return result;
+        }
+
+        uint64_t hash(const CallFuncStat &call)
+        {
+            return hash(call.call_expr);
+        }
+
+        uint64_t hash(const MakeScope &make_scope)
+        {
+            return hash(*make_scope.body);
+        }
+
+        uint64_t hash(const ExitScope &)
+        {
+            return 0;
+        }
+
+        uint64_t hash(const InlineAsm &inline_asm)
+        {
+            uint64_t result = hash_str(inline_asm.asm_string);
+            result = combine(result, inline_asm.side_effects);
+            result = combine(result, inline_asm.input_values.size());
+            for(auto &e : inline_asm.input_values)
+                result = combine(result, hash(e));
+            result = combine(result, inline_asm.output_addresses.size());
+            for(auto &e : inline_asm.output_addresses)
+                result = combine(result, hash(e));
+            result = combine(result, hash_str(inline_asm.input_constraints));
+            result = combine(result, hash_str(inline_asm.output_constraints));
+            result = combine(result, hash_str(inline_asm.clobber_constraints));
+            return result;
+        }
+
+        // expressions
+
+        uint64_t hash(const Expr &e)
+        {
+            return combine(e.index(), e.match([&](auto &_e) { return hash(_e); }));
+        }
+
+        uint64_t hash(const FuncArgAddr &addr)
+        {
+            return combine(hash(addr.addr_type), addr.arg_index);
+        }
+
+        uint64_t hash(const LocalAllocAddr &addr)
+        {
+            return combine(hash(addr.alloc_type), addr.alloc_index);
+        }
+
+        uint64_t hash(const Load &load)
+        {
+            return combine(hash(load.val_type), hash(*load.src_addr));
+        }
+
+        uint64_t hash(const Immediate &imm)
+        {
+            return combine(imm.value.index(), immediate_bits(imm));
+        }
+
+        uint64_t hash(const NullPtr &null_ptr)
+        {
+            return hash(null_ptr.ptr_type);
+        }
+
+        uint64_t hash(const ArithmeticCast &cast)
+        {
+            uint64_t result = hash(cast.dst_type);
+            result = combine(result, hash(cast.src_type));
+            return combine(result, hash(*cast.src_val));
+        }
+
+        uint64_t hash(const BitwiseCast &cast)
+        {
+            uint64_t result = hash(cast.dst_type);
+            result = combine(result, hash(cast.src_type));
+            return combine(result, hash(*cast.src_val));
+        }
+
+        uint64_t hash(const PointerOffset &ptr_offset)
+        {
+            uint64_t result = hash(ptr_offset.ptr_type);
+            result = combine(result, hash(ptr_offset.offset_type));
+            result = combine(result, hash(*ptr_offset.ptr_val));
+            result = combine(result, hash(*ptr_offset.offset_val));
+            return combine(result, ptr_offset.negative);
+        }
+
+        uint64_t hash(const ClassPointerToMemberPointer &mem)
+        {
+            uint64_t result = hash(mem.class_ptr_type);
+            result = combine(result, hash(mem.member_ptr_type));
+            result = combine(result, hash(*mem.class_ptr));
+            return combine(result, mem.member_index);
+        }
+
+        uint64_t hash(const DerefClassPointer &deref)
+        {
+            return combine(hash(deref.class_ptr_type), hash(*deref.class_ptr));
+        }
+
+        uint64_t hash(const DerefArrayPointer &deref)
+        {
+            return combine(hash(deref.array_ptr_type), hash(*deref.array_ptr));
+        }
+
+        uint64_t hash(const SaveClassIntoLocalAlloc &save)
+        {
+            return combine(hash(save.class_ptr_type), hash(*save.class_val));
+        }
+
+        uint64_t hash(const SaveArrayIntoLocalAlloc &save)
+        {
+            return combine(hash(save.array_ptr_type), hash(*save.array_val));
+        }
+
+        uint64_t hash(const ArrayAddrToFirstElemAddr &to)
+        {
+            return combine(hash(to.array_ptr_type), hash(*to.array_ptr));
+        }
+
+        uint64_t hash(const Binary &binary)
+        {
+            uint64_t result = mix(static_cast<uint64_t>(binary.op));
+            result = combine(result, hash(*binary.lhs));
+            result = combine(result, hash(*binary.rhs));
+            result = combine(result, hash(binary.lhs_type));
+            return combine(result, hash(binary.rhs_type));
+        }
+
+        uint64_t hash(const Unary &unary)
+        {
+            uint64_t result = mix(static_cast<uint64_t>(unary.op));
+            result = combine(result, hash(*unary.val));
+            return combine(result, hash(unary.val_type));
+        }
+
+        uint64_t hash(const Select &select)
+        {
+            uint64_t result = hash(select.cond_type);
+            result = combine(result, hash(select.val_type));
+            result = combine(result, hash(*select.cond));
+            result = combine(result, hash(*select.true_val));
+            return combine(result, hash(*select.false_val));
+        }
+
+        uint64_t hash(const CallFunc &call)
+        {
+            uint64_t result = mix(static_cast<uint64_t>(call.intrinsic));
+            if(call.contextless_func)
+                result = combine(result, hash(*call.contextless_func));
+            else
+                result = combine(result, call.contexted_func_index);
+            result = combine(result, call.args.size());
+            for(auto &arg : call.args)
+                result = combine(result, hash(*arg));
+            return result;
+        }
+
+        uint64_t hash(const GlobalVarAddr &addr)
+        {
+            uint64_t result = hash_str(addr.var->symbol_name);
+            result = combine(result, static_cast<uint64_t>(addr.var->memory_type));
+            return combine(result, hash(addr.var->type));
+        }
+
+        uint64_t hash(const GlobalConstAddr &global_const)
+        {
+            uint64_t result = hash(global_const.pointed_type);
+            result = combine(result, global_const.alignment);
+            return combine(result, hash_bytes(
+                global_const.data.data(), global_const.data.size()));
+        }
+
+        uint64_t hash(const MakeVector &make)
+        {
+            uint64_t result = hash(make.vector_type);
+            result = combine(result, make.elements.size());
+            for(auto &elem : make.elements)
+                result = combine(result, hash(*elem));
+            return result;
+        }
+
+        uint64_t hash(const VectorExtract &extract)
+        {
+            uint64_t result = hash(extract.vector_type);
+            result = combine(result, hash(*extract.vector));
+            return combine(result, hash(*extract.index));
+        }
+
+        uint64_t hash(const VectorInsert &insert)
+        {
+            uint64_t result = hash(insert.vector_type);
+            result = combine(result, hash(*insert.vector));
+            result = combine(result, hash(*insert.index));
+            return combine(result, hash(*insert.element));
+        }
+
+        uint64_t hash(const VectorShuffle &shuffle)
+        {
+            uint64_t result = hash(shuffle.dst_type);
+            result = combine(result, hash(shuffle.src_type));
+            result = combine(result, hash(*shuffle.lhs));
+            result = combine(result, hash(*shuffle.rhs));
+            for(int index : shuffle.indices)
+                result = combine(result, static_cast<uint64_t>(index));
+            return result;
+        }
+
+        uint64_t hash(const VectorReduce &reduce)
+        {
+            uint64_t result = mix(static_cast<uint64_t>(reduce.op));
+            result = combine(result, hash(reduce.vector_type));
+            return combine(result, hash(*reduce.vector));
+        }
+
+        // types
+
+        uint64_t hash(const Type *type)
+        {
+            if(!type)
+                return mix(0xe0);
+
+            return combine(type->index(), type->match(
+                [&](Builtin builtin)
+            {
+                return mix(static_cast<uint64_t>(builtin));
+            },
+                [&](const Struct &s)
+            {
+                if(auto cached = structs_.find_cached(type))
+                    return *cached;
+
+                // recursive struct is hashed as a back reference
+                const size_t ref = structs_.find_back_reference(
+                    [&](const Type *t) { return t == type; });
+                if(ref)
+                    return combine(mix(0xd0), ref);
+
+                return structs_.visit(type, [&]
+                {
+                    uint64_t ret = mix(s.custom_alignment);
+                    ret = combine(ret, s.members.size());
+                    for(auto member : s.members)
+                        ret = combine(ret, hash(member));
+                    return std::pair{ ret, true };
+                });
+            },
+                [&](const Array &a)
+            {
+                return combine(hash(a.element), a.size);
+            },
+                [&](const Pointer &p)
+            {
+                return hash(p.pointed);
+            },
+                [&](const Vector &v)
+            {
+                return combine(hash(v.element), v.size);
+            }));
+        }
+
+    private:
+
+        RecursionStack<const Type *, uint64_t> structs_;
+        RecursionStack<const Func *, uint64_t> funcs_;
+    };
+
+    class Comparer
+    {
+    public:
+
+        bool equal(const Prog &a, const Prog &b)
+        {
+            if(a.funcs.size() != b.funcs.size() ||
+               a.global_vars.size() != b.global_vars.size())
+                return false;
+
+            auto vars_a = sorted_global_vars(a);
+            auto vars_b = sorted_global_vars(b);
+            for(size_t i = 0; i < vars_a.size(); ++i)
+            {
+                if(!equal(*vars_a[i], *vars_b[i]))
+                    return false;
+            }
+
+            for(size_t i = 0; i < a.funcs.size(); ++i)
+            {
+                if(!equal(*a.funcs[i], *b.funcs[i]))
+                    return false;
+            }
+            return true;
+        }
+
+        bool equal(const Func &a, const Func &b)
+        {
+            const std::pair key = { &a, &b };
+            if(auto cached = funcs_.find_cached(key))
+                return *cached;
+
+            // recursive calls through contextless functions are equal when
+            // they refer back to the same depth, as they are hashed
+
+            const size_t ref_a = funcs_.find_back_reference(
+                [&](const auto &p) { return p.first == &a; });
+            const size_t ref_b = funcs_.find_back_reference(
+                [&](const auto &p) { return p.second == &b; });
+            if(ref_a || ref_b)
+                return ref_a == ref_b;
+
+            // functions reaching enclosing ones must be compared even if
+            // they are the same
+            if(&a == &b && funcs_.is_top_level())
+                return true;
+
+            return funcs_.visit(key, [&]
+            {
+                const bool ret = equal_under_recursion(a, b);
+                return std::pair{ ret, ret };
+            });
+        }
+
+        bool equal_under_recursion(const Func &a, const Func &b)
+        {
+            if(a.type != b.type || a.is_declaration != b.is_declaration ||
+               a.attributes != b.attributes)
+                return false;
+
+            const bool is_auto_a = is_auto_function_name(a.name);
+            const bool is_auto_b = is_auto_function_name(b.name);
+            if(is_auto_a != is_auto_b || (!is_auto_a && a.name != b.name))
+                return false;
+
+            if(a.argument_types.size() != b.argument_types.size())
+                return false;
+            for(size_t i = 0; i < a.argument_types.size(); ++i)
+            {
+                if(!equal(a.argument_types[i], b.argument_types[i]))
+                    return false;
+            }
+            if(!equal(a.return_type, b.return_type))
+                return false;
+
+            if(a.local_alloc_types.size() != b.local_alloc_types.size())
+                return false;
+            for(size_t i = 0; i < a.local_alloc_types.size(); ++i)
+            {
+                if(!equal(a.local_alloc_types[i], b.local_alloc_types[i]))
+                    return false;
+            }
+
+            return equal(a.root_block, b.root_block);
+        }
+
+        // statements
+
+        bool equal(const Stat &a, const Stat &b)
+        {
+            if(a.index() != b.index())
+                return false;
+            return a.match([&]<typename T>(const T &_a)
+            {
+                return equal(_a, b.as<T>());
+            });
+        }
+
+        bool equal(const Store &a, const Store &b)
+        {
+            return equal(a.dst_addr, b.dst_addr) && equal(a.val, b.val);
+        }
+
+        bool equal(const Copy &a, const Copy &b)
+        {
+            return equal(a.dst_addr, b.dst_addr) &&
+                   equal(a.src_addr, b.src_addr);
+        }
+
+        bool equal(const Block &a, const Block &b)
+        {
+            if(a.stats.size() != b.stats.size())
+                return false;
+            for(size_t i = 0; i < a.stats.size(); ++i)
+            {
+                if(!equal(*a.stats[i], *b.stats[i]))
+                    return false;
+            }
+            return true;
+        }
+
+        bool equal(const Return &a, const Return &b)
+        {
+            if(!equal(a.return_type, b.return_type))
+                return false;
+            return is_void(a.return_type) || equal(a.val, b.val);
+        }
+
+        bool equal(const If &a, const If &b)
+        {
+            return a.likelihood == b.likelihood &&
+                   equal(a.calc_cond, b.calc_cond) &&
+                   equal(a.cond, b.cond) &&
+                   equal(a.then_body, b.then_body) &&
+                   equal(a.else_body, b.else_body);
+        }
+
+        bool equal(const Loop &a, const Loop &b)
+        {
+            return a.hints == b.hints && equal(a.body, b.body);
+        }
+
+        bool equal(const Break &, const Break &)
+        {
+            return true;
+        }
+
+        bool equal(const Continue &, const Continue &)
+        {
+            return true;
+        }
+
+        bool equal(const Switch &a, const Switch &b)
+        {
+            if(!equal(a.value, b.value) ||
+               a.branches.size() != b.branches.size())
+                return false;
+            for(size_t i = 0; i < a.branches.size(); ++i)
+            {
+                auto &ba = a.branches[i], &bb = b.branches[i];
+                if(!equal(ba.cond, bb.cond) ||
+                   !equal(ba.body, bb.body) ||
+                   ba.fallthrough != bb.fallthrough)
+                    return false;
+            }
+            return equal(a.default_body, b.default_body);
+        }
+
+        bool equal(const CallFuncStat &a, const CallFuncStat &b)
+        {
+            return equal(a.call_expr, b.call_expr);
+        }
+
+        bool equal(const MakeScope &a, const MakeScope &b)
+        {
+            return equal(a.body, b.body);
+        }
+
+        bool equal(const ExitScope &, const ExitScope &)
+        {
+            return true;
+        }
+
+        bool equal(const InlineAsm &a, const InlineAsm &b)
+        {
+            return a.asm_string          == b.asm_string &&
+                   a.side_effects        == b.side_effects &&
+                   a.input_constraints   == b.input_constraints &&
+                   a.output_constraints  == b.output_constraints &&
+                   a.clobber_constraints == b.clobber_constraints &&
+                   equal(a.input_values, b.input_values) &&
+                   equal(a.output_addresses, b.output_addresses);
+        }
+
+        // expressions
+
+        bool equal(const Expr &a, const Expr &b)
+        {
+            if(a.index() != b.index())
+                return false;
+            return a.match([&]<typename T>(const T &_a)
+            {
+                return equal(_a, b.as<T>());
+            });
+        }
+
+        bool equal(const FuncArgAddr &a, const FuncArgAddr &b)
+        {
+            return a.arg_index == b.arg_index &&
+                   equal(a.addr_type, b.addr_type);
+        }
+
+        bool equal(const LocalAllocAddr &a, const LocalAllocAddr &b)
+        {
+            return a.alloc_index == b.alloc_index &&
+                   equal(a.alloc_type, b.alloc_type);
+        }
+
+        bool equal(const Load &a, const Load &b)
+        {
+            return equal(a.val_type, b.val_type) &&
+                   equal(a.src_addr, b.src_addr);
+        }
+
+        bool equal(const Immediate &a, const Immediate &b)
+        {
+            // compare bit patterns so that nan and signed zeros are
+            // distinguished like the generated code does
+            return a.value.index() == b.value.index() &&
+                   immediate_bits(a) == immediate_bits(b);
+        }
+
+        bool equal(const NullPtr &a, const NullPtr &b)
+        {
+            return equal(a.ptr_type, b.ptr_type);
+        }
+
+        bool equal(const ArithmeticCast &a, const ArithmeticCast &b)
+        {
+            return equal(a.dst_type, b.dst_type) &&
+                   equal(a.src_type, b.src_type) &&
+                   equal(a.src_val, b.src_val);
+        }
+
+        bool equal(const BitwiseCast &a, const BitwiseCast &b)
+        {
+            return equal(a.dst_type, b.dst_type) &&
+                   equal(a.src_type, b.src_type) &&
+                   equal(a.src_val, b.src_val);
+        }
+
+        bool equal(const PointerOffset &a, const PointerOffset &b)
+        {
+            return a.negative == b.negative &&
+                   equal(a.ptr_type, b.ptr_type) &&
+                   equal(a.offset_type, b.offset_type) &&
+                   equal(a.ptr_val, b.ptr_val) &&
+                   equal(a.offset_val, b.offset_val);
+        }
+
+        bool equal(
+            const ClassPointerToMemberPointer &a,
+            const ClassPointerToMemberPointer &b)
+        {
+            return a.member_index == b.member_index &&
+                   equal(a.class_ptr_type, b.class_ptr_type) &&
+                   equal(a.member_ptr_type, b.member_ptr_type) &&
+                   equal(a.class_ptr, b.class_ptr);
+        }
+
+        bool equal(const DerefClassPointer &a, const DerefClassPointer &b)
+        {
+            return equal(a.class_ptr_type, b.class_ptr_type) &&
+                   equal(a.class_ptr, b.class_ptr);
+        }
+
+        bool equal(const DerefArrayPointer &a, const DerefArrayPointer &b)
+        {
+            return equal(a.array_ptr_type, b.array_ptr_type) &&
+                   equal(a.array_ptr, b.array_ptr);
+        }
+
+        bool equal(
+            const SaveClassIntoLocalAlloc &a, const SaveClassIntoLocalAlloc &b)
+        {
+            return equal(a.class_ptr_type, b.class_ptr_type) &&
+                   equal(a.class_val, b.class_val);
+        }
+
+        bool equal(
+            const SaveArrayIntoLocalAlloc &a, const SaveArrayIntoLocalAlloc &b)
+        {
+            return equal(a.array_ptr_type, b.array_ptr_type) &&
+                   equal(a.array_val, b.array_val);
+        }
+
+        bool equal(
+            const ArrayAddrToFirstElemAddr &a, const ArrayAddrToFirstElemAddr &b)
+        {
+            return equal(a.array_ptr_type, b.array_ptr_type) &&
+                   equal(a.array_ptr, b.array_ptr);
+        }
+
+        bool equal(const Binary &a, const Binary &b)
+        {
+            return a.op == b.op &&
+                   equal(a.lhs_type, b.lhs_type) &&
+                   equal(a.rhs_type, b.rhs_type) &&
+                   equal(a.lhs, b.lhs) &&
+                   equal(a.rhs, b.rhs);
+        }
+
+        bool equal(const Unary &a, const Unary &b)
+        {
+            return a.op == b.op &&
+                   equal(a.val_type, b.val_type) &&
+                   equal(a.val, b.val);
+        }
+
+        bool equal(const Select &a, const Select &b)
+        {
+            return equal(a.cond_type, b.cond_type) &&
+                   equal(a.val_type, b.val_type) &&
+                   equal(a.cond, b.cond) &&
+                   equal(a.true_val, b.true_val) &&
+                   equal(a.false_val, b.false_val);
+        }
+
+        bool equal(const CallFunc &a, const CallFunc &b)
+        {
+            if(a.intrinsic != b.intrinsic ||
+               a.contexted_func_index != b.contexted_func_index ||
+               !equal(a.contextless_func, b.contextless_func) ||
+               a.args.size() != b.args.size())
+                return false;
+            for(size_t i = 0; i < a.args.size(); ++i)
+            {
+                if(!equal(*a.args[i], *b.args[i]))
+                    return false;
+            }
+            return true;
+        }
+
+        bool equal(const GlobalVarAddr &a, const GlobalVarAddr &b)
+        {
+            return equal(*a.var, *b.var);
+        }
+
+        bool equal(const GlobalConstAddr &a, const GlobalConstAddr &b)
+        {
+            return a.alignment == b.alignment &&
+                   a.data      == b.data &&
+                   equal(a.pointed_type, b.pointed_type);
+        }
+
+        bool equal(const MakeVector &a, const MakeVector &b)
+        {
+            if(!equal(a.vector_type, b.vector_type) ||
+               a.elements.size() != b.elements.size())
+                return false;
+            for(size_t i = 0; i < a.elements.size(); ++i)
+            {
+                if(!equal(*a.elements[i], *b.elements[i]))
+                    return false;
+            }
+            return true;
+        }
+
+        bool equal(const VectorExtract &a, const VectorExtract &b)
+        {
+            return equal(a.vector_type, b.vector_type) &&
+                   equal(a.vector, b.vector) &&
+                   equal(a.index, b.index);
+        }
+
+        bool equal(const VectorInsert &a, const VectorInsert &b)
+        {
+            return equal(a.vector_type, b.vector_type) &&
+                   equal(a.vector, b.vector) &&
+                   equal(a.index, b.index) &&
+                   equal(a.element, b.element);
+        }
+
+        bool equal(const VectorShuffle &a, const VectorShuffle &b)
+        {
+            return a.indices == b.indices &&
+                   equal(a.dst_type, b.dst_type) &&
+                   equal(a.src_type, b.src_type) &&
+                   equal(a.lhs, b.lhs) &&
+                   equal(a.rhs, b.rhs);
+        }
+
+        bool equal(const VectorReduce &a, const VectorReduce &b)
+        {
+            return a.op == b.op &&
+                   equal(a.vector_type, b.vector_type) &&
+                   equal(a.vector, b.vector);
+        }
+
+        // types
+
+        bool equal(const Type *a, const Type *b)
+        {
+            if(a == b && structs_.is_top_level())
+                return true;
+            if(!a || !b || a->index() != b->index())
+                return false;
+
+            return a->match(
+                [&](Builtin builtin)
+            {
+                return builtin == b->as<Builtin>();
+            },
+                [&](const Struct &sa)
+            {
+                const std::pair key = { a, b };
+                if(auto cached = structs_.find_cached(key))
+                    return *cached;
+
+                // recursive structs are equal when they refer back to the
+                // same depth, as they are hashed
+                const size_t ref_a = structs_.find_back_reference(
+                    [&](const auto &p) { return p.first == a; });
+                const size_t ref_b = structs_.find_back_reference(
+                    [&](const auto &p) { return p.second == b; });
+                if(ref_a || ref_b)
+                    return ref_a == ref_b;
+
+                return structs_.visit(key, [&]
+                {
+                    auto &sb = b->as<Struct>();
+                    bool ret = sa.custom_alignment == sb.custom_alignment &&
+                               sa.members.size() == sb.members.size();
+                    for(size_t i = 0; ret && i < sa.members.size(); ++i)
+                        ret = equal(sa.members[i], sb.members[i]);
+                    return std::pair{ ret, ret };
+                });
+            },
+                [&](const Array &aa)
+            {
+                auto &ab = b->as<Array>();
+                return aa.size == ab.size && equal(aa.element, ab.element);
+            },
+                [&](const Pointer &pa)
+            {
+                return equal(pa.pointed, b->as<Pointer>().pointed);
+            },
+                [&](const Vector &va)
+            {
+                auto &vb = b->as<Vector>();
+                return va.size == vb.size && equal(va.element, vb.element);
+            });
+        }
+
+    private:
+
+        bool equal(const GlobalVar &a, const GlobalVar &b)
+        {
+            return a.symbol_name == b.symbol_name &&
+                   a.memory_type == b.memory_type &&
+                   equal(a.type, b.type);
+        }
+
+        bool equal(const Func::Argument &a, const Func::Argument &b)
+        {
+            return a.is_reference == b.is_reference &&
+                   a.is_restrict == b.is_restrict &&
+                   equal(a.type, b.type);
+        }
+
+        bool equal(const std::vector<Expr> &a, const std::vector<Expr> &b)
+        {
+            if(a.size() != b.size())
+                return false;
+            for(size_t i = 0; i < a.size(); ++i)
+            {
+                if(!equal(a[i], b[i]))
+                    return false;
+            }
+            return true;
+        }
+
+        template<typename T>
+        bool equal(const RC<T> &a, const RC<T> &b)
+        {
+            if(!a || !b)
+                return !a && !b;
+            return equal(*a, *b);
+        }
+
+        template<typename T>
+        using PairStack = RecursionStack<std::pair<const T *, const T *>, bool>;
+
+        PairStack<Type> structs_;
+        PairStack<Func> funcs_;
+    };
+
+} // namespace anonymous
+
+uint64_t structural_hash(const Prog &prog)
+{
+    return Hasher().hash(prog);
+}
+
+uint64_t structural_hash(const Func &func)
+{
+    return Hasher().hash(func);
+}
+
+uint64_t structural_hash(const Block &block)
+{
+    return Hasher().hash(block);
+}
+
+uint64_t structural_hash(const Stat &stat)
+{
+    return Hasher().hash(stat);
+}
+
+uint64_t structural_hash(const Expr &expr)
+{
+    return Hasher().hash(expr);
+}
+
+uint64_t structural_hash(const GlobalConstAddr &global_const)
+{
+    return Hasher().hash(global_const);
+}
+
+uint64_t structural_hash(const Type *type)
+{
+    return Hasher().hash(type);
+}
+
+bool structural_equal(const Prog &a, const Prog &b)
+{
+    return Comparer().equal(a, b);
+}
+
+bool structural_equal(const Func &a, const Func &b)
+{
+    return Comparer().equal(a, b);
+}
+
+bool structural_equal(const Block &a, const Block &b)
+{
+    return Comparer().equal(a, b);
+}
+
+bool structural_equal(const Stat &a, const Stat &b)
+{
+    return Comparer().equal(a, b);
+}
+
+bool structural_equal(const Expr &a, const Expr &b)
+{
+    return Comparer().equal(a, b);
+}
+
+bool structural_equal(const GlobalConstAddr &a, const GlobalConstAddr &b)
+{
+    return Comparer().equal(a, b);
+}
+
+bool structural_equal(const Type *a, const Type *b)
+{
+    return Comparer().equal(a, b);
+}
+
+bool is_auto_function_name(const std::string &name)
+{
+    return name.starts_with(AUTO_FUNCTION_NAME_PREFIX);
+}
+
+CUJ_NAMESPACE_END(cuj::core)
@@ -49,4 +49,17 @@ bool Pointer::operator==(const Pointer &rhs) const
     return *pointed == *rhs.pointed;
 }
 
+std::strong_ordering Vector::operator<=>(const Vector &rhs) const
+{
+    const std::strong_ordering elem_comp = *element <=> *rhs.element;
+    if(elem_comp != std::strong_ordering::equal)
+        return elem_comp;
+    return size <=> rhs.size;
+}
+
+bool Vector::operator==(const Vector &rhs) const
+{
+    return *element == *rhs.element && size == rhs.size;
+}
+
 CUJ_NAMESPACE_END(cuj::core)
@@ -230,6 +230,15 @@ void Visitor::visit(const Unary &expr)
     visit(*expr.val);
 }
 
+void Visitor::visit(const Select &expr)
+{
+    if(on_select)
+        on_select(expr);
+    visit(*expr.cond);
+    visit(*expr.true_val);
+    visit(*expr.false_val);
+}
+
 void Visitor::visit(const CallFunc &expr)
 {
     if(on_call_func)
@@ -250,4 +259,44 @@ void Visitor::visit(const GlobalConstAddr &expr)
         on_global_const_addr(expr);
 }
 
+void Visitor::visit(const MakeVector &expr)
+{
+    if(on_make_vector)
+        on_make_vector(expr);
+    for(auto &elem : expr.elements)
+        visit(*elem);
+}
+
+void Visitor::visit(const VectorExtract &expr)
+{
+    if(on_vector_extract)
+        on_vector_extract(expr);
+    visit(*expr.vector);
+    visit(*expr.index);
+}
+
+void Visitor::visit(const VectorInsert &expr)
+{
+    if(on_vector_insert)
+        on_vector_insert(expr);
+    visit(*expr.vector);
+    visit(*expr.index);
+    visit(*expr.element);
+}
+
+void Visitor::visit(const VectorShuffle &expr)
+{
+    if(on_vector_shuffle)
+        on_vector_shuffle(expr);
+    visit(*expr.lhs);
+    visit(*expr.rhs);
+}
+
+void Visitor::visit(const VectorReduce &expr)
+{
+    if(on_vector_reduce)
+        on_vector_reduce(expr);
+    visit(*expr.vector);
+}
+
 CUJ_NAMESPACE_END(cuj::core)
@@ -2,73 +2,133 @@
 
 CUJ_NAMESPACE_BEGIN(cuj::cstd)
 
-i32 atomic_add(ptr<i32> dst, i32 val)
+namespace
 {
-    return i32::_from_expr(core::CallFunc{
-        .intrinsic = core::Intrinsic::atomic_add_i32,
-        .args = {
-            newRC<core::Expr>(dst._load()),
-            newRC<core::Expr>(val._load())
-        }
-    });
-}
 
-u32 atomic_add(ptr<u32> dst, u32 val)
-{
-    return u32::_from_expr(core::CallFunc{
-        .intrinsic = core::Intrinsic::atomic_add_u32,
-        .args = {
-            newRC<core::Expr>(dst._load()),
-            newRC<core::Expr>(val._load())
-        }
-    });
-}
+    core::CallFunc make_atomic_call(
+        core::Intrinsic             intrinsic,
+        std::vector<RC<core::Expr>> args,
+        MemoryOrder                 order,
+        MemoryScope                 scope)
+    {
+        args.push_back(newRC<core::Expr>(core::Immediate{
+            .value = static_cast<int32_t>(order) }));
+        args.push_back(newRC<core::Expr>(core::Immediate{
+            .value = static_cast<int32_t>(scope) }));
+        return core::CallFunc{
+            .intrinsic = intrinsic,
+            .args      = std::move(args)
+        };
+    }
 
-f32 atomic_add(ptr<f32> dst, f32 val)
-{
-    return f32::_from_expr(core::CallFunc{
-        .intrinsic = core::Intrinsic::atomic_add_f32,
-        .args = {
-            newRC<core::Expr>(dst._load()),
-            newRC<core::Expr>(val._load())
-        }
-    });
-}
+    template<typename R, typename...Args>
+    R call_atomic(
+        core::Intrinsic intrinsic,
+        MemoryOrder     order,
+        MemoryScope     scope,
+        const Args &... args)
+    {
+        return R::_from_expr(make_atomic_call(
+            intrinsic, { newRC<core::Expr>(args._load())... }, order, scope));
+    }
 
-i32 atomic_cmpxchg(ptr<i32> addr, i32 cmp, i32 new_val)
-{
-    return i32::_from_expr(core::CallFunc{
-        .intrinsic = core::Intrinsic::cmpxchg_i32,
-        .args = {
-            newRC<core::Expr>(addr._load()),
-            newRC<core::Expr>(cmp._load()),
-            newRC<core::Expr>(new_val._load())
-        }
-    });
-}
+    template<typename...Args>
+    void append_atomic(
+        core::Intrinsic intrinsic,
+        MemoryOrder     order,
+        MemoryScope     scope,
+        const Args &... args)
+    {
+        dsl::FunctionContext::get_func_context()->append_statement(
+            core::CallFuncStat{
+                .call_expr = make_atomic_call(
+                    intrinsic, { newRC<core::Expr>(args._load())... },
+                    order, scope)
+            });
+    }
 
-u32 atomic_cmpxchg(ptr<u32> addr, u32 cmp, u32 new_val)
-{
-    return u32::_from_expr(core::CallFunc{
-        .intrinsic = core::Intrinsic::cmpxchg_u32,
-        .args = {
-            newRC<core::Expr>(addr._load()),
-            newRC<core::Expr>(cmp._load()),
-            newRC<core::Expr>(new_val._load())
-        }
-    });
-}
+    template<typename T>
+    num<T> atomic_load_impl(
+        const ptr<num<T>> &addr, MemoryOrder order, MemoryScope scope)
+    {
+        if(order == MemoryOrder::Release || order == MemoryOrder::AcqRel)
+            throw CujException("invalid memory order for atomic load");
+        return call_atomic<num<T>>(
+            core::Intrinsic::atomic_load, order, scope, addr);
+    }
+
+    template<typename T>
+    void atomic_store_impl(
+        const ptr<num<T>> &addr, const num<T> &val,
+        MemoryOrder order, MemoryScope scope)
+    {
+        if(order == MemoryOrder::Acquire || order == MemoryOrder::AcqRel)
+            throw CujException("invalid memory order for atomic store");
+        append_atomic(core::Intrinsic::atomic_store, order, scope, addr, val);
+    }
+
+} // namespace anonymous
+
+#define CUJ_DEFINE_LOAD_STORE(T)                                                \
+    T atomic_load(ptr<T> addr, MemoryOrder order, MemoryScope scope)            \
+    {                                                                           \
+        return atomic_load_impl(addr, order, scope);                            \
+    }                                                                           \
+    void atomic_store(ptr<T> addr, T val, MemoryOrder order, MemoryScope scope) \
+    {                                                                           \
+        atomic_store_impl(addr, val, order, scope);                             \
+    }
+
+#define CUJ_DEFINE_RMW(NAME, T, INTRINSIC)                                      \
+    T NAME(ptr<T> dst, T val, MemoryOrder order, MemoryScope scope)             \
+    {                                                                           \
+        return call_atomic<T>(                                                  \
+            core::Intrinsic::INTRINSIC, order, scope, dst, val);                \
+    }
+
+#define CUJ_DEFINE_CMPXCHG(T)                                                   \
+    T atomic_cmpxchg(                                                           \
+        ptr<T> addr, T cmp, T new_val, MemoryOrder order, MemoryScope scope)    \
+    {                                                                           \
+        return call_atomic<T>(                                                  \
+            core::Intrinsic::atomic_cmpxchg, order, scope, addr, cmp, new_val); \
+    }
+
+#define CUJ_DEFINE_INTEGER_ATOMICS(T, SIGN)                                     \
+    CUJ_DEFINE_LOAD_STORE(T)                                                    \
+    CUJ_DEFINE_CMPXCHG(T)                                                       \
+    CUJ_DEFINE_RMW(atomic_exchange, T, atomic_exchange)                         \
+    CUJ_DEFINE_RMW(atomic_add,      T, atomic_add)                              \
+    CUJ_DEFINE_RMW(atomic_min,      T, atomic_min_##SIGN)                       \
+    CUJ_DEFINE_RMW(atomic_max,      T, atomic_max_##SIGN)                       \
+    CUJ_DEFINE_RMW(atomic_and,      T, atomic_and)                              \
+    CUJ_DEFINE_RMW(atomic_or,       T, atomic_or)                               \
+    CUJ_DEFINE_RMW(atomic_xor,      T, atomic_xor)
+
+#define CUJ_DEFINE_FLOAT_ATOMICS(T)                                             \
+    CUJ_DEFINE_LOAD_STORE(T)                                                    \
+    CUJ_DEFINE_RMW(atomic_exchange, T, atomic_exchange)                         \
+    CUJ_DEFINE_RMW(atomic_add,      T, atomic_fadd)
+
+CUJ_DEFINE_INTEGER_ATOMICS(i32, s)
+CUJ_DEFINE_INTEGER_ATOMICS(u32, u)
+CUJ_DEFINE_INTEGER_ATOMICS(i64, s)
+CUJ_DEFINE_INTEGER_ATOMICS(u64, u)
+
+CUJ_DEFINE_FLOAT_ATOMICS(f32)
+CUJ_DEFINE_FLOAT_ATOMICS(f64)
+
+#undef CUJ_DEFINE_LOAD_STORE
+#undef CUJ_DEFINE_RMW
+#undef CUJ_DEFINE_CMPXCHG
+#undef CUJ_DEFINE_INTEGER_ATOMICS
+#undef CUJ_DEFINE_FLOAT_ATOMICS
 
-u64 atomic_cmpxchg(ptr<u64> addr, u64 cmp, u64 new_val)
+void atomic_fence(MemoryOrder order, MemoryScope scope)
 {
-    return u64::_from_expr(core::CallFunc{
-        .intrinsic = core::Intrinsic::cmpxchg_u64,
-        .args = {
-            newRC<core::Expr>(addr._load()),
-            newRC<core::Expr>(cmp._load()),
-            newRC<core::Expr>(new_val._load())
-        }
-    });
+    if(order == MemoryOrder::Relaxed)
+        throw CujException("invalid memory order for atomic fence");
+    append_atomic(core::Intrinsic::atomic_fence, order, scope);
 }
 
 CUJ_NAMESPACE_END(cuj::cstd)
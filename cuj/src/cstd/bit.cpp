@@ -0,0 +1,104 @@
+#include <cuj/cstd/bit.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::cstd)
+
+namespace
+{
+
+    template<typename R, typename...Args>
+    R call_intrinsic(core::Intrinsic intrinsic, const Args &...args)
+    {
+        return R::_from_expr(core::CallFunc{
+            .intrinsic = intrinsic,
+            .args      = { newRC<core::Expr>(args._load())... }
+        });
+    }
+
+    // the counting intrinsics return a value of the operand type
+    template<typename T>
+    i32 count_bits(core::Intrinsic intrinsic, const num<T> &x)
+    {
+        return i32(call_intrinsic<num<T>>(intrinsic, x));
+    }
+
+    template<typename T>
+    num<T> rotate(core::Intrinsic intrinsic, const num<T> &x, const i32 &n)
+    {
+        return call_intrinsic<num<T>>(intrinsic, x, num<T>(n));
+    }
+
+    template<typename T>
+    num<T> binary(
+        core::Intrinsic signed_intrinsic,
+        core::Intrinsic unsigned_intrinsic,
+        const num<T>   &a,
+        const num<T>   &b)
+    {
+        return call_intrinsic<num<T>>(
+            std::is_signed_v<T> ? signed_intrinsic : unsigned_intrinsic, a, b);
+    }
+
+} // namespace anonymous
+
+#define CUJ_DEFINE_COUNT(NAME)                                                  \
+    i32 NAME(i8  x) { return count_bits(core::Intrinsic::NAME, x); }            \
+    i32 NAME(i16 x) { return count_bits(core::Intrinsic::NAME, x); }            \
+    i32 NAME(i32 x) { return count_bits(core::Intrinsic::NAME, x); }            \
+    i32 NAME(i64 x) { return count_bits(core::Intrinsic::NAME, x); }            \
+    i32 NAME(u8  x) { return count_bits(core::Intrinsic::NAME, x); }            \
+    i32 NAME(u16 x) { return count_bits(core::Intrinsic::NAME, x); }            \
+    i32 NAME(u32 x) { return count_bits(core::Intrinsic::NAME, x); }            \
+    i32 NAME(u64 x) { return count_bits(core::Intrinsic::NAME, x); }
+
+#define CUJ_DEFINE_ROTATE(NAME)                                                 \
+    i8  NAME(i8  x, i32 n) { return rotate(core::Intrinsic::NAME, x, n); }      \
+    i16 NAME(i16 x, i32 n) { return rotate(core::Intrinsic::NAME, x, n); }      \
+    i32 NAME(i32 x, i32 n) { return rotate(core::Intrinsic::NAME, x, n); }      \
+    i64 NAME(i64 x, i32 n) { return rotate(core::Intrinsic::NAME, x, n); }      \
+    u8  NAME(u8  x, i32 n) { return rotate(core::Intrinsic::NAME, x, n); }      \
+    u16 NAME(u16 x, i32 n) { return rotate(core::Intrinsic::NAME, x, n); }      \
+    u32 NAME(u32 x, i32 n) { return rotate(core::Intrinsic::NAME, x, n); }      \
+    u64 NAME(u64 x, i32 n) { return rotate(core::Intrinsic::NAME, x, n); }
+
+#define CUJ_DEFINE_BINARY(NAME)                                                 \
+    i8  NAME(i8  a, i8  b) { return binary(core::Intrinsic::NAME##_s, core::Intrinsic::NAME##_u, a, b); } \
+    i16 NAME(i16 a, i16 b) { return binary(core::Intrinsic::NAME##_s, core::Intrinsic::NAME##_u, a, b); } \
+    i32 NAME(i32 a, i32 b) { return binary(core::Intrinsic::NAME##_s, core::Intrinsic::NAME##_u, a, b); } \
+    i64 NAME(i64 a, i64 b) { return binary(core::Intrinsic::NAME##_s, core::Intrinsic::NAME##_u, a, b); } \
+    u8  NAME(u8  a, u8  b) { return binary(core::Intrinsic::NAME##_s, core::Intrinsic::NAME##_u, a, b); } \
+    u16 NAME(u16 a, u16 b) { return binary(core::Intrinsic::NAME##_s, core::Intrinsic::NAME##_u, a, b); } \
+    u32 NAME(u32 a, u32 b) { return binary(core::Intrinsic::NAME##_s, core::Intrinsic::NAME##_u, a, b); } \
+    u64 NAME(u64 a, u64 b) { return binary(core::Intrinsic::NAME##_s, core::Intrinsic::NAME##_u, a, b); }
+
+CUJ_DEFINE_COUNT(popcount)
+CUJ_DEFINE_COUNT(clz)
+CUJ_DEFINE_COUNT(ctz)
+
+CUJ_DEFINE_ROTATE(rotl)
+CUJ_DEFINE_ROTATE(rotr)
+
+CUJ_DEFINE_BINARY(mul_hi)
+CUJ_DEFINE_BINARY(add_sat)
+
+#undef CUJ_DEFINE_COUNT
+#undef CUJ_DEFINE_ROTATE
+#undef CUJ_DEFINE_BINARY
+
+i16 bswap(i16 x) { return call_intrinsic<i16>(core::Intrinsic::bswap, x); }
+i32 bswap(i32 x) { return call_intrinsic<i32>(core::Intrinsic::bswap, x); }
+i64 bswap(i64 x) { return call_intrinsic<i64>(core::Intrinsic::bswap, x); }
+u16 bswap(u16 x) { return call_intrinsic<u16>(core::Intrinsic::bswap, x); }
+u32 bswap(u32 x) { return call_intrinsic<u32>(core::Intrinsic::bswap, x); }
+u64 bswap(u64 x) { return call_intrinsic<u64>(core::Intrinsic::bswap, x); }
+
+f32 fma(f32 a, f32 b, f32 c)
+{
+    return call_intrinsic<f32>(core::Intrinsic::f32_fma, a, b, c);
+}
+
+f64 fma(f64 a, f64 b, f64 c)
+{
+    return call_intrinsic<f64>(core::Intrinsic::f64_fma, a, b, c);
+}
+
+CUJ_NAMESPACE_END(cuj::cstd)
@@ -70,6 +70,23 @@ void FunctionContext::set_type(core::Func::FuncType type)
     func_->type = type;
 }
 
+void FunctionContext::add_attribute(core::Func::Attribute attrib)
+{
+    using Attrib = core::Func::Attribute;
+
+    auto conflicts = [&](Attrib a, Attrib b)
+    {
+        return (attrib == a && func_->has_attribute(b)) ||
+               (attrib == b && func_->has_attribute(a));
+    };
+    if(conflicts(Attrib::AlwaysInline, Attrib::NoInline) ||
+       conflicts(Attrib::Cold, Attrib::Hot) ||
+       conflicts(Attrib::ReadNone, Attrib::ReadOnly))
+        throw CujException("conflicting function attributes");
+
+    func_->attributes |= static_cast<uint32_t>(attrib);
+}
+
 void FunctionContext::append_statement(RC<core::Stat> stat)
 {
     assert(!blocks_.empty());
@@ -81,6 +98,16 @@ void FunctionContext::add_argument(const core::Type *type, bool is_reference)
     func_->argument_types.push_back({ type, is_reference });
 }
 
+void FunctionContext::set_argument_restrict(size_t index, bool is_restrict)
+{
+    if(index >= func_->argument_types.size())
+        throw CujException("argument index out of range");
+    auto &arg = func_->argument_types[index];
+    if(!arg.is_reference && !arg.type->is<core::Pointer>())
+        throw CujException("only pointer/reference arguments can be restrict");
+    arg.is_restrict = is_restrict;
+}
+
 void FunctionContext::set_return(const core::Type *type, bool is_reference)
 {
     func_->return_type = { type, is_reference };
@@ -156,6 +183,12 @@ void FunctionContext::mark_as_non_declaration()
     func_->is_declaration = false;
 }
 
+void FunctionContext::add_trace_time(double seconds)
+{
+    if(module_ && get_func_ctcs_per_thread().empty())
+        module_->_add_trace_time(seconds);
+}
+
 namespace function_detail
 {
 
@@ -30,6 +30,7 @@ Module::Module()
 {
     type_context_ = newRC<TypeContext>(newRC<core::TypeSet>());
     auto_global_memory_index_ = 0;
+    trace_time_ = 0;
 }
 
 RC<FunctionContext> Module::_get_function(size_t index)
@@ -49,6 +50,16 @@ size_t Module::_add_function(RC<FunctionContext> context)
     return ret;
 }
 
+void Module::_add_trace_time(double seconds)
+{
+    trace_time_ += seconds;
+}
+
+double Module::get_trace_time() const
+{
+    return trace_time_;
+}
+
 core::Prog Module::_generate_prog() const
 {
     core::Prog ret;
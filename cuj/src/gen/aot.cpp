@@ -0,0 +1,578 @@
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4141)
+#pragma warning(disable: 4244)
+#pragma warning(disable: 4624)
+#pragma warning(disable: 4626)
+#pragma warning(disable: 4996)
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+
+#include <llvm/ADT/Triple.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/Object/ArchiveWriter.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Program.h>
+
+#include <cuj/core/hash.h>
+#include <cuj/gen/aot.h>
+#include <cuj/gen/llvm.h>
+#include <cuj/utils/printer.h>
+#include <cuj/utils/scope_guard.h>
+#include <cuj/utils/unreachable.h>
+
+#include "llvm/native_module.h"
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+namespace
+{
+
+    // auto names come from a process-wide counter, which depends on
+    // tracing order. functions with them are internal
+    bool is_exported(const core::Func &func)
+    {
+        return !func.is_declaration && func.type == core::Func::Regular &&
+               !core::is_auto_function_name(func.name);
+    }
+
+    // lets auto-named functions be inlined and removed.
+    // user-named kernels keep their symbols, though not declared in header
+    void internalize_functions(llvm::Module &llvm_module, const core::Prog &prog)
+    {
+        for(auto &func : prog.funcs)
+        {
+            if(func->is_declaration || !core::is_auto_function_name(func->name))
+                continue;
+            if(auto llvm_func = llvm_module.getFunction(func->name))
+                llvm_func->setLinkage(llvm::GlobalValue::InternalLinkage);
+        }
+    }
+
+    // llvm passes aggregates by value as first-class values, which doesn't
+    // follow the c abi. exported functions take them by pointer instead,
+    // and return them through an extra first argument
+
+    bool is_passed_by_pointer(const core::Func::Argument &arg)
+    {
+        return !arg.is_reference &&
+               (arg.type->is<core::Struct>() || arg.type->is<core::Array>());
+    }
+
+    void add_c_abi_wrappers(llvm::Module &llvm_module, const core::Prog &prog)
+    {
+        for(auto &func : prog.funcs)
+        {
+            if(!is_exported(*func))
+                continue;
+
+            const bool return_by_pointer = is_passed_by_pointer(func->return_type);
+            const bool has_aggregate_arg = std::any_of(
+                func->argument_types.begin(), func->argument_types.end(),
+                is_passed_by_pointer);
+            if(!return_by_pointer && !has_aggregate_arg)
+                continue;
+
+            auto impl = llvm_module.getFunction(func->name);
+            if(!impl)
+                continue;
+            impl->setName(func->name + ".impl");
+            impl->setLinkage(llvm::GlobalValue::InternalLinkage);
+
+            auto impl_type = impl->getFunctionType();
+            auto &context = llvm_module.getContext();
+
+            std::vector<llvm::Type *> arg_types;
+            if(return_by_pointer)
+                arg_types.push_back(llvm::PointerType::get(impl_type->getReturnType(), 0));
+            for(size_t i = 0; i < func->argument_types.size(); ++i)
+            {
+                auto arg_type = impl_type->getParamType(static_cast<unsigned>(i));
+                if(is_passed_by_pointer(func->argument_types[i]))
+                    arg_type = llvm::PointerType::get(arg_type, 0);
+                arg_types.push_back(arg_type);
+            }
+            auto ret_type = return_by_pointer ?
+                llvm::Type::getVoidTy(context) : impl_type->getReturnType();
+
+            auto wrapper = llvm::Function::Create(
+                llvm::FunctionType::get(ret_type, arg_types, false),
+                llvm::GlobalValue::ExternalLinkage, func->name, &llvm_module);
+
+            llvm::IRBuilder<> ir(llvm::BasicBlock::Create(context, "entry", wrapper));
+            const unsigned first_arg = return_by_pointer ? 1 : 0;
+
+            std::vector<llvm::Value *> args;
+            for(size_t i = 0; i < func->argument_types.size(); ++i)
+            {
+                llvm::Value *arg = wrapper->getArg(first_arg + static_cast<unsigned>(i));
+                if(is_passed_by_pointer(func->argument_types[i]))
+                {
+                    arg = ir.CreateLoad(
+                        impl_type->getParamType(static_cast<unsigned>(i)), arg);
+                }
+                args.push_back(arg);
+            }
+
+            auto ret = ir.CreateCall(impl, args);
+            if(return_by_pointer)
+            {
+                ir.CreateStore(ret, wrapper->getArg(0));
+                ir.CreateRetVoid();
+            }
+            else if(ret_type->isVoidTy())
+                ir.CreateRetVoid();
+            else
+                ir.CreateRet(ret);
+        }
+    }
+
+    class CHeaderGenerator
+    {
+    public:
+
+        std::string generate(const core::Prog &prog)
+        {
+            // collect types
+
+            for(auto &var : prog.global_vars)
+                add_type(var->type);
+            for(auto &func : prog.funcs)
+            {
+                if(!is_exported(*func))
+                    continue;
+                check_passed_by_value(func->return_type);
+                add_type(func->return_type.type);
+                for(auto &arg : func->argument_types)
+                {
+                    check_passed_by_value(arg);
+                    add_type(arg.type);
+                }
+            }
+
+            b_.appendl("#pragma once");
+            b_.new_line();
+            b_.appendl("#include <stdint.h>");
+            b_.appendl("#include <stdbool.h>");
+            b_.new_line();
+            b_.appendl("#ifdef __cplusplus");
+            b_.appendl("#define CUJ_ALIGNAS(N) alignas(N)");
+            b_.appendl("extern \"C\" {");
+            b_.appendl("#else");
+            b_.appendl("#define CUJ_ALIGNAS(N) _Alignas(N)");
+            b_.appendl("#endif");
+            b_.new_line();
+
+            // arrays are wrapped in structs to be referenced by name
+
+            for(auto &[type, name] : type_names_)
+                b_.appendl("typedef struct ", name, " ", name, ";");
+            if(!type_names_.empty())
+                b_.new_line();
+
+            std::set<std::string> defined;
+            for(auto &[type, name] : type_names_)
+                define_type(defined, type);
+
+            for(auto &var : sorted_global_vars(prog))
+            {
+                b_.appendl(
+                    "extern ", get_type_name(var->type), " ",
+                    var->symbol_name, ";");
+            }
+            if(!prog.global_vars.empty())
+                b_.new_line();
+
+            for(auto &func : prog.funcs)
+            {
+                if(is_exported(*func))
+                    declare_function(*func);
+            }
+
+            b_.new_line();
+            b_.appendl("#ifdef __cplusplus");
+            b_.appendl("} // extern \"C\"");
+            b_.appendl("#endif");
+            b_.new_line();
+            b_.appendl("#undef CUJ_ALIGNAS");
+
+            return b_.get_str();
+        }
+
+    private:
+
+        static size_t builtin_size(core::Builtin builtin)
+        {
+            switch(builtin)
+            {
+            case core::Builtin::S8:
+            case core::Builtin::U8:
+            case core::Builtin::Char:
+            case core::Builtin::Bool:
+                return 1;
+            case core::Builtin::S16:
+            case core::Builtin::U16:
+                return 2;
+            case core::Builtin::S32:
+            case core::Builtin::U32:
+            case core::Builtin::F32:
+                return 4;
+            case core::Builtin::S64:
+            case core::Builtin::U64:
+            case core::Builtin::F64:
+                return 8;
+            case core::Builtin::Void:
+                break;
+            }
+            unreachable();
+        }
+
+        // simd vectors are passed in vector registers, which has no
+        // equivalent in c
+
+        static void check_passed_by_value(const core::Func::Argument &arg)
+        {
+            if(!arg.is_reference && arg.type->is<core::Vector>())
+            {
+                throw CujException(
+                    "vector types cannot be passed by value to exported functions");
+            }
+        }
+
+        static std::vector<const core::GlobalVar *> sorted_global_vars(
+            const core::Prog &prog)
+        {
+            std::vector<const core::GlobalVar *> result;
+            for(auto &var : prog.global_vars)
+                result.push_back(var.get());
+            std::sort(result.begin(), result.end(), [](auto a, auto b)
+            {
+                return a->symbol_name < b->symbol_name;
+            });
+            return result;
+        }
+
+        const core::Type *find_type(const core::Type *type) const
+        {
+            // types from different type sets may be structurally equal
+            for(auto &[t, name] : type_names_)
+            {
+                if(core::structural_equal(t, type))
+                    return t;
+            }
+            return nullptr;
+        }
+
+        void add_type(const core::Type *type)
+        {
+            type->match(
+                [](core::Builtin) { },
+                [&](const core::Struct &s)
+            {
+                if(find_type(type))
+                    return;
+                type_names_.push_back(
+                    { type, "cuj_struct_" + std::to_string(struct_count_++) });
+                for(auto member : s.members)
+                    add_type(member);
+            },
+                [&](const core::Array &a)
+            {
+                if(find_type(type))
+                    return;
+                type_names_.push_back(
+                    { type, "cuj_array_" + std::to_string(array_count_++) });
+                add_type(a.element);
+            },
+                [&](const core::Pointer &p)
+            {
+                add_type(p.pointed);
+            },
+                [&](const core::Vector &v)
+            {
+                if(find_type(type))
+                    return;
+                if(v.element->as<core::Builtin>() == core::Builtin::Bool)
+                    throw CujException("bool vectors have no c layout");
+                type_names_.push_back(
+                    { type, "cuj_vector_" + std::to_string(vector_count_++) });
+            });
+        }
+
+        std::string get_type_name(const core::Type *type) const
+        {
+            return type->match(
+                [](core::Builtin builtin) -> std::string
+            {
+                switch(builtin)
+                {
+                case core::Builtin::S8:   return "int8_t";
+                case core::Builtin::S16:  return "int16_t";
+                case core::Builtin::S32:  return "int32_t";
+                case core::Builtin::S64:  return "int64_t";
+                case core::Builtin::U8:   return "uint8_t";
+                case core::Builtin::U16:  return "uint16_t";
+                case core::Builtin::U32:  return "uint32_t";
+                case core::Builtin::U64:  return "uint64_t";
+                case core::Builtin::F32:  return "float";
+                case core::Builtin::F64:  return "double";
+                case core::Builtin::Char: return "char";
+                case core::Builtin::Bool: return "bool";
+                case core::Builtin::Void: return "void";
+                }
+                unreachable();
+            },
+                [&](const core::Pointer &p)
+            {
+                return get_type_name(p.pointed) + " *";
+            },
+                [&](const auto &)
+            {
+                auto t = find_type(type);
+                for(auto &[u, name] : type_names_)
+                {
+                    if(u == t)
+                        return name;
+                }
+                unreachable();
+            });
+        }
+
+        void define_type(std::set<std::string> &defined, const core::Type *type)
+        {
+            type = find_type(type);
+            if(!type)
+                return;
+            auto name = get_type_name(type);
+            if(!defined.insert(name).second)
+                return;
+
+            // members stored by value must be defined first
+
+            if(auto s = type->as_if<core::Struct>())
+            {
+                for(auto member : s->members)
+                    define_type(defined, member);
+
+                b_.appendl("struct ", name);
+                b_.appendl("{");
+                b_.with_indent([&]
+                {
+                    for(size_t i = 0; i < s->members.size(); ++i)
+                    {
+                        if(i == 0 && s->custom_alignment)
+                            b_.append("CUJ_ALIGNAS(", s->custom_alignment, ") ");
+                        b_.appendl(get_type_name(s->members[i]), " m", i, ";");
+                    }
+                });
+                b_.appendl("};");
+            }
+            else if(auto v = type->as_if<core::Vector>())
+            {
+                // vectors are aligned to their sizes rounded up to powers of 2
+
+                const size_t elem_size = builtin_size(v->element->as<core::Builtin>());
+                size_t alignment = elem_size;
+                while(alignment < elem_size * v->size)
+                    alignment *= 2;
+
+                b_.appendl("struct ", name);
+                b_.appendl("{");
+                b_.with_indent([&]
+                {
+                    b_.appendl(
+                        "CUJ_ALIGNAS(", alignment, ") ",
+                        get_type_name(v->element), " data[", v->size, "];");
+                });
+                b_.appendl("};");
+            }
+            else
+            {
+                auto &a = type->as<core::Array>();
+                define_type(defined, a.element);
+
+                b_.appendl("struct ", name);
+                b_.appendl("{");
+                b_.with_indent([&]
+                {
+                    b_.appendl(get_type_name(a.element), " data[", a.size, "];");
+                });
+                b_.appendl("};");
+            }
+            b_.new_line();
+        }
+
+        void declare_function(const core::Func &func)
+        {
+            // see add_c_abi_wrappers
+
+            const bool return_by_pointer = is_passed_by_pointer(func.return_type);
+
+            auto ret_type = get_type_name(func.return_type.type);
+            if(func.return_type.is_reference)
+                ret_type += " *";
+
+            b_.append(return_by_pointer ? "void" : ret_type, " ", func.name, "(");
+            if(return_by_pointer)
+            {
+                b_.append(ret_type, " * ret");
+                if(!func.argument_types.empty())
+                    b_.append(", ");
+            }
+            for(size_t i = 0; i < func.argument_types.size(); ++i)
+            {
+                auto &arg = func.argument_types[i];
+                if(i > 0)
+                    b_.append(", ");
+                if(is_passed_by_pointer(arg))
+                    b_.append("const ", get_type_name(arg.type), " *");
+                else
+                    b_.append(get_type_name(arg.type));
+                if(arg.is_reference)
+                    b_.append(" *");
+                b_.append(" a", i);
+            }
+            if(func.argument_types.empty() && !return_by_pointer)
+                b_.append("void");
+            b_.appendl(");");
+        }
+
+        TextBuilder b_;
+
+        std::vector<std::pair<const core::Type *, std::string>> type_names_;
+        int struct_count_ = 0;
+        int array_count_  = 0;
+        int vector_count_ = 0;
+    };
+
+    void write_file(const std::string &filename, const char *data, size_t size)
+    {
+        std::ofstream fout(filename, std::ofstream::out | std::ofstream::binary);
+        if(!fout)
+            throw CujException("failed to create file: " + filename);
+        fout.write(data, static_cast<std::streamsize>(size));
+        if(!fout)
+            throw CujException("failed to write file: " + filename);
+    }
+
+    void check_llvm_error(llvm::Error err)
+    {
+        if(err)
+            throw CujException(llvm::toString(std::move(err)));
+    }
+
+} // namespace anonymous
+
+void AOTCompiler::set_options(const Options &opts)
+{
+    opts_ = opts;
+}
+
+void AOTCompiler::generate(const dsl::Module &mod)
+{
+    const auto prog = mod._generate_prog();
+    c_header_ = CHeaderGenerator().generate(prog);
+
+    auto llvm_mod = build_llvm_module(mod, opts_);
+    delete llvm_mod.machine;
+    Box<llvm::TargetMachine> machine(get_native_target_machine(
+        llvm_mod.codegen_opt, llvm_mod.cpu, llvm_mod.cpu_features, false));
+
+    auto &llvm_module = *llvm_mod.llvm_module;
+    add_c_abi_wrappers(llvm_module, prog);
+    internalize_functions(llvm_module, prog);
+    define_native_intrinsic_functions(llvm_module);
+    do_llvm_optimize(&llvm_module, machine.get(), opts_);
+
+    llvm_ir_.clear();
+    llvm::raw_string_ostream ss(llvm_ir_);
+    ss << llvm_module;
+    ss.flush();
+
+    llvm::SmallVector<char, 0> object_data;
+    llvm::raw_svector_ostream object_stream(object_data);
+    llvm::legacy::PassManager passes;
+    if(machine->addPassesToEmitFile(
+        passes, object_stream, nullptr, llvm::CGFT_ObjectFile))
+        throw CujException("target doesn't support object emission");
+    passes.run(llvm_module);
+
+    object_.assign(object_data.begin(), object_data.end());
+}
+
+const std::string &AOTCompiler::get_llvm_string() const
+{
+    return llvm_ir_;
+}
+
+const std::vector<char> &AOTCompiler::get_object() const
+{
+    return object_;
+}
+
+const std::string &AOTCompiler::get_c_header() const
+{
+    return c_header_;
+}
+
+void AOTCompiler::write_object(const std::string &filename) const
+{
+    write_file(filename, object_.data(), object_.size());
+}
+
+void AOTCompiler::write_static_library(const std::string &filename) const
+{
+    const std::string member_name =
+        llvm::sys::path::stem(filename).str() + ".o";
+    std::vector<llvm::NewArchiveMember> members;
+    members.emplace_back(llvm::MemoryBufferRef(
+        llvm::StringRef(object_.data(), object_.size()), member_name));
+    members.back().MemberName = member_name;
+
+    const auto kind = llvm::Triple(llvm::sys::getDefaultTargetTriple())
+        .isOSDarwin() ? llvm::object::Archive::K_DARWIN
+                      : llvm::object::Archive::K_GNU;
+    check_llvm_error(llvm::writeArchive(
+        filename, members, true, kind, true, false));
+}
+
+void AOTCompiler::write_shared_library(const std::string &filename) const
+{
+    auto cc = llvm::sys::findProgramByName("cc");
+    if(!cc)
+        throw CujException("c compiler driver (cc) is not found");
+
+    llvm::SmallString<128> object_filename;
+    if(llvm::sys::fs::createTemporaryFile("cuj_aot", "o", object_filename))
+        throw CujException("failed to create temporary object file");
+    CUJ_SCOPE_EXIT{ llvm::sys::fs::remove(object_filename); };
+    write_object(object_filename.str().str());
+
+    std::vector<llvm::StringRef> args = {
+        *cc, "-shared", "-o", filename, object_filename
+    };
+    if(opts_.vector_math_library == VectorMathLibrary::LibMVec)
+        args.push_back("-lmvec");
+    args.push_back("-lm");
+    std::string err;
+    const int ret = llvm::sys::ExecuteAndWait(*cc, args, {}, {}, 0, 0, &err);
+    if(ret != 0)
+        throw CujException("failed to link shared library: " + err);
+}
+
+void AOTCompiler::write_c_header(const std::string &filename) const
+{
+    write_file(filename, c_header_.data(), c_header_.size());
+}
+
+CUJ_NAMESPACE_END(cuj::gen)
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
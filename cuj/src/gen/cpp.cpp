@@ -64,6 +64,7 @@ void CPPCodeGenerator::generate(const dsl::Module &mod)
         result_ =
             "#define CUJ_IS_CUDA 1\n"
             "#define CUJ_FUNCTION_PREFIX __device__\n"
+            "#define CUJ_RESTRICT __restrict__\n"
             "#define CUJ_STD\n";
     }
     else
@@ -71,6 +72,11 @@ void CPPCodeGenerator::generate(const dsl::Module &mod)
         result_ =
             "#include <cmath>\n"
             "#define CUJ_FUNCTION_PREFIX\n"
+            "#ifdef _MSC_VER\n"
+            "#define CUJ_RESTRICT __restrict\n"
+            "#else\n"
+            "#define CUJ_RESTRICT __restrict__\n"
+            "#endif\n"
             "#define CUJ_STD std::\n";
     }
     result_.append(
@@ -135,6 +141,10 @@ std::map<std::type_index, std::string> CPPCodeGenerator::build_index_to_name(
                 [&](const core::Struct &s)
             {
                 return "Struct" + std::to_string(result.size());
+            },
+                [&](const core::Vector &v)
+            {
+                return "Vector" + std::to_string(result.size());
             });
 
         result[index] = "CujType" + suffix;
@@ -215,6 +225,14 @@ void CPPCodeGenerator::declare_type(std::map<std::string, TypeDefineState> &stat
         {
             builder_.appendl("struct ", name, ";");
             state.complete = false;
+        },
+            [&](const core::Vector &v)
+        {
+            declare_type(states, v.element);
+            builder_.appendl(
+                "using ", name, " = _CujVector<",
+                type_names_.at(v.element), ", ", v.size, ">;");
+            state.complete = true;
         });
 }
 
@@ -341,6 +359,21 @@ void CPPCodeGenerator::declare_function(const core::Func &func, bool var_name)
             throw CujException("non-ptx backend doesn't support kernel function");
         prefix = "__global__ ";
     }
+
+    using Attrib = core::Func::Attribute;
+    for(auto [attrib, macro] : {
+        std::pair{ Attrib::AlwaysInline, "CUJ_ATTRIB_ALWAYS_INLINE " },
+        std::pair{ Attrib::NoInline,     "CUJ_ATTRIB_NOINLINE "      },
+        std::pair{ Attrib::Cold,         "CUJ_ATTRIB_COLD "          },
+        std::pair{ Attrib::Hot,          "CUJ_ATTRIB_HOT "           },
+        std::pair{ Attrib::ReadNone,     "CUJ_ATTRIB_READNONE "      },
+        std::pair{ Attrib::ReadOnly,     "CUJ_ATTRIB_READONLY "      },
+        std::pair{ Attrib::NoUnwind,     "CUJ_ATTRIB_NOUNWIND "      } })
+    {
+        if(func.has_attribute(attrib))
+            prefix.append(macro);
+    }
+
     builder_.append("extern \"C\" ", prefix);
     
     builder_.append(type_names_.at(func.return_type.type));
@@ -356,6 +389,8 @@ void CPPCodeGenerator::declare_function(const core::Func &func, bool var_name)
         builder_.append(type_names_.at(func.argument_types[i].type));
         if(func.argument_types[i].is_reference)
             builder_.append("*");
+        if(func.argument_types[i].is_restrict)
+            builder_.append(" CUJ_RESTRICT");
         if(var_name)
             builder_.append(" _cuj_a", i);
     }
@@ -366,6 +401,7 @@ void CPPCodeGenerator::define_function(const core::Func &func)
 {
     declare_function(func, true);
 
+    func_ = &func;
     next_label_index_ = 0;
     local_temp_index_ = 0;
 
@@ -440,7 +476,18 @@ void CPPCodeGenerator::generate(const core::Return &s)
 void CPPCodeGenerator::generate(const core::If &s)
 {
     generate(*s.calc_cond);
-    builder_.appendl("if(", generate(s.cond), ")");
+    switch(s.likelihood)
+    {
+    case core::If::Likelihood::Unknown:
+        builder_.appendl("if(", generate(s.cond), ")");
+        break;
+    case core::If::Likelihood::Likely:
+        builder_.appendl("if(CUJ_LIKELY(", generate(s.cond), "))");
+        break;
+    case core::If::Likelihood::Unlikely:
+        builder_.appendl("if(CUJ_UNLIKELY(", generate(s.cond), "))");
+        break;
+    }
     builder_.appendl("{");
     builder_.with_indent([&]{ generate(*s.then_body); });
     builder_.appendl("}");
@@ -458,6 +505,18 @@ void CPPCodeGenerator::generate(const core::Loop &s)
     const auto new_break_label = "_cuj_break_dest" + std::to_string(next_label_index_++);
     break_dest_label_names_.push(new_break_label);
 
+    if(s.hints.unroll_count)
+        builder_.appendl("CUJ_PRAGMA_UNROLL(", s.hints.unroll_count, ")");
+    if(s.hints.unroll_full)
+        builder_.appendl("CUJ_PRAGMA_UNROLL_FULL");
+    if(s.hints.unroll_disable)
+        builder_.appendl("CUJ_PRAGMA_UNROLL(1)");
+    if(s.hints.vectorize_width)
+        builder_.appendl("CUJ_PRAGMA_VECTORIZE_WIDTH(", s.hints.vectorize_width, ")");
+    if(s.hints.interleave_count)
+        builder_.appendl("CUJ_PRAGMA_INTERLEAVE_COUNT(", s.hints.interleave_count, ")");
+    if(s.hints.independent)
+        builder_.appendl("CUJ_PRAGMA_IVDEP");
     builder_.appendl("while(true)");
     builder_.appendl("{");
     builder_.with_indent([&] { generate(*s.body); });
@@ -561,6 +620,13 @@ std::string CPPCodeGenerator::generate(const core::Expr &e) const
 
 std::string CPPCodeGenerator::generate(const core::FuncArgAddr &e) const
 {
+    // address of a restrict parameter has type T *__restrict *, which is
+    // not implicitly convertible to T ** of locals storing it
+    if(func_ && func_->argument_types[e.arg_index].is_restrict)
+    {
+        return "((" + type_names_.at(e.addr_type) + ")(&_cuj_a" +
+               std::to_string(e.arg_index) + "))";
+    }
     return "(&_cuj_a" + std::to_string(e.arg_index) + ")";
 }
 
@@ -691,6 +757,17 @@ std::string CPPCodeGenerator::generate(const core::Unary &e) const
     return "(" + op + "(" + generate(*e.val) + "))";
 }
 
+std::string CPPCodeGenerator::generate(const core::Select &e) const
+{
+    if(e.cond_type->is<core::Vector>())
+    {
+        return "_cuj_vector_select(" + generate(*e.cond) + ", " +
+               generate(*e.true_val) + ", " + generate(*e.false_val) + ")";
+    }
+    return "(" + generate(*e.cond) + " ? " + generate(*e.true_val) +
+           " : " + generate(*e.false_val) + ")";
+}
+
 std::string CPPCodeGenerator::generate(const core::CallFunc &e) const
 {
     if(e.intrinsic != core::Intrinsic::None)
@@ -725,6 +802,62 @@ std::string CPPCodeGenerator::generate(const core::GlobalConstAddr &e) const
            std::to_string(global_const_indices_.at(e.data)) + "))";
 }
 
+std::string CPPCodeGenerator::generate(const core::MakeVector &e) const
+{
+    auto &type_name = type_names_.at(e.vector_type);
+    if(e.elements.size() == 1)
+        return "(_cuj_broadcast_vector<" + type_name + ">(" + generate(*e.elements[0]) + "))";
+
+    std::string result = "(_cuj_make_vector<" + type_name + ">(";
+    for(size_t i = 0; i < e.elements.size(); ++i)
+    {
+        if(i > 0)
+            result.append(", ");
+        result.append(generate(*e.elements[i]));
+    }
+    result.append("))");
+    return result;
+}
+
+std::string CPPCodeGenerator::generate(const core::VectorExtract &e) const
+{
+    return "((" + generate(*e.vector) + ").data[" + generate(*e.index) + "])";
+}
+
+std::string CPPCodeGenerator::generate(const core::VectorInsert &e) const
+{
+    return "(_cuj_vector_insert(" + generate(*e.vector) + ", " +
+           generate(*e.index) + ", " + generate(*e.element) + "))";
+}
+
+std::string CPPCodeGenerator::generate(const core::VectorShuffle &e) const
+{
+    std::string result = "(_cuj_vector_shuffle<" + type_names_.at(e.dst_type) + ">(";
+    result.append(generate(*e.lhs));
+    result.append(", ");
+    result.append(generate(*e.rhs));
+    for(int index : e.indices)
+        result.append(", " + std::to_string(index));
+    result.append("))");
+    return result;
+}
+
+std::string CPPCodeGenerator::generate(const core::VectorReduce &e) const
+{
+    std::string callee;
+    switch(e.op)
+    {
+    case core::VectorReduce::Op::Add:        callee = "_cuj_vector_reduce_add";     break;
+    case core::VectorReduce::Op::Mul:        callee = "_cuj_vector_reduce_mul";     break;
+    case core::VectorReduce::Op::Min:        callee = "_cuj_vector_reduce_min";     break;
+    case core::VectorReduce::Op::Max:        callee = "_cuj_vector_reduce_max";     break;
+    case core::VectorReduce::Op::BitwiseAnd: callee = "_cuj_vector_reduce_bit_and"; break;
+    case core::VectorReduce::Op::BitwiseOr:  callee = "_cuj_vector_reduce_bit_or";  break;
+    case core::VectorReduce::Op::BitwiseXOr: callee = "_cuj_vector_reduce_bit_xor"; break;
+    }
+    return "(" + callee + "(" + generate(*e.vector) + "))";
+}
+
 std::string CPPCodeGenerator::generate_intrinsic_call(const core::CallFunc &e) const
 {
     assert(e.intrinsic != core::Intrinsic::None);
@@ -801,6 +934,18 @@ std::string CPPCodeGenerator::generate_intrinsic_call(const core::CallFunc &e) c
     case core::Intrinsic::i64_max:           callee = "_cuj_i64_max";            break;
     case core::Intrinsic::u64_min:           callee = "_cuj_u64_min";            break;
     case core::Intrinsic::u64_max:           callee = "_cuj_u64_max";            break;
+    case core::Intrinsic::popcount:          callee = "_cuj_popcount";           break;
+    case core::Intrinsic::clz:               callee = "_cuj_clz";                break;
+    case core::Intrinsic::ctz:               callee = "_cuj_ctz";                break;
+    case core::Intrinsic::bswap:             callee = "_cuj_bswap";              break;
+    case core::Intrinsic::rotl:              callee = "_cuj_rotl";               break;
+    case core::Intrinsic::rotr:              callee = "_cuj_rotr";               break;
+    case core::Intrinsic::mul_hi_s:          callee = "_cuj_mul_hi";             break;
+    case core::Intrinsic::mul_hi_u:          callee = "_cuj_mul_hi";             break;
+    case core::Intrinsic::add_sat_s:         callee = "_cuj_add_sat";            break;
+    case core::Intrinsic::add_sat_u:         callee = "_cuj_add_sat";            break;
+    case core::Intrinsic::f32_fma:           callee = "_cuj_f32_fma";            break;
+    case core::Intrinsic::f64_fma:           callee = "_cuj_f64_fma";            break;
     case core::Intrinsic::thread_idx_x:      callee = "_cuj_thread_idx_x";       break;
     case core::Intrinsic::thread_idx_y:      callee = "_cuj_thread_idx_y";       break;
     case core::Intrinsic::thread_idx_z:      callee = "_cuj_thread_idx_z";       break;
@@ -828,12 +973,28 @@ std::string CPPCodeGenerator::generate_intrinsic_call(const core::CallFunc &e) c
     case core::Intrinsic::load_f32x2:        callee = "_cuj_load_f32x2";         break;
     case core::Intrinsic::load_u32x2:        callee = "_cuj_load_u32x2";         break;
     case core::Intrinsic::load_i32x2:        callee = "_cuj_load_i32x2";         break;
-    case core::Intrinsic::atomic_add_i32:    callee = "_cuj_i32_atomic_add";     break;
-    case core::Intrinsic::atomic_add_u32:    callee = "_cuj_u32_atomic_add";     break;
-    case core::Intrinsic::atomic_add_f32:    callee = "_cuj_f32_atomic_add";     break;
-    case core::Intrinsic::cmpxchg_i32:       callee = "_cuj_i32_atomic_cmpxchg"; break;
-    case core::Intrinsic::cmpxchg_u32:       callee = "_cuj_u32_atomic_cmpxchg"; break;
-    case core::Intrinsic::cmpxchg_u64:       callee = "_cuj_u64_atomic_cmpxchg"; break;
+    case core::Intrinsic::masked_load:       callee = "_cuj_masked_load";        break;
+    case core::Intrinsic::masked_store:      callee = "_cuj_masked_store";       break;
+    case core::Intrinsic::gather:            callee = "_cuj_gather";             break;
+    case core::Intrinsic::scatter:           callee = "_cuj_scatter";            break;
+    case core::Intrinsic::prefetch:          callee = "_cuj_prefetch";           break;
+    case core::Intrinsic::store_nontemporal: callee = "_cuj_store_nontemporal";  break;
+    case core::Intrinsic::assume_aligned:    callee = "_cuj_assume_aligned";     break;
+    case core::Intrinsic::assume:            callee = "_cuj_assume";             break;
+    case core::Intrinsic::atomic_load:       callee = "_cuj_atomic_load";        break;
+    case core::Intrinsic::atomic_store:      callee = "_cuj_atomic_store";       break;
+    case core::Intrinsic::atomic_exchange:   callee = "_cuj_atomic_exchange";    break;
+    case core::Intrinsic::atomic_cmpxchg:    callee = "_cuj_atomic_cmpxchg";     break;
+    case core::Intrinsic::atomic_add:        callee = "_cuj_atomic_add";         break;
+    case core::Intrinsic::atomic_fadd:       callee = "_cuj_atomic_add";         break;
+    case core::Intrinsic::atomic_and:        callee = "_cuj_atomic_and";         break;
+    case core::Intrinsic::atomic_or:         callee = "_cuj_atomic_or";          break;
+    case core::Intrinsic::atomic_xor:        callee = "_cuj_atomic_xor";         break;
+    case core::Intrinsic::atomic_min_s:      callee = "_cuj_atomic_min";         break;
+    case core::Intrinsic::atomic_min_u:      callee = "_cuj_atomic_min";         break;
+    case core::Intrinsic::atomic_max_s:      callee = "_cuj_atomic_max";         break;
+    case core::Intrinsic::atomic_max_u:      callee = "_cuj_atomic_max";         break;
+    case core::Intrinsic::atomic_fence:      callee = "_cuj_atomic_fence";       break;
     case core::Intrinsic::print:             callee = "_cuj_print";              break;
     case core::Intrinsic::assert_fail:       callee = "_cuj_assertfail";         break;
     case core::Intrinsic::unreachable:       callee = "_cuj_unreachable";        break;
@@ -5,6 +5,74 @@ R"___(
 #include <atomic>
 #endif
 
+#if defined(_MSC_VER) && !defined(__clang__)
+#define CUJ_LIKELY(X)   (X)
+#define CUJ_UNLIKELY(X) (X)
+#else
+#define CUJ_LIKELY(X)   __builtin_expect(!!(X), 1)
+#define CUJ_UNLIKELY(X) __builtin_expect(!!(X), 0)
+#endif
+
+#define CUJ_PRAGMA(X) _Pragma(#X)
+
+#if defined(CUJ_IS_CUDA)
+#define CUJ_PRAGMA_UNROLL(N)              CUJ_PRAGMA(unroll N)
+#define CUJ_PRAGMA_UNROLL_FULL            CUJ_PRAGMA(unroll)
+#define CUJ_PRAGMA_VECTORIZE_WIDTH(N)
+#define CUJ_PRAGMA_INTERLEAVE_COUNT(N)
+#define CUJ_PRAGMA_IVDEP
+#elif defined(__clang__)
+#define CUJ_PRAGMA_UNROLL(N)              CUJ_PRAGMA(unroll N)
+#define CUJ_PRAGMA_UNROLL_FULL            CUJ_PRAGMA(unroll)
+#define CUJ_PRAGMA_VECTORIZE_WIDTH(N)     CUJ_PRAGMA(clang loop vectorize_width(N))
+#define CUJ_PRAGMA_INTERLEAVE_COUNT(N)    CUJ_PRAGMA(clang loop interleave_count(N))
+#define CUJ_PRAGMA_IVDEP                  CUJ_PRAGMA(clang loop vectorize(assume_safety))
+#elif defined(__GNUC__)
+#define CUJ_PRAGMA_UNROLL(N)              CUJ_PRAGMA(GCC unroll N)
+#define CUJ_PRAGMA_UNROLL_FULL            CUJ_PRAGMA(GCC unroll 65534)
+#define CUJ_PRAGMA_VECTORIZE_WIDTH(N)
+#define CUJ_PRAGMA_INTERLEAVE_COUNT(N)
+#define CUJ_PRAGMA_IVDEP                  CUJ_PRAGMA(GCC ivdep)
+#elif defined(_MSC_VER)
+#define CUJ_PRAGMA_UNROLL(N)
+#define CUJ_PRAGMA_UNROLL_FULL
+#define CUJ_PRAGMA_VECTORIZE_WIDTH(N)
+#define CUJ_PRAGMA_INTERLEAVE_COUNT(N)
+#define CUJ_PRAGMA_IVDEP                  __pragma(loop(ivdep))
+#else
+#define CUJ_PRAGMA_UNROLL(N)
+#define CUJ_PRAGMA_UNROLL_FULL
+#define CUJ_PRAGMA_VECTORIZE_WIDTH(N)
+#define CUJ_PRAGMA_INTERLEAVE_COUNT(N)
+#define CUJ_PRAGMA_IVDEP
+#endif
+
+#if defined(CUJ_IS_CUDA)
+#define CUJ_ATTRIB_ALWAYS_INLINE __forceinline__
+#define CUJ_ATTRIB_NOINLINE      __noinline__
+#define CUJ_ATTRIB_COLD
+#define CUJ_ATTRIB_HOT
+#define CUJ_ATTRIB_READNONE
+#define CUJ_ATTRIB_READONLY
+#define CUJ_ATTRIB_NOUNWIND
+#elif defined(_MSC_VER)
+#define CUJ_ATTRIB_ALWAYS_INLINE __forceinline
+#define CUJ_ATTRIB_NOINLINE      __declspec(noinline)
+#define CUJ_ATTRIB_COLD
+#define CUJ_ATTRIB_HOT
+#define CUJ_ATTRIB_READNONE
+#define CUJ_ATTRIB_READONLY
+#define CUJ_ATTRIB_NOUNWIND      __declspec(nothrow)
+#else
+#define CUJ_ATTRIB_ALWAYS_INLINE __attribute__((always_inline))
+#define CUJ_ATTRIB_NOINLINE      __attribute__((noinline))
+#define CUJ_ATTRIB_COLD          __attribute__((cold))
+#define CUJ_ATTRIB_HOT           __attribute__((hot))
+#define CUJ_ATTRIB_READNONE      __attribute__((const))
+#define CUJ_ATTRIB_READONLY      __attribute__((pure))
+#define CUJ_ATTRIB_NOUNWIND      __attribute__((nothrow))
+#endif
+
 CUJ_FUNCTION_PREFIX inline constexpr size_t _cuj_constexpr_max(size_t a, size_t b)
 {
     return a > b ? a : b;
@@ -365,6 +433,195 @@ CUJ_FUNCTION_PREFIX inline int _cuj_u64_max(unsigned long long a, unsigned long
     return a > b ? a : b;
 }
 
+CUJ_FUNCTION_PREFIX inline float _cuj_f32_fma(float a, float b, float c)
+{
+    return CUJ_STD fmaf(a, b, c);
+}
+
+CUJ_FUNCTION_PREFIX inline double _cuj_f64_fma(double a, double b, double c)
+{
+    return CUJ_STD fma(a, b, c);
+}
+
+// integer bit manipulation. values narrower than 64 bits are zero extended
+// and processed as 64-bit integers
+
+template<typename T>
+CUJ_FUNCTION_PREFIX unsigned long long _cuj_zext64(T x)
+{
+    return static_cast<unsigned long long>(x) & (~0ull >> (64 - 8 * sizeof(T)));
+}
+
+CUJ_FUNCTION_PREFIX inline int _cuj_popcount64(unsigned long long x)
+{
+#if defined(CUJ_IS_CUDA)
+    return __popcll(x);
+#elif defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    int r = 0;
+    for(; x; x &= x - 1)
+        ++r;
+    return r;
+#endif
+}
+
+CUJ_FUNCTION_PREFIX inline int _cuj_clz64(unsigned long long x)
+{
+#if defined(CUJ_IS_CUDA)
+    return __clzll(static_cast<long long>(x));
+#elif defined(__GNUC__) || defined(__clang__)
+    return x ? __builtin_clzll(x) : 64;
+#else
+    int r = 0;
+    for(unsigned long long m = 1ull << 63; m && !(x & m); m >>= 1)
+        ++r;
+    return r;
+#endif
+}
+
+CUJ_FUNCTION_PREFIX inline int _cuj_ctz64(unsigned long long x)
+{
+#if defined(CUJ_IS_CUDA)
+    return x ? __ffsll(static_cast<long long>(x)) - 1 : 64;
+#elif defined(__GNUC__) || defined(__clang__)
+    return x ? __builtin_ctzll(x) : 64;
+#else
+    if(!x)
+        return 64;
+    int r = 0;
+    for(; !(x & 1); x >>= 1)
+        ++r;
+    return r;
+#endif
+}
+
+template<typename T>
+CUJ_FUNCTION_PREFIX T _cuj_popcount(T x)
+{
+    return static_cast<T>(_cuj_popcount64(_cuj_zext64(x)));
+}
+
+template<typename T>
+CUJ_FUNCTION_PREFIX T _cuj_clz(T x)
+{
+    return static_cast<T>(
+        _cuj_clz64(_cuj_zext64(x)) - (64 - 8 * static_cast<int>(sizeof(T))));
+}
+
+template<typename T>
+CUJ_FUNCTION_PREFIX T _cuj_ctz(T x)
+{
+    const unsigned long long v = _cuj_zext64(x);
+    return static_cast<T>(v ? _cuj_ctz64(v) : 8 * static_cast<int>(sizeof(T)));
+}
+
+template<typename T>
+CUJ_FUNCTION_PREFIX T _cuj_bswap(T x)
+{
+#if !defined(CUJ_IS_CUDA) && (defined(__GNUC__) || defined(__clang__))
+    if(sizeof(T) == 2)
+        return static_cast<T>(__builtin_bswap16(static_cast<unsigned short>(x)));
+    if(sizeof(T) == 4)
+        return static_cast<T>(__builtin_bswap32(static_cast<unsigned int>(x)));
+    return static_cast<T>(__builtin_bswap64(static_cast<unsigned long long>(x)));
+#else
+    const unsigned long long v = _cuj_zext64(x);
+    unsigned long long r = 0;
+    for(int i = 0; i < static_cast<int>(sizeof(T)); ++i)
+        r = (r << 8) | ((v >> (8 * i)) & 0xff);
+    return static_cast<T>(r);
+#endif
+}
+
+// shift amounts are taken modulo the bit width, as in llvm.fshl/fshr
+
+template<typename T>
+CUJ_FUNCTION_PREFIX T _cuj_rotl(T x, T n)
+{
+    const int w = 8 * static_cast<int>(sizeof(T));
+    const int s = static_cast<int>(static_cast<unsigned long long>(n) % w);
+    const unsigned long long v = _cuj_zext64(x);
+    return static_cast<T>(s ? (v << s) | (v >> (w - s)) : v);
+}
+
+template<typename T>
+CUJ_FUNCTION_PREFIX T _cuj_rotr(T x, T n)
+{
+    const int w = 8 * static_cast<int>(sizeof(T));
+    const int s = static_cast<int>(static_cast<unsigned long long>(n) % w);
+    const unsigned long long v = _cuj_zext64(x);
+    return static_cast<T>(s ? (v >> s) | (v << (w - s)) : v);
+}
+
+#define CUJ_DEFINE_MUL_HI(T, W)                                                \
+    CUJ_FUNCTION_PREFIX inline T _cuj_mul_hi(T a, T b)                         \
+    {                                                                          \
+        return static_cast<T>(                                                 \
+            (static_cast<W>(a) * static_cast<W>(b)) >> (8 * sizeof(T)));       \
+    }
+
+CUJ_DEFINE_MUL_HI(signed char,    long long)
+CUJ_DEFINE_MUL_HI(short,          long long)
+CUJ_DEFINE_MUL_HI(int,            long long)
+CUJ_DEFINE_MUL_HI(unsigned char,  unsigned long long)
+CUJ_DEFINE_MUL_HI(unsigned short, unsigned long long)
+CUJ_DEFINE_MUL_HI(unsigned int,   unsigned long long)
+
+#undef CUJ_DEFINE_MUL_HI
+
+CUJ_FUNCTION_PREFIX inline unsigned long long _cuj_mul_hi(unsigned long long a, unsigned long long b)
+{
+#if defined(CUJ_IS_CUDA)
+    return __umul64hi(a, b);
+#elif defined(__SIZEOF_INT128__)
+    return static_cast<unsigned long long>(
+        (static_cast<unsigned __int128>(a) * b) >> 64);
+#else
+    const unsigned long long a_lo = a & 0xffffffff, a_hi = a >> 32;
+    const unsigned long long b_lo = b & 0xffffffff, b_hi = b >> 32;
+    const unsigned long long lo_lo = a_lo * b_lo;
+    const unsigned long long hi_lo = a_hi * b_lo;
+    const unsigned long long lo_hi = a_lo * b_hi;
+    const unsigned long long cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+    return a_hi * b_hi + (hi_lo >> 32) + (cross >> 32);
+#endif
+}
+
+CUJ_FUNCTION_PREFIX inline long long _cuj_mul_hi(long long a, long long b)
+{
+#if defined(CUJ_IS_CUDA)
+    return __mul64hi(a, b);
+#elif defined(__SIZEOF_INT128__)
+    return static_cast<long long>((static_cast<__int128>(a) * b) >> 64);
+#else
+    const unsigned long long ua = static_cast<unsigned long long>(a);
+    const unsigned long long ub = static_cast<unsigned long long>(b);
+    unsigned long long r = _cuj_mul_hi(ua, ub);
+    if(a < 0)
+        r -= ub;
+    if(b < 0)
+        r -= ua;
+    return static_cast<long long>(r);
+#endif
+}
+
+template<typename T>
+CUJ_FUNCTION_PREFIX T _cuj_add_sat(T a, T b)
+{
+    const unsigned long long mask = ~0ull >> (64 - 8 * sizeof(T));
+    const unsigned long long ua = _cuj_zext64(a), ub = _cuj_zext64(b);
+    const unsigned long long ur = (ua + ub) & mask;
+    if(T(-1) > T(0))
+        return static_cast<T>(ur < ua ? mask : ur);
+
+    // signed overflow iff both operands have a sign different from the result
+    const unsigned long long sign_bit = (mask >> 1) + 1;
+    if(!((ua ^ ur) & (ub ^ ur) & sign_bit))
+        return static_cast<T>(ur);
+    return static_cast<T>(a < T(0) ? sign_bit : mask >> 1);
+}
+
 #ifdef CUJ_IS_CUDA
 
 CUJ_FUNCTION_PREFIX inline int _cuj_thread_idx_x()
@@ -639,63 +896,220 @@ CUJ_FUNCTION_PREFIX inline void _cuj_load_i32x2(int *p, int *a, int *b)
 #endif
 }
 
-CUJ_FUNCTION_PREFIX inline int _cuj_i32_atomic_add(int *p, int v)
-{
+// atomic operations. order and scope are values of cuj::core::MemoryOrder
+// and cuj::core::MemoryScope
+
 #ifdef CUJ_IS_CUDA
-    return atomicAdd(p, v);
-#else
-    return CUJ_STD atomic_ref(*p).fetch_add(v);
-#endif
+
+CUJ_FUNCTION_PREFIX inline void _cuj_scoped_fence(int scope)
+{
+    if(scope == 0)
+        __threadfence_block();
+    else if(scope == 1)
+        __threadfence();
+    else
+        __threadfence_system();
 }
 
-CUJ_FUNCTION_PREFIX inline float _cuj_f32_atomic_add(float *p, float v)
+// release/acq_rel/seq_cst
+CUJ_FUNCTION_PREFIX inline void _cuj_fence_before_atomic(int order, int scope)
 {
-#ifdef CUJ_IS_CUDA
-    return atomicAdd(p, v);
-#else
-    return CUJ_STD atomic_ref(*p).fetch_add(v);
-#endif
+    if(order >= 2)
+        _cuj_scoped_fence(scope);
 }
 
-CUJ_FUNCTION_PREFIX inline unsigned _cuj_u32_atomic_add(unsigned *p, unsigned v)
+// acquire/acq_rel/seq_cst
+CUJ_FUNCTION_PREFIX inline void _cuj_fence_after_atomic(int order, int scope)
 {
-#ifdef CUJ_IS_CUDA
-    return atomicAdd(p, v);
-#else
-    return CUJ_STD atomic_ref(*p).fetch_add(v);
-#endif
+    if(order == 1 || order >= 3)
+        _cuj_scoped_fence(scope);
 }
 
-CUJ_FUNCTION_PREFIX inline unsigned _cuj_i32_atomic_cmpxchg(unsigned *p, unsigned cmp, unsigned new_val)
+// cuda atomics take unsigned long long instead of long long, and only
+// atomicAdd supports double
+
+template<typename T> struct _cuj_atomic_native            { using Type = T; };
+
+template<typename T> struct _cuj_atomic_add_bits            { using Type = T; };
+template<>           struct _cuj_atomic_add_bits<long long> { using Type = unsigned long long; };
+
+template<typename T> struct _cuj_atomic_int_bits            { using Type = T; };
+template<>           struct _cuj_atomic_int_bits<long long> { using Type = unsigned long long; };
+template<>           struct _cuj_atomic_int_bits<double>    { using Type = unsigned long long; };
+
+template<typename To, typename From>
+CUJ_FUNCTION_PREFIX To _cuj_atomic_bitcast(From from)
 {
-#ifdef CUJ_IS_CUDA
-    return atomicCAS(p, cmp, new_val);
-#else
-    std::atomic_ref(*p).compare_exchange_strong(cmp, new_val);
-    return cmp;
-#endif
+    To to;
+    memcpy(&to, &from, sizeof(To));
+    return to;
 }
 
-CUJ_FUNCTION_PREFIX inline int _cuj_u32_atomic_cmpxchg(int *p, int cmp, int new_val)
+#define CUJ_DEFINE_ATOMIC_RMW(NAME, FUNC, BITS)                                 \
+    template<typename T>                                                        \
+    CUJ_FUNCTION_PREFIX T NAME(T *p, T v, int order, int scope)                 \
+    {                                                                           \
+        using U = typename BITS<T>::Type;                                       \
+        U *up = reinterpret_cast<U *>(p);                                       \
+        U uv = _cuj_atomic_bitcast<U>(v);                                       \
+        _cuj_fence_before_atomic(order, scope);                                 \
+        U r = scope == 0 ? FUNC##_block(up, uv) :                               \
+              scope == 1 ? FUNC(up, uv) : FUNC##_system(up, uv);                \
+        _cuj_fence_after_atomic(order, scope);                                  \
+        return _cuj_atomic_bitcast<T>(r);                                       \
+    }
+
+CUJ_DEFINE_ATOMIC_RMW(_cuj_atomic_exchange, atomicExch, _cuj_atomic_int_bits)
+CUJ_DEFINE_ATOMIC_RMW(_cuj_atomic_add,      atomicAdd,  _cuj_atomic_add_bits)
+CUJ_DEFINE_ATOMIC_RMW(_cuj_atomic_and,      atomicAnd,  _cuj_atomic_int_bits)
+CUJ_DEFINE_ATOMIC_RMW(_cuj_atomic_or,       atomicOr,   _cuj_atomic_int_bits)
+CUJ_DEFINE_ATOMIC_RMW(_cuj_atomic_xor,      atomicXor,  _cuj_atomic_int_bits)
+CUJ_DEFINE_ATOMIC_RMW(_cuj_atomic_min,      atomicMin,  _cuj_atomic_native)
+CUJ_DEFINE_ATOMIC_RMW(_cuj_atomic_max,      atomicMax,  _cuj_atomic_native)
+
+#undef CUJ_DEFINE_ATOMIC_RMW
+
+template<typename T>
+CUJ_FUNCTION_PREFIX T _cuj_atomic_cmpxchg(T *p, T cmp, T new_val, int order, int scope)
 {
-#ifdef CUJ_IS_CUDA
-    return atomicCAS(p, cmp, new_val);
-#else
-    std::atomic_ref(*p).compare_exchange_strong(cmp, new_val);
-    return cmp;
-#endif
+    using U = typename _cuj_atomic_int_bits<T>::Type;
+    U *up = reinterpret_cast<U *>(p);
+    U ucmp = _cuj_atomic_bitcast<U>(cmp);
+    U unew = _cuj_atomic_bitcast<U>(new_val);
+    _cuj_fence_before_atomic(order, scope);
+    U r = scope == 0 ? atomicCAS_block(up, ucmp, unew) :
+          scope == 1 ? atomicCAS(up, ucmp, unew) : atomicCAS_system(up, ucmp, unew);
+    _cuj_fence_after_atomic(order, scope);
+    return _cuj_atomic_bitcast<T>(r);
 }
 
-CUJ_FUNCTION_PREFIX inline unsigned long long _cuj_u64_atomic_cmpxchg(unsigned long long *p, unsigned long long cmp, unsigned long long new_val)
+template<typename T>
+CUJ_FUNCTION_PREFIX T _cuj_atomic_load(T *p, int order, int scope)
 {
-#ifdef CUJ_IS_CUDA
-    return atomicCAS(p, cmp, new_val);
-#else
-    std::atomic_ref(*p).compare_exchange_strong(cmp, new_val);
+    _cuj_fence_before_atomic(order, scope);
+    T r = *reinterpret_cast<volatile T *>(p);
+    _cuj_fence_after_atomic(order, scope);
+    return r;
+}
+
+template<typename T>
+CUJ_FUNCTION_PREFIX void _cuj_atomic_store(T *p, T v, int order, int scope)
+{
+    _cuj_fence_before_atomic(order, scope);
+    *reinterpret_cast<volatile T *>(p) = v;
+    _cuj_fence_after_atomic(order, scope);
+}
+
+CUJ_FUNCTION_PREFIX inline void _cuj_atomic_fence(int, int scope)
+{
+    _cuj_scoped_fence(scope);
+}
+
+#else // #ifdef CUJ_IS_CUDA
+
+inline std::memory_order _cuj_memory_order(int order)
+{
+    switch(order)
+    {
+    case 0:  return std::memory_order_relaxed;
+    case 1:  return std::memory_order_acquire;
+    case 2:  return std::memory_order_release;
+    case 3:  return std::memory_order_acq_rel;
+    default: return std::memory_order_seq_cst;
+    }
+}
+
+// order of the load part of an operation
+inline std::memory_order _cuj_load_memory_order(int order)
+{
+    switch(order)
+    {
+    case 1:
+    case 3:  return std::memory_order_acquire;
+    case 4:  return std::memory_order_seq_cst;
+    default: return std::memory_order_relaxed;
+    }
+}
+
+template<typename T>
+T _cuj_atomic_load(T *p, int order, int)
+{
+    return std::atomic_ref<T>(*p).load(_cuj_memory_order(order));
+}
+
+template<typename T>
+void _cuj_atomic_store(T *p, T v, int order, int)
+{
+    std::atomic_ref<T>(*p).store(v, _cuj_memory_order(order));
+}
+
+template<typename T>
+T _cuj_atomic_exchange(T *p, T v, int order, int)
+{
+    return std::atomic_ref<T>(*p).exchange(v, _cuj_memory_order(order));
+}
+
+template<typename T>
+T _cuj_atomic_cmpxchg(T *p, T cmp, T new_val, int order, int)
+{
+    std::atomic_ref<T>(*p).compare_exchange_strong(
+        cmp, new_val, _cuj_memory_order(order), _cuj_load_memory_order(order));
     return cmp;
-#endif
 }
 
+template<typename T>
+T _cuj_atomic_add(T *p, T v, int order, int)
+{
+    return std::atomic_ref<T>(*p).fetch_add(v, _cuj_memory_order(order));
+}
+
+template<typename T>
+T _cuj_atomic_and(T *p, T v, int order, int)
+{
+    return std::atomic_ref<T>(*p).fetch_and(v, _cuj_memory_order(order));
+}
+
+template<typename T>
+T _cuj_atomic_or(T *p, T v, int order, int)
+{
+    return std::atomic_ref<T>(*p).fetch_or(v, _cuj_memory_order(order));
+}
+
+template<typename T>
+T _cuj_atomic_xor(T *p, T v, int order, int)
+{
+    return std::atomic_ref<T>(*p).fetch_xor(v, _cuj_memory_order(order));
+}
+
+template<typename T>
+T _cuj_atomic_min(T *p, T v, int order, int)
+{
+    std::atomic_ref<T> ref(*p);
+    T old = ref.load(_cuj_load_memory_order(order));
+    while(v < old && !ref.compare_exchange_weak(
+        old, v, _cuj_memory_order(order), _cuj_load_memory_order(order)))
+        ;
+    return old;
+}
+
+template<typename T>
+T _cuj_atomic_max(T *p, T v, int order, int)
+{
+    std::atomic_ref<T> ref(*p);
+    T old = ref.load(_cuj_load_memory_order(order));
+    while(old < v && !ref.compare_exchange_weak(
+        old, v, _cuj_memory_order(order), _cuj_load_memory_order(order)))
+        ;
+    return old;
+}
+
+inline void _cuj_atomic_fence(int order, int)
+{
+    std::atomic_thread_fence(_cuj_memory_order(order));
+}
+
+#endif // #ifdef CUJ_IS_CUDA
+
 #define _cuj_print printf
 
 #ifdef CUJ_IS_CUDA
@@ -707,7 +1121,7 @@ __device__ void __assertfail(
     size_t      charSize);
 #endif
 
-CUJ_FUNCTION_PREFIX inline void _cuj_assertfail(
+CUJ_FUNCTION_PREFIX CUJ_ATTRIB_COLD inline void _cuj_assertfail(
     const char *message,
     const char *file,
     int         line,
@@ -768,6 +1182,250 @@ CUJ_FUNCTION_PREFIX inline void _cuj_sample_tex3d_i32(unsigned long long tex, fl
 
 #endif
 
+CUJ_FUNCTION_PREFIX inline constexpr size_t _cuj_vector_alignment(size_t size)
+{
+    size_t result = 1;
+    while(result < size)
+        result *= 2;
+    return result;
+}
+
+template<typename T, int N>
+struct alignas(_cuj_vector_alignment(sizeof(T) * N)) _CujVector
+{
+    using Element = T;
+    static constexpr int Size = N;
+
+    T data[N];
+
+    _CujVector() = default;
+
+    template<typename U>
+    CUJ_FUNCTION_PREFIX explicit _CujVector(const _CujVector<U, N> &other)
+    {
+        for(int i = 0; i < N; ++i)
+            data[i] = static_cast<T>(other.data[i]);
+    }
+};
+
+#define CUJ_VECTOR_BINARY_OP(OP, RET)                                          \
+template<typename T, int N>                                                    \
+CUJ_FUNCTION_PREFIX _CujVector<RET, N> operator OP(                            \
+    const _CujVector<T, N> &a, const _CujVector<T, N> &b)                      \
+{                                                                              \
+    _CujVector<RET, N> r;                                                      \
+    for(int i = 0; i < N; ++i)                                                 \
+        r.data[i] = a.data[i] OP b.data[i];                                    \
+    return r;                                                                  \
+}
+
+CUJ_VECTOR_BINARY_OP(+,  T)
+CUJ_VECTOR_BINARY_OP(-,  T)
+CUJ_VECTOR_BINARY_OP(*,  T)
+CUJ_VECTOR_BINARY_OP(/,  T)
+CUJ_VECTOR_BINARY_OP(%,  T)
+CUJ_VECTOR_BINARY_OP(<<, T)
+CUJ_VECTOR_BINARY_OP(>>, T)
+CUJ_VECTOR_BINARY_OP(&,  T)
+CUJ_VECTOR_BINARY_OP(|,  T)
+CUJ_VECTOR_BINARY_OP(^,  T)
+CUJ_VECTOR_BINARY_OP(==, bool)
+CUJ_VECTOR_BINARY_OP(!=, bool)
+CUJ_VECTOR_BINARY_OP(<,  bool)
+CUJ_VECTOR_BINARY_OP(<=, bool)
+CUJ_VECTOR_BINARY_OP(>,  bool)
+CUJ_VECTOR_BINARY_OP(>=, bool)
+
+#undef CUJ_VECTOR_BINARY_OP
+
+#define CUJ_VECTOR_UNARY_OP(OP)                                                \
+template<typename T, int N>                                                    \
+CUJ_FUNCTION_PREFIX _CujVector<T, N> operator OP(const _CujVector<T, N> &a)    \
+{                                                                              \
+    _CujVector<T, N> r;                                                        \
+    for(int i = 0; i < N; ++i)                                                 \
+        r.data[i] = OP a.data[i];                                              \
+    return r;                                                                  \
+}
+
+CUJ_VECTOR_UNARY_OP(-)
+CUJ_VECTOR_UNARY_OP(~)
+CUJ_VECTOR_UNARY_OP(!)
+
+#undef CUJ_VECTOR_UNARY_OP
+
+template<typename V, typename...Ts>
+CUJ_FUNCTION_PREFIX V _cuj_make_vector(Ts...elems)
+{
+    const typename V::Element values[] = { elems... };
+    V r;
+    for(int i = 0; i < V::Size; ++i)
+        r.data[i] = values[i];
+    return r;
+}
+
+template<typename V>
+CUJ_FUNCTION_PREFIX V _cuj_broadcast_vector(typename V::Element elem)
+{
+    V r;
+    for(int i = 0; i < V::Size; ++i)
+        r.data[i] = elem;
+    return r;
+}
+
+template<typename T, int N>
+CUJ_FUNCTION_PREFIX _CujVector<T, N> _cuj_vector_insert(
+    _CujVector<T, N> v, unsigned int index, typename _CujVector<T, N>::Element elem)
+{
+    v.data[index] = elem;
+    return v;
+}
+
+template<typename T, int N>
+CUJ_FUNCTION_PREFIX _CujVector<T, N> _cuj_vector_select(
+    const _CujVector<bool, N> &mask, const _CujVector<T, N> &a, const _CujVector<T, N> &b)
+{
+    _CujVector<T, N> r;
+    for(int i = 0; i < N; ++i)
+        r.data[i] = mask.data[i] ? a.data[i] : b.data[i];
+    return r;
+}
+
+template<typename D, typename S, typename...Is>
+CUJ_FUNCTION_PREFIX D _cuj_vector_shuffle(const S &a, const S &b, Is...indices)
+{
+    const int idx[] = { indices... };
+    D r;
+    for(int i = 0; i < D::Size; ++i)
+        r.data[i] = idx[i] < S::Size ? a.data[idx[i]] : b.data[idx[i] - S::Size];
+    return r;
+}
+
+#define CUJ_VECTOR_REDUCE(NAME, EXPR)                                          \
+template<typename T, int N>                                                    \
+CUJ_FUNCTION_PREFIX T _cuj_vector_reduce_##NAME(const _CujVector<T, N> &v)     \
+{                                                                              \
+    T r = v.data[0];                                                           \
+    for(int i = 1; i < N; ++i)                                                 \
+    {                                                                          \
+        const T e = v.data[i];                                                 \
+        r = EXPR;                                                              \
+    }                                                                          \
+    return r;                                                                  \
+}
+
+CUJ_VECTOR_REDUCE(add,     r + e)
+CUJ_VECTOR_REDUCE(mul,     r * e)
+CUJ_VECTOR_REDUCE(min,     e < r ? e : r)
+CUJ_VECTOR_REDUCE(max,     r < e ? e : r)
+CUJ_VECTOR_REDUCE(bit_and, r & e)
+CUJ_VECTOR_REDUCE(bit_or,  r | e)
+CUJ_VECTOR_REDUCE(bit_xor, r ^ e)
+
+#undef CUJ_VECTOR_REDUCE
+
+template<typename T, int N>
+CUJ_FUNCTION_PREFIX _CujVector<T, N> _cuj_masked_load(
+    const T *p, const _CujVector<bool, N> &mask, _CujVector<T, N> passthru)
+{
+    for(int i = 0; i < N; ++i)
+    {
+        if(mask.data[i])
+            passthru.data[i] = p[i];
+    }
+    return passthru;
+}
+
+template<typename T, int N>
+CUJ_FUNCTION_PREFIX void _cuj_masked_store(
+    T *p, const _CujVector<bool, N> &mask, const _CujVector<T, N> &val)
+{
+    for(int i = 0; i < N; ++i)
+    {
+        if(mask.data[i])
+            p[i] = val.data[i];
+    }
+}
+
+template<typename T, int N>
+CUJ_FUNCTION_PREFIX _CujVector<T, N> _cuj_gather(
+    const T *p, const _CujVector<int, N> &indices,
+    const _CujVector<bool, N> &mask, _CujVector<T, N> passthru)
+{
+    for(int i = 0; i < N; ++i)
+    {
+        if(mask.data[i])
+            passthru.data[i] = p[indices.data[i]];
+    }
+    return passthru;
+}
+
+template<typename T, int N>
+CUJ_FUNCTION_PREFIX void _cuj_scatter(
+    T *p, const _CujVector<int, N> &indices,
+    const _CujVector<bool, N> &mask, const _CujVector<T, N> &val)
+{
+    for(int i = 0; i < N; ++i)
+    {
+        if(mask.data[i])
+            p[indices.data[i]] = val.data[i];
+    }
+}
+
+// locality and write flag are always immediate values, so the builtins
+// receive constant arguments after macro expansion
+
+#if !defined(CUJ_IS_CUDA) && (defined(__GNUC__) || defined(__clang__))
+template<size_t ALIGN, typename T>
+CUJ_FUNCTION_PREFIX T *_cuj_assume_aligned_impl(T *p)
+{
+    return static_cast<T *>(__builtin_assume_aligned(p, ALIGN));
+}
+#define _cuj_prefetch(P, LOCALITY, WRITE) \
+    __builtin_prefetch((P), (WRITE) ? 1 : 0, (LOCALITY))
+#define _cuj_assume_aligned(P, ALIGN) (_cuj_assume_aligned_impl<(ALIGN)>(P))
+#else
+#define _cuj_prefetch(P, LOCALITY, WRITE) ((void)(P))
+#define _cuj_assume_aligned(P, ALIGN) (P)
+#endif
+
+#if defined(CUJ_IS_CUDA)
+#define _cuj_assume(COND) ((void)(COND))
+#elif defined(__clang__)
+#define _cuj_assume(COND) __builtin_assume(COND)
+#elif defined(__GNUC__)
+#define _cuj_assume(COND) ((COND) ? (void)0 : __builtin_unreachable())
+#elif defined(_MSC_VER)
+#define _cuj_assume(COND) __assume(COND)
+#else
+#define _cuj_assume(COND) ((void)(COND))
+#endif
+
+template<typename T>
+CUJ_FUNCTION_PREFIX void _cuj_store_nontemporal(T *p, T val)
+{
+    *p = val;
+}
+
+#if !defined(CUJ_IS_CUDA) && defined(__clang__)
+
+#define CUJ_STORE_NONTEMPORAL(T)                                               \
+CUJ_FUNCTION_PREFIX inline void _cuj_store_nontemporal(T *p, T val)            \
+{                                                                              \
+    __builtin_nontemporal_store(val, p);                                       \
+}
+
+CUJ_STORE_NONTEMPORAL(float)
+CUJ_STORE_NONTEMPORAL(double)
+CUJ_STORE_NONTEMPORAL(int)
+CUJ_STORE_NONTEMPORAL(unsigned int)
+CUJ_STORE_NONTEMPORAL(long long)
+CUJ_STORE_NONTEMPORAL(unsigned long long)
+
+#undef CUJ_STORE_NONTEMPORAL
+
+#endif
+
 CUJ_FUNCTION_PREFIX inline void _cuj_memcpy(void *dst, void *src, unsigned long long size)
 {
     CUJ_STD memcpy(dst, src, size);
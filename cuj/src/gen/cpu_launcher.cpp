@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cuj/gen/cpu_launcher.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+namespace
+{
+
+    // blocks [begin, end) owned by one thread. the owner takes blocks from
+    // the front, and other threads steal the back half when they are idle
+    struct alignas(64) BlockRange
+    {
+        std::mutex mutex;
+        int64_t    begin = 0;
+        int64_t    end   = 0;
+    };
+
+} // namespace anonymous
+
+struct CPULauncher::CPULauncherData
+{
+    std::mutex launch_mutex;
+
+    std::mutex              mutex;
+    std::condition_variable start_cond;
+    std::condition_variable finish_cond;
+    bool                    stop            = false;
+    uint64_t                launch_index    = 0;
+    int                     running_workers = 0;
+
+    // current launch
+
+    Dim3          block_cnt;
+    Dim3          block_size;
+    BlockFunction block_func      = nullptr;
+    const void   *block_func_data = nullptr;
+
+    // ranges[0] belongs to the launching thread, and ranges[i] belongs to
+    // workers[i - 1]
+    std::vector<BlockRange>  ranges;
+    std::vector<std::thread> workers;
+
+    bool pop_block(int owner, int64_t &block_index)
+    {
+        auto &range = ranges[owner];
+        std::lock_guard lock(range.mutex);
+        if(range.begin >= range.end)
+            return false;
+        block_index = range.begin++;
+        return true;
+    }
+
+    bool steal_blocks(int thief)
+    {
+        const int range_count = static_cast<int>(ranges.size());
+        for(int i = 1; i < range_count; ++i)
+        {
+            auto &victim = ranges[(thief + i) % range_count];
+
+            int64_t begin, end;
+            {
+                std::lock_guard lock(victim.mutex);
+                const int64_t remaining = victim.end - victim.begin;
+                if(remaining <= 0)
+                    continue;
+                begin = victim.end - (remaining + 1) / 2;
+                end = victim.end;
+                victim.end = begin;
+            }
+
+            auto &range = ranges[thief];
+            std::lock_guard lock(range.mutex);
+            range.begin = begin;
+            range.end   = end;
+            return true;
+        }
+        return false;
+    }
+
+    void run_blocks(int owner)
+    {
+        const int64_t block_cnt_xy =
+            static_cast<int64_t>(block_cnt.x) * block_cnt.y;
+
+        for(;;)
+        {
+            int64_t block_index;
+            if(!pop_block(owner, block_index))
+            {
+                if(!steal_blocks(owner))
+                    return;
+                continue;
+            }
+
+            const int64_t block_index_xy = block_index % block_cnt_xy;
+            const CPUBlockInfo block_info = {
+                .block_idx = {
+                    static_cast<int32_t>(block_index_xy % block_cnt.x),
+                    static_cast<int32_t>(block_index_xy / block_cnt.x),
+                    static_cast<int32_t>(block_index / block_cnt_xy)
+                },
+                .block_dim = { block_size.x, block_size.y, block_size.z }
+            };
+            block_func(block_func_data, block_info);
+        }
+    }
+
+    void run_worker(int owner)
+    {
+        uint64_t last_launch_index = 0;
+        for(;;)
+        {
+            {
+                std::unique_lock lock(mutex);
+                start_cond.wait(lock, [&]
+                {
+                    return stop || launch_index != last_launch_index;
+                });
+                if(stop)
+                    return;
+                last_launch_index = launch_index;
+            }
+
+            run_blocks(owner);
+
+            std::lock_guard lock(mutex);
+            if(--running_workers == 0)
+                finish_cond.notify_one();
+        }
+    }
+};
+
+CPULauncher::CPULauncher(int thread_count)
+{
+    if(thread_count <= 0)
+    {
+        thread_count = static_cast<int>(
+            (std::max)(std::thread::hardware_concurrency(), 1u));
+    }
+
+    data_ = new CPULauncherData;
+    data_->ranges = std::vector<BlockRange>(thread_count);
+    for(int i = 1; i < thread_count; ++i)
+        data_->workers.emplace_back([data = data_, i] { data->run_worker(i); });
+}
+
+CPULauncher::~CPULauncher()
+{
+    {
+        std::lock_guard lock(data_->mutex);
+        data_->stop = true;
+    }
+    data_->start_cond.notify_all();
+
+    for(auto &worker : data_->workers)
+        worker.join();
+    delete data_;
+}
+
+int CPULauncher::get_thread_count() const
+{
+    return static_cast<int>(data_->ranges.size());
+}
+
+void CPULauncher::launch_impl(
+    const Dim3   &block_cnt,
+    const Dim3   &block_size,
+    BlockFunction block_func,
+    const void   *block_func_data)
+{
+    if(block_cnt.x <= 0 || block_cnt.y <= 0 || block_cnt.z <= 0 ||
+       block_size.x <= 0 || block_size.y <= 0 || block_size.z <= 0)
+        throw CujException("invalid kernel launch dimensions");
+
+    std::lock_guard launch_lock(data_->launch_mutex);
+
+    // blocks are initially split evenly
+
+    const int64_t total_block_cnt =
+        static_cast<int64_t>(block_cnt.x) * block_cnt.y * block_cnt.z;
+    const int64_t range_count = static_cast<int64_t>(data_->ranges.size());
+    for(int64_t i = 0; i < range_count; ++i)
+    {
+        auto &range = data_->ranges[i];
+        std::lock_guard lock(range.mutex);
+        range.begin = total_block_cnt * i / range_count;
+        range.end   = total_block_cnt * (i + 1) / range_count;
+    }
+
+    {
+        std::lock_guard lock(data_->mutex);
+        data_->block_cnt       = block_cnt;
+        data_->block_size      = block_size;
+        data_->block_func      = block_func;
+        data_->block_func_data = block_func_data;
+        data_->running_workers = static_cast<int>(data_->workers.size());
+        ++data_->launch_index;
+    }
+    data_->start_cond.notify_all();
+
+    data_->run_blocks(0);
+
+    std::unique_lock lock(data_->mutex);
+    data_->finish_cond.wait(lock, [&] { return data_->running_workers == 0; });
+}
+
+CUJ_NAMESPACE_END(cuj::gen)
@@ -0,0 +1,139 @@
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include <cuj/dsl/module.h>
+#include <cuj/gen/jit_service.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+namespace
+{
+
+    struct Task
+    {
+        Box<dsl::Module>             mod;
+        Options                      opts;
+        std::stop_token              cancel_token;
+        std::promise<CompiledModule> promise;
+    };
+
+    // (inverted priority, submission index)
+    using TaskKey = std::pair<int, uint64_t>;
+
+    void cancel_task(Task &task)
+    {
+        task.promise.set_exception(std::make_exception_ptr(
+            CujException("jit task is cancelled")));
+    }
+
+} // namespace anonymous
+
+struct JITService::JITServiceData
+{
+    std::mutex              mutex;
+    std::condition_variable cond;
+    bool                    stop = false;
+
+    uint64_t                next_task_index = 0;
+    std::map<TaskKey, Task> pending_tasks;
+
+    std::vector<std::thread> workers;
+
+    void run_worker()
+    {
+        for(;;)
+        {
+            Task task;
+            {
+                std::unique_lock lock(mutex);
+                cond.wait(lock, [&] { return stop || !pending_tasks.empty(); });
+                if(stop)
+                    return;
+                auto it = pending_tasks.begin();
+                task = std::move(it->second);
+                pending_tasks.erase(it);
+            }
+
+            if(task.cancel_token.stop_requested())
+            {
+                cancel_task(task);
+                continue;
+            }
+
+            try
+            {
+                MCJIT mcjit;
+                mcjit.set_options(task.opts);
+                mcjit.generate(*task.mod);
+                task.mod.reset();
+                task.promise.set_value(std::move(mcjit));
+            }
+            catch(...)
+            {
+                task.promise.set_exception(std::current_exception());
+            }
+        }
+    }
+};
+
+JITService::JITService(int thread_count)
+{
+    if(thread_count <= 0)
+    {
+        thread_count = static_cast<int>(
+            (std::max)(std::thread::hardware_concurrency(), 1u));
+    }
+
+    data_ = new JITServiceData;
+    for(int i = 0; i < thread_count; ++i)
+        data_->workers.emplace_back([data = data_] { data->run_worker(); });
+}
+
+JITService::~JITService()
+{
+    {
+        std::lock_guard lock(data_->mutex);
+        data_->stop = true;
+        for(auto &[key, task] : data_->pending_tasks)
+            cancel_task(task);
+        data_->pending_tasks.clear();
+    }
+    data_->cond.notify_all();
+
+    for(auto &worker : data_->workers)
+        worker.join();
+    delete data_;
+}
+
+std::future<CompiledModule> JITService::submit(
+    dsl::Module   &&mod,
+    const Options  &opts,
+    Priority        priority,
+    std::stop_token cancel_token)
+{
+    Task task;
+    task.mod          = newBox<dsl::Module>(std::move(mod));
+    task.opts         = opts;
+    task.cancel_token = std::move(cancel_token);
+    auto result = task.promise.get_future();
+
+    {
+        std::lock_guard lock(data_->mutex);
+        const TaskKey key = {
+            -static_cast<int>(priority), data_->next_task_index++ };
+        data_->pending_tasks.insert({ key, std::move(task) });
+    }
+    data_->cond.notify_one();
+
+    return result;
+}
+
+size_t JITService::get_pending_task_count() const
+{
+    std::lock_guard lock(data_->mutex);
+    return data_->pending_tasks.size();
+}
+
+CUJ_NAMESPACE_END(cuj::gen)
@@ -7,12 +7,15 @@
 #pragma warning(disable: 4996)
 #endif
 
+#include <array>
 #include <stack>
 
 #include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/CFG.h>
 #include <llvm/IR/Intrinsics.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/MDBuilder.h>
 #include <llvm/IR/InlineAsm.h>
 #include <llvm/IR/IntrinsicsNVPTX.h>
 #include <llvm/IR/Verifier.h>
@@ -28,50 +31,18 @@
 #include <cuj/utils/scope_guard.h>
 #include <cuj/utils/unreachable.h>
 
+#include "./llvm/atomic_intrinsics.h"
+#include "./llvm/generator_data.h"
 #include "./llvm/helper.h"
 #include "./llvm/libdevice_man.h"
 #include "./llvm/native_intrinsics.h"
 #include "./llvm/ptx_intrinsics.h"
+#include "./llvm/spmd_kernel.h"
 #include "./llvm/type_manager.h"
 #include "./llvm/vector_intrinsic.h"
 
 CUJ_NAMESPACE_BEGIN(cuj::gen)
 
-struct LLVMIRGenerator::LLVMData
-{
-    // per module
-
-    core::Prog             prog;
-    Box<llvm::LLVMContext> context;
-
-    Box<llvm::IRBuilder<>> ir_builder;
-    Box<llvm::Module>      top_module;
-
-    struct FunctionRecord
-    {
-        llvm::Function *llvm_function;
-    };
-
-    std::map<const core::Func *, FunctionRecord> llvm_functions_;
-
-    std::map<const core::GlobalVar *, llvm::GlobalVariable *> global_vars_;
-
-    std::map<std::vector<unsigned char>, llvm::GlobalVariable *> global_const_vars_;
-
-    llvm_helper::TypeManager type_manager;
-
-    // per function
-
-    llvm::Function *current_function = nullptr;
-
-    std::vector<llvm::AllocaInst *> local_allocas;
-    std::vector<llvm::AllocaInst *> arg_allocas;
-
-    std::stack<llvm::BasicBlock *> break_dsts;
-    std::stack<llvm::BasicBlock *> continue_dsts;
-    std::stack<llvm::BasicBlock *> scope_exits;
-};
-
 LLVMIRGenerator::~LLVMIRGenerator()
 {
     delete llvm_;
@@ -92,6 +63,16 @@ void LLVMIRGenerator::use_approx_math_func()
     approx_math_func_ = true;
 }
 
+void LLVMIRGenerator::set_native_math_precision(MathPrecision precision)
+{
+    math_precision_ = precision;
+}
+
+void LLVMIRGenerator::set_cpu_kernel_simd_width(int width)
+{
+    cpu_kernel_simd_width_ = width;
+}
+
 void LLVMIRGenerator::disable_assert()
 {
     enable_assert_ = false;
@@ -103,6 +84,11 @@ void LLVMIRGenerator::set_data_layout(llvm::DataLayout *data_layout)
 }
 
 void LLVMIRGenerator::generate(const dsl::Module &mod)
+{
+    generate(mod._generate_prog());
+}
+
+void LLVMIRGenerator::generate(core::Prog program)
 {
     assert(!llvm_);
     llvm_ = new LLVMData;
@@ -133,7 +119,7 @@ void LLVMIRGenerator::generate(const dsl::Module &mod)
     if(data_layout_)
         llvm_->top_module->setDataLayout(*data_layout_);
     
-    llvm_->prog = mod._generate_prog();
+    llvm_->prog = std::move(program);
     auto &prog = llvm_->prog;
 
     // build llvm types
@@ -267,6 +253,82 @@ llvm::FunctionType *LLVMIRGenerator::get_function_type(const core::Func &func)
     return llvm::FunctionType::get(ret_type, arg_types, false);
 }
 
+void LLVMIRGenerator::add_argument_attributes(
+    llvm::Function *llvm_func, const core::Func &func, unsigned first_arg)
+{
+    // references always point to a complete object, whose size is known
+    // only when the target data layout is given
+
+    auto add_reference_attributes = [&](
+        const core::Type *type, auto add_attr, auto add_dereferenceable)
+    {
+        add_attr(llvm::Attribute::NonNull);
+        if(!data_layout_)
+            return;
+        auto llvm_type = llvm_->type_manager.get_llvm_type(type);
+        if(llvm_type->isSized())
+        {
+            const uint64_t size = data_layout_->getTypeAllocSize(llvm_type);
+            if(size)
+                add_dereferenceable(size);
+        }
+    };
+
+    for(size_t i = 0; i < func.argument_types.size(); ++i)
+    {
+        auto &arg = func.argument_types[i];
+        const unsigned arg_index = first_arg + static_cast<unsigned>(i);
+        if(arg.is_restrict)
+            llvm_func->addParamAttr(arg_index, llvm::Attribute::NoAlias);
+        if(arg.is_reference)
+        {
+            add_reference_attributes(
+                arg.type,
+                [&](llvm::Attribute::AttrKind kind)
+            {
+                llvm_func->addParamAttr(arg_index, kind);
+            },
+                [&](uint64_t size)
+            {
+                llvm_func->addDereferenceableParamAttr(arg_index, size);
+            });
+        }
+    }
+
+    if(func.return_type.is_reference)
+    {
+        add_reference_attributes(
+            func.return_type.type,
+            [&](llvm::Attribute::AttrKind kind)
+        {
+            llvm_func->addAttribute(llvm::AttributeList::ReturnIndex, kind);
+        },
+            [&](uint64_t size)
+        {
+            llvm_func->addDereferenceableAttr(
+                llvm::AttributeList::ReturnIndex, size);
+        });
+    }
+}
+
+void LLVMIRGenerator::add_function_attributes(
+    llvm::Function *llvm_func, const core::Func &func)
+{
+    using Attrib = core::Func::Attribute;
+    for(auto [attrib, llvm_attrib] : {
+        std::pair{ Attrib::AlwaysInline, llvm::Attribute::AlwaysInline },
+        std::pair{ Attrib::NoInline,     llvm::Attribute::NoInline     },
+        std::pair{ Attrib::Cold,         llvm::Attribute::Cold         },
+        std::pair{ Attrib::Hot,          llvm::Attribute::Hot          },
+        std::pair{ Attrib::ReadNone,     llvm::Attribute::ReadNone     },
+        std::pair{ Attrib::ReadOnly,     llvm::Attribute::ReadOnly     },
+        std::pair{ Attrib::NoUnwind,     llvm::Attribute::NoUnwind     } })
+    {
+        if(func.has_attribute(attrib))
+            llvm_func->addFnAttr(llvm_attrib);
+    }
+}
+
 void LLVMIRGenerator::declare_function(const core::Func *func)
 {
     std::string symbol_name = func->name;
@@ -287,6 +349,12 @@ void LLVMIRGenerator::declare_function(const core::Func *func)
             "multiple definitions of function " + symbol_name);
     }
 
+    if(func->type == core::Func::Kernel && target_ == Target::Native)
+    {
+        declare_native_kernel(func);
+        return;
+    }
+
     auto func_type = get_function_type(*func);
     llvm::Function *llvm_func;
     if(func->is_declaration)
@@ -300,15 +368,14 @@ void LLVMIRGenerator::declare_function(const core::Func *func)
             func_type, llvm::GlobalValue::ExternalLinkage,
             symbol_name, llvm_->top_module.get());
     }
+    add_argument_attributes(llvm_func, *func, 0);
+    add_function_attributes(llvm_func, *func);
 
     if(target_ == Target::PTX)
         llvm_func->addFnAttr("nvptx-f32ftz", "true");
 
     if(func->type == core::Func::Kernel)
     {
-        if(target_ != Target::PTX)
-            throw CujException("only ptx target supports kernel function");
-
         auto one = llvm_helper::llvm_constant_num(*llvm_->context, 1);
         llvm::Metadata *mds[] = {
             llvm::ValueAsMetadata::get(llvm_func),
@@ -325,15 +392,238 @@ void LLVMIRGenerator::declare_function(const core::Func *func)
     llvm_->llvm_functions_.insert({ func, { llvm_func } });
 }
 
+void LLVMIRGenerator::declare_native_kernel(const core::Func *func)
+{
+    if(func->is_declaration)
+        throw CujException("kernel function must be defined: " + func->name);
+
+    auto func_type       = get_function_type(*func);
+    auto i32_type        = llvm_->ir_builder->getInt32Ty();
+    auto block_info_type = llvm::PointerType::get(i32_type, 0);
+
+    // thread function: (args..., block_info, thread_idx_x/y/z)
+
+    std::vector<llvm::Type *> thread_arg_types(
+        func_type->param_begin(), func_type->param_end());
+    thread_arg_types.push_back(block_info_type);
+    thread_arg_types.insert(thread_arg_types.end(), 3, i32_type);
+
+    auto thread_func = llvm::Function::Create(
+        llvm::FunctionType::get(
+            func_type->getReturnType(), thread_arg_types, false),
+        llvm::GlobalValue::InternalLinkage,
+        func->name + ".thread", llvm_->top_module.get());
+    thread_func->addFnAttr(llvm::Attribute::AlwaysInline);
+    add_argument_attributes(thread_func, *func, 0);
+
+    const unsigned block_info_arg_index =
+        static_cast<unsigned>(func->argument_types.size());
+    thread_func->addParamAttr(block_info_arg_index, llvm::Attribute::NoAlias);
+    thread_func->addParamAttr(block_info_arg_index, llvm::Attribute::ReadOnly);
+
+    // entry function: (block_info, args...), running all threads in a block
+
+    std::vector<llvm::Type *> entry_arg_types = { block_info_type };
+    entry_arg_types.insert(
+        entry_arg_types.end(), func_type->param_begin(), func_type->param_end());
+
+    auto entry_func = llvm::Function::Create(
+        llvm::FunctionType::get(
+            func_type->getReturnType(), entry_arg_types, false),
+        llvm::GlobalValue::ExternalLinkage,
+        func->name, llvm_->top_module.get());
+    entry_func->addParamAttr(0, llvm::Attribute::NoAlias);
+    entry_func->addParamAttr(0, llvm::Attribute::ReadOnly);
+    add_argument_attributes(entry_func, *func, 1);
+    add_function_attributes(entry_func, *func);
+
+    // spmd function: (args..., block_info, thread_idx_x/y/z, lane mask),
+    // running threads thread_idx_x + i for each active lane i
+
+    llvm::Function *spmd_func = nullptr;
+    if(cpu_kernel_simd_width_ > 1 && SPMDKernelGenerator::is_supported(*func))
+    {
+        std::vector<llvm::Type *> spmd_arg_types = thread_arg_types;
+        spmd_arg_types.push_back(llvm::FixedVectorType::get(
+            llvm_->ir_builder->getInt1Ty(), cpu_kernel_simd_width_));
+
+        spmd_func = llvm::Function::Create(
+            llvm::FunctionType::get(
+                func_type->getReturnType(), spmd_arg_types, false),
+            llvm::GlobalValue::InternalLinkage,
+            func->name + ".spmd", llvm_->top_module.get());
+        spmd_func->addFnAttr(llvm::Attribute::AlwaysInline);
+        add_argument_attributes(spmd_func, *func, 0);
+        spmd_func->addParamAttr(block_info_arg_index, llvm::Attribute::NoAlias);
+        spmd_func->addParamAttr(block_info_arg_index, llvm::Attribute::ReadOnly);
+    }
+
+    generate_native_kernel_entry(entry_func, thread_func, spmd_func);
+
+    llvm_->llvm_functions_.insert({ func, { thread_func, spmd_func } });
+}
+
+void LLVMIRGenerator::generate_native_kernel_entry(
+    llvm::Function *entry_func,
+    llvm::Function *thread_func,
+    llvm::Function *spmd_func)
+{
+    auto &context  = *llvm_->context;
+    auto  i32_type = llvm::Type::getInt32Ty(context);
+
+    llvm::IRBuilder<> builder(context);
+    builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry", entry_func));
+
+    auto block_info = entry_func->getArg(0);
+    std::array<llvm::Value *, 3> block_dim;
+    for(int i = 0; i < 3; ++i)
+    {
+        auto addr = builder.CreateConstInBoundsGEP1_32(i32_type, block_info, 3 + i);
+        block_dim[i] = builder.CreateLoad(i32_type, addr);
+    }
+
+    std::vector<llvm::Value *> call_args;
+    for(unsigned i = 1; i < entry_func->arg_size(); ++i)
+        call_args.push_back(entry_func->getArg(i));
+    call_args.push_back(block_info);
+    call_args.resize(call_args.size() + 3);
+
+    // groups of consecutive x indices are run by spmd function. full groups
+    // are followed by at most one partial group, whose lanes out of block
+    // are masked. spmd function is inlined into both calls, which makes the
+    // mask of full groups a constant
+
+    auto generate_spmd_groups = [&]
+    {
+        const int width = cpu_kernel_simd_width_;
+        auto mask_type = llvm::FixedVectorType::get(builder.getInt1Ty(), width);
+
+        auto pre_block   = builder.GetInsertBlock();
+        auto group_block = llvm::BasicBlock::Create(
+            context, "thread_group_x", entry_func);
+        auto tail_check_block = llvm::BasicBlock::Create(
+            context, "thread_group_x_tail_check", entry_func);
+        auto tail_block = llvm::BasicBlock::Create(
+            context, "thread_group_x_tail", entry_func);
+        auto exit_block = llvm::BasicBlock::Create(
+            context, "thread_x_exit", entry_func);
+
+        auto zero = builder.getInt32(0);
+        auto last_group_begin = builder.CreateSub(
+            block_dim[0], builder.getInt32(width));
+        builder.CreateCondBr(
+            builder.CreateICmpSLE(zero, last_group_begin),
+            group_block, tail_check_block);
+
+        builder.SetInsertPoint(group_block);
+        auto idx = builder.CreatePHI(i32_type, 2, "thread_idx_x");
+        idx->addIncoming(zero, pre_block);
+        call_args[call_args.size() - 3] = idx;
+
+        auto spmd_args = call_args;
+        spmd_args.push_back(llvm::Constant::getAllOnesValue(mask_type));
+        builder.CreateCall(spmd_func, spmd_args);
+
+        auto next_idx = builder.CreateNSWAdd(idx, builder.getInt32(width));
+        idx->addIncoming(next_idx, builder.GetInsertBlock());
+        builder.CreateCondBr(
+            builder.CreateICmpSLE(next_idx, last_group_begin),
+            group_block, tail_check_block);
+
+        builder.SetInsertPoint(tail_check_block);
+        auto tail_idx = builder.CreatePHI(i32_type, 2, "tail_thread_idx_x");
+        tail_idx->addIncoming(zero, pre_block);
+        tail_idx->addIncoming(next_idx, group_block);
+        builder.CreateCondBr(
+            builder.CreateICmpSLT(tail_idx, block_dim[0]),
+            tail_block, exit_block);
+
+        builder.SetInsertPoint(tail_block);
+        std::vector<uint32_t> lane_offsets(width);
+        for(int i = 0; i < width; ++i)
+            lane_offsets[i] = static_cast<uint32_t>(i);
+        auto lane_idx = builder.CreateAdd(
+            builder.CreateVectorSplat(width, tail_idx),
+            llvm::ConstantDataVector::get(context, lane_offsets));
+        auto mask = builder.CreateICmpSLT(
+            lane_idx, builder.CreateVectorSplat(width, block_dim[0]));
+
+        call_args[call_args.size() - 3] = tail_idx;
+        spmd_args = call_args;
+        spmd_args.push_back(mask);
+        builder.CreateCall(spmd_func, spmd_args);
+        builder.CreateBr(exit_block);
+
+        builder.SetInsertPoint(exit_block);
+    };
+
+    // z is the outermost loop and x is the innermost one
+
+    auto generate_loop = [&](auto &self, int dim) -> void
+    {
+        if(dim < 0)
+        {
+            builder.CreateCall(thread_func, call_args);
+            return;
+        }
+
+        if(dim == 0 && spmd_func)
+        {
+            generate_spmd_groups();
+            return;
+        }
+
+        const std::string name = std::string(1, static_cast<char>('x' + dim));
+        auto pre_block  = builder.GetInsertBlock();
+        auto body_block = llvm::BasicBlock::Create(
+            context, "thread_" + name, entry_func);
+        auto exit_block = llvm::BasicBlock::Create(
+            context, "thread_" + name + "_exit", entry_func);
+
+        auto zero = builder.getInt32(0);
+        builder.CreateCondBr(
+            builder.CreateICmpSGT(block_dim[dim], zero), body_block, exit_block);
+
+        builder.SetInsertPoint(body_block);
+        auto idx = builder.CreatePHI(i32_type, 2, "thread_idx_" + name);
+        idx->addIncoming(zero, pre_block);
+        call_args[call_args.size() - 3 + dim] = idx;
+
+        self(self, dim - 1);
+
+        auto next_idx = builder.CreateNSWAdd(idx, builder.getInt32(1));
+        idx->addIncoming(next_idx, builder.GetInsertBlock());
+        builder.CreateCondBr(
+            builder.CreateICmpSLT(next_idx, block_dim[dim]),
+            body_block, exit_block);
+
+        builder.SetInsertPoint(exit_block);
+    };
+    generate_loop(generate_loop, 2);
+
+    builder.CreateRetVoid();
+}
+
 void LLVMIRGenerator::define_function(const core::Func *func)
 {
     if(func->is_declaration)
         return;
 
     clear_temp_function_data();
-    llvm_->current_function = llvm_->top_module->getFunction(func->name);
+    llvm_->current_function = llvm_->llvm_functions_.at(func).llvm_function;
     CUJ_SCOPE_EXIT{ llvm_->current_function = nullptr; };
 
+    if(func->type == core::Func::Kernel && target_ == Target::Native)
+    {
+        auto arg_index = static_cast<unsigned>(func->argument_types.size());
+        llvm_->block_info = llvm_->current_function->getArg(arg_index);
+        for(unsigned i = 0; i < 3; ++i)
+        {
+            llvm_->thread_idx[i] =
+                llvm_->current_function->getArg(arg_index + 1 + i);
+        }
+    }
+
     auto entry_block = llvm::BasicBlock::Create(
         *llvm_->context, "entry", llvm_->current_function);
     llvm_->ir_builder->SetInsertPoint(entry_block);
@@ -350,11 +640,20 @@ void LLVMIRGenerator::define_function(const core::Func *func)
     if(verifyFunction(*llvm_->current_function, &err_stream))
         throw CujException(err_msg);
 #endif
+
+    if(auto spmd_func = llvm_->llvm_functions_.at(func).spmd_function)
+    {
+        clear_temp_function_data();
+        SPMDKernelGenerator(*this, *func, cpu_kernel_simd_width_)
+            .generate(spmd_func);
+    }
 }
 
 void LLVMIRGenerator::clear_temp_function_data()
 {
     llvm_->current_function = nullptr;
+    llvm_->block_info = nullptr;
+    llvm_->thread_idx = {};
     llvm_->local_allocas.clear();
     llvm_->arg_allocas.clear();
     llvm_->break_dsts = {};
@@ -445,6 +744,11 @@ void LLVMIRGenerator::generate_default_ret(const core::Func *func)
             llvm_->ir_builder->CreateRet(
                 llvm::ConstantPointerNull::get(
                     llvm::dyn_cast<llvm::PointerType>(llvm_type)));
+        },
+            [&](const core::Vector &)
+        {
+            llvm_->ir_builder->CreateRet(
+                llvm::Constant::getNullValue(llvm_type));
         });
     }
 }
@@ -505,6 +809,26 @@ void LLVMIRGenerator::generate(const core::Return &ret)
     llvm_->ir_builder->SetInsertPoint(block);
 }
 
+llvm::MDNode *LLVMIRGenerator::get_branch_weights(
+    core::If::Likelihood likelihood)
+{
+    // same weights as clang uses for __builtin_expect
+    constexpr uint32_t LIKELY_WEIGHT   = 2000;
+    constexpr uint32_t UNLIKELY_WEIGHT = 1;
+
+    llvm::MDBuilder md_builder(*llvm_->context);
+    switch(likelihood)
+    {
+    case core::If::Likelihood::Unknown:
+        return nullptr;
+    case core::If::Likelihood::Likely:
+        return md_builder.createBranchWeights(LIKELY_WEIGHT, UNLIKELY_WEIGHT);
+    case core::If::Likelihood::Unlikely:
+        return md_builder.createBranchWeights(UNLIKELY_WEIGHT, LIKELY_WEIGHT);
+    }
+    unreachable();
+}
+
 void LLVMIRGenerator::generate(const core::If &if_s)
 {
     auto then_block = llvm::BasicBlock::Create(*llvm_->context, "then");
@@ -517,7 +841,8 @@ void LLVMIRGenerator::generate(const core::If &if_s)
     generate(*if_s.calc_cond);
     auto cond = generate(if_s.cond);
     llvm_->ir_builder->CreateCondBr(
-        cond, then_block, else_block ? else_block : exit_block);
+        cond, then_block, else_block ? else_block : exit_block,
+        get_branch_weights(if_s.likelihood));
 
     llvm_->current_function->getBasicBlockList().push_back(then_block);
     llvm_->ir_builder->SetInsertPoint(then_block);
@@ -536,6 +861,135 @@ void LLVMIRGenerator::generate(const core::If &if_s)
     llvm_->ir_builder->SetInsertPoint(exit_block);
 }
 
+void LLVMIRGenerator::add_loop_metadata(
+    const core::Loop::Hints &hints,
+    llvm::BasicBlock        *header,
+    llvm::BasicBlock        *exit_block)
+{
+    if(!hints.unroll_count && !hints.unroll_full && !hints.unroll_disable &&
+       !hints.vectorize_width && !hints.interleave_count && !hints.independent)
+        return;
+
+    // blocks of the loop are those reachable from the header
+    // without leaving through the exit block
+
+    std::vector<llvm::BasicBlock *> loop_blocks;
+    llvm::SmallPtrSet<llvm::BasicBlock *, 16> visited = { header, exit_block };
+    std::vector<llvm::BasicBlock *> pending = { header };
+    while(!pending.empty())
+    {
+        auto block = pending.back();
+        pending.pop_back();
+        loop_blocks.push_back(block);
+        for(auto succ : llvm::successors(block))
+        {
+            if(visited.insert(succ).second)
+                pending.push_back(succ);
+        }
+    }
+
+    auto &context = *llvm_->context;
+
+    auto make_flag = [&](const char *name)
+    {
+        return llvm::MDNode::get(context, llvm::MDString::get(context, name));
+    };
+
+    auto make_value = [&](const char *name, llvm::Constant *value)
+    {
+        return llvm::MDNode::get(context, {
+            llvm::MDString::get(context, name),
+            llvm::ConstantAsMetadata::get(value)
+        });
+    };
+
+    // the first operand is replaced with the loop id itself
+    std::vector<llvm::Metadata *> loop_properties = { nullptr };
+
+    if(hints.unroll_count)
+    {
+        loop_properties.push_back(make_value(
+            "llvm.loop.unroll.count",
+            llvm_->ir_builder->getInt32(hints.unroll_count)));
+    }
+    if(hints.unroll_full)
+        loop_properties.push_back(make_flag("llvm.loop.unroll.full"));
+    if(hints.unroll_disable)
+        loop_properties.push_back(make_flag("llvm.loop.unroll.disable"));
+
+    if(hints.vectorize_width)
+    {
+        loop_properties.push_back(make_value(
+            "llvm.loop.vectorize.width",
+            llvm_->ir_builder->getInt32(hints.vectorize_width)));
+        if(hints.vectorize_width > 1)
+        {
+            loop_properties.push_back(make_value(
+                "llvm.loop.vectorize.enable", llvm_->ir_builder->getTrue()));
+        }
+    }
+    if(hints.interleave_count)
+    {
+        loop_properties.push_back(make_value(
+            "llvm.loop.interleave.count",
+            llvm_->ir_builder->getInt32(hints.interleave_count)));
+    }
+
+    if(hints.independent)
+    {
+        // tag every memory access in the loop with a new access group.
+        // accesses in nested independent loops belong to several groups
+        auto access_group = llvm::MDNode::getDistinct(context, {});
+        for(auto block : loop_blocks)
+        {
+            for(auto &inst : *block)
+            {
+                if(!inst.mayReadOrWriteMemory())
+                    continue;
+                std::vector<llvm::Metadata *> groups;
+                if(auto old = inst.getMetadata(llvm::LLVMContext::MD_access_group))
+                {
+                    if(old->getNumOperands() == 0)
+                        groups.push_back(old);
+                    for(auto &op : old->operands())
+                        groups.push_back(op.get());
+                }
+                groups.push_back(access_group);
+                inst.setMetadata(
+                    llvm::LLVMContext::MD_access_group,
+                    groups.size() == 1 ?
+                        access_group : llvm::MDNode::get(context, groups));
+            }
+        }
+
+        loop_properties.push_back(llvm::MDNode::get(context, {
+            llvm::MDString::get(context, "llvm.loop.parallel_accesses"),
+            access_group
+        }));
+    }
+
+    auto loop_id = llvm::MDNode::getDistinct(context, loop_properties);
+    loop_id->replaceOperandWith(0, loop_id);
+
+    // continue statements create extra latches, and all of them must carry
+    // the same loop id
+    for(auto block : loop_blocks)
+    {
+        auto branch = llvm::dyn_cast_or_null<llvm::BranchInst>(
+            block->getTerminator());
+        if(!branch)
+            continue;
+        for(auto succ : branch->successors())
+        {
+            if(succ == header)
+            {
+                branch->setMetadata(llvm::LLVMContext::MD_loop, loop_id);
+                break;
+            }
+        }
+    }
+}
+
 void LLVMIRGenerator::generate(const core::Loop &loop)
 {
     auto body_block = llvm::BasicBlock::Create(*llvm_->context, "loop");
@@ -554,6 +1008,8 @@ void LLVMIRGenerator::generate(const core::Loop &loop)
     llvm_->break_dsts.pop();
     llvm_->continue_dsts.pop();
 
+    add_loop_metadata(loop.hints, body_block, exit_block);
+
     llvm_->current_function->getBasicBlockList().push_back(exit_block);
     llvm_->ir_builder->SetInsertPoint(exit_block);
 }
@@ -782,81 +1238,18 @@ llvm::Value *LLVMIRGenerator::generate(const core::NullPtr &expr)
 
 llvm::Value *LLVMIRGenerator::generate(const core::ArithmeticCast &expr)
 {
-    auto src_builtin_type = expr.src_type->as<core::Builtin>();
-    auto dst_builtin_type = expr.dst_type->as<core::Builtin>();
-
-    const bool is_src_int = !is_floating_point(src_builtin_type);
-    const bool is_dst_int = !is_floating_point(dst_builtin_type);
-    const bool is_src_signed = is_signed(src_builtin_type);
-    const bool is_dst_signed = is_signed(dst_builtin_type);
-
     auto src_val = generate(*expr.src_val);
-    if(src_builtin_type == dst_builtin_type)
-        return src_val;
-    auto dst_type = llvm_->type_manager.get_llvm_type(expr.dst_type);
-
-    if(src_builtin_type == core::Builtin::Bool)
-    {
-        if(is_dst_int)
-        {
-            return llvm_->ir_builder->CreateSelect(
-                src_val,
-                llvm::ConstantInt::get(dst_type, 1, false),
-                llvm::ConstantInt::get(dst_type, 0, false));
-        }
-        return llvm_->ir_builder->CreateSelect(
-            src_val,
-            llvm::ConstantFP::get(dst_type, 1),
-            llvm::ConstantFP::get(dst_type, 0));
-    }
-
-    if(is_src_int && is_dst_int)
-    {
-        if(is_dst_signed)
-            return llvm_->ir_builder->CreateSExtOrTrunc(src_val, dst_type);
-        return llvm_->ir_builder->CreateZExtOrTrunc(src_val, dst_type);
-    }
-
-    if(is_src_int && !is_dst_int)
-    {
-        if(is_src_signed)
-            return llvm_->ir_builder->CreateSIToFP(src_val, dst_type);
-        return llvm_->ir_builder->CreateUIToFP(src_val, dst_type);
-    }
-
-    if(!is_src_int && is_dst_int)
-    {
-        if(is_dst_signed)
-            return llvm_->ir_builder->CreateFPToSI(src_val, dst_type);
-        return llvm_->ir_builder->CreateFPToUI(src_val, dst_type);
-    }
-
-    if(!is_src_int && !is_dst_int)
-        return llvm_->ir_builder->CreateFPCast(src_val, dst_type);
-
-    unreachable();
+    return create_arithmetic_cast(
+        llvm_helper::get_arithmetic_builtin(expr.src_type),
+        llvm_helper::get_arithmetic_builtin(expr.dst_type),
+        src_val, llvm_->type_manager.get_llvm_type(expr.dst_type));
 }
 
 llvm::Value *LLVMIRGenerator::generate(const core::BitwiseCast &expr)
 {
-    auto src_type = llvm_->type_manager.get_llvm_type(expr.src_type);
-    auto dst_type = llvm_->type_manager.get_llvm_type(expr.dst_type);
     auto src_val = generate(*expr.src_val);
-
-    if(src_type->isPointerTy())
-    {
-        if(dst_type->isPointerTy()) // ptr to ptr
-            return llvm_->ir_builder->CreatePointerCast(src_val, dst_type);
-
-        // ptr to integer
-        return llvm_->ir_builder->CreatePtrToInt(src_val, dst_type);
-    }
-
-    if(dst_type->isPointerTy()) // integer to ptr
-        return llvm_->ir_builder->CreateIntToPtr(src_val, dst_type);
-
-    // arithmetic to arithmetic
-    return llvm_->ir_builder->CreateBitCast(src_val, dst_type);
+    return create_bitwise_cast(
+        src_val, llvm_->type_manager.get_llvm_type(expr.dst_type));
 }
 
 llvm::Value *LLVMIRGenerator::generate(const core::PointerOffset &expr)
@@ -923,195 +1316,70 @@ llvm::Value *LLVMIRGenerator::generate(const core::Binary &expr)
     auto lhs = generate(*expr.lhs);
     auto rhs = generate(*expr.rhs);
 
-    auto lhs_type = expr.lhs_type->as<core::Builtin>();
-    auto rhs_type = expr.rhs_type->as<core::Builtin>();
+    auto lhs_type = llvm_helper::get_arithmetic_builtin(expr.lhs_type);
+    auto rhs_type = llvm_helper::get_arithmetic_builtin(expr.rhs_type);
     assert(lhs_type == rhs_type);
 
-    switch(expr.op)
-    {
-    case core::Binary::Op::Add:
+    return create_binary(expr.op, lhs_type, lhs, rhs);
+}
+
+llvm::Value *LLVMIRGenerator::generate(const core::Unary &expr)
+{
+    auto val = generate(*expr.val);
+    return create_unary(
+        expr.op, llvm_helper::get_arithmetic_builtin(expr.val_type), val);
+}
+
+llvm::Value *LLVMIRGenerator::generate(const core::Select &expr)
+{
+    auto cond = generate(*expr.cond);
+    auto true_val = generate(*expr.true_val);
+    auto false_val = generate(*expr.false_val);
+    return llvm_->ir_builder->CreateSelect(cond, true_val, false_val);
+}
+
+llvm::Value *LLVMIRGenerator::generate(const core::CallFunc &expr)
+{
+    std::vector<llvm::Value *> args;
+    for(auto &a : expr.args)
+        args.push_back(generate(*a));
+
+    if(expr.contextless_func)
     {
-        assert(lhs_type != core::Builtin::Bool);
-        if(lhs->getType()->isFloatingPointTy())
-            return llvm_->ir_builder->CreateFAdd(lhs, rhs);
-        return llvm_->ir_builder->CreateAdd(lhs, rhs);
+        auto func = llvm_->top_module->getFunction(expr.contextless_func->name);
+        return llvm_->ir_builder->CreateCall(func, args);
     }
-    case core::Binary::Op::Sub:
+    
+    if(expr.intrinsic != core::Intrinsic::None)
+        return process_intrinsic_call(expr, args);
+
+    auto core_func = llvm_->prog.funcs[expr.contexted_func_index].get();
+    auto func = llvm_->llvm_functions_.at(core_func).llvm_function;
+    return llvm_->ir_builder->CreateCall(func, args);
+}
+
+llvm::Value *LLVMIRGenerator::generate(const core::GlobalVarAddr &expr)
+{
+    llvm::Value *ptr = llvm_->global_vars_.at(expr.var.get());
+    if(target_ == Target::PTX)
     {
-        assert(lhs_type != core::Builtin::Bool);
-        if(lhs->getType()->isFloatingPointTy())
-            return llvm_->ir_builder->CreateFSub(lhs, rhs);
-        return llvm_->ir_builder->CreateSub(lhs, rhs);
+        auto var_type = llvm_->type_manager.get_llvm_type(expr.var->type);
+        auto dst_type = llvm::PointerType::get(var_type, 0);
+        ptr = llvm_->ir_builder->CreateAddrSpaceCast(ptr, dst_type);
     }
-    case core::Binary::Op::Mul:
-    {
-        assert(lhs_type != core::Builtin::Bool);
-        if(lhs->getType()->isFloatingPointTy())
-            return llvm_->ir_builder->CreateFMul(lhs, rhs);
-        return llvm_->ir_builder->CreateMul(lhs, rhs);
-    }
-    case core::Binary::Op::Div:
-    {
-        assert(lhs_type != core::Builtin::Bool);
-        if(is_floating_point(lhs_type))
-            return llvm_->ir_builder->CreateFDiv(lhs, rhs);
-        if(is_signed(lhs_type))
-            return llvm_->ir_builder->CreateSDiv(lhs, rhs);
-        return llvm_->ir_builder->CreateUDiv(lhs, rhs);
-    }
-    case core::Binary::Op::Mod:
-    {
-        assert(!is_floating_point(lhs_type));
-        if(is_signed(lhs_type))
-            return llvm_->ir_builder->CreateSRem(lhs, rhs);
-        return llvm_->ir_builder->CreateURem(lhs, rhs);
-    }
-    case core::Binary::Op::Equal:
-    {
-        if(lhs->getType()->isFloatingPointTy())
-            return llvm_->ir_builder->CreateFCmpOEQ(lhs, rhs);
-        return llvm_->ir_builder->CreateICmpEQ(lhs, rhs);
-    }
-    case core::Binary::Op::NotEqual:
-    {
-        if(lhs->getType()->isFloatingPointTy())
-            return llvm_->ir_builder->CreateFCmpONE(lhs, rhs);
-        return llvm_->ir_builder->CreateICmpNE(lhs, rhs);
-    }
-    case core::Binary::Op::Less:
-    {
-        if(lhs->getType()->isFloatingPointTy())
-            return llvm_->ir_builder->CreateFCmpOLT(lhs, rhs);
-        if(is_signed(lhs_type))
-            return llvm_->ir_builder->CreateICmpSLT(lhs, rhs);
-        return llvm_->ir_builder->CreateICmpULT(lhs, rhs);
-    }
-    case core::Binary::Op::LessEqual:
-    {
-        if(lhs->getType()->isFloatingPointTy())
-            return llvm_->ir_builder->CreateFCmpOLE(lhs, rhs);
-        if(is_signed(lhs_type))
-            return llvm_->ir_builder->CreateICmpSLE(lhs, rhs);
-        return llvm_->ir_builder->CreateICmpULE(lhs, rhs);
-    }
-    case core::Binary::Op::Greater:
-    {
-        if(lhs->getType()->isFloatingPointTy())
-            return llvm_->ir_builder->CreateFCmpOGT(lhs, rhs);
-        if(is_signed(lhs_type))
-            return llvm_->ir_builder->CreateICmpSGT(lhs, rhs);
-        return llvm_->ir_builder->CreateICmpUGT(lhs, rhs);
-    }
-    case core::Binary::Op::GreaterEqual:
-    {
-        if(lhs->getType()->isFloatingPointTy())
-            return llvm_->ir_builder->CreateFCmpOGE(lhs, rhs);
-        if(is_signed(lhs_type))
-            return llvm_->ir_builder->CreateICmpSGE(lhs, rhs);
-        return llvm_->ir_builder->CreateICmpUGE(lhs, rhs);
-    }
-    case core::Binary::Op::LeftShift:
-    {
-        assert(!is_floating_point(lhs_type));
-        return llvm_->ir_builder->CreateShl(lhs, rhs);
-    }
-    case core::Binary::Op::RightShift:
-    {
-        assert(!is_signed(lhs_type));
-        assert(!is_floating_point(lhs_type));
-        return llvm_->ir_builder->CreateLShr(lhs, rhs);
-    }
-    case core::Binary::Op::BitwiseAnd:
-    {
-        assert(!is_floating_point(lhs_type));
-        return llvm_->ir_builder->CreateAnd(lhs, rhs);
-    }
-    case core::Binary::Op::BitwiseOr:
-    {
-        assert(!is_floating_point(lhs_type));
-        return llvm_->ir_builder->CreateOr(lhs, rhs);
-    }
-    case core::Binary::Op::BitwiseXOr:
-    {
-        assert(!is_floating_point(lhs_type));
-        return llvm_->ir_builder->CreateXor(lhs, rhs);
-    }
-    }
-
-    unreachable();
-}
-
-llvm::Value *LLVMIRGenerator::generate(const core::Unary &expr)
-{
-    auto val = generate(*expr.val);
-    auto val_type = expr.val_type->as<core::Builtin>();
-
-    switch(expr.op)
-    {
-    case core::Unary::Op::Neg:
-    {
-        assert(val_type != core::Builtin::Bool);
-        if(is_floating_point(val_type))
-            return llvm_->ir_builder->CreateFNeg(val);
-        return llvm_->ir_builder->CreateNeg(val);
-    }
-    case core::Unary::Op::Not:
-    {
-        assert(val_type == core::Builtin::Bool);
-        return llvm_->ir_builder->CreateNot(val);
-    }
-    case core::Unary::Op::BitwiseNot:
-    {
-        assert(!is_floating_point(val_type));
-        return llvm_->ir_builder->CreateNot(val);
-    }
-    }
-
-    unreachable();
-}
-
-llvm::Value *LLVMIRGenerator::generate(const core::CallFunc &expr)
-{
-    std::vector<llvm::Value *> args;
-    for(auto &a : expr.args)
-        args.push_back(generate(*a));
-
-    if(expr.contextless_func)
-    {
-        auto func = llvm_->top_module->getFunction(expr.contextless_func->name);
-        return llvm_->ir_builder->CreateCall(func, args);
-    }
-    
-    if(expr.intrinsic != core::Intrinsic::None)
-        return process_intrinsic_call(expr, args);
-
-    auto core_func = llvm_->prog.funcs[expr.contexted_func_index].get();
-    auto func = llvm_->llvm_functions_.at(core_func).llvm_function;
-    return llvm_->ir_builder->CreateCall(func, args);
-}
-
-llvm::Value *LLVMIRGenerator::generate(const core::GlobalVarAddr &expr)
-{
-    llvm::Value *ptr = llvm_->global_vars_.at(expr.var.get());
-    if(target_ == Target::PTX)
-    {
-        auto var_type = llvm_->type_manager.get_llvm_type(expr.var->type);
-        auto dst_type = llvm::PointerType::get(var_type, 0);
-        ptr = llvm_->ir_builder->CreateAddrSpaceCast(ptr, dst_type);
-    }
-    return ptr;
-}
-
-llvm::Value *LLVMIRGenerator::generate(const core::GlobalConstAddr &expr)
-{
-    const int GLOBAL_ADDR_SPACE = target_ == Target::PTX ? 1 : 0;
-
-    auto llvm_u8   = llvm_->ir_builder->getInt8Ty();
-    auto llvm_elem = llvm_->type_manager.get_llvm_type(expr.pointed_type);
-
-    llvm::GlobalVariable *global_var;
-    if(auto it = llvm_->global_const_vars_.find(expr.data);
-       it != llvm_->global_const_vars_.end())
+    return ptr;
+}
+
+llvm::Value *LLVMIRGenerator::generate(const core::GlobalConstAddr &expr)
+{
+    const int GLOBAL_ADDR_SPACE = target_ == Target::PTX ? 1 : 0;
+
+    auto llvm_u8   = llvm_->ir_builder->getInt8Ty();
+    auto llvm_elem = llvm_->type_manager.get_llvm_type(expr.pointed_type);
+
+    llvm::GlobalVariable *global_var;
+    if(auto it = llvm_->global_const_vars_.find(expr.data);
+       it != llvm_->global_const_vars_.end())
     {
         global_var = it->second;
         size_t alignment = global_var->getAlign().valueOrOne().value();
@@ -1166,6 +1434,58 @@ llvm::Value *LLVMIRGenerator::generate(const core::GlobalConstAddr &expr)
     return val;
 }
 
+llvm::Value *LLVMIRGenerator::generate(const core::MakeVector &expr)
+{
+    auto vec_type = llvm::dyn_cast<llvm::FixedVectorType>(
+        llvm_->type_manager.get_llvm_type(expr.vector_type));
+
+    if(expr.elements.size() == 1)
+    {
+        auto elem = generate(*expr.elements[0]);
+        return llvm_->ir_builder->CreateVectorSplat(
+            vec_type->getNumElements(), elem);
+    }
+
+    assert(expr.elements.size() == vec_type->getNumElements());
+    llvm::Value *result = llvm::UndefValue::get(vec_type);
+    for(size_t i = 0; i < expr.elements.size(); ++i)
+    {
+        auto elem = generate(*expr.elements[i]);
+        result = llvm_->ir_builder->CreateInsertElement(
+            result, elem, static_cast<uint64_t>(i));
+    }
+    return result;
+}
+
+llvm::Value *LLVMIRGenerator::generate(const core::VectorExtract &expr)
+{
+    auto vec = generate(*expr.vector);
+    auto index = generate(*expr.index);
+    return llvm_->ir_builder->CreateExtractElement(vec, index);
+}
+
+llvm::Value *LLVMIRGenerator::generate(const core::VectorInsert &expr)
+{
+    auto vec = generate(*expr.vector);
+    auto index = generate(*expr.index);
+    auto elem = generate(*expr.element);
+    return llvm_->ir_builder->CreateInsertElement(vec, elem, index);
+}
+
+llvm::Value *LLVMIRGenerator::generate(const core::VectorShuffle &expr)
+{
+    auto lhs = generate(*expr.lhs);
+    auto rhs = generate(*expr.rhs);
+    return llvm_->ir_builder->CreateShuffleVector(lhs, rhs, expr.indices);
+}
+
+llvm::Value *LLVMIRGenerator::generate(const core::VectorReduce &expr)
+{
+    auto vec = generate(*expr.vector);
+    return create_vector_reduce(
+        expr.op, llvm_helper::get_arithmetic_builtin(expr.vector_type), vec);
+}
+
 llvm::Value *LLVMIRGenerator::process_intrinsic_call(
     const core::CallFunc &call, const std::vector<llvm::Value*> &args)
 {
@@ -1198,29 +1518,77 @@ llvm::Value *LLVMIRGenerator::process_intrinsic_call(
         return nullptr;
     }
 
-    if(call.intrinsic == core::Intrinsic::atomic_add_f32)
+    // ptx has no masked vector memory instructions, so lanes are
+    // accessed one by one under their own branches
+
+    if(call.intrinsic == core::Intrinsic::masked_load)
     {
-        return llvm_->ir_builder->CreateAtomicRMW(
-            llvm::AtomicRMWInst::FAdd, args[0], args[1],
-            llvm::AtomicOrdering::SequentiallyConsistent);
+        return detail::create_masked_load(
+            *llvm_->ir_builder, args, target_ == Target::PTX);
     }
 
-    if(call.intrinsic == core::Intrinsic::atomic_add_i32 ||
-       call.intrinsic == core::Intrinsic::atomic_add_u32)
+    if(call.intrinsic == core::Intrinsic::masked_store)
     {
-        return llvm_->ir_builder->CreateAtomicRMW(
-            llvm::AtomicRMWInst::Add, args[0], args[1],
-            llvm::AtomicOrdering::SequentiallyConsistent);
+        return detail::create_masked_store(
+            *llvm_->ir_builder, args, target_ == Target::PTX);
     }
 
-    if(call.intrinsic == core::Intrinsic::cmpxchg_i32 ||
-       call.intrinsic == core::Intrinsic::cmpxchg_u32 ||
-       call.intrinsic == core::Intrinsic::cmpxchg_u64)
+    if(call.intrinsic == core::Intrinsic::gather)
     {
-        llvm_->ir_builder->CreateAtomicCmpXchg(
-            args[0], args[1], args[2],
-            llvm::AtomicOrdering::SequentiallyConsistent,
-            llvm::AtomicOrdering::SequentiallyConsistent);
+        return detail::create_gather(
+            *llvm_->ir_builder, args, target_ == Target::PTX);
+    }
+
+    if(call.intrinsic == core::Intrinsic::scatter)
+    {
+        return detail::create_scatter(
+            *llvm_->ir_builder, args, target_ == Target::PTX);
+    }
+
+    if(call.intrinsic == core::Intrinsic::prefetch)
+    {
+        // nvptx has no lowering for llvm.prefetch
+        if(target_ == Target::PTX)
+            return nullptr;
+        auto &ir = *llvm_->ir_builder;
+        auto addr = ir.CreatePointerCast(
+            args[0], ir.getInt8PtrTy(
+                args[0]->getType()->getPointerAddressSpace()));
+        auto func = llvm::Intrinsic::getDeclaration(
+            llvm_->top_module.get(), llvm::Intrinsic::prefetch, { addr->getType() });
+        return ir.CreateCall(
+            func, { addr, args[2], args[1], ir.getInt32(1) });
+    }
+
+    if(call.intrinsic == core::Intrinsic::store_nontemporal)
+    {
+        auto store = llvm_->ir_builder->CreateStore(args[1], args[0]);
+        store->setMetadata(
+            llvm::LLVMContext::MD_nontemporal,
+            llvm::MDNode::get(
+                *llvm_->context, llvm::ConstantAsMetadata::get(
+                    llvm_->ir_builder->getInt32(1))));
+        return store;
+    }
+
+    if(call.intrinsic == core::Intrinsic::assume_aligned)
+    {
+        llvm_->ir_builder->CreateAlignmentAssumption(
+            llvm_->top_module->getDataLayout(), args[0], args[1]);
+        return args[0];
+    }
+
+    if(call.intrinsic == core::Intrinsic::assume)
+        return llvm_->ir_builder->CreateAssumption(args[0]);
+
+    if(auto ret = process_bit_intrinsic(call.intrinsic, args))
+        return ret;
+
+    if(is_atomic_intrinsic(call.intrinsic))
+    {
+        return process_atomic_intrinsics(
+            *llvm_->top_module, *llvm_->ir_builder,
+            call.intrinsic, args, target_ == Target::PTX);
     }
 
     if(call.intrinsic == core::Intrinsic::f32_min ||
@@ -1283,8 +1651,11 @@ llvm::Value *LLVMIRGenerator::process_intrinsic_call(
 
     if(target_ == Target::Native)
     {
+        if(auto index = process_native_kernel_index(call.intrinsic))
+            return index;
         return process_native_intrinsics(
-            *llvm_->top_module, *llvm_->ir_builder, call.intrinsic, args);
+            *llvm_->top_module, *llvm_->ir_builder,
+            call.intrinsic, args, math_precision_);
     }
 
     assert(target_ == Target::PTX);
@@ -1293,6 +1664,397 @@ llvm::Value *LLVMIRGenerator::process_intrinsic_call(
         call.intrinsic, args, approx_math_func_);
 }
 
+llvm::Value *LLVMIRGenerator::process_bit_intrinsic(
+    core::Intrinsic intrinsic, const std::vector<llvm::Value *> &args)
+{
+    auto &ir = *llvm_->ir_builder;
+    switch(intrinsic)
+    {
+    case core::Intrinsic::popcount:
+        return ir.CreateUnaryIntrinsic(llvm::Intrinsic::ctpop, args[0]);
+    case core::Intrinsic::clz:
+        return ir.CreateBinaryIntrinsic(
+            llvm::Intrinsic::ctlz, args[0], ir.getFalse());
+    case core::Intrinsic::ctz:
+        return ir.CreateBinaryIntrinsic(
+            llvm::Intrinsic::cttz, args[0], ir.getFalse());
+    case core::Intrinsic::bswap:
+        return ir.CreateUnaryIntrinsic(llvm::Intrinsic::bswap, args[0]);
+    case core::Intrinsic::rotl:
+        return ir.CreateIntrinsic(
+            llvm::Intrinsic::fshl, { args[0]->getType() },
+            { args[0], args[0], args[1] });
+    case core::Intrinsic::rotr:
+        return ir.CreateIntrinsic(
+            llvm::Intrinsic::fshr, { args[0]->getType() },
+            { args[0], args[0], args[1] });
+    case core::Intrinsic::add_sat_s:
+        return ir.CreateBinaryIntrinsic(
+            llvm::Intrinsic::sadd_sat, args[0], args[1]);
+    case core::Intrinsic::add_sat_u:
+        return ir.CreateBinaryIntrinsic(
+            llvm::Intrinsic::uadd_sat, args[0], args[1]);
+    case core::Intrinsic::f32_fma:
+    case core::Intrinsic::f64_fma:
+        return ir.CreateIntrinsic(
+            llvm::Intrinsic::fma, { args[0]->getType() },
+            { args[0], args[1], args[2] });
+    case core::Intrinsic::mul_hi_s:
+    case core::Intrinsic::mul_hi_u:
+        break;
+    default:
+        return nullptr;
+    }
+
+    const bool is_signed = intrinsic == core::Intrinsic::mul_hi_s;
+    auto type = args[0]->getType();
+    const unsigned bits = type->getIntegerBitWidth();
+
+    // nvptx doesn't support i128 arithmetic
+    if(target_ == Target::PTX && (bits == 32 || bits == 64))
+    {
+        llvm::Intrinsic::ID id;
+        if(bits == 32)
+            id = is_signed ? llvm::Intrinsic::nvvm_mulhi_i : llvm::Intrinsic::nvvm_mulhi_ui;
+        else
+            id = is_signed ? llvm::Intrinsic::nvvm_mulhi_ll : llvm::Intrinsic::nvvm_mulhi_ull;
+        return ir.CreateIntrinsic(id, {}, { args[0], args[1] });
+    }
+
+    auto wide_type = ir.getIntNTy(2 * bits);
+    auto a = ir.CreateIntCast(args[0], wide_type, is_signed);
+    auto b = ir.CreateIntCast(args[1], wide_type, is_signed);
+    auto product = ir.CreateMul(a, b);
+    return ir.CreateTrunc(ir.CreateLShr(product, bits), type);
+}
+
+llvm::Value *LLVMIRGenerator::process_native_kernel_index(
+    core::Intrinsic intrinsic)
+{
+    int thread_dim       = -1;
+    int block_info_index = -1;
+    switch(intrinsic)
+    {
+    case core::Intrinsic::thread_idx_x: thread_dim = 0;       break;
+    case core::Intrinsic::thread_idx_y: thread_dim = 1;       break;
+    case core::Intrinsic::thread_idx_z: thread_dim = 2;       break;
+    case core::Intrinsic::block_idx_x:  block_info_index = 0; break;
+    case core::Intrinsic::block_idx_y:  block_info_index = 1; break;
+    case core::Intrinsic::block_idx_z:  block_info_index = 2; break;
+    case core::Intrinsic::block_dim_x:  block_info_index = 3; break;
+    case core::Intrinsic::block_dim_y:  block_info_index = 4; break;
+    case core::Intrinsic::block_dim_z:  block_info_index = 5; break;
+    default:
+        return nullptr;
+    }
+
+    if(!llvm_->block_info)
+    {
+        throw CujException(
+            "thread/block index on native target is only available "
+            "in kernel function");
+    }
+
+    if(thread_dim >= 0)
+        return llvm_->thread_idx[thread_dim];
+
+    auto i32_type = llvm_->ir_builder->getInt32Ty();
+    auto addr = llvm_->ir_builder->CreateConstInBoundsGEP1_32(
+        i32_type, llvm_->block_info, block_info_index);
+    return llvm_->ir_builder->CreateLoad(i32_type, addr);
+}
+
+llvm::Value *LLVMIRGenerator::create_arithmetic_cast(
+    core::Builtin src_type, core::Builtin dst_type,
+    llvm::Value *src_val, llvm::Type *dst_llvm_type)
+{
+    const bool is_src_int = !is_floating_point(src_type);
+    const bool is_dst_int = !is_floating_point(dst_type);
+    const bool is_src_signed = is_signed(src_type);
+    const bool is_dst_signed = is_signed(dst_type);
+
+    if(src_type == dst_type)
+        return src_val;
+
+    if(src_type == core::Builtin::Bool)
+    {
+        if(is_dst_int)
+        {
+            return llvm_->ir_builder->CreateSelect(
+                src_val,
+                llvm::ConstantInt::get(dst_llvm_type, 1, false),
+                llvm::ConstantInt::get(dst_llvm_type, 0, false));
+        }
+        return llvm_->ir_builder->CreateSelect(
+            src_val,
+            llvm::ConstantFP::get(dst_llvm_type, 1),
+            llvm::ConstantFP::get(dst_llvm_type, 0));
+    }
+
+    if(is_src_int && is_dst_int)
+    {
+        if(is_dst_signed)
+            return llvm_->ir_builder->CreateSExtOrTrunc(src_val, dst_llvm_type);
+        return llvm_->ir_builder->CreateZExtOrTrunc(src_val, dst_llvm_type);
+    }
+
+    if(is_src_int && !is_dst_int)
+    {
+        if(is_src_signed)
+            return llvm_->ir_builder->CreateSIToFP(src_val, dst_llvm_type);
+        return llvm_->ir_builder->CreateUIToFP(src_val, dst_llvm_type);
+    }
+
+    if(!is_src_int && is_dst_int)
+    {
+        if(is_dst_signed)
+            return llvm_->ir_builder->CreateFPToSI(src_val, dst_llvm_type);
+        return llvm_->ir_builder->CreateFPToUI(src_val, dst_llvm_type);
+    }
+
+    if(!is_src_int && !is_dst_int)
+        return llvm_->ir_builder->CreateFPCast(src_val, dst_llvm_type);
+
+    unreachable();
+}
+
+llvm::Value *LLVMIRGenerator::create_bitwise_cast(
+    llvm::Value *src_val, llvm::Type *dst_type)
+{
+    // scalar types decide the kind of cast, so that vectors of pointers
+    // are handled in the same way as pointers
+    auto src_type = src_val->getType();
+    if(src_type->getScalarType()->isPointerTy())
+    {
+        if(dst_type->getScalarType()->isPointerTy()) // ptr to ptr
+            return llvm_->ir_builder->CreatePointerCast(src_val, dst_type);
+
+        // ptr to integer
+        return llvm_->ir_builder->CreatePtrToInt(src_val, dst_type);
+    }
+
+    if(dst_type->getScalarType()->isPointerTy()) // integer to ptr
+        return llvm_->ir_builder->CreateIntToPtr(src_val, dst_type);
+
+    // arithmetic to arithmetic
+    return llvm_->ir_builder->CreateBitCast(src_val, dst_type);
+}
+
+llvm::Value *LLVMIRGenerator::create_binary(
+    core::Binary::Op op, core::Builtin lhs_type, llvm::Value *lhs, llvm::Value *rhs)
+{
+    switch(op)
+    {
+    case core::Binary::Op::Add:
+    {
+        assert(lhs_type != core::Builtin::Bool);
+        if(lhs->getType()->isFPOrFPVectorTy())
+            return llvm_->ir_builder->CreateFAdd(lhs, rhs);
+        return llvm_->ir_builder->CreateAdd(lhs, rhs);
+    }
+    case core::Binary::Op::Sub:
+    {
+        assert(lhs_type != core::Builtin::Bool);
+        if(lhs->getType()->isFPOrFPVectorTy())
+            return llvm_->ir_builder->CreateFSub(lhs, rhs);
+        return llvm_->ir_builder->CreateSub(lhs, rhs);
+    }
+    case core::Binary::Op::Mul:
+    {
+        assert(lhs_type != core::Builtin::Bool);
+        if(lhs->getType()->isFPOrFPVectorTy())
+            return llvm_->ir_builder->CreateFMul(lhs, rhs);
+        return llvm_->ir_builder->CreateMul(lhs, rhs);
+    }
+    case core::Binary::Op::Div:
+    {
+        assert(lhs_type != core::Builtin::Bool);
+        if(is_floating_point(lhs_type))
+            return llvm_->ir_builder->CreateFDiv(lhs, rhs);
+        if(is_signed(lhs_type))
+            return llvm_->ir_builder->CreateSDiv(lhs, rhs);
+        return llvm_->ir_builder->CreateUDiv(lhs, rhs);
+    }
+    case core::Binary::Op::Mod:
+    {
+        assert(!is_floating_point(lhs_type));
+        if(is_signed(lhs_type))
+            return llvm_->ir_builder->CreateSRem(lhs, rhs);
+        return llvm_->ir_builder->CreateURem(lhs, rhs);
+    }
+    case core::Binary::Op::Equal:
+    {
+        if(lhs->getType()->isFPOrFPVectorTy())
+            return llvm_->ir_builder->CreateFCmpOEQ(lhs, rhs);
+        return llvm_->ir_builder->CreateICmpEQ(lhs, rhs);
+    }
+    case core::Binary::Op::NotEqual:
+    {
+        if(lhs->getType()->isFPOrFPVectorTy())
+            return llvm_->ir_builder->CreateFCmpONE(lhs, rhs);
+        return llvm_->ir_builder->CreateICmpNE(lhs, rhs);
+    }
+    case core::Binary::Op::Less:
+    {
+        if(lhs->getType()->isFPOrFPVectorTy())
+            return llvm_->ir_builder->CreateFCmpOLT(lhs, rhs);
+        if(is_signed(lhs_type))
+            return llvm_->ir_builder->CreateICmpSLT(lhs, rhs);
+        return llvm_->ir_builder->CreateICmpULT(lhs, rhs);
+    }
+    case core::Binary::Op::LessEqual:
+    {
+        if(lhs->getType()->isFPOrFPVectorTy())
+            return llvm_->ir_builder->CreateFCmpOLE(lhs, rhs);
+        if(is_signed(lhs_type))
+            return llvm_->ir_builder->CreateICmpSLE(lhs, rhs);
+        return llvm_->ir_builder->CreateICmpULE(lhs, rhs);
+    }
+    case core::Binary::Op::Greater:
+    {
+        if(lhs->getType()->isFPOrFPVectorTy())
+            return llvm_->ir_builder->CreateFCmpOGT(lhs, rhs);
+        if(is_signed(lhs_type))
+            return llvm_->ir_builder->CreateICmpSGT(lhs, rhs);
+        return llvm_->ir_builder->CreateICmpUGT(lhs, rhs);
+    }
+    case core::Binary::Op::GreaterEqual:
+    {
+        if(lhs->getType()->isFPOrFPVectorTy())
+            return llvm_->ir_builder->CreateFCmpOGE(lhs, rhs);
+        if(is_signed(lhs_type))
+            return llvm_->ir_builder->CreateICmpSGE(lhs, rhs);
+        return llvm_->ir_builder->CreateICmpUGE(lhs, rhs);
+    }
+    case core::Binary::Op::LeftShift:
+    {
+        assert(!is_floating_point(lhs_type));
+        return llvm_->ir_builder->CreateShl(lhs, rhs);
+    }
+    case core::Binary::Op::RightShift:
+    {
+        assert(!is_signed(lhs_type));
+        assert(!is_floating_point(lhs_type));
+        return llvm_->ir_builder->CreateLShr(lhs, rhs);
+    }
+    case core::Binary::Op::BitwiseAnd:
+    {
+        assert(!is_floating_point(lhs_type));
+        return llvm_->ir_builder->CreateAnd(lhs, rhs);
+    }
+    case core::Binary::Op::BitwiseOr:
+    {
+        assert(!is_floating_point(lhs_type));
+        return llvm_->ir_builder->CreateOr(lhs, rhs);
+    }
+    case core::Binary::Op::BitwiseXOr:
+    {
+        assert(!is_floating_point(lhs_type));
+        return llvm_->ir_builder->CreateXor(lhs, rhs);
+    }
+    }
+
+    unreachable();
+}
+
+llvm::Value *LLVMIRGenerator::create_unary(
+    core::Unary::Op op, core::Builtin val_type, llvm::Value *val)
+{
+    switch(op)
+    {
+    case core::Unary::Op::Neg:
+    {
+        assert(val_type != core::Builtin::Bool);
+        if(is_floating_point(val_type))
+            return llvm_->ir_builder->CreateFNeg(val);
+        return llvm_->ir_builder->CreateNeg(val);
+    }
+    case core::Unary::Op::Not:
+    {
+        assert(val_type == core::Builtin::Bool);
+        return llvm_->ir_builder->CreateNot(val);
+    }
+    case core::Unary::Op::BitwiseNot:
+    {
+        assert(!is_floating_point(val_type));
+        return llvm_->ir_builder->CreateNot(val);
+    }
+    }
+
+    unreachable();
+}
+
+llvm::Value *LLVMIRGenerator::create_vector_reduce(
+    core::VectorReduce::Op op, core::Builtin elem_type, llvm::Value *vec)
+{
+    auto llvm_elem_type = llvm::dyn_cast<llvm::VectorType>(
+        vec->getType())->getElementType();
+
+    // floating-point reductions are evaluated in tree order rather than
+    // sequentially, which is what the horizontal instructions do
+
+    auto allow_reassoc = [](llvm::Value *reduce)
+    {
+        llvm::dyn_cast<llvm::Instruction>(reduce)->setHasAllowReassoc(true);
+        return reduce;
+    };
+
+    switch(op)
+    {
+    case core::VectorReduce::Op::Add:
+    {
+        assert(elem_type != core::Builtin::Bool);
+        if(is_floating_point(elem_type))
+        {
+            return allow_reassoc(llvm_->ir_builder->CreateFAddReduce(
+                llvm::ConstantFP::getNegativeZero(llvm_elem_type), vec));
+        }
+        return llvm_->ir_builder->CreateAddReduce(vec);
+    }
+    case core::VectorReduce::Op::Mul:
+    {
+        assert(elem_type != core::Builtin::Bool);
+        if(is_floating_point(elem_type))
+        {
+            return allow_reassoc(llvm_->ir_builder->CreateFMulReduce(
+                llvm::ConstantFP::get(llvm_elem_type, 1), vec));
+        }
+        return llvm_->ir_builder->CreateMulReduce(vec);
+    }
+    case core::VectorReduce::Op::Min:
+    {
+        assert(elem_type != core::Builtin::Bool);
+        if(is_floating_point(elem_type))
+            return llvm_->ir_builder->CreateFPMinReduce(vec);
+        return llvm_->ir_builder->CreateIntMinReduce(vec, is_signed(elem_type));
+    }
+    case core::VectorReduce::Op::Max:
+    {
+        assert(elem_type != core::Builtin::Bool);
+        if(is_floating_point(elem_type))
+            return llvm_->ir_builder->CreateFPMaxReduce(vec);
+        return llvm_->ir_builder->CreateIntMaxReduce(vec, is_signed(elem_type));
+    }
+    case core::VectorReduce::Op::BitwiseAnd:
+    {
+        assert(!is_floating_point(elem_type));
+        return llvm_->ir_builder->CreateAndReduce(vec);
+    }
+    case core::VectorReduce::Op::BitwiseOr:
+    {
+        assert(!is_floating_point(elem_type));
+        return llvm_->ir_builder->CreateOrReduce(vec);
+    }
+    case core::VectorReduce::Op::BitwiseXOr:
+    {
+        assert(!is_floating_point(elem_type));
+        return llvm_->ir_builder->CreateXorReduce(vec);
+    }
+    }
+
+    unreachable();
+}
+
 CUJ_NAMESPACE_END(cuj::gen)
 
 #ifdef _MSC_VER
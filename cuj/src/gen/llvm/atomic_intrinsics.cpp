@@ -0,0 +1,359 @@
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4141)
+#pragma warning(disable: 4244)
+#pragma warning(disable: 4624)
+#pragma warning(disable: 4626)
+#pragma warning(disable: 4996)
+#endif
+
+#include <llvm/IR/InlineAsm.h>
+#include <llvm/IR/IntrinsicsNVPTX.h>
+
+#include <cuj/utils/unreachable.h>
+
+#include "atomic_intrinsics.h"
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+namespace
+{
+
+    llvm::AtomicOrdering to_llvm_ordering(core::MemoryOrder order)
+    {
+        switch(order)
+        {
+        case core::MemoryOrder::Relaxed: return llvm::AtomicOrdering::Monotonic;
+        case core::MemoryOrder::Acquire: return llvm::AtomicOrdering::Acquire;
+        case core::MemoryOrder::Release: return llvm::AtomicOrdering::Release;
+        case core::MemoryOrder::AcqRel:  return llvm::AtomicOrdering::AcquireRelease;
+        case core::MemoryOrder::SeqCst:  return llvm::AtomicOrdering::SequentiallyConsistent;
+        }
+        unreachable();
+    }
+
+    // ordering of a failed cmpxchg, which only loads
+    llvm::AtomicOrdering to_llvm_load_ordering(core::MemoryOrder order)
+    {
+        switch(order)
+        {
+        case core::MemoryOrder::Relaxed:
+        case core::MemoryOrder::Release:
+            return llvm::AtomicOrdering::Monotonic;
+        case core::MemoryOrder::Acquire:
+        case core::MemoryOrder::AcqRel:
+            return llvm::AtomicOrdering::Acquire;
+        case core::MemoryOrder::SeqCst:
+            return llvm::AtomicOrdering::SequentiallyConsistent;
+        }
+        unreachable();
+    }
+
+    bool has_release(core::MemoryOrder order)
+    {
+        return order == core::MemoryOrder::Release ||
+               order == core::MemoryOrder::AcqRel ||
+               order == core::MemoryOrder::SeqCst;
+    }
+
+    bool has_acquire(core::MemoryOrder order)
+    {
+        return order == core::MemoryOrder::Acquire ||
+               order == core::MemoryOrder::AcqRel ||
+               order == core::MemoryOrder::SeqCst;
+    }
+
+    int64_t get_immediate(llvm::Value *value)
+    {
+        auto constant = llvm::dyn_cast<llvm::ConstantInt>(value);
+        if(!constant)
+            throw CujException("memory order/scope of atomic must be constant");
+        return constant->getSExtValue();
+    }
+
+    llvm::Align get_atomic_alignment(llvm::Module &top_module, llvm::Type *type)
+    {
+        return llvm::Align(
+            top_module.getDataLayout().getTypeStoreSize(type).getFixedSize());
+    }
+
+    void create_ptx_membar(
+        llvm::Module      &top_module,
+        llvm::IRBuilder<> &ir,
+        core::MemoryScope  scope)
+    {
+        llvm::Intrinsic::ID id;
+        switch(scope)
+        {
+        case core::MemoryScope::Block:  id = llvm::Intrinsic::nvvm_membar_cta; break;
+        case core::MemoryScope::Device: id = llvm::Intrinsic::nvvm_membar_gl;  break;
+        case core::MemoryScope::System: id = llvm::Intrinsic::nvvm_membar_sys; break;
+        default: unreachable();
+        }
+        ir.CreateCall(llvm::Intrinsic::getDeclaration(&top_module, id));
+    }
+
+    llvm::AtomicRMWInst::BinOp get_rmw_op(core::Intrinsic intrinsic_type)
+    {
+        switch(intrinsic_type)
+        {
+        case core::Intrinsic::atomic_exchange: return llvm::AtomicRMWInst::Xchg;
+        case core::Intrinsic::atomic_add:      return llvm::AtomicRMWInst::Add;
+        case core::Intrinsic::atomic_fadd:     return llvm::AtomicRMWInst::FAdd;
+        case core::Intrinsic::atomic_and:      return llvm::AtomicRMWInst::And;
+        case core::Intrinsic::atomic_or:       return llvm::AtomicRMWInst::Or;
+        case core::Intrinsic::atomic_xor:      return llvm::AtomicRMWInst::Xor;
+        case core::Intrinsic::atomic_min_s:    return llvm::AtomicRMWInst::Min;
+        case core::Intrinsic::atomic_min_u:    return llvm::AtomicRMWInst::UMin;
+        case core::Intrinsic::atomic_max_s:    return llvm::AtomicRMWInst::Max;
+        case core::Intrinsic::atomic_max_u:    return llvm::AtomicRMWInst::UMax;
+        default: unreachable();
+        }
+    }
+
+    // scoped ptx atomic. returns not_intrinsic for operations without one
+    llvm::Intrinsic::ID get_scoped_ptx_intrinsic(
+        core::Intrinsic intrinsic_type, core::MemoryScope scope)
+    {
+        const bool cta = scope == core::MemoryScope::Block;
+        switch(intrinsic_type)
+        {
+        case core::Intrinsic::atomic_exchange:
+            return cta ? llvm::Intrinsic::nvvm_atomic_exch_gen_i_cta
+                       : llvm::Intrinsic::nvvm_atomic_exch_gen_i_sys;
+        case core::Intrinsic::atomic_cmpxchg:
+            return cta ? llvm::Intrinsic::nvvm_atomic_cas_gen_i_cta
+                       : llvm::Intrinsic::nvvm_atomic_cas_gen_i_sys;
+        case core::Intrinsic::atomic_add:
+            return cta ? llvm::Intrinsic::nvvm_atomic_add_gen_i_cta
+                       : llvm::Intrinsic::nvvm_atomic_add_gen_i_sys;
+        case core::Intrinsic::atomic_fadd:
+            return cta ? llvm::Intrinsic::nvvm_atomic_add_gen_f_cta
+                       : llvm::Intrinsic::nvvm_atomic_add_gen_f_sys;
+        case core::Intrinsic::atomic_and:
+            return cta ? llvm::Intrinsic::nvvm_atomic_and_gen_i_cta
+                       : llvm::Intrinsic::nvvm_atomic_and_gen_i_sys;
+        case core::Intrinsic::atomic_or:
+            return cta ? llvm::Intrinsic::nvvm_atomic_or_gen_i_cta
+                       : llvm::Intrinsic::nvvm_atomic_or_gen_i_sys;
+        case core::Intrinsic::atomic_xor:
+            return cta ? llvm::Intrinsic::nvvm_atomic_xor_gen_i_cta
+                       : llvm::Intrinsic::nvvm_atomic_xor_gen_i_sys;
+        case core::Intrinsic::atomic_min_s:
+            return cta ? llvm::Intrinsic::nvvm_atomic_min_gen_i_cta
+                       : llvm::Intrinsic::nvvm_atomic_min_gen_i_sys;
+        case core::Intrinsic::atomic_max_s:
+            return cta ? llvm::Intrinsic::nvvm_atomic_max_gen_i_cta
+                       : llvm::Intrinsic::nvvm_atomic_max_gen_i_sys;
+        default:
+            return llvm::Intrinsic::not_intrinsic;
+        }
+    }
+
+    // there are no scoped unsigned min/max intrinsics for ptx
+    llvm::Value *create_scoped_ptx_unsigned_minmax(
+        llvm::IRBuilder<> &ir,
+        core::Intrinsic    intrinsic_type,
+        core::MemoryScope  scope,
+        llvm::Value       *ptr,
+        llvm::Value       *val)
+    {
+        const unsigned bits = val->getType()->getIntegerBitWidth();
+        const char *op = intrinsic_type == core::Intrinsic::atomic_min_u ? "min" : "max";
+        const char *scope_name = scope == core::MemoryScope::Block ? "cta" : "sys";
+        const std::string asm_string =
+            std::string("atom.") + scope_name + "." + op + ".u" +
+            std::to_string(bits) + " $0, [$1], $2;";
+        const std::string constraints =
+            bits == 64 ? "=l,l,l,~{memory}" : "=r,l,r,~{memory}";
+
+        auto func_type = llvm::FunctionType::get(
+            val->getType(), { ptr->getType(), val->getType() }, false);
+        auto callee = llvm::InlineAsm::get(
+            func_type, asm_string, constraints, true);
+        return ir.CreateCall(callee, { ptr, val });
+    }
+
+    llvm::Value *create_rmw(
+        llvm::Module              &top_module,
+        llvm::IRBuilder<>         &ir,
+        llvm::AtomicRMWInst::BinOp op,
+        llvm::Value               *ptr,
+        llvm::Value               *val,
+        llvm::AtomicOrdering       ordering)
+    {
+        // floating-point exchange is performed on integers of the same size
+        auto val_type = val->getType();
+        if(op == llvm::AtomicRMWInst::Xchg && val_type->isFloatingPointTy())
+        {
+            auto int_type = ir.getIntNTy(val_type->getScalarSizeInBits());
+            auto int_ptr = ir.CreatePointerCast(
+                ptr, int_type->getPointerTo(
+                    ptr->getType()->getPointerAddressSpace()));
+            auto int_val = ir.CreateBitCast(val, int_type);
+            auto ret = create_rmw(
+                top_module, ir, op, int_ptr, int_val, ordering);
+            return ir.CreateBitCast(ret, val_type);
+        }
+
+        return ir.Insert(new llvm::AtomicRMWInst(
+            op, ptr, val, get_atomic_alignment(top_module, val_type),
+            ordering, llvm::SyncScope::System));
+    }
+
+    llvm::Value *create_scoped_ptx_atomic(
+        llvm::Module                    &top_module,
+        llvm::IRBuilder<>               &ir,
+        core::Intrinsic                  intrinsic_type,
+        core::MemoryScope                scope,
+        const std::vector<llvm::Value*> &args)
+    {
+        if(intrinsic_type == core::Intrinsic::atomic_min_u ||
+           intrinsic_type == core::Intrinsic::atomic_max_u)
+        {
+            return create_scoped_ptx_unsigned_minmax(
+                ir, intrinsic_type, scope, args[0], args[1]);
+        }
+
+        // exch only accepts integers
+        auto val_type = args[1]->getType();
+        if(intrinsic_type == core::Intrinsic::atomic_exchange &&
+           val_type->isFloatingPointTy())
+        {
+            auto int_type = ir.getIntNTy(val_type->getScalarSizeInBits());
+            auto int_ptr = ir.CreatePointerCast(
+                args[0], int_type->getPointerTo(
+                    args[0]->getType()->getPointerAddressSpace()));
+            auto int_val = ir.CreateBitCast(args[1], int_type);
+            auto ret = create_scoped_ptx_atomic(
+                top_module, ir, intrinsic_type, scope,
+                { int_ptr, int_val, args[2], args[3] });
+            return ir.CreateBitCast(ret, val_type);
+        }
+
+        auto id = get_scoped_ptx_intrinsic(intrinsic_type, scope);
+        assert(id != llvm::Intrinsic::not_intrinsic);
+        auto func = llvm::Intrinsic::getDeclaration(
+            &top_module, id, { val_type, args[0]->getType() });
+
+        // drop memory order and scope
+        std::vector<llvm::Value *> call_args(args.begin(), args.end() - 2);
+        return ir.CreateCall(func, call_args);
+    }
+
+    llvm::Value *create_atomic_operation(
+        llvm::Module                    &top_module,
+        llvm::IRBuilder<>               &ir,
+        core::Intrinsic                  intrinsic_type,
+        core::MemoryOrder                order,
+        core::MemoryScope                scope,
+        const std::vector<llvm::Value*> &args,
+        bool                             ptx)
+    {
+        const auto ordering = ptx ?
+            llvm::AtomicOrdering::Monotonic : to_llvm_ordering(order);
+
+        if(intrinsic_type == core::Intrinsic::atomic_load)
+        {
+            auto type = args[0]->getType()->getPointerElementType();
+            return ir.Insert(new llvm::LoadInst(
+                type, args[0], "", false,
+                get_atomic_alignment(top_module, type),
+                ordering, llvm::SyncScope::System));
+        }
+
+        if(intrinsic_type == core::Intrinsic::atomic_store)
+        {
+            return ir.Insert(new llvm::StoreInst(
+                args[1], args[0], false,
+                get_atomic_alignment(top_module, args[1]->getType()),
+                ordering, llvm::SyncScope::System));
+        }
+
+        if(ptx && scope != core::MemoryScope::Device)
+        {
+            return create_scoped_ptx_atomic(
+                top_module, ir, intrinsic_type, scope, args);
+        }
+
+        if(intrinsic_type == core::Intrinsic::atomic_cmpxchg)
+        {
+            const auto failure_ordering = ptx ?
+                llvm::AtomicOrdering::Monotonic : to_llvm_load_ordering(order);
+            auto inst = ir.Insert(new llvm::AtomicCmpXchgInst(
+                args[0], args[1], args[2],
+                get_atomic_alignment(top_module, args[1]->getType()),
+                ordering, failure_ordering, llvm::SyncScope::System));
+            return ir.CreateExtractValue(inst, 0);
+        }
+
+        return create_rmw(
+            top_module, ir, get_rmw_op(intrinsic_type),
+            args[0], args[1], ordering);
+    }
+
+} // namespace anonymous
+
+bool is_atomic_intrinsic(core::Intrinsic intrinsic_type)
+{
+    switch(intrinsic_type)
+    {
+    case core::Intrinsic::atomic_load:
+    case core::Intrinsic::atomic_store:
+    case core::Intrinsic::atomic_exchange:
+    case core::Intrinsic::atomic_cmpxchg:
+    case core::Intrinsic::atomic_add:
+    case core::Intrinsic::atomic_fadd:
+    case core::Intrinsic::atomic_and:
+    case core::Intrinsic::atomic_or:
+    case core::Intrinsic::atomic_xor:
+    case core::Intrinsic::atomic_min_s:
+    case core::Intrinsic::atomic_min_u:
+    case core::Intrinsic::atomic_max_s:
+    case core::Intrinsic::atomic_max_u:
+    case core::Intrinsic::atomic_fence:
+        return true;
+    default:
+        return false;
+    }
+}
+
+llvm::Value *process_atomic_intrinsics(
+    llvm::Module                    &top_module,
+    llvm::IRBuilder<>               &ir_builder,
+    core::Intrinsic                  intrinsic_type,
+    const std::vector<llvm::Value*> &args,
+    bool                             ptx)
+{
+    assert(args.size() >= 2);
+    const auto order = static_cast<core::MemoryOrder>(
+        get_immediate(args[args.size() - 2]));
+    const auto scope = static_cast<core::MemoryScope>(
+        get_immediate(args[args.size() - 1]));
+
+    if(intrinsic_type == core::Intrinsic::atomic_fence)
+    {
+        if(ptx)
+            create_ptx_membar(top_module, ir_builder, scope);
+        else
+            ir_builder.CreateFence(to_llvm_ordering(order));
+        return nullptr;
+    }
+
+    if(ptx && has_release(order))
+        create_ptx_membar(top_module, ir_builder, scope);
+
+    auto ret = create_atomic_operation(
+        top_module, ir_builder, intrinsic_type, order, scope, args, ptx);
+
+    if(ptx && has_acquire(order))
+        create_ptx_membar(top_module, ir_builder, scope);
+
+    return ret;
+}
+
+CUJ_NAMESPACE_END(cuj::gen)
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
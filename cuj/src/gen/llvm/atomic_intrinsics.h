@@ -0,0 +1,21 @@
+#pragma once
+
+#include <llvm/IR/IRBuilder.h>
+
+#include <cuj/core/expr.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+bool is_atomic_intrinsic(core::Intrinsic intrinsic_type);
+
+// the last two arguments are immediate memory order and memory scope.
+// llvm has no ordered atomics or fences for ptx, so relaxed operations
+// surrounded by membar are generated instead
+llvm::Value *process_atomic_intrinsics(
+    llvm::Module                    &top_module,
+    llvm::IRBuilder<>               &ir_builder,
+    core::Intrinsic                  intrinsic_type,
+    const std::vector<llvm::Value*> &args,
+    bool                             ptx);
+
+CUJ_NAMESPACE_END(cuj::gen)
@@ -0,0 +1,92 @@
+#include "compile_stats.h"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4141)
+#pragma warning(disable: 4244)
+#pragma warning(disable: 4624)
+#pragma warning(disable: 4626)
+#pragma warning(disable: 4996)
+#endif
+
+#include <llvm/IR/Instructions.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+size_t count_instructions(const llvm::Module &llvm_module)
+{
+    size_t ret = 0;
+    for(auto &f : llvm_module.functions())
+        ret += f.getInstructionCount();
+    return ret;
+}
+
+size_t count_allocas(const llvm::Module &llvm_module)
+{
+    size_t ret = 0;
+    for(auto &f : llvm_module.functions())
+    {
+        for(auto &bb : f)
+        {
+            for(auto &inst : bb)
+            {
+                if(llvm::isa<llvm::AllocaInst>(inst))
+                    ++ret;
+            }
+        }
+    }
+    return ret;
+}
+
+size_t get_peak_memory()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage))
+        return 0;
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+void accumulate_stats(CompileStats &total, const CompileStats &partition)
+{
+    total.generate_prog_time += partition.generate_prog_time;
+    total.ir_generation_time += partition.ir_generation_time;
+    total.function_pass_time += partition.function_pass_time;
+    total.module_pass_time   += partition.module_pass_time;
+    total.codegen_time       += partition.codegen_time;
+
+    total.ir_instruction_count_before_opt +=
+        partition.ir_instruction_count_before_opt;
+    total.ir_instruction_count_after_opt +=
+        partition.ir_instruction_count_after_opt;
+    total.local_alloca_count += partition.local_alloca_count;
+
+    for(auto &[name, size] : partition.function_code_sizes)
+        total.function_code_sizes[name] += size;
+}
+
+CUJ_NAMESPACE_END(cuj::gen)
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4141)
+#pragma warning(disable: 4244)
+#pragma warning(disable: 4624)
+#pragma warning(disable: 4626)
+#pragma warning(disable: 4996)
+#endif
+
+#include <llvm/IR/Module.h>
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <cuj/gen/compile_stats.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+class PhaseTimer
+{
+public:
+
+    PhaseTimer()
+        : start_(std::chrono::steady_clock::now())
+    {
+        
+    }
+
+    double get_seconds() const
+    {
+        return std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start_).count();
+    }
+
+private:
+
+    std::chrono::steady_clock::time_point start_;
+};
+
+size_t count_instructions(const llvm::Module &llvm_module);
+
+size_t count_allocas(const llvm::Module &llvm_module);
+
+// peak resident memory of current process in bytes. 0 if unknown
+size_t get_peak_memory();
+
+// merge statistics of a partition into total
+void accumulate_stats(CompileStats &total, const CompileStats &partition);
+
+CUJ_NAMESPACE_END(cuj::gen)
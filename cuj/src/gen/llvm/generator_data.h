@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <map>
+#include <stack>
+
+#include <llvm/IR/IRBuilder.h>
+
+#include <cuj/gen/llvm.h>
+
+#include "type_manager.h"
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+struct LLVMIRGenerator::LLVMData
+{
+    // per module
+
+    core::Prog             prog;
+    Box<llvm::LLVMContext> context;
+
+    Box<llvm::IRBuilder<>> ir_builder;
+    Box<llvm::Module>      top_module;
+
+    struct FunctionRecord
+    {
+        llvm::Function *llvm_function;
+
+        // native kernels compiled in spmd form run a group of consecutive
+        // thread_idx_x values per call of this function
+        llvm::Function *spmd_function = nullptr;
+    };
+
+    std::map<const core::Func *, FunctionRecord> llvm_functions_;
+
+    std::map<const core::GlobalVar *, llvm::GlobalVariable *> global_vars_;
+
+    std::map<std::vector<unsigned char>, llvm::GlobalVariable *> global_const_vars_;
+
+    llvm_helper::TypeManager type_manager;
+
+    // per function
+
+    llvm::Function *current_function = nullptr;
+
+    // native kernels run one thread per call of their llvm function,
+    // with the thread index and block info appended to the arguments.
+    // in spmd form, thread_idx[0] is the index of the first lane
+
+    llvm::Value                *block_info = nullptr;
+    std::array<llvm::Value *, 3> thread_idx = {};
+
+    std::vector<llvm::AllocaInst *> local_allocas;
+    std::vector<llvm::AllocaInst *> arg_allocas;
+
+    std::stack<llvm::BasicBlock *> break_dsts;
+    std::stack<llvm::BasicBlock *> continue_dsts;
+    std::stack<llvm::BasicBlock *> scope_exits;
+};
+
+CUJ_NAMESPACE_END(cuj::gen)
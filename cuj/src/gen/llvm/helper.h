@@ -49,6 +49,14 @@ inline llvm::Type *builtin_to_llvm_type(llvm::LLVMContext *ctx, core::Builtin bu
     unreachable();
 }
 
+// element type of vectors, or the builtin type itself
+inline core::Builtin get_arithmetic_builtin(const core::Type *type)
+{
+    if(auto vec = type->as_if<core::Vector>())
+        return vec->element->as<core::Builtin>();
+    return type->as<core::Builtin>();
+}
+
 template<typename T> requires std::is_arithmetic_v<T>
 auto llvm_constant_num(llvm::LLVMContext &ctx, T v)
 {
@@ -10,6 +10,7 @@
 #include <llvm/IR/IRBuilder.h>
 
 #include "native_intrinsics.h"
+#include "native_math.h"
 
 CUJ_NAMESPACE_BEGIN(cuj::gen)
 
@@ -71,6 +72,8 @@ namespace
         func = llvm::Function::Create(
             func_type, llvm::GlobalValue::ExternalLinkage, name, top_module);
         func->deleteBody();
+        // keeps failure paths out of hot code
+        func->addFnAttr(llvm::Attribute::Cold);
         return func;
     }
 
@@ -139,7 +142,8 @@ llvm::Value *process_native_intrinsics(
     llvm::Module                    &top_module,
     llvm::IRBuilder<>               &ir_builder,
     core::Intrinsic                  intrinsic_type,
-    const std::vector<llvm::Value*> &args)
+    const std::vector<llvm::Value*> &args,
+    MathPrecision                    math_precision)
 {
     auto &context = top_module.getContext();
     auto f32 = llvm::Type::getFloatTy(context);
@@ -216,6 +220,10 @@ llvm::Value *process_native_intrinsics(
         return ir_builder.CreateCall(func, args);
     }
 
+    if(auto func = get_native_math_function(
+        top_module, intrinsic_type, math_precision))
+        return ir_builder.CreateCall(func, args);
+
     auto func = get_intrinsics_function(top_module, intrinsic_type);
     return ir_builder.CreateCall(func, args);
 }
@@ -3,6 +3,7 @@
 #include <llvm/IR/IRBuilder.h>
 
 #include <cuj/core/expr.h>
+#include <cuj/gen/option.h>
 
 CUJ_NAMESPACE_BEGIN(cuj::gen)
 
@@ -10,6 +11,7 @@ llvm::Value *process_native_intrinsics(
     llvm::Module                    &top_module,
     llvm::IRBuilder<>               &ir_builder,
     core::Intrinsic                  intrinsic_type,
-    const std::vector<llvm::Value*> &args);
+    const std::vector<llvm::Value*> &args,
+    MathPrecision                    math_precision);
 
 CUJ_NAMESPACE_END(cuj::gen)
@@ -0,0 +1,1411 @@
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4141)
+#pragma warning(disable: 4244)
+#pragma warning(disable: 4624)
+#pragma warning(disable: 4626)
+#pragma warning(disable: 4996)
+#endif
+
+#include <cmath>
+#include <span>
+#include <string_view>
+
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/MDBuilder.h>
+
+#include "native_math.h"
+#include "vector_intrinsic.h"
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+namespace
+{
+
+    // polynomial coefficients are minimax approximations of relative error.
+    // Precise/Fast variants differ in degree only
+
+    namespace f32_coefs
+    {
+
+        // tan(r) = r + r^3 * P(r^2), |r| <= pi/4
+        constexpr double TAN_PRECISE[] = {
+            3.333315682e-01, 1.333880024e-01, 5.341121207e-02,
+            2.443037961e-02, 3.119533332e-03, 9.385629314e-03
+        };
+        constexpr double TAN_FAST[] = {
+            3.331543338e-01, 1.360650481e-01, 4.139859450e-02,
+            4.308876052e-02
+        };
+
+        // atan(t) = t + t^3 * P(t^2), |t| <= tan(pi/8)
+        constexpr double ATAN_PRECISE[] = {
+            -3.333294913e-01, 1.997770964e-01, -1.387767504e-01,
+            8.053711885e-02
+        };
+        constexpr double ATAN_FAST[] = {
+            -3.332550758e-01, 1.971414016e-01, -1.122514854e-01
+        };
+
+        // asin(s) = s + s^3 * P(s^2), |s| <= 0.5
+        constexpr double ASIN_PRECISE[] = {
+            1.666675248e-01, 7.495297651e-02, 4.547037406e-02,
+            2.417952635e-02, 4.216628631e-02
+        };
+        constexpr double ASIN_FAST[] = {
+            1.668012598e-01, 7.189979707e-02, 6.410730065e-02
+        };
+
+        // 10^r = 1 + r * P(r), |r| <= log10(2) / 2
+        constexpr double EXP10_PRECISE[] = {
+            2.302585167e+00, 2.650948748e+00, 2.034649853e+00,
+            1.171292687e+00, 5.420251889e-01, 2.063216570e-01
+        };
+        constexpr double EXP10_FAST[] = {
+            2.302508729e+00, 2.651108844e+00, 2.049426889e+00,
+            1.166959091e+00
+        };
+
+        // sin(r) = r + r^3 * P(r^2), |r| <= pi/4
+        constexpr double SIN[] = {
+            -1.666666664e-01, 8.333329305e-03, -1.983931226e-04,
+            2.718121535e-06
+        };
+
+        // cos(r) = 1 - r^2 / 2 + r^4 * P(r^2), |r| <= pi/4
+        constexpr double COS[] = {
+            4.166666662e-02, -1.388888350e-03, 2.479946015e-05,
+            -2.720575398e-07
+        };
+
+        // e^r = 1 + r * P(r), |r| <= ln(2) / 2
+        constexpr double EXP[] = {
+            1.000000032e+00, 4.999999421e-01, 1.666643126e-01,
+            4.166800207e-02, 8.374155595e-03, 1.384365236e-03
+        };
+
+        // 2^r = 1 + r * P(r), |r| <= 1/2
+        constexpr double EXP2[] = {
+            6.931472029e-01, 2.402264791e-01, 5.550332470e-02,
+            9.618437366e-03, 1.339887487e-03, 1.535336063e-04
+        };
+
+        // log((1 + s) / (1 - s)) = 2s + s^3 * P(s^2), |s| <= 3 - 2 * sqrt(2)
+        constexpr double LOG[] = {
+            6.666666565e-01, 4.000033454e-01, 2.853734679e-01,
+            2.358147506e-01
+        };
+
+    } // namespace f32_coefs
+
+    namespace f64_coefs
+    {
+
+        constexpr double TAN_PRECISE[] = {
+            3.33333333333333759e-01, 1.33333333333258169e-01,
+            5.39682539726429183e-02, 2.18694884065001142e-02,
+            8.86323780516296185e-03, 3.59210211571489623e-03,
+            1.45603670515883883e-03, 5.88908994039849423e-04,
+            2.43592011080199551e-04, 8.39674480198334896e-05,
+            6.64751502712629383e-05, -2.46856872001185109e-05,
+            4.78414800955108164e-05, -2.38789663597784199e-05,
+            9.71083312002860952e-06
+        };
+        constexpr double TAN_FAST[] = {
+            3.33333334641377321e-01, 1.33333249108872343e-01,
+            5.39701120605989432e-02, 2.18495213767904879e-02,
+            8.98352818221145530e-03, 3.16035583023401619e-03,
+            2.38892537077888033e-03, -5.71498892488595867e-04,
+            9.50566551025866665e-04
+        };
+
+        constexpr double ATAN_PRECISE[] = {
+            -3.33333333333331983e-01, 1.99999999999532413e-01,
+            -1.42857142801660564e-01, 1.11111107821320027e-01,
+            -9.09089772464069384e-02, 7.69205970728097377e-02,
+            -6.66309909519586518e-02, 5.84785852537076309e-02,
+            -5.03918722019146767e-02, 3.80620621246975585e-02,
+            -1.79049579180934719e-02
+        };
+        constexpr double ATAN_FAST[] = {
+            -3.33333324990841728e-01, 1.99999039048675803e-01,
+            -1.42820076837617271e-01, 1.10446908722335924e-01,
+            -8.47626594502965680e-02, 4.74404333422263624e-02
+        };
+
+        constexpr double ASIN_PRECISE[] = {
+            1.66666666666654084e-01, 7.50000000033700653e-02,
+            4.46428568283354713e-02, 3.03819591366593020e-02,
+            2.23717580580735098e-02, 1.73597046442326257e-02,
+            1.38852366844551389e-02, 1.21692033646748649e-02,
+            6.52801205311957181e-03, 1.95281626528517223e-02,
+            -1.62240901197627414e-02, 3.19121577738712414e-02
+        };
+        constexpr double ASIN_FAST[] = {
+            1.66666671802590455e-01, 7.49994889789807051e-02,
+            4.46599720465241171e-02, 3.01125270428636849e-02,
+            2.46047009251810118e-02, 7.50950867001724896e-03,
+            3.46462854535978040e-02
+        };
+
+        constexpr double EXP10_PRECISE[] = {
+            2.30258509299404590e+00, 2.65094905523920543e+00,
+            2.03467859229342141e+00, 1.17125514890808313e+00,
+            5.39382929209585749e-01, 2.06995849553298972e-01,
+            6.80893636863709739e-02, 1.95976182434014039e-02,
+            5.01398477869256960e-03, 1.15758802925331806e-03,
+            2.41081388740832823e-04
+        };
+        constexpr double EXP10_FAST[] = {
+            2.30258509295506775e+00, 2.65094905548204274e+00,
+            2.03467861750909051e+00, 1.17125508905737430e+00,
+            5.39378750914089600e-01, 2.06999813956174117e-01,
+            6.83412401685102033e-02, 1.95434879659475355e-02
+        };
+
+        constexpr double SIN[] = {
+            -1.66666666666666297e-01, 8.33333333332211823e-03,
+            -1.98412698295889560e-04, 2.75573136212129913e-06,
+            -2.50507477391050109e-08, 1.58962289234398619e-10
+        };
+
+        constexpr double COS[] = {
+            4.16666666666665950e-02, -1.38888888888730557e-03,
+            2.48015872888514836e-05, -2.75573141792397877e-07,
+            2.08757008349566445e-09, -1.13585361878832080e-11
+        };
+
+        constexpr double EXP[] = {
+            1.00000000000000000e+00, 5.00000000000001221e-01,
+            1.66666666666662161e-01, 4.16666666665178251e-02,
+            8.33333333354969660e-03, 1.38888889463531962e-03,
+            1.98412694367867943e-04, 2.48014906360563988e-05,
+            2.75576267058013313e-06, 2.76310341779993079e-07,
+            2.49914301062616001e-08
+        };
+
+        constexpr double EXP2[] = {
+            6.93147180559945286e-01, 2.40226506959101305e-01,
+            5.55041086648200843e-02, 9.61812910759411895e-03,
+            1.33335581467746312e-03, 1.54035304571126415e-04,
+            1.52527334931184389e-05, 1.32154352820681866e-06,
+            1.01781995753067903e-07, 7.07378328540206272e-09,
+            4.43477081037750163e-10
+        };
+
+        constexpr double LOG[] = {
+            6.66666666666673402e-01, 3.99999999994163635e-01,
+            2.85714287420166690e-01, 2.22221986106898056e-01,
+            1.81835624091056164e-01, 1.53140987506624970e-01,
+            1.47954758810635217e-01
+        };
+
+        // P(z) of LOG = 2/3 + z * Q(z), for log in double-double
+        constexpr double LOG_DD[] = {
+            3.99999999999999967e-01, 2.85714285714341931e-01,
+            2.22222222201107544e-01, 1.81818185648984831e-01,
+            1.53845769885205763e-01, 1.33355705485931092e-01,
+            1.16894488571449601e-01, 1.18713885439579975e-01
+        };
+
+    } // namespace f64_coefs
+
+    // pi/2 = sum of PIO2_PARTS. first four parts have 24 significant bits,
+    // so q * PIO2_PARTS[i] is exact for q < 2^29 and x - q * pi/2
+    // can be accumulated in double without cancellation error
+    constexpr double PIO2_PARTS[] = {
+        1.57079625129699707031e+00, 7.54978941586159635335e-08,
+        5.39030252995776476554e-15, 3.28200341580791294123e-22,
+        1.27065587601398785720e-29
+    };
+
+    // sin/cos/tan arguments above this are reduced by payne-hanek method
+    constexpr double TRIG_MAX_ARGUMENT = 268435456.0; // 2^28
+
+    // bits of 2/pi, 32 per word, covering all finite f64 arguments.
+    // TWO_OVER_PI_WORDS[0] is padding for arguments whose exponent is small
+    constexpr uint32_t TWO_OVER_PI_WORDS[] = {
+        0x00000000,
+        0xa2f9836e, 0x4e441529, 0xfc2757d1, 0xf534ddc0, 0xdb629599, 0x3c439041,
+        0xfe5163ab, 0xdebbc561, 0xb7246e3a, 0x424dd2e0, 0x06492eea, 0x09d1921c,
+        0xfe1deb1c, 0xb129a73e, 0xe88235f5, 0x2ebb4484, 0xe99c7026, 0xb45f7e41,
+        0x3991d639, 0x835339f4, 0x9c845f8b, 0xbdf9283b, 0x1ff897ff, 0xde05980f,
+        0xef2f118b, 0x5a0a6d1f, 0x6d367ecf, 0x27cb09b7, 0x4f463f66, 0x9e5fea2d,
+        0x7527bac7, 0xebe5f17b, 0x3d0739f7, 0x8a5292ea, 0x6bfb5fb1, 0x1f8d5d08,
+        0x56033046
+    };
+
+    // number of words of 2/pi multiplied with the mantissa of x.
+    // absolute error of reduced argument is below 2^-104
+    constexpr int TWO_OVER_PI_WINDOW = 6;
+
+    // pow with |y| above this is passed to c library,
+    // so that splitting y in double-double arithmetic doesn't overflow
+    constexpr double POW_MAX_EXPONENT = 8.452712498170644e+270; // 2^900
+
+    struct MathConstants
+    {
+        // pi/2 = PIO2_HI + PIO2_LO
+        double pio2_hi;
+        double pio2_lo;
+
+        // log10(2) = LG102_HI + LG102_LO. n * LG102_HI is exact
+        double lg102_hi;
+        double lg102_lo;
+
+        // ln(2) = LN2_HI + LN2_LO. n * LN2_HI is exact
+        double ln2_hi;
+        double ln2_lo;
+
+        // b^x overflows/underflows outside [min, max]
+        double exp_min;
+        double exp_max;
+        double exp2_min;
+        double exp2_max;
+        double exp10_min;
+        double exp10_max;
+
+        int mantissa_bits;
+        int exponent_bias;
+    };
+
+    constexpr MathConstants F32_CONSTANTS = {
+        .pio2_hi       = 1.5707963705062866,
+        .pio2_lo       = -4.371139000186243e-8,
+        .lg102_hi      = 3.00781250000000000000e-1,
+        .lg102_lo      = 2.48745663981195213739e-4,
+        .ln2_hi        = 6.93145751953125000000e-1,
+        .ln2_lo        = 1.42860682030941725553e-6,
+        .exp_min       = -104,
+        .exp_max       = 89,
+        .exp2_min      = -151,
+        .exp2_max      = 129,
+        .exp10_min     = -46,
+        .exp10_max     = 39,
+        .mantissa_bits = 23,
+        .exponent_bias = 127
+    };
+
+    constexpr MathConstants F64_CONSTANTS = {
+        .pio2_hi       = 1.5707963267948966,
+        .pio2_lo       = 6.123233995736766e-17,
+        .lg102_hi      = 3.01025390625000000000e-1,
+        .lg102_lo      = 4.60503898119521373889e-6,
+        .ln2_hi        = 6.93147180369123816490e-1,
+        .ln2_lo        = 1.90821492927058770002e-10,
+        .exp_min       = -746,
+        .exp_max       = 710,
+        .exp2_min      = -1076,
+        .exp2_max      = 1025,
+        .exp10_min     = -324,
+        .exp10_max     = 309,
+        .mantissa_bits = 52,
+        .exponent_bias = 1023
+    };
+
+    // scalar or vector type of the same shape as type, with given element
+    // type. Type::getWithNewType isn't available on older llvm versions
+    llvm::Type *with_element_type(llvm::Type *type, llvm::Type *elem_type)
+    {
+        if(auto vec_type = llvm::dyn_cast<llvm::FixedVectorType>(type))
+            return llvm::FixedVectorType::get(elem_type, vec_type->getNumElements());
+        return elem_type;
+    }
+
+    // builds math functions on scalar or vector floating point type
+    class MathBuilder
+    {
+    public:
+
+        MathBuilder(
+            llvm::IRBuilder<> &builder,
+            llvm::Type        *type,
+            MathPrecision      precision)
+            : builder_(builder),
+              type_(type),
+              int_type_(with_element_type(type, llvm::IntegerType::get(
+                  type->getContext(), type->getScalarSizeInBits()))),
+              is_f32_(type->getScalarType()->isFloatTy()),
+              precision_(precision),
+              is_fast_(precision == MathPrecision::Fast),
+              consts_(is_f32_ ? F32_CONSTANTS : F64_CONSTANTS)
+        {
+
+        }
+
+        llvm::Value *tan(llvm::Value *x)
+        {
+            auto [r, quadrant] = reduce_pio2(x);
+            auto is_odd = builder_.CreateTrunc(quadrant, i1_type());
+
+            auto z = mul(r, r);
+            auto p = coefs(
+                f32_coefs::TAN_PRECISE, f32_coefs::TAN_FAST,
+                f64_coefs::TAN_PRECISE, f64_coefs::TAN_FAST);
+            auto t = fmuladd(mul(r, z), poly(z, p), r);
+
+            // tan(r + pi/2) = -1/tan(r)
+            auto result = select(is_odd, builder_.CreateFDiv(c(-1), t), t);
+            return trig_special_cases(x, result);
+        }
+
+        llvm::Value *atan(llvm::Value *x)
+        {
+            auto a = abs(x);
+            auto is_inv = builder_.CreateFCmpOGT(a, c(1));
+            auto t = select(is_inv, builder_.CreateFDiv(c(1), a), a);
+            auto r = atan01(t);
+            r = select(is_inv, sub(c(consts_.pio2_hi), r), r);
+            return copysign(r, x);
+        }
+
+        llvm::Value *atan2(llvm::Value *y, llvm::Value *x)
+        {
+            auto ax = abs(x);
+            auto ay = abs(y);
+            auto is_swapped = builder_.CreateFCmpOGT(ay, ax);
+            auto max_xy = select(is_swapped, ay, ax);
+            auto min_xy = select(is_swapped, ax, ay);
+
+            // atan2(0, 0) and atan2(inf, inf)
+            auto t = builder_.CreateFDiv(min_xy, max_xy);
+            t = select(builder_.CreateFCmpOEQ(max_xy, c(0)), c(0), t);
+            t = select(builder_.CreateFCmpOEQ(min_xy, inf()), c(1), t);
+
+            auto r = atan01(t);
+            r = select(is_swapped, sub(c(consts_.pio2_hi), r), r);
+            r = select(signbit(x), sub(c(2 * consts_.pio2_hi), r), r);
+            r = copysign(r, y);
+
+            return select(builder_.CreateFCmpUNO(x, y), add(x, y), r);
+        }
+
+        llvm::Value *asin(llvm::Value *x)
+        {
+            auto s = asin_core(abs(x));
+            return copysign(select(s.is_reduced, reflect(s.value), s.value), x);
+        }
+
+        llvm::Value *acos(llvm::Value *x)
+        {
+            auto s = asin_core(abs(x));
+
+            // |x| <= 0.5: pi/2 - asin(x)
+            // x > 0.5:    2 * asin(sqrt((1 - x) / 2))
+            // x < -0.5:   pi - 2 * asin(sqrt((1 + x) / 2))
+
+            auto small = sub(
+                c(consts_.pio2_hi),
+                sub(copysign(s.value, x), c(consts_.pio2_lo)));
+            auto twice = mul(c(2), s.value);
+            auto big = select(
+                signbit(x),
+                sub(c(2 * consts_.pio2_hi), sub(twice, c(2 * consts_.pio2_lo))),
+                twice);
+            return select(s.is_reduced, big, small);
+        }
+
+        llvm::Value *exp(llvm::Value *x)
+        {
+            return exp_base(x, {
+                .log2_base  = 1.44269504088896338700,
+                .logb2_hi   = consts_.ln2_hi,
+                .logb2_lo   = consts_.ln2_lo,
+                .min        = consts_.exp_min,
+                .max        = consts_.exp_max,
+                .coefs      = coefs(f32_coefs::EXP, f64_coefs::EXP)
+            });
+        }
+
+        llvm::Value *exp2(llvm::Value *x)
+        {
+            return exp_base(x, {
+                .log2_base  = 1,
+                .logb2_hi   = 1,
+                .logb2_lo   = 0,
+                .min        = consts_.exp2_min,
+                .max        = consts_.exp2_max,
+                .coefs      = coefs(f32_coefs::EXP2, f64_coefs::EXP2)
+            });
+        }
+
+        llvm::Value *exp10(llvm::Value *x)
+        {
+            return exp_base(x, {
+                .log2_base  = 3.32192809488736234787,
+                .logb2_hi   = consts_.lg102_hi,
+                .logb2_lo   = consts_.lg102_lo,
+                .min        = consts_.exp10_min,
+                .max        = consts_.exp10_max,
+                .coefs      = coefs(
+                    f32_coefs::EXP10_PRECISE, f32_coefs::EXP10_FAST,
+                    f64_coefs::EXP10_PRECISE, f64_coefs::EXP10_FAST)
+            });
+        }
+
+        llvm::Value *log(llvm::Value *x)
+        {
+            auto l = log_core(x);
+
+            // k * ln2_hi + (log(1 + f) + k * ln2_lo)
+            auto r = sub(
+                l.hfsq,
+                fmuladd(l.s, add(l.hfsq, l.r), mul(l.k, c(consts_.ln2_lo))));
+            r = fmuladd(l.k, c(consts_.ln2_hi), sub(l.f, r));
+            return log_special_cases(x, r);
+        }
+
+        llvm::Value *log2(llvm::Value *x)
+        {
+            auto l = log_core(x);
+            auto r = mul(log1p_of_core(l), c(1.44269504088896338700));
+            return log_special_cases(x, add(l.k, r));
+        }
+
+        llvm::Value *log10(llvm::Value *x)
+        {
+            auto l = log_core(x);
+            auto r = fmuladd(
+                log1p_of_core(l), c(0.43429448190325181667),
+                mul(l.k, c(consts_.lg102_lo)));
+            return log_special_cases(x, fmuladd(l.k, c(consts_.lg102_hi), r));
+        }
+
+        llvm::Value *sin(llvm::Value *x)
+        {
+            return trig_special_cases(x, sin_cos(x, false));
+        }
+
+        llvm::Value *cos(llvm::Value *x)
+        {
+            return trig_special_cases(x, sin_cos(x, true));
+        }
+
+        // x and y are vectors.
+        // lanes other than finite x > 0 and finite y call c library
+        llvm::Value *pow(llvm::Value *x, llvm::Value *y)
+        {
+            auto in_range = builder_.CreateAnd(
+                builder_.CreateAnd(
+                    builder_.CreateFCmpOGT(x, c(0)),
+                    builder_.CreateFCmpOLT(x, inf())),
+                builder_.CreateFCmpOLT(abs(y), c(POW_MAX_EXPONENT)));
+            auto xs = select(in_range, x, c(1));
+            auto ys = select(in_range, y, c(0));
+
+            llvm::Value *result;
+            if(is_f32_)
+            {
+                // log and exp in f64 are accurate enough for y * log(x)
+                MathBuilder wide(builder_, wide_type(), precision_);
+                auto xw = builder_.CreateFPExt(xs, wide_type());
+                auto yw = builder_.CreateFPExt(ys, wide_type());
+                result = builder_.CreateFPTrunc(
+                    wide.exp(wide.mul(yw, wide.log(xw))), type_);
+            }
+            else
+            {
+                // error of log(x) is amplified by y, so it is computed in
+                // double-double arithmetic
+                auto log_x = log_double_double(xs);
+                auto t = dd_mul(log_x, ys);
+                result = exp_base(t.hi, {
+                    .log2_base  = 1.44269504088896338700,
+                    .logb2_hi   = consts_.ln2_hi,
+                    .logb2_lo   = consts_.ln2_lo,
+                    .min        = consts_.exp_min,
+                    .max        = consts_.exp_max,
+                    .coefs      = f64_coefs::EXP
+                }, t.lo);
+            }
+
+            return with_c_fallback(
+                is_f32_ ? "powf" : "pow", { x, y }, in_range, result);
+        }
+
+        llvm::Value *rsqrt(llvm::Value *x)
+        {
+            if(is_fast_)
+            {
+                // allow backend to use reciprocal sqrt estimation
+                llvm::FastMathFlags flags;
+                flags.setApproxFunc();
+                flags.setAllowReciprocal();
+                builder_.setFastMathFlags(flags);
+            }
+            return builder_.CreateFDiv(
+                c(1), builder_.CreateUnaryIntrinsic(llvm::Intrinsic::sqrt, x));
+        }
+
+        // classification is done on bits to be unaffected by fast math flags
+
+        llvm::Value *isfinite(llvm::Value *x)
+        {
+            return to_i32(builder_.CreateICmpULT(abs_bits(x), exponent_mask()));
+        }
+
+        llvm::Value *isinf(llvm::Value *x)
+        {
+            return to_i32(builder_.CreateICmpEQ(abs_bits(x), exponent_mask()));
+        }
+
+        llvm::Value *isnan(llvm::Value *x)
+        {
+            return to_i32(builder_.CreateICmpUGT(abs_bits(x), exponent_mask()));
+        }
+
+    private:
+
+        struct AsinCore
+        {
+            llvm::Value *value;
+            llvm::Value *is_reduced;
+        };
+
+        struct ExpBase
+        {
+            double                   log2_base;
+            double                   logb2_hi; // log_b(2) = logb2_hi + logb2_lo.
+            double                   logb2_lo; // n * logb2_hi is exact
+            double                   min;
+            double                   max;
+            std::span<const double> coefs;
+        };
+
+        // x = 2^k * (1 + f), sqrt(1/2) <= 1 + f < sqrt(2).
+        // log(1 + f) = f - hfsq + s * (hfsq + r)
+        struct LogCore
+        {
+            llvm::Value *k; // floating point
+            llvm::Value *f;
+            llvm::Value *s;    // f / (2 + f)
+            llvm::Value *hfsq; // f^2 / 2
+            llvm::Value *r;    // s^2 * P(s^2)
+        };
+
+        // hi + lo, |lo| <= ulp(hi) / 2
+        struct DoubleDouble
+        {
+            llvm::Value *hi;
+            llvm::Value *lo;
+        };
+
+        // a >= 0. computes asin(a) when a <= 0.5,
+        // or asin(sqrt((1 - a) / 2)) otherwise
+        AsinCore asin_core(llvm::Value *a)
+        {
+            auto is_reduced = builder_.CreateFCmpOGT(a, c(0.5));
+            auto z = select(
+                is_reduced, mul(sub(c(1), a), c(0.5)), mul(a, a));
+            auto s = select(
+                is_reduced,
+                builder_.CreateUnaryIntrinsic(llvm::Intrinsic::sqrt, z), a);
+            auto p = coefs(
+                f32_coefs::ASIN_PRECISE, f32_coefs::ASIN_FAST,
+                f64_coefs::ASIN_PRECISE, f64_coefs::ASIN_FAST);
+            return { fmuladd(mul(s, z), poly(z, p), s), is_reduced };
+        }
+
+        // pi/2 - 2 * v
+        llvm::Value *reflect(llvm::Value *v)
+        {
+            return sub(
+                c(consts_.pio2_hi), sub(mul(c(2), v), c(consts_.pio2_lo)));
+        }
+
+        // atan(t), 0 <= t <= 1
+        llvm::Value *atan01(llvm::Value *t)
+        {
+            // atan(t) = pi/4 + atan((t - 1) / (t + 1))
+            auto is_reduced = builder_.CreateFCmpOGT(
+                t, c(0.41421356237309504880));
+            auto u = select(
+                is_reduced,
+                builder_.CreateFDiv(sub(t, c(1)), add(t, c(1))), t);
+
+            auto z = mul(u, u);
+            auto p = coefs(
+                f32_coefs::ATAN_PRECISE, f32_coefs::ATAN_FAST,
+                f64_coefs::ATAN_PRECISE, f64_coefs::ATAN_FAST);
+            auto r = fmuladd(mul(u, z), poly(z, p), u);
+            return select(is_reduced, add(c(0.5 * consts_.pio2_hi), r), r);
+        }
+
+        // b^(x + x_lo), where |x_lo| is within rounding error of x
+        llvm::Value *exp_base(
+            llvm::Value *x, const ExpBase &base, llvm::Value *x_lo = nullptr)
+        {
+            // nan is kept by ordered comparisons
+            auto xc = select(builder_.CreateFCmpOGT(x, c(base.max)),
+                             c(base.max), x);
+            xc = select(builder_.CreateFCmpOLT(xc, c(base.min)),
+                        c(base.min), xc);
+
+            // b^x = 2^n * b^r
+            auto n = rint(mul(xc, c(base.log2_base)));
+            auto r = fmuladd(neg(n), c(base.logb2_hi), xc);
+            if(base.logb2_lo != 0)
+                r = fmuladd(neg(n), c(base.logb2_lo), r);
+            if(x_lo)
+                r = add(r, select(builder_.CreateFCmpOEQ(x, xc), x_lo, c(0)));
+            auto result = fmuladd(r, poly(r, base.coefs), c(1));
+
+            // 2^n is split into two factors for denormal results.
+            // conversion is done through i32, which is cheaper for vectors
+            auto ni = builder_.CreateSExt(
+                builder_.CreateFPToSI(n, i32_type()), int_type_);
+            auto n1 = builder_.CreateAShr(ni, 1);
+            auto n2 = builder_.CreateSub(ni, n1);
+            result = mul(result, pow2(n1));
+            result = mul(result, pow2(n2));
+
+            return select(builder_.CreateFCmpUNO(x, x), x, result);
+        }
+
+        // results are meaningful for finite x > 0
+        LogCore log_core(llvm::Value *x)
+        {
+            // denormals are normalized first
+            const int denorm_shift = consts_.mantissa_bits + 2;
+            auto is_denorm = builder_.CreateFCmpOLT(
+                x, c(std::ldexp(1.0, 1 - consts_.exponent_bias)));
+            auto xs = select(
+                is_denorm, mul(x, c(std::ldexp(1.0, denorm_shift))), x);
+
+            // subtracting bits of sqrt(1/2) moves mantissas in
+            // [sqrt(1/2), sqrt(2)) to the same exponent
+            auto sqrt_half = builder_.CreateBitCast(
+                c(0.70710678118654752440), int_type_);
+            auto ix = builder_.CreateSub(
+                builder_.CreateBitCast(xs, int_type_), sqrt_half);
+            auto k = builder_.CreateAShr(ix, consts_.mantissa_bits);
+            k = builder_.CreateSub(
+                k, select(is_denorm, int_c(denorm_shift), int_c(0)));
+            auto m = builder_.CreateBitCast(
+                builder_.CreateAdd(
+                    builder_.CreateAnd(ix, int_c(
+                        (int64_t(1) << consts_.mantissa_bits) - 1)),
+                    sqrt_half),
+                type_);
+
+            auto f = sub(m, c(1));
+            auto s = builder_.CreateFDiv(f, add(c(2), f));
+            auto z = mul(s, s);
+            auto r = mul(z, poly(z, coefs(f32_coefs::LOG, f64_coefs::LOG)));
+            auto hfsq = mul(mul(c(0.5), f), f);
+            auto kf = builder_.CreateSIToFP(
+                builder_.CreateTrunc(k, i32_type()), type_);
+            return { kf, f, s, hfsq, r };
+        }
+
+        llvm::Value *log1p_of_core(const LogCore &l)
+        {
+            return sub(l.f, sub(l.hfsq, mul(l.s, add(l.hfsq, l.r))));
+        }
+
+        llvm::Value *log_special_cases(llvm::Value *x, llvm::Value *result)
+        {
+            result = select(builder_.CreateFCmpOEQ(x, c(0)), neg(inf()), result);
+            result = select(builder_.CreateFCmpOLT(x, c(0)), nan(), result);
+            result = select(builder_.CreateFCmpOEQ(x, inf()), x, result);
+            return select(builder_.CreateFCmpUNO(x, x), x, result);
+        }
+
+        // f64 only. x is finite and positive
+        DoubleDouble log_double_double(llvm::Value *x)
+        {
+            auto l = log_core(x);
+
+            // s = f / (2 + f)
+            auto d_hi = add(c(2), l.f);
+            auto d_lo = sub(l.f, sub(d_hi, c(2)));
+            auto s_hi = builder_.CreateFDiv(l.f, d_hi);
+            auto p = two_prod(s_hi, d_hi);
+            auto e = sub(sub(sub(l.f, p.hi), p.lo), mul(s_hi, d_lo));
+            DoubleDouble s = { s_hi, builder_.CreateFDiv(e, d_hi) };
+
+            // log(1 + f) = 2s + s^3 * (2/3 + z * Q(z)), z = s^2
+            auto z = dd_mul(s, s);
+            auto zq = mul(z.hi, poly(z.hi, f64_coefs::LOG_DD));
+            auto pz = two_sum(
+                c(6.66666666666666629659e-01),
+                add(zq, c(3.70074341541718826265e-17)));
+            auto s3p = dd_mul(dd_mul(s, z), pz);
+            auto log1p = dd_add({ mul(c(2), s.hi), mul(c(2), s.lo) }, s3p);
+
+            auto kln2 = dd_mul(
+                { c(6.93147180559945286227e-01), c(2.31904681384629955842e-17) },
+                l.k);
+            return dd_add(kln2, log1p);
+        }
+
+        DoubleDouble two_sum(llvm::Value *a, llvm::Value *b)
+        {
+            auto s = add(a, b);
+            auto bb = sub(s, a);
+            return { s, add(sub(a, sub(s, bb)), sub(b, bb)) };
+        }
+
+        // |a| >= |b|
+        DoubleDouble fast_two_sum(llvm::Value *a, llvm::Value *b)
+        {
+            auto s = add(a, b);
+            return { s, sub(b, sub(s, a)) };
+        }
+
+        // exact product without relying on fma.
+        // separate fmul/fsub are not contracted without fast math flags
+        DoubleDouble two_prod(llvm::Value *a, llvm::Value *b)
+        {
+            auto split = [&](llvm::Value *v) -> DoubleDouble
+            {
+                auto t = mul(c(134217729.0), v); // 2^27 + 1
+                auto hi = sub(t, sub(t, v));
+                return { hi, sub(v, hi) };
+            };
+            auto p = mul(a, b);
+            auto [ah, al] = split(a);
+            auto [bh, bl] = split(b);
+            auto err = add(
+                add(add(sub(mul(ah, bh), p), mul(ah, bl)), mul(al, bh)),
+                mul(al, bl));
+            return { p, err };
+        }
+
+        DoubleDouble dd_add(const DoubleDouble &a, const DoubleDouble &b)
+        {
+            auto s = two_sum(a.hi, b.hi);
+            return fast_two_sum(s.hi, add(s.lo, add(a.lo, b.lo)));
+        }
+
+        DoubleDouble dd_mul(const DoubleDouble &a, const DoubleDouble &b)
+        {
+            auto p = two_prod(a.hi, b.hi);
+            auto e = add(p.lo, add(mul(a.hi, b.lo), mul(a.lo, b.hi)));
+            return fast_two_sum(p.hi, e);
+        }
+
+        DoubleDouble dd_mul(const DoubleDouble &a, llvm::Value *b)
+        {
+            auto p = two_prod(a.hi, b);
+            return fast_two_sum(p.hi, add(p.lo, mul(a.lo, b)));
+        }
+
+        struct ReducedArgument
+        {
+            llvm::Value *r;
+            llvm::Value *quadrant; // i32
+        };
+
+        // x = quadrant * pi/2 + r for finite x.
+        // reduction is done in f64 for both f32 and f64, and both methods
+        // are computed for all lanes so that no branch is generated
+        ReducedArgument reduce_pio2(llvm::Value *x)
+        {
+            auto type = wide_type();
+            auto xr = is_f32_ ? builder_.CreateFPExt(x, type) : x;
+            auto ax = abs(xr);
+            auto in_range = builder_.CreateFCmpOLE(ax, c(type, TRIG_MAX_ARGUMENT));
+
+            auto xs = select(in_range, xr, c(type, 0));
+            auto q = rint(mul(xs, c(type, 0.63661977236758134308)));
+            llvm::Value *r = xs;
+            for(double part : PIO2_PARTS)
+                r = fmuladd(neg(q), c(type, part), r);
+            r = select(builder_.CreateFCmpOEQ(q, c(type, 0)), xs, r);
+            llvm::Value *quadrant = builder_.CreateFPToSI(q, i32_type());
+
+            // other lanes are replaced by a large argument to keep
+            // table indices valid
+            auto is_large = builder_.CreateAnd(
+                builder_.CreateNot(in_range),
+                builder_.CreateFCmpONE(ax, c(type, HUGE_VAL)));
+            auto large = reduce_pio2_large(
+                select(is_large, ax, c(type, 2 * TRIG_MAX_ARGUMENT)));
+            auto is_neg = signbit(x);
+            r = select(
+                in_range, r,
+                select(is_neg, neg(large.r), large.r));
+            quadrant = select(
+                in_range, quadrant,
+                select(is_neg, builder_.CreateNeg(large.quadrant), large.quadrant));
+
+            if(is_f32_)
+                r = builder_.CreateFPTrunc(r, type_);
+            return { r, quadrant };
+        }
+
+        // payne-hanek reduction of f64 a > TRIG_MAX_ARGUMENT.
+        // with a = m * 2^s, a * 2/pi mod 4 is computed from m and
+        // TWO_OVER_PI_WINDOW words of 2/pi starting near bit s, because
+        // preceding bits contribute multiples of 4
+        ReducedArgument reduce_pio2_large(llvm::Value *a)
+        {
+            auto i64_type = with_element_type(wide_type(), builder_.getInt64Ty());
+            auto i64 = [&](uint64_t v)
+            {
+                return llvm::ConstantInt::get(i64_type, v);
+            };
+            auto mask32 = i64(0xffffffff);
+
+            auto bits = builder_.CreateBitCast(a, i64_type);
+            auto m = builder_.CreateOr(
+                builder_.CreateAnd(bits, i64((uint64_t(1) << 52) - 1)),
+                i64(uint64_t(1) << 52));
+
+            // e = s + 30 >= 0 selects word j = e / 32 containing the bit of
+            // weight 2 in a * 2/pi, and m is shifted by e % 32 to align the
+            // product to word boundary
+            auto e = builder_.CreateSub(builder_.CreateLShr(bits, 52), i64(1045));
+            auto j = builder_.CreateLShr(e, 5);
+            auto shift = builder_.CreateAnd(e, i64(31));
+            auto rshift = builder_.CreateSub(i64(32), shift);
+
+            // m * 2^shift in 32-bit limbs, least significant first
+            llvm::Value *ms[3] = {
+                builder_.CreateAnd(builder_.CreateShl(m, shift), mask32),
+                builder_.CreateAnd(builder_.CreateLShr(m, rshift), mask32),
+                builder_.CreateLShr(builder_.CreateLShr(m, 32), rshift)
+            };
+
+            // window of 2/pi in 32-bit limbs, least significant first
+            constexpr int W = TWO_OVER_PI_WINDOW;
+            llvm::Value *ws[W];
+            for(int i = 0; i < W; ++i)
+            {
+                ws[i] = builder_.CreateZExt(
+                    load_two_over_pi(builder_.CreateAdd(j, i64(W - 1 - i))),
+                    i64_type);
+            }
+
+            // product modulo 2^(32 * W). high halves of partial products
+            // are added to the next column, so columns don't overflow
+            llvm::Value *cols[W + 1];
+            for(auto &col : cols)
+                col = i64(0);
+            for(int i = 0; i < 3; ++i)
+            {
+                for(int k = 0; i + k < W; ++k)
+                {
+                    auto p = builder_.CreateMul(ms[i], ws[k]);
+                    cols[i + k] = builder_.CreateAdd(
+                        cols[i + k], builder_.CreateAnd(p, mask32));
+                    cols[i + k + 1] = builder_.CreateAdd(
+                        cols[i + k + 1], builder_.CreateLShr(p, 32));
+                }
+            }
+            llvm::Value *limbs[W];
+            llvm::Value *carry = i64(0);
+            for(int i = 0; i < W; ++i)
+            {
+                auto col = builder_.CreateAdd(cols[i], carry);
+                limbs[i] = builder_.CreateAnd(col, mask32);
+                carry = builder_.CreateLShr(col, 32);
+            }
+
+            // top 2 bits are the quadrant, and the rest is the fraction.
+            // fraction is taken as signed to round quadrant to nearest
+            auto hi = builder_.CreateOr(
+                builder_.CreateShl(limbs[W - 1], 32), limbs[W - 2]);
+            auto mid = builder_.CreateOr(
+                builder_.CreateShl(limbs[W - 3], 32), limbs[W - 4]);
+            auto frac_hi = builder_.CreateOr(
+                builder_.CreateShl(hi, 2), builder_.CreateLShr(mid, 62));
+            auto frac_lo = builder_.CreateShl(mid, 2);
+            auto quadrant = builder_.CreateAdd(
+                builder_.CreateLShr(hi, 62), builder_.CreateLShr(frac_hi, 63));
+
+            // fraction = (frac_hi + frac_lo / 2^64) / 2^64 as signed frac_hi,
+            // converted in two exact or nearly exact parts
+            auto type = wide_type();
+            auto f_hi = builder_.CreateSIToFP(
+                builder_.CreateAShr(frac_hi, 11), type);
+            auto f_lo = builder_.CreateUIToFP(
+                builder_.CreateOr(
+                    builder_.CreateShl(frac_hi, 53),
+                    builder_.CreateLShr(frac_lo, 11)),
+                type);
+            auto f = fmuladd(
+                f_lo, c(type, std::ldexp(1.0, -117)),
+                mul(f_hi, c(type, std::ldexp(1.0, -53))));
+            auto r = fmuladd(
+                f, c(type, F64_CONSTANTS.pio2_hi),
+                mul(f, c(type, F64_CONSTANTS.pio2_lo)));
+
+            return { r, builder_.CreateTrunc(quadrant, i32_type()) };
+        }
+
+        // i64 index -> i32 word of TWO_OVER_PI_WORDS
+        llvm::Value *load_two_over_pi(llvm::Value *index)
+        {
+            auto &module = *builder_.GetInsertBlock()->getModule();
+            auto i32_type = builder_.getInt32Ty();
+            auto table_type = llvm::ArrayType::get(
+                i32_type, std::size(TWO_OVER_PI_WORDS));
+
+            const char *name = "__cuj_math_two_over_pi";
+            auto table = module.getNamedGlobal(name);
+            if(!table)
+            {
+                table = new llvm::GlobalVariable(
+                    module, table_type, true,
+                    llvm::GlobalValue::PrivateLinkage,
+                    llvm::ConstantDataArray::get(
+                        module.getContext(),
+                        llvm::ArrayRef<uint32_t>(TWO_OVER_PI_WORDS)),
+                    name);
+                table->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+            }
+
+            auto addr = builder_.CreateGEP(
+                table_type, table, { builder_.getInt64(0), index });
+            if(!type_->isVectorTy())
+                return builder_.CreateLoad(i32_type, addr);
+            auto vec_type = with_element_type(index->getType(), i32_type);
+            return detail::create_masked_gather_inst(
+                builder_, vec_type, addr, llvm::Align(4));
+        }
+
+        // tan/sin/cos of infinity or nan is nan
+        llvm::Value *trig_special_cases(llvm::Value *x, llvm::Value *result)
+        {
+            auto is_finite = builder_.CreateICmpULT(abs_bits(x), exponent_mask());
+            return select(is_finite, result, sub(x, x));
+        }
+
+        llvm::Value *sin_cos(llvm::Value *x, bool is_cos)
+        {
+            auto [r, quadrant] = reduce_pio2(x);
+
+            // cos(x) = sin(x + pi/2)
+            if(is_cos)
+                quadrant = builder_.CreateAdd(
+                    quadrant, llvm::ConstantInt::get(quadrant->getType(), 1));
+            auto use_cos = builder_.CreateTrunc(quadrant, i1_type());
+            auto is_neg = builder_.CreateTrunc(
+                builder_.CreateLShr(quadrant, 1), i1_type());
+
+            auto z = mul(r, r);
+            auto sin_r = fmuladd(
+                mul(r, z), poly(z, coefs(f32_coefs::SIN, f64_coefs::SIN)), r);
+            auto cos_r = fmuladd(
+                mul(z, z), poly(z, coefs(f32_coefs::COS, f64_coefs::COS)),
+                fmuladd(z, c(-0.5), c(1)));
+
+            auto result = select(use_cos, cos_r, sin_r);
+            return select(is_neg, neg(result), result);
+        }
+
+        // returns result when all lanes are in range.
+        // otherwise all lanes are computed by c library.
+        // c functions are called by name rather than through llvm intrinsics,
+        // which vectorizers could map back to the vector function calling them
+        llvm::Value *with_c_fallback(
+            const char                          *c_name,
+            std::initializer_list<llvm::Value *> args,
+            llvm::Value                         *in_range,
+            llvm::Value                         *result)
+        {
+            auto &context = builder_.getContext();
+            auto scalar_type = type_->getScalarType();
+            const std::vector<llvm::Type *> arg_types(args.size(), scalar_type);
+            auto c_func = builder_.GetInsertBlock()->getModule()->getOrInsertFunction(
+                c_name, llvm::FunctionType::get(scalar_type, arg_types, false));
+
+            auto func = builder_.GetInsertBlock()->getParent();
+            auto fast_block = builder_.GetInsertBlock();
+            auto fallback_block = llvm::BasicBlock::Create(
+                context, "c_fallback", func);
+            auto exit_block = llvm::BasicBlock::Create(context, "exit", func);
+
+            const bool is_vector = type_->isVectorTy();
+            auto out_of_range = builder_.CreateNot(in_range);
+            auto any_out_of_range = is_vector ?
+                builder_.CreateOrReduce(out_of_range) : out_of_range;
+            builder_.CreateCondBr(
+                any_out_of_range, fallback_block, exit_block,
+                llvm::MDBuilder(context).createBranchWeights(1, 1000));
+
+            builder_.SetInsertPoint(fallback_block);
+            llvm::Value *fallback_result;
+            if(is_vector)
+            {
+                fallback_result = llvm::UndefValue::get(type_);
+                const unsigned lanes =
+                    llvm::cast<llvm::FixedVectorType>(type_)->getNumElements();
+                for(unsigned lane = 0; lane < lanes; ++lane)
+                {
+                    std::vector<llvm::Value *> lane_args;
+                    for(auto arg : args)
+                        lane_args.push_back(builder_.CreateExtractElement(arg, lane));
+                    fallback_result = builder_.CreateInsertElement(
+                        fallback_result, builder_.CreateCall(c_func, lane_args), lane);
+                }
+            }
+            else
+                fallback_result = builder_.CreateCall(c_func, std::vector(args));
+            builder_.CreateBr(exit_block);
+
+            builder_.SetInsertPoint(exit_block);
+            auto phi = builder_.CreatePHI(type_, 2);
+            phi->addIncoming(result, fast_block);
+            phi->addIncoming(fallback_result, fallback_block);
+            return phi;
+        }
+
+        // f64 type with the same shape as type_
+        llvm::Type *wide_type() const
+        {
+            return with_element_type(type_, builder_.getDoubleTy());
+        }
+
+        llvm::Type *i32_type() const
+        {
+            return with_element_type(type_, builder_.getInt32Ty());
+        }
+
+        llvm::Type *i1_type() const
+        {
+            return with_element_type(type_, builder_.getInt1Ty());
+        }
+
+        std::span<const double> coefs(
+            std::span<const double> f32_precise,
+            std::span<const double> f32_fast,
+            std::span<const double> f64_precise,
+            std::span<const double> f64_fast) const
+        {
+            if(is_f32_)
+                return is_fast_ ? f32_fast : f32_precise;
+            return is_fast_ ? f64_fast : f64_precise;
+        }
+
+        // functions without fast variants
+        std::span<const double> coefs(
+            std::span<const double> f32, std::span<const double> f64) const
+        {
+            return is_f32_ ? f32 : f64;
+        }
+
+        llvm::Value *poly(llvm::Value *x, std::span<const double> coefs)
+        {
+            llvm::Value *result = c(coefs.back());
+            for(size_t i = coefs.size() - 1; i > 0; --i)
+                result = fmuladd(result, x, c(coefs[i - 1]));
+            return result;
+        }
+
+        // 2^n for normal exponents
+        llvm::Value *pow2(llvm::Value *n)
+        {
+            auto bits = builder_.CreateShl(
+                builder_.CreateAdd(n, int_c(consts_.exponent_bias)),
+                consts_.mantissa_bits);
+            return builder_.CreateBitCast(bits, type_);
+        }
+
+        llvm::Value *abs_bits(llvm::Value *x)
+        {
+            return builder_.CreateAnd(
+                builder_.CreateBitCast(x, int_type_),
+                llvm::ConstantInt::get(
+                    int_type_, llvm::APInt::getSignedMaxValue(
+                        int_type_->getScalarSizeInBits())));
+        }
+
+        llvm::Value *exponent_mask()
+        {
+            return builder_.CreateBitCast(inf(), int_type_);
+        }
+
+        llvm::Value *signbit(llvm::Value *x)
+        {
+            return builder_.CreateICmpSLT(
+                builder_.CreateBitCast(x, int_type_), int_c(0));
+        }
+
+        llvm::Value *to_i32(llvm::Value *b)
+        {
+            return builder_.CreateZExt(b, i32_type());
+        }
+
+        llvm::Constant *int_c(int64_t v)
+        {
+            return llvm::ConstantInt::get(int_type_, v, true);
+        }
+
+        llvm::Constant *c(double v)
+        {
+            return c(type_, v);
+        }
+
+        llvm::Constant *c(llvm::Type *type, double v)
+        {
+            return llvm::ConstantFP::get(type, v);
+        }
+
+        llvm::Constant *inf()
+        {
+            return llvm::ConstantFP::getInfinity(type_);
+        }
+
+        llvm::Constant *nan()
+        {
+            return llvm::ConstantFP::getNaN(type_);
+        }
+
+        llvm::Value *add(llvm::Value *a, llvm::Value *b)
+        {
+            return builder_.CreateFAdd(a, b);
+        }
+
+        llvm::Value *sub(llvm::Value *a, llvm::Value *b)
+        {
+            return builder_.CreateFSub(a, b);
+        }
+
+        llvm::Value *mul(llvm::Value *a, llvm::Value *b)
+        {
+            return builder_.CreateFMul(a, b);
+        }
+
+        llvm::Value *neg(llvm::Value *a)
+        {
+            return builder_.CreateFNeg(a);
+        }
+
+        llvm::Value *select(llvm::Value *cond, llvm::Value *a, llvm::Value *b)
+        {
+            return builder_.CreateSelect(cond, a, b);
+        }
+
+        llvm::Value *fmuladd(llvm::Value *a, llvm::Value *b, llvm::Value *c)
+        {
+            return builder_.CreateIntrinsic(
+                llvm::Intrinsic::fmuladd, { a->getType() }, { a, b, c });
+        }
+
+        llvm::Value *abs(llvm::Value *x)
+        {
+            return builder_.CreateUnaryIntrinsic(llvm::Intrinsic::fabs, x);
+        }
+
+        llvm::Value *rint(llvm::Value *x)
+        {
+            return builder_.CreateUnaryIntrinsic(llvm::Intrinsic::rint, x);
+        }
+
+        llvm::Value *copysign(llvm::Value *mag, llvm::Value *sign)
+        {
+            return builder_.CreateBinaryIntrinsic(
+                llvm::Intrinsic::copysign, mag, sign);
+        }
+
+        llvm::IRBuilder<>   &builder_;
+        llvm::Type          *type_;
+        llvm::Type          *int_type_;
+        bool                 is_f32_;
+        MathPrecision        precision_;
+        bool                 is_fast_;
+        const MathConstants &consts_;
+    };
+
+    bool is_in_ir_function(core::Intrinsic intrinsic_type)
+    {
+        switch(intrinsic_type)
+        {
+        case core::Intrinsic::f32_tan:
+        case core::Intrinsic::f32_asin:
+        case core::Intrinsic::f32_acos:
+        case core::Intrinsic::f32_atan:
+        case core::Intrinsic::f32_atan2:
+        case core::Intrinsic::f32_exp10:
+        case core::Intrinsic::f32_rsqrt:
+        case core::Intrinsic::f64_tan:
+        case core::Intrinsic::f64_asin:
+        case core::Intrinsic::f64_acos:
+        case core::Intrinsic::f64_atan:
+        case core::Intrinsic::f64_atan2:
+        case core::Intrinsic::f64_exp10:
+        case core::Intrinsic::f64_rsqrt:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool is_classification(core::Intrinsic intrinsic_type)
+    {
+        switch(intrinsic_type)
+        {
+        case core::Intrinsic::f32_isfinite:
+        case core::Intrinsic::f32_isinf:
+        case core::Intrinsic::f32_isnan:
+        case core::Intrinsic::f64_isfinite:
+        case core::Intrinsic::f64_isinf:
+        case core::Intrinsic::f64_isnan:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+} // namespace anonymous
+
+llvm::Function *get_native_math_function(
+    llvm::Module   &top_module,
+    core::Intrinsic intrinsic_type,
+    MathPrecision   precision)
+{
+    // classification is exact and always done in ir
+    if(!is_classification(intrinsic_type) &&
+       (precision == MathPrecision::Library ||
+        !is_in_ir_function(intrinsic_type)))
+        return nullptr;
+
+    // __cuj_intrinsic_xxx -> __cuj_math_xxx
+    std::string_view intrinsic_str = core::intrinsic_name(intrinsic_type);
+    intrinsic_str.remove_prefix(std::string_view("__cuj_intrinsic_").size());
+    const std::string name = "__cuj_math_" + std::string(intrinsic_str);
+    if(auto func = top_module.getFunction(name))
+        return func;
+
+    auto &context = top_module.getContext();
+    auto i32 = llvm::Type::getInt32Ty(context);
+    auto f32 = llvm::Type::getFloatTy(context);
+    auto f64 = llvm::Type::getDoubleTy(context);
+    auto type = intrinsic_str.starts_with("f32_") ? f32 : f64;
+
+    const bool is_binary = intrinsic_type == core::Intrinsic::f32_atan2 ||
+                           intrinsic_type == core::Intrinsic::f64_atan2;
+    auto ret_type = is_classification(intrinsic_type) ? i32 : type;
+    auto func_type = is_binary ?
+        llvm::FunctionType::get(ret_type, { type, type }, false) :
+        llvm::FunctionType::get(ret_type, { type }, false);
+
+    auto func = llvm::Function::Create(
+        func_type, llvm::GlobalValue::InternalLinkage, name, &top_module);
+    func->addFnAttr(llvm::Attribute::ReadNone);
+    func->addFnAttr(llvm::Attribute::NoUnwind);
+    func->addFnAttr(llvm::Attribute::AlwaysInline);
+
+    llvm::IRBuilder<> builder(
+        llvm::BasicBlock::Create(context, "entry", func));
+    MathBuilder math(builder, type, precision);
+    auto x = func->getArg(0);
+
+    llvm::Value *result;
+    switch(intrinsic_type)
+    {
+    case core::Intrinsic::f32_tan:
+    case core::Intrinsic::f64_tan:
+        result = math.tan(x);
+        break;
+    case core::Intrinsic::f32_asin:
+    case core::Intrinsic::f64_asin:
+        result = math.asin(x);
+        break;
+    case core::Intrinsic::f32_acos:
+    case core::Intrinsic::f64_acos:
+        result = math.acos(x);
+        break;
+    case core::Intrinsic::f32_atan:
+    case core::Intrinsic::f64_atan:
+        result = math.atan(x);
+        break;
+    case core::Intrinsic::f32_atan2:
+    case core::Intrinsic::f64_atan2:
+        result = math.atan2(x, func->getArg(1));
+        break;
+    case core::Intrinsic::f32_exp10:
+    case core::Intrinsic::f64_exp10:
+        result = math.exp10(x);
+        break;
+    case core::Intrinsic::f32_rsqrt:
+    case core::Intrinsic::f64_rsqrt:
+        result = math.rsqrt(x);
+        break;
+    case core::Intrinsic::f32_isfinite:
+    case core::Intrinsic::f64_isfinite:
+        result = math.isfinite(x);
+        break;
+    case core::Intrinsic::f32_isinf:
+    case core::Intrinsic::f64_isinf:
+        result = math.isinf(x);
+        break;
+    default:
+        result = math.isnan(x);
+        break;
+    }
+
+    builder.CreateRet(result);
+    return func;
+}
+
+void define_vector_math_function(
+    llvm::Function *func, core::Intrinsic intrinsic_type)
+{
+    func->setLinkage(llvm::GlobalValue::InternalLinkage);
+    func->addFnAttr(llvm::Attribute::NoUnwind);
+
+    // pow calls c library for special arguments, which may set errno
+    if(intrinsic_type != core::Intrinsic::f32_pow &&
+       intrinsic_type != core::Intrinsic::f64_pow)
+        func->addFnAttr(llvm::Attribute::ReadNone);
+
+    llvm::IRBuilder<> builder(
+        llvm::BasicBlock::Create(func->getContext(), "entry", func));
+    MathBuilder math(
+        builder, func->getFunctionType()->getParamType(0),
+        MathPrecision::Precise);
+    auto x = func->getArg(0);
+
+    llvm::Value *result;
+    switch(intrinsic_type)
+    {
+    case core::Intrinsic::f32_sin:
+    case core::Intrinsic::f64_sin:
+        result = math.sin(x);
+        break;
+    case core::Intrinsic::f32_cos:
+    case core::Intrinsic::f64_cos:
+        result = math.cos(x);
+        break;
+    case core::Intrinsic::f32_exp:
+    case core::Intrinsic::f64_exp:
+        result = math.exp(x);
+        break;
+    case core::Intrinsic::f32_exp2:
+    case core::Intrinsic::f64_exp2:
+        result = math.exp2(x);
+        break;
+    case core::Intrinsic::f32_log:
+    case core::Intrinsic::f64_log:
+        result = math.log(x);
+        break;
+    case core::Intrinsic::f32_log2:
+    case core::Intrinsic::f64_log2:
+        result = math.log2(x);
+        break;
+    case core::Intrinsic::f32_log10:
+    case core::Intrinsic::f64_log10:
+        result = math.log10(x);
+        break;
+    case core::Intrinsic::f32_pow:
+    case core::Intrinsic::f64_pow:
+        result = math.pow(x, func->getArg(1));
+        break;
+    default:
+        throw CujException(
+            std::string("no vector math function for ") +
+            core::intrinsic_name(intrinsic_type));
+    }
+
+    builder.CreateRet(result);
+}
+
+CUJ_NAMESPACE_END(cuj::gen)
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
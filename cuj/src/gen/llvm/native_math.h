@@ -0,0 +1,23 @@
+#pragma once
+
+#include <llvm/IR/Module.h>
+
+#include <cuj/core/intrinsic.h>
+#include <cuj/gen/option.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+// returns internal function implementing given intrinsic in llvm ir,
+// which can be inlined and vectorized.
+// returns nullptr if the intrinsic should be implemented by c library
+llvm::Function *get_native_math_function(
+    llvm::Module   &top_module,
+    core::Intrinsic intrinsic_type,
+    MathPrecision   precision);
+
+// defines body of vector function declared by vectorizers.
+// intrinsic_type is the scalar version, such as f32_sin
+void define_vector_math_function(
+    llvm::Function *func, core::Intrinsic intrinsic_type);
+
+CUJ_NAMESPACE_END(cuj::gen)
@@ -0,0 +1,469 @@
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4141)
+#pragma warning(disable: 4244)
+#pragma warning(disable: 4624)
+#pragma warning(disable: 4626)
+#pragma warning(disable: 4996)
+#endif
+
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <mutex>
+
+#include <llvm/Analysis/TargetTransformInfo.h>
+#include <llvm/ExecutionEngine/MCJIT.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/MC/SubtargetFeature.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/TargetRegistry.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Target/TargetOptions.h>
+#include <llvm/Transforms/IPO/PassManagerBuilder.h>
+#include <llvm/Transforms/IPO.h>
+#include <llvm/Transforms/InstCombine/InstCombine.h>
+#include <llvm/Transforms/Scalar.h>
+
+#include <cuj/gen/llvm.h>
+
+#include "compile_stats.h"
+#include "helper.h"
+#include "native_module.h"
+#include "vector_math.h"
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+namespace
+{
+
+    void assert_fail(
+        const char *message,
+        const char *file,
+        int32_t     line,
+        const char *function)
+    {
+        std::cerr << "assertion failed. "
+                  << "file: " << file << ", "
+                  << "line: " << line << ", "
+                  << "func: " << function << ", "
+                  << "message: " << message;
+        std::abort();
+    }
+
+    std::map<std::string, void *> create_native_intrinsic_functions()
+    {
+        std::map<std::string, void *> ret;
+
+#define ADD_GLOBAL_FUNC(NAME, FUNC) \
+        ret[#NAME] = reinterpret_cast<void *>(FUNC)
+
+        auto *f32_exp10    = +[](float x)            { return std::pow(10.0f, x); };
+        auto *f32_rsqrt    = +[](float x)            { return 1 / std::sqrt(x); };
+        auto *f32_isfinite = +[](float x) -> int32_t { return std::isfinite(x); };
+        auto *f32_isinf    = +[](float x) -> int32_t { return std::isinf(x); };
+        auto *f32_isnan    = +[](float x) -> int32_t { return std::isnan(x); };
+        
+        auto *f64_exp10    = +[](double x)            { return std::pow(10.0, x); };
+        auto *f64_rsqrt    = +[](double x)            { return 1 / std::sqrt(x); };
+        auto *f64_isfinite = +[](double x) -> int32_t { return std::isfinite(x); };
+        auto *f64_isinf    = +[](double x) -> int32_t { return std::isinf(x); };
+        auto *f64_isnan    = +[](double x) -> int32_t { return std::isnan(x); };
+
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_mod,      &::fmodf);
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_rem,      &::remainderf);
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_exp10,    f32_exp10);
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_rsqrt,    f32_rsqrt);
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_tan,      &::tanf);
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_asin,     &::asinf);
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_acos,     &::acosf);
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_atan,     &::atanf);
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_atan2,    &::atan2f);
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_isfinite, f32_isfinite);
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_isinf,    f32_isinf);
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_isnan,    f32_isnan);
+
+        using DD  = double(*)(double);
+        using DDD = double(*)(double, double);
+
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_mod,      static_cast<DDD>(&::fmod));
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_rem,      static_cast<DDD>(&::remainder));
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_exp10,    f64_exp10);
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_rsqrt,    f64_rsqrt);
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_tan,      static_cast<DD>(&::tan));
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_asin,     static_cast<DD>(&::asin));
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_acos,     static_cast<DD>(&::acos));
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_atan,     static_cast<DD>(&::atan));
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_atan2,    static_cast<DDD>(&::atan2));
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_isfinite, f64_isfinite);
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_isinf,    f64_isinf);
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_isnan,    f64_isnan);
+
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_print,       printf);
+        ADD_GLOBAL_FUNC(__cuj_intrinsic_assert_fail, assert_fail);
+
+#undef ADD_GLOBAL_FUNC
+
+        return ret;
+    }
+
+} // namespace anonymous
+
+void init_native_target()
+{
+    static std::once_flag init_native_target_flag;
+    std::call_once(init_native_target_flag, []
+    {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+        LLVMLinkInMCJIT();
+    });
+}
+
+std::pair<std::string, std::string> get_native_cpu(const Options &opts)
+{
+    if(!opts.native_cpu.empty())
+        return { opts.native_cpu, opts.native_cpu_features };
+
+    std::string cpu = llvm::sys::getHostCPUName().str();
+    if(!opts.native_cpu_features.empty())
+        return { std::move(cpu), opts.native_cpu_features };
+
+    llvm::SubtargetFeatures features;
+    llvm::StringMap<bool> host_features;
+    if(llvm::sys::getHostCPUFeatures(host_features))
+    {
+        for(auto &f : host_features)
+            features.AddFeature(f.first(), f.second);
+    }
+    return { std::move(cpu), features.getString() };
+}
+
+llvm::TargetMachine *get_native_target_machine(
+    llvm::CodeGenOpt::Level codegen_opt,
+    const std::string      &cpu,
+    const std::string      &cpu_features,
+    bool                    jit)
+{
+    init_native_target();
+
+    auto target_triple = llvm::sys::getDefaultTargetTriple();
+
+    std::string err;
+    auto target = llvm::TargetRegistry::lookupTarget(target_triple, err);
+    if(!target)
+        throw CujException(err);
+
+    llvm::Optional<llvm::Reloc::Model> reloc_model;
+    if(!jit)
+        reloc_model = llvm::Reloc::PIC_;
+
+    return target->createTargetMachine(
+        target_triple, cpu, cpu_features,
+        {}, reloc_model, {}, codegen_opt, jit);
+}
+
+void do_llvm_optimize(
+    llvm::Module        *mod,
+    llvm::TargetMachine *tm,
+    const Options       &opts,
+    CompileStats        *stats)
+{
+    llvm::PassManagerBuilder pass_mgr_builder;
+    pass_mgr_builder.OptLevel = static_cast<int>(opts.opt_level);
+    pass_mgr_builder.Inliner = llvm::createFunctionInliningPass(
+        pass_mgr_builder.OptLevel, 0, false);
+    pass_mgr_builder.SLPVectorize = true;
+    pass_mgr_builder.LoopVectorize = true;
+    if(opts.opt_level == OptimizationLevel::O2 ||
+       opts.opt_level == OptimizationLevel::O3)
+        pass_mgr_builder.MergeFunctions = true;
+    else
+        pass_mgr_builder.MergeFunctions = false;
+    tm->adjustPassManager(pass_mgr_builder);
+
+    // vectorizers replace calls to math intrinsics with vector variants
+    // registered in library info. ownership is taken by pass_mgr_builder
+    pass_mgr_builder.LibraryInfo = create_vector_math_library_info(
+        tm->getTargetTriple(), opts.vector_math_library).release();
+
+    // builtin vector functions are defined before optimization so that
+    // their bodies are optimized with the module
+    define_vector_math_functions(*mod, *tm, opts.vector_math_library);
+
+    {
+        PhaseTimer timer;
+        llvm::legacy::FunctionPassManager fp_mgr(mod);
+        fp_mgr.add(
+            createTargetTransformInfoWrapperPass(tm->getTargetIRAnalysis()));
+        pass_mgr_builder.populateFunctionPassManager(fp_mgr);
+        fp_mgr.doInitialization();
+        for(auto &f : mod->functions())
+            fp_mgr.run(f);
+        fp_mgr.doFinalization();
+        if(stats)
+            stats->function_pass_time += timer.get_seconds();
+    }
+
+    {
+        PhaseTimer timer;
+        llvm::legacy::PassManager passes;
+        passes.add(
+            createTargetTransformInfoWrapperPass(tm->getTargetIRAnalysis()));
+        pass_mgr_builder.populateModulePassManager(passes);
+        passes.run(*mod);
+
+        // calls to vector functions are added by vectorizers after the
+        // inliner has run, so they get a second inlining round
+        if(finalize_vector_math_functions(*mod, *tm, opts.vector_math_library))
+        {
+            llvm::legacy::PassManager late_passes;
+            late_passes.add(
+                createTargetTransformInfoWrapperPass(tm->getTargetIRAnalysis()));
+            late_passes.add(llvm::createFunctionInliningPass(
+                pass_mgr_builder.OptLevel, 0, false));
+            late_passes.add(llvm::createInstructionCombiningPass());
+            late_passes.add(llvm::createCFGSimplificationPass());
+            late_passes.add(llvm::createGlobalDCEPass());
+            late_passes.run(*mod);
+        }
+
+        if(stats)
+            stats->module_pass_time += timer.get_seconds();
+    }
+
+    if(stats)
+        stats->ir_instruction_count_after_opt += count_instructions(*mod);
+}
+
+LLVMModuleData build_llvm_module(
+    const dsl::Module &mod, const Options &opts, CompileStats *stats)
+{
+    PhaseTimer prog_timer;
+    auto prog = mod._generate_prog();
+    if(stats)
+        stats->generate_prog_time += prog_timer.get_seconds();
+
+    return build_llvm_module(std::move(prog), opts, stats);
+}
+
+LLVMModuleData build_llvm_module(
+    core::Prog prog, const Options &opts, CompileStats *stats)
+{
+    init_native_target();
+
+    const llvm::CodeGenOpt::Level codegen_opt =
+        llvm_helper::get_codegen_opt_level(opts.opt_level);
+    auto [cpu, cpu_features] = get_native_cpu(opts);
+    auto target_machine = get_native_target_machine(
+        codegen_opt, cpu, cpu_features);
+    auto data_layout = target_machine->createDataLayout();
+
+    LLVMIRGenerator llvm_ir_gen;
+    llvm_ir_gen.set_target(LLVMIRGenerator::Target::Native);
+    if(opts.fast_math)
+        llvm_ir_gen.use_fast_math();
+    if(opts.approx_math_func)
+        llvm_ir_gen.use_approx_math_func();
+    if(!opts.enable_assert)
+        llvm_ir_gen.disable_assert();
+    llvm_ir_gen.set_native_math_precision(opts.native_math_precision);
+    llvm_ir_gen.set_cpu_kernel_simd_width(opts.cpu_kernel_simd_width);
+    llvm_ir_gen.set_data_layout(&data_layout);
+
+    PhaseTimer ir_timer;
+    llvm_ir_gen.generate(std::move(prog));
+    const double ir_generation_time = ir_timer.get_seconds();
+
+    // function attributes make per-function codegen agree with
+    // the target machine, and allow inlining between them
+    auto llvm_module = llvm_ir_gen.get_llvm_module();
+    llvm_module->setTargetTriple(
+        target_machine->getTargetTriple().str());
+    for(auto &f : llvm_module->functions())
+    {
+        if(f.isDeclaration())
+            continue;
+        f.addFnAttr("target-cpu", cpu);
+        if(!cpu_features.empty())
+            f.addFnAttr("target-features", cpu_features);
+    }
+
+    if(stats)
+    {
+        stats->ir_generation_time += ir_generation_time;
+        stats->ir_instruction_count_before_opt +=
+            count_instructions(*llvm_module);
+        stats->local_alloca_count += count_allocas(*llvm_module);
+    }
+
+    LLVMModuleData ret;
+    std::tie(ret.llvm_context, ret.llvm_module) =
+        llvm_ir_gen.get_data_ownership();
+    ret.codegen_opt  = codegen_opt;
+    ret.machine      = target_machine;
+    ret.cpu          = std::move(cpu);
+    ret.cpu_features = std::move(cpu_features);
+
+    return ret;
+}
+
+LLVMModuleData create_empty_llvm_module(const Options &opts)
+{
+    init_native_target();
+
+    LLVMModuleData ret;
+    ret.codegen_opt = llvm_helper::get_codegen_opt_level(opts.opt_level);
+    std::tie(ret.cpu, ret.cpu_features) = get_native_cpu(opts);
+    ret.machine = get_native_target_machine(
+        ret.codegen_opt, ret.cpu, ret.cpu_features);
+
+    ret.llvm_context = newBox<llvm::LLVMContext>();
+    ret.llvm_module = newBox<llvm::Module>("cuj_objects", *ret.llvm_context);
+    ret.llvm_module->setDataLayout(ret.machine->createDataLayout());
+    ret.llvm_module->setTargetTriple(ret.machine->getTargetTriple().str());
+
+    return ret;
+}
+
+const std::map<std::string, void *> &get_native_intrinsic_functions()
+{
+    static const std::map<std::string, void *> ret =
+        create_native_intrinsic_functions();
+    return ret;
+}
+
+void define_native_intrinsic_functions(llvm::Module &llvm_module)
+{
+    auto &context = llvm_module.getContext();
+
+    auto replace_with_function = [&](const char *name, const char *c_name)
+    {
+        auto func = llvm_module.getFunction(name);
+        if(!func || !func->isDeclaration())
+            return;
+        auto c_func = llvm_module.getOrInsertFunction(
+            c_name, func->getFunctionType()).getCallee();
+        func->replaceAllUsesWith(c_func);
+        func->eraseFromParent();
+    };
+
+    auto define_function = [&](
+        const char *name,
+        const std::function<llvm::Value*(
+            llvm::IRBuilder<> &, llvm::Function *)> &body)
+    {
+        auto func = llvm_module.getFunction(name);
+        if(!func || !func->isDeclaration())
+            return;
+        func->setLinkage(llvm::GlobalValue::InternalLinkage);
+        llvm::IRBuilder<> builder(
+            llvm::BasicBlock::Create(context, "entry", func));
+        auto ret = body(builder, func);
+        if(builder.GetInsertBlock()->getTerminator())
+            return;
+        if(ret)
+            builder.CreateRet(ret);
+        else
+            builder.CreateRetVoid();
+    };
+
+    auto arg = [](llvm::Function *func, unsigned i)
+    {
+        return func->getArg(i);
+    };
+
+    for(const char *type : { "f32", "f64" })
+    {
+        const bool is_f32 = type == std::string("f32");
+        auto c_name = [&](std::string name)
+        {
+            return is_f32 ? name + "f" : name;
+        };
+        auto intrinsic_name = [&](const char *name)
+        {
+            return std::string("__cuj_intrinsic_") + type + "_" + name;
+        };
+
+        for(const char *name : { "mod", "rem", "tan", "asin", "acos", "atan", "atan2" })
+        {
+            const std::string c_base_name =
+                name == std::string("mod") ? "fmod" :
+                name == std::string("rem") ? "remainder" : name;
+            replace_with_function(
+                intrinsic_name(name).c_str(), c_name(c_base_name).c_str());
+        }
+
+        define_function(intrinsic_name("exp10").c_str(), [&](
+            llvm::IRBuilder<> &builder, llvm::Function *func)
+        {
+            auto x = arg(func, 0);
+            auto pow = llvm_module.getOrInsertFunction(
+                c_name("pow"), x->getType(), x->getType(), x->getType());
+            return builder.CreateCall(
+                pow, { llvm::ConstantFP::get(x->getType(), 10.0), x });
+        });
+
+        define_function(intrinsic_name("rsqrt").c_str(), [&](
+            llvm::IRBuilder<> &builder, llvm::Function *func)
+        {
+            auto x = arg(func, 0);
+            auto sqrt = builder.CreateUnaryIntrinsic(llvm::Intrinsic::sqrt, x);
+            return builder.CreateFDiv(
+                llvm::ConstantFP::get(x->getType(), 1.0), sqrt);
+        });
+
+        auto define_class_test = [&](const char *name, auto test)
+        {
+            define_function(intrinsic_name(name).c_str(), [&](
+                llvm::IRBuilder<> &builder, llvm::Function *func)
+            {
+                auto x = arg(func, 0);
+                auto inf = llvm::ConstantFP::getInfinity(x->getType());
+                auto abs = builder.CreateUnaryIntrinsic(llvm::Intrinsic::fabs, x);
+                return builder.CreateZExt(
+                    test(builder, x, abs, inf), builder.getInt32Ty());
+            });
+        };
+
+        define_class_test("isfinite", [](auto &b, auto, auto abs, auto inf)
+        {
+            return b.CreateFCmpONE(abs, inf);
+        });
+        define_class_test("isinf", [](auto &b, auto, auto abs, auto inf)
+        {
+            return b.CreateFCmpOEQ(abs, inf);
+        });
+        define_class_test("isnan", [](auto &b, auto x, auto, auto)
+        {
+            return b.CreateFCmpUNO(x, x);
+        });
+    }
+
+    replace_with_function("__cuj_intrinsic_print", "printf");
+
+    define_function("__cuj_intrinsic_assert_fail", [&](
+        llvm::IRBuilder<> &builder, llvm::Function *func) -> llvm::Value *
+    {
+        auto printf = llvm_module.getOrInsertFunction(
+            "printf", llvm::FunctionType::get(
+                builder.getInt32Ty(), { builder.getInt8PtrTy() }, true));
+        auto abort = llvm_module.getOrInsertFunction(
+            "abort", builder.getVoidTy());
+
+        auto format = builder.CreateGlobalStringPtr(
+            "assertion failed. file: %s, line: %d, func: %s, message: %s\n");
+        builder.CreateCall(
+            printf, { format, arg(func, 1), arg(func, 2), arg(func, 3), arg(func, 0) });
+        builder.CreateCall(abort);
+        builder.CreateUnreachable();
+        return nullptr;
+    });
+}
+
+CUJ_NAMESPACE_END(cuj::gen)
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4141)
+#pragma warning(disable: 4244)
+#pragma warning(disable: 4624)
+#pragma warning(disable: 4626)
+#pragma warning(disable: 4996)
+#endif
+
+#include <llvm/IR/Module.h>
+#include <llvm/Support/CodeGen.h>
+#include <llvm/Target/TargetMachine.h>
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <cuj/dsl/module.h>
+#include <cuj/gen/compile_stats.h>
+#include <cuj/gen/option.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+struct LLVMModuleData
+{
+    Box<llvm::LLVMContext>  llvm_context;
+    Box<llvm::Module>       llvm_module;
+    llvm::TargetMachine    *machine;
+    llvm::CodeGenOpt::Level codegen_opt;
+    std::string             cpu;
+    std::string             cpu_features;
+};
+
+// thread-safe. called by functions below on demand
+void init_native_target();
+
+// returns (cpu name, feature string) of native target
+std::pair<std::string, std::string> get_native_cpu(const Options &opts);
+
+// machine for aot compilation generates position independent code
+llvm::TargetMachine *get_native_target_machine(
+    llvm::CodeGenOpt::Level codegen_opt,
+    const std::string      &cpu,
+    const std::string      &cpu_features,
+    bool                    jit = true);
+
+// pass timings and optimized instruction count are added to stats
+void do_llvm_optimize(
+    llvm::Module        *mod,
+    llvm::TargetMachine *tm,
+    const Options       &opts,
+    CompileStats        *stats = nullptr);
+
+// generate unoptimized llvm module for native target.
+// ownership of returned target machine is transferred to caller
+LLVMModuleData build_llvm_module(
+    const dsl::Module &mod, const Options &opts, CompileStats *stats = nullptr);
+
+LLVMModuleData build_llvm_module(
+    core::Prog prog, const Options &opts, CompileStats *stats = nullptr);
+
+// empty llvm module with target machine of given options, for execution
+// engines loading compiled objects only
+LLVMModuleData create_empty_llvm_module(const Options &opts);
+
+// symbol name -> address of functions called by native llvm module
+const std::map<std::string, void *> &get_native_intrinsic_functions();
+
+// replace declarations of functions in get_native_intrinsic_functions()
+// with definitions or c library functions, for code not loaded by jit
+void define_native_intrinsic_functions(llvm::Module &llvm_module);
+
+CUJ_NAMESPACE_END(cuj::gen)
@@ -61,6 +61,8 @@ namespace
         func = llvm::Function::Create(
             func_type, llvm::GlobalValue::ExternalLinkage, name, top_module);
         func->deleteBody();
+        // keeps failure paths out of hot code
+        func->addFnAttr(llvm::Attribute::Cold);
         return func;
     }
 
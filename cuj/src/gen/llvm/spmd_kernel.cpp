@@ -0,0 +1,1932 @@
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4141)
+#pragma warning(disable: 4244)
+#pragma warning(disable: 4624)
+#pragma warning(disable: 4626)
+#pragma warning(disable: 4996)
+#endif
+
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Verifier.h>
+
+#include <cuj/core/visit.h>
+#include <cuj/utils/scope_guard.h>
+#include <cuj/utils/unreachable.h>
+
+#include "helper.h"
+#include "spmd_kernel.h"
+#include "vector_intrinsic.h"
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+namespace
+{
+
+    bool is_kernel_index_intrinsic(core::Intrinsic intrinsic)
+    {
+        return core::Intrinsic::thread_idx_x <= intrinsic &&
+               intrinsic <= core::Intrinsic::block_dim_z;
+    }
+
+    // math, min/max, bit manipulation and fma intrinsics.
+    // they have no side effects and can be called for inactive lanes
+    bool is_pure_intrinsic(core::Intrinsic intrinsic)
+    {
+        return core::Intrinsic::f32_abs <= intrinsic &&
+               intrinsic <= core::Intrinsic::f64_fma;
+    }
+
+    // pure intrinsics accepting vector arguments
+    bool is_elementwise_intrinsic(core::Intrinsic intrinsic)
+    {
+        switch(intrinsic)
+        {
+        case core::Intrinsic::f32_min:
+        case core::Intrinsic::f32_max:
+        case core::Intrinsic::f64_min:
+        case core::Intrinsic::f64_max:
+        case core::Intrinsic::i32_min:
+        case core::Intrinsic::i32_max:
+        case core::Intrinsic::u32_min:
+        case core::Intrinsic::u32_max:
+        case core::Intrinsic::i64_min:
+        case core::Intrinsic::i64_max:
+        case core::Intrinsic::u64_min:
+        case core::Intrinsic::u64_max:
+        case core::Intrinsic::popcount:
+        case core::Intrinsic::clz:
+        case core::Intrinsic::ctz:
+        case core::Intrinsic::bswap:
+        case core::Intrinsic::rotl:
+        case core::Intrinsic::rotr:
+        case core::Intrinsic::add_sat_s:
+        case core::Intrinsic::add_sat_u:
+        case core::Intrinsic::f32_fma:
+        case core::Intrinsic::f64_fma:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // integer arithmetic on linear values assumes that lanes don't overflow,
+    // as does indexing with the first lane in scalar code
+    bool is_linear_type(llvm::Type *type)
+    {
+        return (type->isIntegerTy() && !type->isIntegerTy(1)) ||
+               type->isPointerTy();
+    }
+
+} // namespace anonymous
+
+SPMDKernelGenerator::Exits &SPMDKernelGenerator::Exits::operator|=(const Exits &rhs)
+{
+    loop  |= rhs.loop;
+    scope |= rhs.scope;
+    ret   |= rhs.ret;
+    return *this;
+}
+
+SPMDKernelGenerator::SPMDKernelGenerator(
+    LLVMIRGenerator &gen, const core::Func &func, int width)
+    : gen_(gen),
+      llvm_(*gen.llvm_),
+      ir_(*gen.llvm_->ir_builder),
+      func_(func),
+      width_(width)
+{
+    assert(width > 1);
+}
+
+bool SPMDKernelGenerator::is_supported(const core::Func &func)
+{
+    bool has_inline_asm = false;
+    core::Visitor visitor;
+    visitor.on_inline_asm = [&](const core::InlineAsm &)
+    {
+        has_inline_asm = true;
+    };
+    visitor.visit(*func.root_block);
+    return !has_inline_asm;
+}
+
+void SPMDKernelGenerator::generate(llvm::Function *spmd_func)
+{
+    function_ = spmd_func;
+    llvm_.current_function = spmd_func;
+    CUJ_SCOPE_EXIT{ llvm_.current_function = nullptr; };
+
+    const auto arg_index = static_cast<unsigned>(func_.argument_types.size());
+    llvm_.block_info = spmd_func->getArg(arg_index);
+    for(unsigned i = 0; i < 3; ++i)
+        llvm_.thread_idx[i] = spmd_func->getArg(arg_index + 1 + i);
+
+    mask_type_ = llvm::FixedVectorType::get(ir_.getInt1Ty(), width_);
+
+    auto entry_block = llvm::BasicBlock::Create(
+        *llvm_.context, "entry", spmd_func);
+    ir_.SetInsertPoint(entry_block);
+
+    gen_.generate_local_allocs(&func_);
+
+    analyze();
+    create_slot_storages();
+
+    exec_mask_ = ir_.CreateAlloca(mask_type_, nullptr, "exec_mask");
+    store_mask(spmd_func->getArg(arg_index + 4));
+
+    generate(*func_.root_block);
+    ir_.CreateRetVoid();
+
+#if defined(DEBUG) || defined(_DEBUG)
+    std::string err_msg;
+    llvm::raw_string_ostream err_stream(err_msg);
+    if(verifyFunction(*spmd_func, &err_stream))
+        throw CujException(err_msg);
+#endif
+}
+
+void SPMDKernelGenerator::analyze()
+{
+    // a variable is uniform or linear only if all stores into it are,
+    // which is found by iterating until no shape changes
+
+    const size_t local_count = llvm_.local_allocas.size();
+    slots_.resize(local_count + llvm_.arg_allocas.size());
+    for(size_t i = 0; i < local_count; ++i)
+        slots_[i].type = llvm_.local_allocas[i]->getAllocatedType();
+    for(size_t i = 0; i < llvm_.arg_allocas.size(); ++i)
+    {
+        auto &slot = slots_[local_count + i];
+        slot.type = llvm_.arg_allocas[i]->getAllocatedType();
+        slot.stored_shape = Shape::Uniform;
+        slot.holds_other_values = true;
+    }
+    count_stores(*func_.root_block, false);
+
+    do
+    {
+        analysis_changed_ = false;
+        shapes_.clear();
+        analyze(*func_.root_block, false);
+
+    } while(analysis_changed_);
+}
+
+std::optional<size_t> SPMDKernelGenerator::get_slot_index(
+    const core::Expr &addr) const
+{
+    if(auto local = addr.as_if<core::LocalAllocAddr>())
+        return local->alloc_index;
+    if(auto arg = addr.as_if<core::FuncArgAddr>())
+        return llvm_.local_allocas.size() + arg->arg_index;
+    return std::nullopt;
+}
+
+SPMDKernelGenerator::Shape SPMDKernelGenerator::get_slot_shape(
+    size_t slot_index) const
+{
+    auto &slot = slots_[slot_index];
+    if(!slot.stored_shape || *slot.stored_shape == Shape::Uniform)
+        return Shape::Uniform;
+    if(*slot.stored_shape == Shape::Linear && slot.direct_only &&
+       is_linear_type(slot.type))
+        return Shape::Linear;
+    return Shape::Varying;
+}
+
+bool SPMDKernelGenerator::keeps_linear(const core::ArithmeticCast &cast) const
+{
+    // integer casts keep lanes consecutive unless they change signedness
+    // while extending
+    auto src_type = cast.src_type->as_if<core::Builtin>();
+    auto dst_type = cast.dst_type->as_if<core::Builtin>();
+    if(!src_type || !dst_type)
+        return false;
+
+    auto src_llvm_type = llvm_.type_manager.get_llvm_type(cast.src_type);
+    auto dst_llvm_type = llvm_.type_manager.get_llvm_type(cast.dst_type);
+    if(!is_linear_type(src_llvm_type) || !is_linear_type(dst_llvm_type) ||
+       src_llvm_type->isPointerTy() || dst_llvm_type->isPointerTy())
+        return false;
+
+    const unsigned src_bits = src_llvm_type->getIntegerBitWidth();
+    const unsigned dst_bits = dst_llvm_type->getIntegerBitWidth();
+    return src_bits == dst_bits ||
+           (src_bits < dst_bits && is_signed(*src_type) == is_signed(*dst_type));
+}
+
+void SPMDKernelGenerator::count_stores(const core::Stat &stat, bool in_loop)
+{
+    auto count_store = [&](const core::Expr &dst_addr)
+    {
+        if(auto slot_index = get_slot_index(dst_addr))
+        {
+            auto &slot = slots_[*slot_index];
+            ++slot.store_stat_count;
+            slot.stored_in_loop |= in_loop;
+        }
+    };
+
+    stat.match(
+        [&](const core::Store &store)
+    {
+        count_store(store.dst_addr);
+    },
+        [&](const core::Copy &copy)
+    {
+        count_store(copy.dst_addr);
+    },
+        [&](const core::Block &block)
+    {
+        count_stores(block, in_loop);
+    },
+        [&](const core::If &if_s)
+    {
+        count_stores(*if_s.calc_cond, in_loop);
+        count_stores(*if_s.then_body, in_loop);
+        if(if_s.else_body)
+            count_stores(*if_s.else_body, in_loop);
+    },
+        [&](const core::Loop &loop)
+    {
+        count_stores(*loop.body, true);
+    },
+        [&](const core::Switch &switch_s)
+    {
+        for(auto &branch : switch_s.branches)
+            count_stores(*branch.body, in_loop);
+        if(switch_s.default_body)
+            count_stores(*switch_s.default_body, in_loop);
+    },
+        [&](const core::MakeScope &make_scope)
+    {
+        count_stores(*make_scope.body, in_loop);
+    },
+        [&](const auto &) { });
+}
+
+void SPMDKernelGenerator::count_stores(const core::Block &block, bool in_loop)
+{
+    for(auto &s : block.stats)
+        count_stores(*s, in_loop);
+}
+
+SPMDKernelGenerator::Shape SPMDKernelGenerator::get_stored_shape(
+    size_t slot_index, Shape val_shape, bool divergent) const
+{
+    // inactive lanes keep their values when a variable is stored in
+    // divergent code, unless the variable is stored only once. lanes not
+    // running that store would read it uninitialized, so all lanes can be
+    // written, like temporary pointers made by the dsl
+    auto &slot = slots_[slot_index];
+    const bool stored_once =
+        slot_index < llvm_.local_allocas.size() && slot.direct_only &&
+        slot.store_stat_count == 1 && !slot.stored_in_loop;
+    return divergent && !stored_once ? Shape::Varying : val_shape;
+}
+
+void SPMDKernelGenerator::store_into_slot(size_t slot_index, Shape shape)
+{
+    auto &stored = slots_[slot_index].stored_shape;
+    const Shape new_shape = !stored || *stored == shape ? shape : Shape::Varying;
+    if(stored != new_shape)
+    {
+        stored = new_shape;
+        analysis_changed_ = true;
+    }
+}
+
+void SPMDKernelGenerator::use_slot_indirectly(size_t slot_index)
+{
+    if(slots_[slot_index].direct_only)
+    {
+        slots_[slot_index].direct_only = false;
+        analysis_changed_ = true;
+    }
+    forget_pointee(slot_index);
+}
+
+SPMDKernelGenerator::Shape SPMDKernelGenerator::escape_slot(size_t slot_index)
+{
+    // a variable whose address is used as a value can be accessed
+    // through any pointer, so each lane keeps its own copy in memory
+    use_slot_indirectly(slot_index);
+    store_into_slot(slot_index, Shape::Varying);
+    return Shape::Varying;
+}
+
+bool SPMDKernelGenerator::store_pointee(size_t slot_index, const core::Expr &val)
+{
+    auto pointee = get_slot_index(val);
+    if(!pointee)
+        pointee = get_pointee(val);
+    auto &slot = slots_[slot_index];
+    if(!pointee || slot.holds_other_values ||
+       (slot.pointee && slot.pointee != pointee))
+        return false;
+    if(!slot.pointee)
+    {
+        slot.pointee = pointee;
+        analysis_changed_ = true;
+    }
+    return true;
+}
+
+void SPMDKernelGenerator::forget_pointee(size_t slot_index)
+{
+    auto &slot = slots_[slot_index];
+    if(slot.holds_other_values)
+        return;
+    slot.holds_other_values = true;
+    analysis_changed_ = true;
+    if(slot.pointee)
+        escape_slot(*slot.pointee);
+}
+
+std::optional<size_t> SPMDKernelGenerator::get_pointee(
+    const core::Expr &addr) const
+{
+    auto load = addr.as_if<core::Load>();
+    if(!load)
+        return std::nullopt;
+    auto slot_index = get_slot_index(*load->src_addr);
+    if(!slot_index || slots_[*slot_index].holds_other_values)
+        return std::nullopt;
+    return slots_[*slot_index].pointee;
+}
+
+SPMDKernelGenerator::Exits SPMDKernelGenerator::analyze(
+    const core::Stat &stat, bool divergent)
+{
+    return stat.match(
+        [&](const core::Store &store)
+    {
+        auto slot_index = get_slot_index(store.dst_addr);
+        if(slot_index && store_pointee(*slot_index, store.val))
+        {
+            std::optional<size_t> pointee;
+            const Shape shape = analyze_address(store.val, pointee);
+            store_into_slot(
+                *slot_index, get_stored_shape(*slot_index, shape, divergent));
+        }
+        else
+            analyze_store(store.dst_addr, analyze(store.val), divergent);
+        return Exits{};
+    },
+        [&](const core::Copy &copy)
+    {
+        analyze_store(copy.dst_addr, analyze_load(copy.src_addr), divergent);
+        return Exits{};
+    },
+        [&](const core::Block &block)
+    {
+        return analyze(block, divergent);
+    },
+        [&](const core::Return &)
+    {
+        return Exits{ false, false, divergent };
+    },
+        [&](const core::If &if_s)
+    {
+        Exits exits = analyze(*if_s.calc_cond, divergent);
+        const bool divergent_body =
+            divergent || analyze(if_s.cond) != Shape::Uniform;
+        exits |= analyze(*if_s.then_body, divergent_body);
+        if(if_s.else_body)
+            exits |= analyze(*if_s.else_body, divergent_body);
+        return exits;
+    },
+        [&](const core::Loop &loop)
+    {
+        // lanes run different numbers of iterations if some of them exit
+        // the loop earlier, which makes the whole body divergent
+        const bool divergent_body = divergent || divergent_loops_.contains(&loop);
+        Exits exits = analyze(*loop.body, divergent_body);
+        if(exits.any() && divergent_loops_.insert(&loop).second)
+            analysis_changed_ = true;
+        exits.loop = false;
+        return exits;
+    },
+        [&](const core::Break &)
+    {
+        return Exits{ divergent, false, false };
+    },
+        [&](const core::Continue &)
+    {
+        return Exits{ divergent, false, false };
+    },
+        [&](const core::Switch &switch_s)
+    {
+        const bool divergent_body =
+            divergent || analyze(switch_s.value) != Shape::Uniform;
+        Exits exits;
+        for(auto &branch : switch_s.branches)
+            exits |= analyze(*branch.body, divergent_body);
+        if(switch_s.default_body)
+            exits |= analyze(*switch_s.default_body, divergent_body);
+        return exits;
+    },
+        [&](const core::CallFuncStat &call)
+    {
+        analyze(call.call_expr);
+        return Exits{};
+    },
+        [&](const core::MakeScope &make_scope)
+    {
+        Exits exits = analyze(*make_scope.body, divergent);
+        exits.scope = false;
+        return exits;
+    },
+        [&](const core::ExitScope &)
+    {
+        return Exits{ false, divergent, false };
+    },
+        [&](const core::InlineAsm &)
+    {
+        return Exits{};
+    });
+}
+
+SPMDKernelGenerator::Exits SPMDKernelGenerator::analyze(
+    const core::Block &block, bool divergent)
+{
+    // lanes that took an exit don't run the rest of the block
+    Exits exits;
+    for(auto &s : block.stats)
+    {
+        const Exits stat_exits = analyze(*s, divergent);
+        exits |= stat_exits;
+        divergent |= stat_exits.any();
+    }
+    return exits;
+}
+
+void SPMDKernelGenerator::analyze_store(
+    const core::Expr &dst_addr, Shape val_shape, bool divergent)
+{
+    if(auto slot_index = get_slot_index(dst_addr))
+    {
+        forget_pointee(*slot_index);
+        store_into_slot(
+            *slot_index, get_stored_shape(*slot_index, val_shape, divergent));
+        return;
+    }
+
+    std::optional<size_t> slot_index;
+    const Shape addr_shape = analyze_address(dst_addr, slot_index);
+    if(slot_index)
+    {
+        const bool is_uniform = !divergent &&
+                                addr_shape == Shape::Uniform &&
+                                val_shape == Shape::Uniform;
+        store_into_slot(*slot_index, is_uniform ? Shape::Uniform : Shape::Varying);
+    }
+}
+
+SPMDKernelGenerator::Shape SPMDKernelGenerator::analyze(const core::Expr &expr)
+{
+    auto all_uniform = [&](std::initializer_list<const core::Expr *> exprs)
+    {
+        bool result = true;
+        for(auto e : exprs)
+            result &= analyze(*e) == Shape::Uniform;
+        return result ? Shape::Uniform : Shape::Varying;
+    };
+
+    const Shape shape = expr.match(
+        [&](const core::FuncArgAddr &)
+    {
+        return escape_slot(*get_slot_index(expr));
+    },
+        [&](const core::LocalAllocAddr &)
+    {
+        return escape_slot(*get_slot_index(expr));
+    },
+        [&](const core::Load &e)
+    {
+        return analyze_load(*e.src_addr);
+    },
+        [&](const core::Immediate &)
+    {
+        return Shape::Uniform;
+    },
+        [&](const core::NullPtr &)
+    {
+        return Shape::Uniform;
+    },
+        [&](const core::ArithmeticCast &e)
+    {
+        const Shape src_shape = analyze(*e.src_val);
+        if(src_shape == Shape::Linear && !keeps_linear(e))
+            return Shape::Varying;
+        return src_shape;
+    },
+        [&](const core::BitwiseCast &e)
+    {
+        return all_uniform({ e.src_val.get() });
+    },
+        [&](const core::PointerOffset &e)
+    {
+        const Shape ptr_shape = analyze(*e.ptr_val);
+        const Shape offset_shape = analyze(*e.offset_val);
+        if(ptr_shape == Shape::Uniform && offset_shape == Shape::Uniform)
+            return Shape::Uniform;
+        const bool is_linear =
+            !e.negative &&
+            ((ptr_shape == Shape::Uniform && offset_shape == Shape::Linear) ||
+             (ptr_shape == Shape::Linear && offset_shape == Shape::Uniform));
+        return is_linear ? Shape::Linear : Shape::Varying;
+    },
+        [&](const core::ClassPointerToMemberPointer &e)
+    {
+        return all_uniform({ e.class_ptr.get() });
+    },
+        [&](const core::DerefClassPointer &e)
+    {
+        return analyze_load(*e.class_ptr);
+    },
+        [&](const core::DerefArrayPointer &e)
+    {
+        return analyze_load(*e.array_ptr);
+    },
+        [&](const core::SaveClassIntoLocalAlloc &e)
+    {
+        return all_uniform({ e.class_val.get() });
+    },
+        [&](const core::SaveArrayIntoLocalAlloc &e)
+    {
+        return all_uniform({ e.array_val.get() });
+    },
+        [&](const core::ArrayAddrToFirstElemAddr &e)
+    {
+        return all_uniform({ e.array_ptr.get() });
+    },
+        [&](const core::Binary &e)
+    {
+        const Shape lhs = analyze(*e.lhs);
+        const Shape rhs = analyze(*e.rhs);
+        if(lhs == Shape::Uniform && rhs == Shape::Uniform)
+            return Shape::Uniform;
+        auto type = e.lhs_type->as_if<core::Builtin>();
+        if(type && !is_floating_point(*type) && *type != core::Builtin::Bool)
+        {
+            if(e.op == core::Binary::Op::Add &&
+               ((lhs == Shape::Linear && rhs == Shape::Uniform) ||
+                (lhs == Shape::Uniform && rhs == Shape::Linear)))
+                return Shape::Linear;
+            if(e.op == core::Binary::Op::Sub &&
+               lhs == Shape::Linear && rhs == Shape::Uniform)
+                return Shape::Linear;
+        }
+        return Shape::Varying;
+    },
+        [&](const core::Unary &e)
+    {
+        return all_uniform({ e.val.get() });
+    },
+        [&](const core::Select &e)
+    {
+        return all_uniform({ e.cond.get(), e.true_val.get(), e.false_val.get() });
+    },
+        [&](const core::CallFunc &e)
+    {
+        return analyze(e);
+    },
+        [&](const core::GlobalVarAddr &)
+    {
+        return Shape::Uniform;
+    },
+        [&](const core::GlobalConstAddr &)
+    {
+        return Shape::Uniform;
+    },
+        [&](const core::MakeVector &e)
+    {
+        bool uniform = true;
+        for(auto &elem : e.elements)
+            uniform &= analyze(*elem) == Shape::Uniform;
+        return uniform ? Shape::Uniform : Shape::Varying;
+    },
+        [&](const core::VectorExtract &e)
+    {
+        return all_uniform({ e.vector.get(), e.index.get() });
+    },
+        [&](const core::VectorInsert &e)
+    {
+        return all_uniform({ e.vector.get(), e.index.get(), e.element.get() });
+    },
+        [&](const core::VectorShuffle &e)
+    {
+        return all_uniform({ e.lhs.get(), e.rhs.get() });
+    },
+        [&](const core::VectorReduce &e)
+    {
+        return all_uniform({ e.vector.get() });
+    });
+
+    shapes_[&expr] = shape;
+    return shape;
+}
+
+SPMDKernelGenerator::Shape SPMDKernelGenerator::analyze(const core::CallFunc &call)
+{
+    bool uniform_args = true;
+    for(auto &arg : call.args)
+        uniform_args &= analyze(*arg) == Shape::Uniform;
+
+    if(call.intrinsic == core::Intrinsic::thread_idx_x)
+        return Shape::Linear;
+    if(is_kernel_index_intrinsic(call.intrinsic))
+        return Shape::Uniform;
+
+    // other calls may have side effects, and are made once per lane
+    if(is_pure_intrinsic(call.intrinsic) && uniform_args)
+        return Shape::Uniform;
+    return Shape::Varying;
+}
+
+SPMDKernelGenerator::Shape SPMDKernelGenerator::analyze_address(
+    const core::Expr &addr, std::optional<size_t> &slot)
+{
+    // member, element and offset addresses of a variable are followed
+    // to the variable, so that accessing its parts doesn't make it escape
+
+    if(auto slot_index = get_slot_index(addr))
+    {
+        use_slot_indirectly(*slot_index);
+        slot = slot_index;
+        shapes_[&addr] = get_slot_shape(*slot_index);
+        return shapes_[&addr];
+    }
+
+    if(auto pointee = get_pointee(addr))
+    {
+        slot = pointee;
+        auto &load = addr.as<core::Load>();
+        shapes_[&addr] = get_slot_shape(*get_slot_index(*load.src_addr));
+        return shapes_[&addr];
+    }
+
+    auto analyze_base = [&](const core::Expr &base)
+    {
+        const Shape shape = analyze_address(base, slot);
+        return shape == Shape::Uniform ? Shape::Uniform : Shape::Varying;
+    };
+
+    Shape shape;
+    if(auto member = addr.as_if<core::ClassPointerToMemberPointer>())
+        shape = analyze_base(*member->class_ptr);
+    else if(auto elem = addr.as_if<core::ArrayAddrToFirstElemAddr>())
+        shape = analyze_base(*elem->array_ptr);
+    else if(auto offset = addr.as_if<core::PointerOffset>())
+    {
+        const Shape ptr_shape = analyze_address(*offset->ptr_val, slot);
+        const Shape offset_shape = analyze(*offset->offset_val);
+        if(ptr_shape == Shape::Uniform && offset_shape == Shape::Uniform)
+            shape = Shape::Uniform;
+        else if(!offset->negative &&
+                ((ptr_shape == Shape::Uniform && offset_shape == Shape::Linear) ||
+                 (ptr_shape == Shape::Linear && offset_shape == Shape::Uniform)))
+            shape = Shape::Linear;
+        else
+            shape = Shape::Varying;
+    }
+    else
+        return analyze(addr);
+
+    shapes_[&addr] = shape;
+    return shape;
+}
+
+SPMDKernelGenerator::Shape SPMDKernelGenerator::analyze_load(
+    const core::Expr &addr)
+{
+    // the loaded value may be the address of another slot
+    if(auto slot_index = get_slot_index(addr))
+    {
+        forget_pointee(*slot_index);
+        return get_slot_shape(*slot_index);
+    }
+
+    std::optional<size_t> slot_index;
+    const Shape addr_shape = analyze_address(addr, slot_index);
+    if(addr_shape != Shape::Uniform)
+        return Shape::Varying;
+    if(slot_index && get_slot_shape(*slot_index) != Shape::Uniform)
+        return Shape::Varying;
+    return Shape::Uniform;
+}
+
+SPMDKernelGenerator::Exits SPMDKernelGenerator::find_exits(
+    const core::Stat &stat)
+{
+    return stat.match(
+        [&](const core::Block &block)
+    {
+        return find_exits(block);
+    },
+        [&](const core::Return &)
+    {
+        return Exits{ false, false, true };
+    },
+        [&](const core::If &if_s)
+    {
+        Exits exits = find_exits(*if_s.then_body);
+        if(if_s.else_body)
+            exits |= find_exits(*if_s.else_body);
+        return exits;
+    },
+        [&](const core::Loop &loop)
+    {
+        Exits exits = find_exits(*loop.body);
+        exits.loop = false;
+        return exits;
+    },
+        [&](const core::Break &)
+    {
+        return Exits{ true, false, false };
+    },
+        [&](const core::Continue &)
+    {
+        return Exits{ true, false, false };
+    },
+        [&](const core::Switch &switch_s)
+    {
+        Exits exits;
+        for(auto &branch : switch_s.branches)
+            exits |= find_exits(*branch.body);
+        if(switch_s.default_body)
+            exits |= find_exits(*switch_s.default_body);
+        return exits;
+    },
+        [&](const core::MakeScope &make_scope)
+    {
+        Exits exits = find_exits(*make_scope.body);
+        exits.scope = false;
+        return exits;
+    },
+        [&](const core::ExitScope &)
+    {
+        return Exits{ false, true, false };
+    },
+        [&](const auto &)
+    {
+        return Exits{};
+    });
+}
+
+SPMDKernelGenerator::Exits SPMDKernelGenerator::find_exits(
+    const core::Block &block)
+{
+    Exits exits;
+    for(auto &s : block.stats)
+        exits |= find_exits(*s);
+    return exits;
+}
+
+bool SPMDKernelGenerator::is_lane_type(llvm::Type *type) const
+{
+    return type->isIntegerTy() || type->isFloatingPointTy() || type->isPointerTy();
+}
+
+bool SPMDKernelGenerator::is_contiguous_lane_type(llvm::Type *type) const
+{
+    auto &data_layout = llvm_.top_module->getDataLayout();
+    return is_lane_type(type) &&
+           data_layout.getTypeSizeInBits(type) ==
+           data_layout.getTypeAllocSizeInBits(type);
+}
+
+llvm::Type *SPMDKernelGenerator::get_varying_type(llvm::Type *type) const
+{
+    if(is_lane_type(type))
+        return llvm::FixedVectorType::get(type, width_);
+    return llvm::ArrayType::get(type, width_);
+}
+
+llvm::Type *SPMDKernelGenerator::get_scalar_type(const Value &value) const
+{
+    auto type = value.value->getType();
+    if(value.shape != Shape::Varying)
+        return type;
+    if(auto vec_type = llvm::dyn_cast<llvm::FixedVectorType>(type))
+        return vec_type->getElementType();
+    return llvm::cast<llvm::ArrayType>(type)->getElementType();
+}
+
+llvm::Type *SPMDKernelGenerator::get_pointed_type(const Value &ptr) const
+{
+    return get_scalar_type(ptr)->getPointerElementType();
+}
+
+llvm::Constant *SPMDKernelGenerator::get_lane_indices(llvm::Type *int_type) const
+{
+    std::vector<llvm::Constant *> indices;
+    for(int i = 0; i < width_; ++i)
+        indices.push_back(llvm::ConstantInt::get(int_type, i));
+    return llvm::ConstantVector::get(indices);
+}
+
+llvm::Value *SPMDKernelGenerator::to_varying(const Value &value)
+{
+    switch(value.shape)
+    {
+    case Shape::Uniform:
+    {
+        auto type = value.value->getType();
+        if(is_lane_type(type))
+            return ir_.CreateVectorSplat(width_, value.value);
+        llvm::Value *result = llvm::UndefValue::get(get_varying_type(type));
+        for(int i = 0; i < width_; ++i)
+            result = ir_.CreateInsertValue(result, value.value, i);
+        return result;
+    }
+    case Shape::Linear:
+    {
+        auto type = value.value->getType();
+        if(type->isPointerTy())
+        {
+            return ir_.CreateGEP(
+                type->getPointerElementType(), value.value,
+                get_lane_indices(ir_.getInt32Ty()));
+        }
+        return ir_.CreateAdd(
+            ir_.CreateVectorSplat(width_, value.value), get_lane_indices(type));
+    }
+    case Shape::Varying:
+        return value.value;
+    }
+    unreachable();
+}
+
+llvm::Value *SPMDKernelGenerator::get_lane(const Value &value, int lane)
+{
+    switch(value.shape)
+    {
+    case Shape::Uniform:
+        return value.value;
+    case Shape::Linear:
+    {
+        auto type = value.value->getType();
+        if(type->isPointerTy())
+        {
+            return ir_.CreateGEP(
+                type->getPointerElementType(), value.value, ir_.getInt32(lane));
+        }
+        return ir_.CreateAdd(value.value, llvm::ConstantInt::get(type, lane));
+    }
+    case Shape::Varying:
+        if(value.value->getType()->isVectorTy())
+            return ir_.CreateExtractElement(value.value, static_cast<uint64_t>(lane));
+        return ir_.CreateExtractValue(value.value, static_cast<unsigned>(lane));
+    }
+    unreachable();
+}
+
+llvm::Value *SPMDKernelGenerator::set_lane(
+    llvm::Value *lanes, llvm::Value *value, int lane)
+{
+    if(lanes->getType()->isVectorTy())
+        return ir_.CreateInsertElement(lanes, value, static_cast<uint64_t>(lane));
+    return ir_.CreateInsertValue(lanes, value, static_cast<unsigned>(lane));
+}
+
+llvm::Value *SPMDKernelGenerator::select_lanes(
+    llvm::Value *mask, llvm::Value *new_val, llvm::Value *old_val)
+{
+    if(new_val->getType()->isVectorTy())
+        return ir_.CreateSelect(mask, new_val, old_val);
+    llvm::Value *result = old_val;
+    for(int i = 0; i < width_; ++i)
+    {
+        const auto lane = static_cast<unsigned>(i);
+        auto val = ir_.CreateSelect(
+            ir_.CreateExtractElement(mask, static_cast<uint64_t>(i)),
+            ir_.CreateExtractValue(new_val, lane),
+            ir_.CreateExtractValue(old_val, lane));
+        result = ir_.CreateInsertValue(result, val, lane);
+    }
+    return result;
+}
+
+template<typename F>
+SPMDKernelGenerator::Value SPMDKernelGenerator::for_each_lane(F &&func)
+{
+    llvm::Value *result = nullptr;
+    for(int i = 0; i < width_; ++i)
+    {
+        llvm::Value *lane_result = func(i);
+        if(!lane_result || lane_result->getType()->isVoidTy())
+            continue;
+        if(!result)
+            result = llvm::UndefValue::get(get_varying_type(lane_result->getType()));
+        result = set_lane(result, lane_result, i);
+    }
+    return { result, Shape::Varying };
+}
+
+template<typename F>
+SPMDKernelGenerator::Value SPMDKernelGenerator::for_each_active_lane(F &&func)
+{
+    auto &context = *llvm_.context;
+    auto mask = load_mask();
+
+    llvm::Value *result = nullptr;
+    for(int i = 0; i < width_; ++i)
+    {
+        auto lane_block = llvm::BasicBlock::Create(context, "lane", function_);
+        auto merge_block = llvm::BasicBlock::Create(context, "lane_merge", function_);
+
+        auto pre_block = ir_.GetInsertBlock();
+        ir_.CreateCondBr(
+            ir_.CreateExtractElement(mask, static_cast<uint64_t>(i)),
+            lane_block, merge_block);
+
+        ir_.SetInsertPoint(lane_block);
+        llvm::Value *lane_result = func(i);
+        const bool has_result = lane_result && !lane_result->getType()->isVoidTy();
+
+        llvm::Value *old_result = nullptr, *new_result = nullptr;
+        if(has_result)
+        {
+            old_result = result ? result : llvm::UndefValue::get(
+                get_varying_type(lane_result->getType()));
+            new_result = set_lane(old_result, lane_result, i);
+        }
+        auto lane_end_block = ir_.GetInsertBlock();
+        ir_.CreateBr(merge_block);
+
+        ir_.SetInsertPoint(merge_block);
+        if(has_result)
+        {
+            auto phi = ir_.CreatePHI(old_result->getType(), 2);
+            phi->addIncoming(old_result, pre_block);
+            phi->addIncoming(new_result, lane_end_block);
+            result = phi;
+        }
+    }
+    return { result, Shape::Varying };
+}
+
+llvm::Value *SPMDKernelGenerator::create_entry_alloca(
+    llvm::Type *type, const char *name)
+{
+    auto &entry_block = function_->getEntryBlock();
+    llvm::IRBuilder<> builder(&entry_block, entry_block.begin());
+    return builder.CreateAlloca(type, nullptr, name);
+}
+
+llvm::Value *SPMDKernelGenerator::load_mask()
+{
+    return ir_.CreateLoad(mask_type_, exec_mask_);
+}
+
+void SPMDKernelGenerator::store_mask(llvm::Value *mask)
+{
+    ir_.CreateStore(mask, exec_mask_);
+}
+
+llvm::Value *SPMDKernelGenerator::any_lane(llvm::Value *mask)
+{
+    return ir_.CreateOrReduce(mask);
+}
+
+llvm::Value *SPMDKernelGenerator::no_lane()
+{
+    return llvm::Constant::getNullValue(mask_type_);
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::load(
+    const Value &addr, llvm::Type *type)
+{
+    if(addr.shape == Shape::Uniform)
+        return { ir_.CreateLoad(type, addr.value), Shape::Uniform };
+
+    auto align = detail::masked_detail::get_element_align(ir_, type);
+
+    if(addr.shape == Shape::Linear && is_contiguous_lane_type(type))
+    {
+        auto vec_type = get_varying_type(type);
+        auto vec_addr = ir_.CreatePointerCast(
+            addr.value, llvm::PointerType::get(
+                vec_type, addr.value->getType()->getPointerAddressSpace()));
+        return {
+            detail::create_masked_load_inst(
+                ir_, vec_type, vec_addr, align, load_mask()),
+            Shape::Varying
+        };
+    }
+
+    if(is_lane_type(type))
+    {
+        return {
+            detail::create_masked_gather_inst(
+                ir_, get_varying_type(type), to_varying(addr), align, load_mask()),
+            Shape::Varying
+        };
+    }
+
+    return for_each_active_lane([&](int lane)
+    {
+        return ir_.CreateLoad(type, get_lane(addr, lane));
+    });
+}
+
+void SPMDKernelGenerator::store(const Value &addr, const Value &val)
+{
+    if(addr.shape == Shape::Uniform && val.shape == Shape::Uniform)
+    {
+        ir_.CreateStore(val.value, addr.value);
+        return;
+    }
+
+    auto type = get_scalar_type(val);
+    auto align = detail::masked_detail::get_element_align(ir_, type);
+
+    if(addr.shape == Shape::Linear && is_contiguous_lane_type(type))
+    {
+        auto vec_type = get_varying_type(type);
+        auto vec_addr = ir_.CreatePointerCast(
+            addr.value, llvm::PointerType::get(
+                vec_type, addr.value->getType()->getPointerAddressSpace()));
+        ir_.CreateMaskedStore(to_varying(val), vec_addr, align, load_mask());
+        return;
+    }
+
+    // lanes are stored in order, so the last active lane wins when
+    // several lanes store into the same address
+    if(is_lane_type(type))
+    {
+        ir_.CreateMaskedScatter(
+            to_varying(val), to_varying(addr), align, load_mask());
+        return;
+    }
+
+    for_each_active_lane([&](int lane)
+    {
+        ir_.CreateStore(get_lane(val, lane), get_lane(addr, lane));
+        return nullptr;
+    });
+}
+
+void SPMDKernelGenerator::create_slot_storages()
+{
+    const size_t local_count = llvm_.local_allocas.size();
+    for(size_t i = 0; i < slots_.size(); ++i)
+    {
+        auto &slot = slots_[i];
+        auto scalar_alloca = i < local_count ?
+            llvm_.local_allocas[i] : llvm_.arg_allocas[i - local_count];
+
+        switch(get_slot_shape(i))
+        {
+        case Shape::Uniform:
+            slot.kind = Slot::Kind::Uniform;
+            break;
+        case Shape::Linear:
+            slot.kind = Slot::Kind::Linear;
+            break;
+        case Shape::Varying:
+            slot.kind = slot.direct_only ? Slot::Kind::Vector : Slot::Kind::Memory;
+            break;
+        }
+
+        if(slot.kind == Slot::Kind::Uniform || slot.kind == Slot::Kind::Linear)
+        {
+            slot.storage = scalar_alloca;
+            continue;
+        }
+
+        auto storage_alloca = ir_.CreateAlloca(
+            slot.kind == Slot::Kind::Vector ?
+                get_varying_type(slot.type) :
+                llvm::ArrayType::get(slot.type, width_));
+        // [N x T] is also accessed as <N x T>
+        auto &data_layout = llvm_.top_module->getDataLayout();
+        storage_alloca->setAlignment((std::max)({
+            storage_alloca->getAlign(), scalar_alloca->getAlign(),
+            data_layout.getABITypeAlign(get_varying_type(slot.type))
+        }));
+        slot.storage = storage_alloca;
+
+        // arguments are the same for all threads
+        if(i >= local_count)
+        {
+            auto arg = function_->getArg(static_cast<unsigned>(i - local_count));
+            auto lanes = to_varying({ arg, Shape::Uniform });
+            if(slot.kind == Slot::Kind::Memory && lanes->getType()->isVectorTy())
+            {
+                auto vec_addr = ir_.CreatePointerCast(
+                    storage_alloca, llvm::PointerType::get(lanes->getType(), 0));
+                ir_.CreateStore(lanes, vec_addr);
+            }
+            else
+                ir_.CreateStore(lanes, storage_alloca);
+        }
+    }
+}
+
+void SPMDKernelGenerator::generate(const core::Stat &stat)
+{
+    stat.match([&](auto &_s) { generate(_s); });
+}
+
+void SPMDKernelGenerator::generate(const core::Store &store)
+{
+    generate_store(store.dst_addr, generate(store.val));
+}
+
+void SPMDKernelGenerator::generate(const core::Copy &copy)
+{
+    generate_store(copy.dst_addr, generate_load(copy.src_addr));
+}
+
+void SPMDKernelGenerator::generate_store(const core::Expr &dst_addr, const Value &val)
+{
+    auto slot_index = get_slot_index(dst_addr);
+    if(!slot_index || slots_[*slot_index].kind == Slot::Kind::Memory)
+    {
+        store(generate(dst_addr), val);
+        return;
+    }
+
+    auto &slot = slots_[*slot_index];
+    switch(slot.kind)
+    {
+    case Slot::Kind::Uniform:
+        assert(val.shape == Shape::Uniform);
+        ir_.CreateStore(val.value, slot.storage);
+        break;
+    case Slot::Kind::Linear:
+        assert(val.shape == Shape::Linear);
+        ir_.CreateStore(val.value, slot.storage);
+        break;
+    case Slot::Kind::Vector:
+    {
+        auto type = get_varying_type(slot.type);
+        auto old_val = ir_.CreateLoad(type, slot.storage);
+        ir_.CreateStore(
+            select_lanes(load_mask(), to_varying(val), old_val), slot.storage);
+        break;
+    }
+    case Slot::Kind::Memory:
+        unreachable();
+    }
+}
+
+void SPMDKernelGenerator::generate(const core::Block &block)
+{
+    // after a statement disabling some lanes, the rest of the block is
+    // skipped if no lane is left
+
+    llvm::BasicBlock *skip_block = nullptr;
+    for(size_t i = 0; i < block.stats.size(); ++i)
+    {
+        auto &stat = *block.stats[i];
+        generate(stat);
+
+        if(i + 1 == block.stats.size() || !find_exits(stat).any())
+            continue;
+
+        if(!skip_block)
+            skip_block = llvm::BasicBlock::Create(*llvm_.context, "skip_rest");
+        auto rest_block = llvm::BasicBlock::Create(
+            *llvm_.context, "rest", function_);
+        ir_.CreateCondBr(any_lane(load_mask()), rest_block, skip_block);
+        ir_.SetInsertPoint(rest_block);
+    }
+
+    if(skip_block)
+    {
+        ir_.CreateBr(skip_block);
+        function_->getBasicBlockList().push_back(skip_block);
+        ir_.SetInsertPoint(skip_block);
+    }
+}
+
+void SPMDKernelGenerator::generate(const core::Return &ret)
+{
+    store_mask(no_lane());
+}
+
+template<typename S>
+void SPMDKernelGenerator::generate_masked(
+    const S &body, llvm::Value *mask,
+    const char *name, llvm::MDNode *branch_weights)
+{
+    auto body_block = llvm::BasicBlock::Create(*llvm_.context, name);
+    auto exit_block = llvm::BasicBlock::Create(
+        *llvm_.context, std::string("exit_") + name);
+
+    store_mask(mask);
+    ir_.CreateCondBr(any_lane(mask), body_block, exit_block, branch_weights);
+
+    function_->getBasicBlockList().push_back(body_block);
+    ir_.SetInsertPoint(body_block);
+    generate(body);
+    ir_.CreateBr(exit_block);
+
+    function_->getBasicBlockList().push_back(exit_block);
+    ir_.SetInsertPoint(exit_block);
+}
+
+void SPMDKernelGenerator::generate(const core::If &if_s)
+{
+    generate(*if_s.calc_cond);
+    auto cond = generate(if_s.cond);
+
+    if(cond.shape == Shape::Uniform)
+    {
+        auto then_block = llvm::BasicBlock::Create(*llvm_.context, "then");
+        auto exit_block = llvm::BasicBlock::Create(*llvm_.context, "exit_if");
+
+        llvm::BasicBlock *else_block = nullptr;
+        if(if_s.else_body)
+            else_block = llvm::BasicBlock::Create(*llvm_.context, "else");
+
+        ir_.CreateCondBr(
+            cond.value, then_block, else_block ? else_block : exit_block,
+            gen_.get_branch_weights(if_s.likelihood));
+
+        function_->getBasicBlockList().push_back(then_block);
+        ir_.SetInsertPoint(then_block);
+        generate(*if_s.then_body);
+        ir_.CreateBr(exit_block);
+
+        if(else_block)
+        {
+            function_->getBasicBlockList().push_back(else_block);
+            ir_.SetInsertPoint(else_block);
+            generate(*if_s.else_body);
+            ir_.CreateBr(exit_block);
+        }
+
+        function_->getBasicBlockList().push_back(exit_block);
+        ir_.SetInsertPoint(exit_block);
+        return;
+    }
+
+    // lanes leaving then_body through break/continue/return stay disabled
+    // after the statement, which is why masks after both bodies are merged
+
+    auto cond_lanes = to_varying(cond);
+    auto mask = load_mask();
+
+    generate_masked(
+        *if_s.then_body, ir_.CreateAnd(mask, cond_lanes), "then",
+        gen_.get_branch_weights(if_s.likelihood));
+    auto then_mask = load_mask();
+
+    auto else_mask = ir_.CreateAnd(mask, ir_.CreateNot(cond_lanes));
+    if(if_s.else_body)
+    {
+        generate_masked(*if_s.else_body, else_mask, "else");
+        else_mask = load_mask();
+    }
+
+    store_mask(ir_.CreateOr(then_mask, else_mask));
+}
+
+void SPMDKernelGenerator::generate(const core::Loop &loop)
+{
+    // the loop runs until all lanes have left it. lanes breaking out of the
+    // loop wait in break_mask, and continuing lanes in continue_mask
+
+    LoopMasks masks;
+    masks.break_mask = create_entry_alloca(mask_type_, "break_mask");
+    masks.continue_mask = create_entry_alloca(mask_type_, "continue_mask");
+    ir_.CreateStore(no_lane(), masks.break_mask);
+
+    auto body_block = llvm::BasicBlock::Create(*llvm_.context, "loop");
+    auto latch_block = llvm::BasicBlock::Create(*llvm_.context, "loop_latch");
+    auto exit_block = llvm::BasicBlock::Create(*llvm_.context, "exit_loop");
+
+    ir_.CreateBr(body_block);
+    function_->getBasicBlockList().push_back(body_block);
+    ir_.SetInsertPoint(body_block);
+    ir_.CreateStore(no_lane(), masks.continue_mask);
+
+    loop_masks_.push(masks);
+    generate(*loop.body);
+    loop_masks_.pop();
+    ir_.CreateBr(latch_block);
+
+    function_->getBasicBlockList().push_back(latch_block);
+    ir_.SetInsertPoint(latch_block);
+    auto mask = ir_.CreateOr(
+        load_mask(), ir_.CreateLoad(mask_type_, masks.continue_mask));
+    store_mask(mask);
+    ir_.CreateCondBr(any_lane(mask), body_block, exit_block);
+
+    gen_.add_loop_metadata(loop.hints, body_block, exit_block);
+
+    function_->getBasicBlockList().push_back(exit_block);
+    ir_.SetInsertPoint(exit_block);
+    store_mask(ir_.CreateLoad(mask_type_, masks.break_mask));
+}
+
+void SPMDKernelGenerator::generate(const core::Break &break_s)
+{
+    assert(!loop_masks_.empty());
+    auto break_mask = loop_masks_.top().break_mask;
+    ir_.CreateStore(
+        ir_.CreateOr(ir_.CreateLoad(mask_type_, break_mask), load_mask()),
+        break_mask);
+    store_mask(no_lane());
+}
+
+void SPMDKernelGenerator::generate(const core::Continue &continue_s)
+{
+    assert(!loop_masks_.empty());
+    auto continue_mask = loop_masks_.top().continue_mask;
+    ir_.CreateStore(
+        ir_.CreateOr(ir_.CreateLoad(mask_type_, continue_mask), load_mask()),
+        continue_mask);
+    store_mask(no_lane());
+}
+
+void SPMDKernelGenerator::generate(const core::Switch &switch_s)
+{
+    // each case runs lanes matching it and lanes falling through into it
+
+    auto value = generate(switch_s.value);
+    if(!get_scalar_type(value)->isIntegerTy())
+        throw CujException("switch statement requires an integer value");
+    auto value_lanes = to_varying(value);
+
+    auto start_mask = load_mask();
+    llvm::Value *matched_mask = no_lane();
+    llvm::Value *fallthrough_mask = no_lane();
+    llvm::Value *end_mask = no_lane();
+
+    for(auto &b : switch_s.branches)
+    {
+        auto cond = b.cond.value.match(
+            [&]<typename T>(T v) -> llvm::Value *
+        {
+            if(!std::is_integral_v<T>)
+                throw CujException("switch statement requires an integer cond");
+            return llvm_helper::llvm_constant_num(*llvm_.context, v);
+        });
+
+        auto hit_mask = ir_.CreateAnd(
+            start_mask, ir_.CreateICmpEQ(
+                value_lanes, ir_.CreateVectorSplat(width_, cond)));
+        matched_mask = ir_.CreateOr(matched_mask, hit_mask);
+
+        generate_masked(*b.body, ir_.CreateOr(hit_mask, fallthrough_mask), "case");
+
+        if(b.fallthrough)
+            fallthrough_mask = load_mask();
+        else
+        {
+            end_mask = ir_.CreateOr(end_mask, load_mask());
+            fallthrough_mask = no_lane();
+        }
+    }
+
+    auto default_mask = ir_.CreateOr(
+        ir_.CreateAnd(start_mask, ir_.CreateNot(matched_mask)), fallthrough_mask);
+    if(switch_s.default_body)
+    {
+        generate_masked(*switch_s.default_body, default_mask, "default");
+        default_mask = load_mask();
+    }
+
+    store_mask(ir_.CreateOr(end_mask, default_mask));
+}
+
+void SPMDKernelGenerator::generate(const core::CallFuncStat &call)
+{
+    generate(call.call_expr);
+}
+
+void SPMDKernelGenerator::generate(const core::MakeScope &make_scope)
+{
+    auto scope_exit_mask = create_entry_alloca(mask_type_, "scope_exit_mask");
+    ir_.CreateStore(no_lane(), scope_exit_mask);
+
+    scope_exit_masks_.push(scope_exit_mask);
+    generate(*make_scope.body);
+    scope_exit_masks_.pop();
+
+    store_mask(ir_.CreateOr(
+        load_mask(), ir_.CreateLoad(mask_type_, scope_exit_mask)));
+}
+
+void SPMDKernelGenerator::generate(const core::ExitScope &exit_scope)
+{
+    assert(!scope_exit_masks_.empty());
+    auto scope_exit_mask = scope_exit_masks_.top();
+    ir_.CreateStore(
+        ir_.CreateOr(ir_.CreateLoad(mask_type_, scope_exit_mask), load_mask()),
+        scope_exit_mask);
+    store_mask(no_lane());
+}
+
+void SPMDKernelGenerator::generate(const core::InlineAsm &inline_asm)
+{
+    throw CujException("inline asm is not supported in spmd kernels");
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::Expr &expr)
+{
+    if(auto it = shapes_.find(&expr);
+       it != shapes_.end() && it->second == Shape::Uniform)
+        return { gen_.generate(expr), Shape::Uniform };
+    return expr.match([&](auto &_e) { return generate(_e); });
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::FuncArgAddr &expr)
+{
+    return generate_slot_address(llvm_.local_allocas.size() + expr.arg_index);
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::LocalAllocAddr &expr)
+{
+    return generate_slot_address(expr.alloc_index);
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::Load &expr)
+{
+    return generate_load(*expr.src_addr);
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::Immediate &expr)
+{
+    return { gen_.generate(expr), Shape::Uniform };
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::NullPtr &expr)
+{
+    return { gen_.generate(expr), Shape::Uniform };
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::ArithmeticCast &expr)
+{
+    auto src = generate(*expr.src_val);
+    auto src_type = llvm_helper::get_arithmetic_builtin(expr.src_type);
+    auto dst_type = llvm_helper::get_arithmetic_builtin(expr.dst_type);
+    auto dst_llvm_type = llvm_.type_manager.get_llvm_type(expr.dst_type);
+
+    if(src.shape == Shape::Uniform ||
+       (src.shape == Shape::Linear && keeps_linear(expr)))
+    {
+        return {
+            gen_.create_arithmetic_cast(src_type, dst_type, src.value, dst_llvm_type),
+            src.shape
+        };
+    }
+
+    if(is_lane_type(dst_llvm_type))
+    {
+        return {
+            gen_.create_arithmetic_cast(
+                src_type, dst_type, to_varying(src),
+                get_varying_type(dst_llvm_type)),
+            Shape::Varying
+        };
+    }
+
+    return for_each_lane([&](int lane)
+    {
+        return gen_.create_arithmetic_cast(
+            src_type, dst_type, get_lane(src, lane), dst_llvm_type);
+    });
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::BitwiseCast &expr)
+{
+    auto src = generate(*expr.src_val);
+    auto dst_type = llvm_.type_manager.get_llvm_type(expr.dst_type);
+
+    if(src.shape == Shape::Uniform)
+        return { gen_.create_bitwise_cast(src.value, dst_type), Shape::Uniform };
+
+    if(is_lane_type(get_scalar_type(src)) && is_lane_type(dst_type))
+    {
+        return {
+            gen_.create_bitwise_cast(to_varying(src), get_varying_type(dst_type)),
+            Shape::Varying
+        };
+    }
+
+    return for_each_lane([&](int lane)
+    {
+        return gen_.create_bitwise_cast(get_lane(src, lane), dst_type);
+    });
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::PointerOffset &expr)
+{
+    auto ptr = generate(*expr.ptr_val);
+    auto offset = generate(*expr.offset_val);
+    auto elem_type = get_pointed_type(ptr);
+
+    if(ptr.shape == Shape::Uniform && offset.shape == Shape::Uniform)
+    {
+        auto offset_val = offset.value;
+        if(expr.negative)
+            offset_val = ir_.CreateNeg(offset_val);
+        return { ir_.CreateGEP(elem_type, ptr.value, offset_val), Shape::Uniform };
+    }
+
+    if(!expr.negative &&
+       ((ptr.shape == Shape::Uniform && offset.shape == Shape::Linear) ||
+        (ptr.shape == Shape::Linear && offset.shape == Shape::Uniform)))
+    {
+        return { ir_.CreateGEP(elem_type, ptr.value, offset.value), Shape::Linear };
+    }
+
+    auto offsets = to_varying(offset);
+    if(expr.negative)
+        offsets = ir_.CreateNeg(offsets);
+    return { ir_.CreateGEP(elem_type, to_varying(ptr), offsets), Shape::Varying };
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate_const_gep(
+    const Value &ptr, unsigned first, unsigned second)
+{
+    std::array<llvm::Value *, 2> indices = {
+        ir_.getInt32(first), ir_.getInt32(second)
+    };
+    auto pointed_type = get_pointed_type(ptr);
+    if(ptr.shape == Shape::Uniform)
+        return { ir_.CreateGEP(pointed_type, ptr.value, indices), Shape::Uniform };
+    return { ir_.CreateGEP(pointed_type, to_varying(ptr), indices), Shape::Varying };
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::ClassPointerToMemberPointer &expr)
+{
+    auto class_ptr = generate(*expr.class_ptr);
+    const int member_index = llvm_.type_manager.get_struct_member_index(
+        expr.class_ptr_type->as<core::Pointer>().pointed,
+        static_cast<int>(expr.member_index));
+    return generate_const_gep(class_ptr, 0, static_cast<unsigned>(member_index));
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::DerefClassPointer &expr)
+{
+    return generate_load(*expr.class_ptr);
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::DerefArrayPointer &expr)
+{
+    return generate_load(*expr.array_ptr);
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::SaveClassIntoLocalAlloc &expr)
+{
+    return save_into_local_alloc(generate(*expr.class_val));
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::SaveArrayIntoLocalAlloc &expr)
+{
+    return save_into_local_alloc(generate(*expr.array_val));
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::ArrayAddrToFirstElemAddr &expr)
+{
+    return generate_const_gep(generate(*expr.array_ptr), 0, 0);
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::Binary &expr)
+{
+    auto lhs = generate(*expr.lhs);
+    auto rhs = generate(*expr.rhs);
+
+    auto type = llvm_helper::get_arithmetic_builtin(expr.lhs_type);
+    assert(type == llvm_helper::get_arithmetic_builtin(expr.rhs_type));
+
+    if(lhs.shape == Shape::Uniform && rhs.shape == Shape::Uniform)
+    {
+        return {
+            gen_.create_binary(expr.op, type, lhs.value, rhs.value),
+            Shape::Uniform
+        };
+    }
+
+    if(expr.lhs_type->is<core::Builtin>() &&
+       !is_floating_point(type) && type != core::Builtin::Bool)
+    {
+        if(expr.op == core::Binary::Op::Add &&
+           ((lhs.shape == Shape::Linear && rhs.shape == Shape::Uniform) ||
+            (lhs.shape == Shape::Uniform && rhs.shape == Shape::Linear)))
+            return { ir_.CreateAdd(lhs.value, rhs.value), Shape::Linear };
+
+        if(expr.op == core::Binary::Op::Sub &&
+           lhs.shape == Shape::Linear && rhs.shape == Shape::Uniform)
+            return { ir_.CreateSub(lhs.value, rhs.value), Shape::Linear };
+    }
+
+    // integer division by zero traps, so inactive lanes divide by one
+    const bool is_int_div = !is_floating_point(type) &&
+                            (expr.op == core::Binary::Op::Div ||
+                             expr.op == core::Binary::Op::Mod);
+
+    if(is_lane_type(get_scalar_type(lhs)))
+    {
+        auto lhs_lanes = to_varying(lhs);
+        auto rhs_lanes = to_varying(rhs);
+        if(is_int_div)
+        {
+            rhs_lanes = ir_.CreateSelect(
+                load_mask(), rhs_lanes,
+                llvm::ConstantInt::get(rhs_lanes->getType(), 1));
+        }
+        return {
+            gen_.create_binary(expr.op, type, lhs_lanes, rhs_lanes),
+            Shape::Varying
+        };
+    }
+
+    auto lane_binary = [&](int lane)
+    {
+        return gen_.create_binary(
+            expr.op, type, get_lane(lhs, lane), get_lane(rhs, lane));
+    };
+    if(is_int_div)
+        return for_each_active_lane(lane_binary);
+    return for_each_lane(lane_binary);
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::Unary &expr)
+{
+    auto val = generate(*expr.val);
+    auto type = llvm_helper::get_arithmetic_builtin(expr.val_type);
+
+    if(val.shape == Shape::Uniform)
+        return { gen_.create_unary(expr.op, type, val.value), Shape::Uniform };
+
+    if(is_lane_type(get_scalar_type(val)))
+        return { gen_.create_unary(expr.op, type, to_varying(val)), Shape::Varying };
+
+    return for_each_lane([&](int lane)
+    {
+        return gen_.create_unary(expr.op, type, get_lane(val, lane));
+    });
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::Select &expr)
+{
+    auto cond = generate(*expr.cond);
+    auto true_val = generate(*expr.true_val);
+    auto false_val = generate(*expr.false_val);
+
+    if(cond.shape == Shape::Uniform &&
+       true_val.shape == Shape::Uniform && false_val.shape == Shape::Uniform)
+    {
+        return {
+            ir_.CreateSelect(cond.value, true_val.value, false_val.value),
+            Shape::Uniform
+        };
+    }
+
+    if(expr.cond_type->is<core::Builtin>() &&
+       is_lane_type(get_scalar_type(true_val)))
+    {
+        return {
+            ir_.CreateSelect(
+                to_varying(cond), to_varying(true_val), to_varying(false_val)),
+            Shape::Varying
+        };
+    }
+
+    return for_each_lane([&](int lane)
+    {
+        return ir_.CreateSelect(
+            get_lane(cond, lane),
+            get_lane(true_val, lane),
+            get_lane(false_val, lane));
+    });
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::CallFunc &expr)
+{
+    std::vector<Value> args;
+    for(auto &a : expr.args)
+        args.push_back(generate(*a));
+
+    if(expr.intrinsic == core::Intrinsic::thread_idx_x)
+        return { llvm_.thread_idx[0], Shape::Linear };
+    if(is_kernel_index_intrinsic(expr.intrinsic))
+    {
+        return {
+            gen_.process_native_kernel_index(expr.intrinsic),
+            Shape::Uniform
+        };
+    }
+
+    auto get_lane_args = [&](int lane)
+    {
+        std::vector<llvm::Value *> lane_args;
+        for(auto &a : args)
+            lane_args.push_back(get_lane(a, lane));
+        return lane_args;
+    };
+
+    if(is_pure_intrinsic(expr.intrinsic))
+    {
+        bool uniform_args = true, lane_type_args = true;
+        for(auto &a : args)
+        {
+            uniform_args &= a.shape == Shape::Uniform;
+            lane_type_args &= is_lane_type(get_scalar_type(a));
+        }
+
+        if(uniform_args)
+        {
+            return {
+                gen_.process_intrinsic_call(expr, get_lane_args(0)),
+                Shape::Uniform
+            };
+        }
+
+        if(lane_type_args && is_elementwise_intrinsic(expr.intrinsic))
+        {
+            std::vector<llvm::Value *> vec_args;
+            for(auto &a : args)
+                vec_args.push_back(to_varying(a));
+            return {
+                gen_.process_intrinsic_call(expr, vec_args),
+                Shape::Varying
+            };
+        }
+
+        return for_each_lane([&](int lane)
+        {
+            return gen_.process_intrinsic_call(expr, get_lane_args(lane));
+        });
+    }
+
+    return for_each_active_lane([&](int lane) -> llvm::Value *
+    {
+        auto lane_args = get_lane_args(lane);
+
+        if(expr.contextless_func)
+        {
+            auto func = llvm_.top_module->getFunction(expr.contextless_func->name);
+            return ir_.CreateCall(func, lane_args);
+        }
+
+        if(expr.intrinsic != core::Intrinsic::None)
+            return gen_.process_intrinsic_call(expr, lane_args);
+
+        auto core_func = llvm_.prog.funcs[expr.contexted_func_index].get();
+        auto func = llvm_.llvm_functions_.at(core_func).llvm_function;
+        return ir_.CreateCall(func, lane_args);
+    });
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::GlobalVarAddr &expr)
+{
+    return { gen_.generate(expr), Shape::Uniform };
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::GlobalConstAddr &expr)
+{
+    return { gen_.generate(expr), Shape::Uniform };
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::MakeVector &expr)
+{
+    auto vec_type = llvm::dyn_cast<llvm::FixedVectorType>(
+        llvm_.type_manager.get_llvm_type(expr.vector_type));
+
+    std::vector<Value> elements;
+    for(auto &e : expr.elements)
+        elements.push_back(generate(*e));
+
+    return for_each_lane([&](int lane) -> llvm::Value *
+    {
+        if(elements.size() == 1)
+        {
+            return ir_.CreateVectorSplat(
+                vec_type->getNumElements(), get_lane(elements[0], lane));
+        }
+        llvm::Value *result = llvm::UndefValue::get(vec_type);
+        for(size_t i = 0; i < elements.size(); ++i)
+        {
+            result = ir_.CreateInsertElement(
+                result, get_lane(elements[i], lane), static_cast<uint64_t>(i));
+        }
+        return result;
+    });
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::VectorExtract &expr)
+{
+    auto vec = generate(*expr.vector);
+    auto index = generate(*expr.index);
+    return for_each_lane([&](int lane)
+    {
+        return ir_.CreateExtractElement(
+            get_lane(vec, lane), get_lane(index, lane));
+    });
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::VectorInsert &expr)
+{
+    auto vec = generate(*expr.vector);
+    auto index = generate(*expr.index);
+    auto elem = generate(*expr.element);
+    return for_each_lane([&](int lane)
+    {
+        return ir_.CreateInsertElement(
+            get_lane(vec, lane), get_lane(elem, lane), get_lane(index, lane));
+    });
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::VectorShuffle &expr)
+{
+    auto lhs = generate(*expr.lhs);
+    auto rhs = generate(*expr.rhs);
+    return for_each_lane([&](int lane)
+    {
+        return ir_.CreateShuffleVector(
+            get_lane(lhs, lane), get_lane(rhs, lane), expr.indices);
+    });
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate(const core::VectorReduce &expr)
+{
+    auto vec = generate(*expr.vector);
+    auto elem_type = llvm_helper::get_arithmetic_builtin(expr.vector_type);
+    return for_each_lane([&](int lane)
+    {
+        return gen_.create_vector_reduce(expr.op, elem_type, get_lane(vec, lane));
+    });
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate_load(const core::Expr &addr)
+{
+    if(auto slot_index = get_slot_index(addr))
+    {
+        auto &slot = slots_[*slot_index];
+        switch(slot.kind)
+        {
+        case Slot::Kind::Uniform:
+            return { ir_.CreateLoad(slot.type, slot.storage), Shape::Uniform };
+        case Slot::Kind::Linear:
+            return { ir_.CreateLoad(slot.type, slot.storage), Shape::Linear };
+        case Slot::Kind::Vector:
+            return {
+                ir_.CreateLoad(get_varying_type(slot.type), slot.storage),
+                Shape::Varying
+            };
+        case Slot::Kind::Memory:
+            break;
+        }
+    }
+
+    auto addr_val = generate(addr);
+    return load(addr_val, get_pointed_type(addr_val));
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::generate_slot_address(size_t slot_index)
+{
+    auto &slot = slots_[slot_index];
+    if(slot.kind == Slot::Kind::Uniform)
+        return { slot.storage, Shape::Uniform };
+
+    // other slots are only accessed through addresses in memory
+    assert(slot.kind == Slot::Kind::Memory);
+    std::array<llvm::Value *, 2> indices = {
+        ir_.getInt32(0), get_lane_indices(ir_.getInt32Ty())
+    };
+    return {
+        ir_.CreateGEP(
+            llvm::ArrayType::get(slot.type, width_), slot.storage, indices),
+        Shape::Varying
+    };
+}
+
+SPMDKernelGenerator::Value SPMDKernelGenerator::save_into_local_alloc(const Value &val)
+{
+    auto type = get_scalar_type(val);
+    if(val.shape == Shape::Uniform)
+    {
+        auto alloc = create_entry_alloca(type, "saved");
+        ir_.CreateStore(val.value, alloc);
+        return { alloc, Shape::Uniform };
+    }
+
+    // classes and arrays are never vector elements, so their lanes
+    // are stored as [N x T]
+    auto arr_type = llvm::ArrayType::get(type, width_);
+    auto alloc = create_entry_alloca(arr_type, "saved");
+    ir_.CreateStore(to_varying(val), alloc);
+
+    std::array<llvm::Value *, 2> indices = {
+        ir_.getInt32(0), get_lane_indices(ir_.getInt32Ty())
+    };
+    return { ir_.CreateGEP(arr_type, alloc, indices), Shape::Varying };
+}
+
+CUJ_NAMESPACE_END(cuj::gen)
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
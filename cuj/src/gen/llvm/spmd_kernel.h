@@ -0,0 +1,328 @@
+#pragma once
+
+#include <map>
+#include <optional>
+#include <set>
+#include <stack>
+
+#include <llvm/IR/IRBuilder.h>
+
+#include <cuj/gen/llvm.h>
+
+#include "generator_data.h"
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+// generates the spmd function of a native kernel, which runs a group of
+// threads with consecutive thread_idx_x values in the lanes of llvm vectors.
+//
+// values that are the same in all lanes are kept scalar, and values like
+// thread_idx_x + n are kept as their first lane, which makes memory accesses
+// through them contiguous. other values are widened to <N x T>, or to
+// [N x T] when T can't be a vector element.
+//
+// statements are executed under an execution mask. both sides of a branch
+// whose condition differs across lanes are executed with complementary masks,
+// and a loop is iterated until none of its lanes are active. memory accesses
+// become masked loads/stores or gathers/scatters, and functions and intrinsics
+// with side effects are called lane by lane
+class SPMDKernelGenerator
+{
+public:
+
+    SPMDKernelGenerator(LLVMIRGenerator &gen, const core::Func &func, int width);
+
+    // kernels containing inline assembly can't be compiled in spmd form
+    static bool is_supported(const core::Func &func);
+
+    void generate(llvm::Function *spmd_func);
+
+private:
+
+    enum class Shape
+    {
+        Uniform, // same value in all lanes
+        Linear,  // first lane + lane index, in elements for pointers
+        Varying
+    };
+
+    // scalar for uniform values, and the first lane for linear values
+    struct Value
+    {
+        llvm::Value *value = nullptr;
+        Shape        shape = Shape::Uniform;
+    };
+
+    // local variable or argument. arguments follow local variables
+    struct Slot
+    {
+        enum class Kind
+        {
+            Uniform, // scalar alloca
+            Linear,  // scalar alloca of the first lane
+            Vector,  // alloca of all lanes, only loaded and stored as a whole
+            Memory   // alloca of [N x T], accessed through lane addresses
+        };
+
+        llvm::Type *type = nullptr;
+
+        // join of shapes of stored values
+        std::optional<Shape> stored_shape;
+
+        // the slot address is only used to load or store the whole slot
+        bool direct_only = true;
+
+        // address of the only other slot stored into this one. loads from
+        // pointers made by the dsl for arguments are followed this way
+        std::optional<size_t> pointee;
+        bool                  holds_other_values = false;
+
+        // statements storing into the slot directly
+        int  store_stat_count = 0;
+        bool stored_in_loop   = false;
+
+        Kind         kind    = Kind::Uniform;
+        llvm::Value *storage = nullptr;
+    };
+
+    // break/continue, scope exits and returns leaving a statement
+    struct Exits
+    {
+        bool loop  = false;
+        bool scope = false;
+        bool ret   = false;
+
+        bool any() const { return loop || scope || ret; }
+
+        Exits &operator|=(const Exits &rhs);
+    };
+
+    struct LoopMasks
+    {
+        llvm::Value *break_mask;
+        llvm::Value *continue_mask;
+    };
+
+    // analysis. statements return exits taken by only some of active lanes
+
+    void analyze();
+
+    std::optional<size_t> get_slot_index(const core::Expr &addr) const;
+
+    Shape get_slot_shape(size_t slot_index) const;
+
+    bool keeps_linear(const core::ArithmeticCast &cast) const;
+
+    void store_into_slot(size_t slot_index, Shape shape);
+
+    void use_slot_indirectly(size_t slot_index);
+
+    Shape escape_slot(size_t slot_index);
+
+    // returns false if val isn't the address of a slot or loaded from a slot
+    // holding one, or another value has been stored into the slot
+    bool store_pointee(size_t slot_index, const core::Expr &val);
+
+    void forget_pointee(size_t slot_index);
+
+    // slot pointed by addr, if addr is loaded from a slot holding its address
+    std::optional<size_t> get_pointee(const core::Expr &addr) const;
+
+    void count_stores(const core::Stat &stat, bool in_loop);
+
+    void count_stores(const core::Block &block, bool in_loop);
+
+    // shape of a value stored into a slot, if the slot is the destination
+    Shape get_stored_shape(size_t slot_index, Shape val_shape, bool divergent) const;
+
+    Exits analyze(const core::Stat &stat, bool divergent);
+
+    Exits analyze(const core::Block &block, bool divergent);
+
+    void analyze_store(const core::Expr &dst_addr, Shape val_shape, bool divergent);
+
+    Shape analyze(const core::Expr &expr);
+
+    Shape analyze(const core::CallFunc &call);
+
+    // address of a loaded or stored value. slot is set to the local
+    // variable or argument it points into, if any
+    Shape analyze_address(const core::Expr &addr, std::optional<size_t> &slot);
+
+    Shape analyze_load(const core::Expr &addr);
+
+    // exits leaving a statement, taken by any lane
+
+    static Exits find_exits(const core::Stat &stat);
+
+    static Exits find_exits(const core::Block &block);
+
+    // values
+
+    bool is_lane_type(llvm::Type *type) const;
+
+    bool is_contiguous_lane_type(llvm::Type *type) const;
+
+    llvm::Type *get_varying_type(llvm::Type *type) const;
+
+    llvm::Type *get_scalar_type(const Value &value) const;
+
+    llvm::Type *get_pointed_type(const Value &ptr) const;
+
+    llvm::Constant *get_lane_indices(llvm::Type *int_type) const;
+
+    llvm::Value *to_varying(const Value &value);
+
+    llvm::Value *get_lane(const Value &value, int lane);
+
+    llvm::Value *set_lane(llvm::Value *lanes, llvm::Value *value, int lane);
+
+    // select(mask, new_val, old_val) for each lane
+    llvm::Value *select_lanes(
+        llvm::Value *mask, llvm::Value *new_val, llvm::Value *old_val);
+
+    // combines non-void results of func(lane) for all lanes
+    template<typename F>
+    Value for_each_lane(F &&func);
+
+    // same as for_each_lane, but only calls func for active lanes,
+    // with one branch per lane
+    template<typename F>
+    Value for_each_active_lane(F &&func);
+
+    llvm::Value *create_entry_alloca(llvm::Type *type, const char *name);
+
+    llvm::Value *load_mask();
+
+    void store_mask(llvm::Value *mask);
+
+    llvm::Value *any_lane(llvm::Value *mask);
+
+    llvm::Value *no_lane();
+
+    Value load(const Value &addr, llvm::Type *type);
+
+    void store(const Value &addr, const Value &val);
+
+    void create_slot_storages();
+
+    // statements
+
+    void generate(const core::Stat &stat);
+
+    void generate(const core::Store &store);
+
+    void generate(const core::Copy &copy);
+
+    void generate(const core::Block &block);
+
+    void generate(const core::Return &ret);
+
+    void generate(const core::If &if_s);
+
+    void generate(const core::Loop &loop);
+
+    void generate(const core::Break &break_s);
+
+    void generate(const core::Continue &continue_s);
+
+    void generate(const core::Switch &switch_s);
+
+    void generate(const core::CallFuncStat &call);
+
+    void generate(const core::MakeScope &make_scope);
+
+    void generate(const core::ExitScope &exit_scope);
+
+    void generate(const core::InlineAsm &inline_asm);
+
+    // runs body with given mask, if any lane of it is active
+    template<typename S>
+    void generate_masked(
+        const S &body, llvm::Value *mask,
+        const char *name, llvm::MDNode *branch_weights = nullptr);
+
+    void generate_store(const core::Expr &dst_addr, const Value &val);
+
+    // expressions
+
+    Value generate(const core::Expr &expr);
+
+    Value generate(const core::FuncArgAddr &expr);
+
+    Value generate(const core::LocalAllocAddr &expr);
+
+    Value generate(const core::Load &expr);
+
+    Value generate(const core::Immediate &expr);
+
+    Value generate(const core::NullPtr &expr);
+
+    Value generate(const core::ArithmeticCast &expr);
+
+    Value generate(const core::BitwiseCast &expr);
+
+    Value generate(const core::PointerOffset &expr);
+
+    Value generate(const core::ClassPointerToMemberPointer &expr);
+
+    Value generate(const core::DerefClassPointer &expr);
+
+    Value generate(const core::DerefArrayPointer &expr);
+
+    Value generate(const core::SaveClassIntoLocalAlloc &expr);
+
+    Value generate(const core::SaveArrayIntoLocalAlloc &expr);
+
+    Value generate(const core::ArrayAddrToFirstElemAddr &expr);
+
+    Value generate(const core::Binary &expr);
+
+    Value generate(const core::Unary &expr);
+
+    Value generate(const core::Select &expr);
+
+    Value generate(const core::CallFunc &expr);
+
+    Value generate(const core::GlobalVarAddr &expr);
+
+    Value generate(const core::GlobalConstAddr &expr);
+
+    Value generate(const core::MakeVector &expr);
+
+    Value generate(const core::VectorExtract &expr);
+
+    Value generate(const core::VectorInsert &expr);
+
+    Value generate(const core::VectorShuffle &expr);
+
+    Value generate(const core::VectorReduce &expr);
+
+    Value generate_load(const core::Expr &addr);
+
+    Value generate_slot_address(size_t slot_index);
+
+    // gep with constant indices, for each lane of varying pointers
+    Value generate_const_gep(const Value &ptr, unsigned first, unsigned second);
+
+    Value save_into_local_alloc(const Value &val);
+
+    LLVMIRGenerator           &gen_;
+    LLVMIRGenerator::LLVMData &llvm_;
+    llvm::IRBuilder<>         &ir_;
+    const core::Func          &func_;
+    const int                  width_;
+
+    std::vector<Slot>                   slots_;
+    std::set<const core::Loop *>        divergent_loops_;
+    std::map<const core::Expr *, Shape> shapes_;
+    bool                                analysis_changed_ = false;
+
+    llvm::Function           *function_  = nullptr;
+    llvm::VectorType         *mask_type_ = nullptr;
+    llvm::Value              *exec_mask_ = nullptr;
+    std::stack<LoopMasks>     loop_masks_;
+    std::stack<llvm::Value *> scope_exit_masks_;
+};
+
+CUJ_NAMESPACE_END(cuj::gen)
@@ -80,6 +80,11 @@ llvm::Type *TypeManager::create_record(const core::Type *type)
         }
         auto pointed = create_record(t.pointed);
         return llvm::PointerType::get(pointed, 0);
+    },
+        [&](const core::Vector &t) -> llvm::Type *
+    {
+        auto elem = create_record(t.element);
+        return llvm::FixedVectorType::get(elem, static_cast<unsigned>(t.size));
     });
 
     assert(!records_.contains(index));
@@ -220,6 +225,25 @@ void TypeManager::fill_layout(const core::Type *type)
             record.alignment = alignof(void *);
             record.size = sizeof(void *);
         }
+    },
+        [&](const core::Vector &t)
+    {
+        if(data_layout_)
+        {
+            record.alignment = data_layout_->getABITypeAlign(record.type).value();
+            record.size = data_layout_->getTypeAllocSize(record.type).getFixedSize();
+        }
+        else
+        {
+            // vectors are aligned to their sizes rounded up to powers of 2
+            fill_layout(t.element);
+            auto &elem_record = find_record(t.element);
+            size_t size = *elem_record.size;
+            while(size < *elem_record.size * t.size)
+                size *= 2;
+            record.alignment = size;
+            record.size = size;
+        }
     });
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <llvm/Config/llvm-config.h>
 #include <llvm/IR/IRBuilder.h>
 
 #include <cuj/common.h>
@@ -49,4 +50,202 @@ inline void create_vector_load(
     }
 }
 
+// llvm 13 takes the loaded vector type explicitly, and earlier versions
+// take it from the pointer type
+
+inline llvm::Value *create_masked_load_inst(
+    llvm::IRBuilder<> &ir, llvm::Type *vec_type, llvm::Value *addr,
+    llvm::Align align, llvm::Value *mask, llvm::Value *passthru = nullptr)
+{
+#if LLVM_VERSION_MAJOR >= 13
+    return ir.CreateMaskedLoad(vec_type, addr, align, mask, passthru);
+#else
+    (void)vec_type;
+    assert(addr->getType()->getPointerElementType() == vec_type);
+    return ir.CreateMaskedLoad(addr, align, mask, passthru);
+#endif
+}
+
+inline llvm::Value *create_masked_gather_inst(
+    llvm::IRBuilder<> &ir, llvm::Type *vec_type, llvm::Value *addrs,
+    llvm::Align align, llvm::Value *mask = nullptr,
+    llvm::Value *passthru = nullptr)
+{
+#if LLVM_VERSION_MAJOR >= 13
+    return ir.CreateMaskedGather(vec_type, addrs, align, mask, passthru);
+#else
+    (void)vec_type;
+    return ir.CreateMaskedGather(addrs, align, mask, passthru);
+#endif
+}
+
+namespace masked_detail
+{
+
+    inline llvm::Align get_element_align(
+        llvm::IRBuilder<> &ir, llvm::Type *elem_type)
+    {
+        return ir.GetInsertBlock()->getModule()
+            ->getDataLayout().getABITypeAlign(elem_type);
+    }
+
+    // address of lane i: base + i, or base + indices[i] when indices is given
+    inline llvm::Value *get_lane_address(
+        llvm::IRBuilder<> &ir, llvm::Type *elem_type,
+        llvm::Value *base, llvm::Value *indices, int lane)
+    {
+        llvm::Value *offset = indices ?
+            ir.CreateExtractElement(indices, lane) : ir.getInt32(lane);
+        return ir.CreateGEP(elem_type, base, offset);
+    }
+
+    // if(mask[i]) result[i] = *addr(i) for each lane, with one branch per lane
+    inline llvm::Value *create_scalarized_load(
+        llvm::IRBuilder<> &ir, llvm::Value *base, llvm::Value *indices,
+        llvm::Value *mask, llvm::Value *passthru)
+    {
+        auto vec_type = llvm::cast<llvm::FixedVectorType>(passthru->getType());
+        auto elem_type = vec_type->getElementType();
+        auto align = get_element_align(ir, elem_type);
+        auto func = ir.GetInsertBlock()->getParent();
+        auto &context = ir.getContext();
+
+        llvm::Value *result = passthru;
+        for(unsigned i = 0; i < vec_type->getNumElements(); ++i)
+        {
+            auto load_block = llvm::BasicBlock::Create(context, "masked_load", func);
+            auto merge_block = llvm::BasicBlock::Create(context, "masked_load_merge", func);
+
+            auto entry_block = ir.GetInsertBlock();
+            ir.CreateCondBr(ir.CreateExtractElement(mask, i), load_block, merge_block);
+
+            ir.SetInsertPoint(load_block);
+            auto addr = get_lane_address(
+                ir, elem_type, base, indices, static_cast<int>(i));
+            auto elem = ir.CreateAlignedLoad(elem_type, addr, align);
+            auto loaded = ir.CreateInsertElement(result, elem, i);
+            ir.CreateBr(merge_block);
+
+            ir.SetInsertPoint(merge_block);
+            auto phi = ir.CreatePHI(vec_type, 2);
+            phi->addIncoming(result, entry_block);
+            phi->addIncoming(loaded, load_block);
+            result = phi;
+        }
+        return result;
+    }
+
+    // if(mask[i]) *addr(i) = val[i] for each lane, with one branch per lane
+    inline void create_scalarized_store(
+        llvm::IRBuilder<> &ir, llvm::Value *base, llvm::Value *indices,
+        llvm::Value *mask, llvm::Value *val)
+    {
+        auto vec_type = llvm::cast<llvm::FixedVectorType>(val->getType());
+        auto elem_type = vec_type->getElementType();
+        auto align = get_element_align(ir, elem_type);
+        auto func = ir.GetInsertBlock()->getParent();
+        auto &context = ir.getContext();
+
+        for(unsigned i = 0; i < vec_type->getNumElements(); ++i)
+        {
+            auto store_block = llvm::BasicBlock::Create(context, "masked_store", func);
+            auto merge_block = llvm::BasicBlock::Create(context, "masked_store_merge", func);
+            ir.CreateCondBr(ir.CreateExtractElement(mask, i), store_block, merge_block);
+
+            ir.SetInsertPoint(store_block);
+            auto addr = get_lane_address(
+                ir, elem_type, base, indices, static_cast<int>(i));
+            ir.CreateAlignedStore(ir.CreateExtractElement(val, i), addr, align);
+            ir.CreateBr(merge_block);
+
+            ir.SetInsertPoint(merge_block);
+        }
+    }
+
+} // namespace masked_detail
+
+// args: addr, mask, passthru
+inline llvm::Value *create_masked_load(
+    llvm::IRBuilder<> &ir, const std::vector<llvm::Value *> &args,
+    bool scalarize)
+{
+    assert(args.size() == 3);
+    if(scalarize)
+    {
+        return masked_detail::create_scalarized_load(
+            ir, args[0], nullptr, args[1], args[2]);
+    }
+
+    auto vec_type = args[2]->getType();
+    auto elem_type = llvm::cast<llvm::FixedVectorType>(vec_type)->getElementType();
+    auto addr = ir.CreatePointerCast(
+        args[0], llvm::PointerType::get(
+            vec_type, args[0]->getType()->getPointerAddressSpace()));
+    return create_masked_load_inst(
+        ir, vec_type, addr, masked_detail::get_element_align(ir, elem_type),
+        args[1], args[2]);
+}
+
+// args: addr, mask, value
+inline llvm::Value *create_masked_store(
+    llvm::IRBuilder<> &ir, const std::vector<llvm::Value *> &args,
+    bool scalarize)
+{
+    assert(args.size() == 3);
+    if(scalarize)
+    {
+        masked_detail::create_scalarized_store(
+            ir, args[0], nullptr, args[1], args[2]);
+        return nullptr;
+    }
+
+    auto vec_type = args[2]->getType();
+    auto elem_type = llvm::cast<llvm::FixedVectorType>(vec_type)->getElementType();
+    auto addr = ir.CreatePointerCast(
+        args[0], llvm::PointerType::get(
+            vec_type, args[0]->getType()->getPointerAddressSpace()));
+    return ir.CreateMaskedStore(
+        args[2], addr, masked_detail::get_element_align(ir, elem_type), args[1]);
+}
+
+// args: base, indices, mask, passthru
+inline llvm::Value *create_gather(
+    llvm::IRBuilder<> &ir, const std::vector<llvm::Value *> &args,
+    bool scalarize)
+{
+    assert(args.size() == 4);
+    if(scalarize)
+    {
+        return masked_detail::create_scalarized_load(
+            ir, args[0], args[1], args[2], args[3]);
+    }
+
+    auto vec_type = args[3]->getType();
+    auto elem_type = llvm::cast<llvm::FixedVectorType>(vec_type)->getElementType();
+    auto addrs = ir.CreateGEP(elem_type, args[0], args[1]);
+    return create_masked_gather_inst(
+        ir, vec_type, addrs, masked_detail::get_element_align(ir, elem_type),
+        args[2], args[3]);
+}
+
+// args: base, indices, mask, value
+inline llvm::Value *create_scatter(
+    llvm::IRBuilder<> &ir, const std::vector<llvm::Value *> &args,
+    bool scalarize)
+{
+    assert(args.size() == 4);
+    if(scalarize)
+    {
+        masked_detail::create_scalarized_store(
+            ir, args[0], args[1], args[2], args[3]);
+        return nullptr;
+    }
+
+    auto vec_type = args[3]->getType();
+    auto elem_type = llvm::cast<llvm::FixedVectorType>(vec_type)->getElementType();
+    auto addrs = ir.CreateGEP(elem_type, args[0], args[1]);
+    return ir.CreateMaskedScatter(
+        args[3], addrs, masked_detail::get_element_align(ir, elem_type), args[2]);
+}
+
 CUJ_NAMESPACE_END(cuj::gen::detail)
@@ -0,0 +1,276 @@
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4141)
+#pragma warning(disable: 4244)
+#pragma warning(disable: 4624)
+#pragma warning(disable: 4626)
+#pragma warning(disable: 4996)
+#endif
+
+#include <algorithm>
+#include <mutex>
+#include <set>
+#include <tuple>
+
+#include <llvm/IR/Instructions.h>
+#include <llvm/Support/DynamicLibrary.h>
+#include <llvm/Transforms/Utils/ModuleUtils.h>
+
+#include "native_math.h"
+#include "vector_math.h"
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+namespace
+{
+
+    struct BuiltinVectorFunction
+    {
+        core::Intrinsic intrinsic_type;
+        std::string     scalar_name; // llvm intrinsic
+        std::string     vector_name;
+        unsigned        width;
+    };
+
+    // f32 functions have 4, 8 and 16 lanes, and f64 functions have 2, 4 and 8
+    // lanes, covering sse to avx-512 registers
+    const std::vector<BuiltinVectorFunction> &get_builtin_vector_functions()
+    {
+        static const std::vector<BuiltinVectorFunction> ret = []
+        {
+            struct Func
+            {
+                const char     *name;
+                core::Intrinsic f32;
+                core::Intrinsic f64;
+            };
+
+            const Func funcs[] = {
+                { "sin",   core::Intrinsic::f32_sin,   core::Intrinsic::f64_sin   },
+                { "cos",   core::Intrinsic::f32_cos,   core::Intrinsic::f64_cos   },
+                { "exp",   core::Intrinsic::f32_exp,   core::Intrinsic::f64_exp   },
+                { "exp2",  core::Intrinsic::f32_exp2,  core::Intrinsic::f64_exp2  },
+                { "log",   core::Intrinsic::f32_log,   core::Intrinsic::f64_log   },
+                { "log2",  core::Intrinsic::f32_log2,  core::Intrinsic::f64_log2  },
+                { "log10", core::Intrinsic::f32_log10, core::Intrinsic::f64_log10 },
+                { "pow",   core::Intrinsic::f32_pow,   core::Intrinsic::f64_pow   },
+            };
+
+            std::vector<BuiltinVectorFunction> result;
+            for(auto &func : funcs)
+            {
+                for(unsigned width : { 4u, 8u, 16u })
+                {
+                    for(auto [type, intrinsic_type, type_width] : {
+                        std::tuple{ "f32", func.f32, width },
+                        std::tuple{ "f64", func.f64, width / 2 } })
+                    {
+                        const std::string name = func.name;
+                        result.push_back({
+                            intrinsic_type,
+                            "llvm." + name + "." + type,
+                            "__cuj_vmath_" + std::string(type) + "_" + name +
+                                "_v" + std::to_string(type_width),
+                            type_width
+                        });
+                    }
+                }
+            }
+            return result;
+        }();
+        return ret;
+    }
+
+    bool is_libmvec_supported(const llvm::Triple &triple)
+    {
+        return triple.getArch() == llvm::Triple::x86_64 && triple.isOSLinux();
+    }
+
+    bool is_called(const llvm::Function &func)
+    {
+        return std::any_of(func.user_begin(), func.user_end(), [](auto user)
+        {
+            return llvm::isa<llvm::CallInst>(user);
+        });
+    }
+
+    // vectorizers declare variants of all widths and keep them in
+    // llvm.compiler.used, as does define_vector_math_functions.
+    // unpinned functions can be removed once inlined
+    void remove_from_compiler_used(
+        llvm::Module &llvm_module, const std::set<llvm::Function *> &funcs)
+    {
+        if(funcs.empty())
+            return;
+
+        auto used = llvm_module.getGlobalVariable("llvm.compiler.used");
+        if(used && used->hasInitializer())
+        {
+            std::vector<llvm::Constant *> elems;
+            auto init = llvm::cast<llvm::ConstantArray>(used->getInitializer());
+            for(auto &op : init->operands())
+            {
+                auto elem = llvm::cast<llvm::Constant>(op.get());
+                auto func = llvm::dyn_cast<llvm::Function>(
+                    elem->stripPointerCasts());
+                if(!func || !funcs.contains(func))
+                    elems.push_back(elem);
+            }
+            used->eraseFromParent();
+
+            std::vector<llvm::GlobalValue *> values;
+            for(auto elem : elems)
+            {
+                values.push_back(llvm::cast<llvm::GlobalValue>(
+                    elem->stripPointerCasts()));
+            }
+            llvm::appendToCompilerUsed(llvm_module, values);
+        }
+
+        for(auto func : funcs)
+            func->removeDeadConstantUsers();
+    }
+
+    void define_builtin_vector_function(
+        llvm::Function              *llvm_func,
+        const BuiltinVectorFunction &func,
+        const llvm::TargetMachine   &machine)
+    {
+        define_vector_math_function(llvm_func, func.intrinsic_type);
+        llvm_func->addFnAttr("target-cpu", machine.getTargetCPU());
+        if(!machine.getTargetFeatureString().empty())
+        {
+            llvm_func->addFnAttr(
+                "target-features", machine.getTargetFeatureString());
+        }
+    }
+
+} // namespace anonymous
+
+Box<llvm::TargetLibraryInfoImpl> create_vector_math_library_info(
+    const llvm::Triple &triple, VectorMathLibrary library)
+{
+    if(library == VectorMathLibrary::None)
+        return {};
+
+    auto ret = newBox<llvm::TargetLibraryInfoImpl>(triple);
+    if(library == VectorMathLibrary::LibMVec)
+    {
+        if(!is_libmvec_supported(triple))
+        {
+            throw CujException(
+                "libmvec is not available on target " + triple.str());
+        }
+        ret->addVectorizableFunctionsFromVecLib(
+            llvm::TargetLibraryInfoImpl::LIBMVEC_X86);
+        return ret;
+    }
+
+    // descriptions refer to names in get_builtin_vector_functions()
+    std::vector<llvm::VecDesc> descs;
+    for(auto &func : get_builtin_vector_functions())
+    {
+        descs.push_back({
+            func.scalar_name, func.vector_name,
+            llvm::ElementCount::getFixed(func.width)
+        });
+    }
+    ret->addVectorizableFunctions(descs);
+    return ret;
+}
+
+void define_vector_math_functions(
+    llvm::Module              &llvm_module,
+    const llvm::TargetMachine &machine,
+    VectorMathLibrary          library)
+{
+    if(library != VectorMathLibrary::Builtin)
+        return;
+
+    // only variants of math intrinsics used by the module can be called
+    // by vectorizers. they are internal, because every jit partition and
+    // aot object defines its own copies
+
+    std::vector<llvm::GlobalValue *> defined_funcs;
+    for(auto &func : get_builtin_vector_functions())
+    {
+        auto scalar_func = llvm_module.getFunction(func.scalar_name);
+        if(!scalar_func || llvm_module.getFunction(func.vector_name))
+            continue;
+
+        auto scalar_type = scalar_func->getFunctionType();
+        std::vector<llvm::Type *> arg_types;
+        for(auto arg_type : scalar_type->params())
+            arg_types.push_back(llvm::FixedVectorType::get(arg_type, func.width));
+        auto llvm_func = llvm::Function::Create(
+            llvm::FunctionType::get(
+                llvm::FixedVectorType::get(
+                    scalar_type->getReturnType(), func.width),
+                arg_types, false),
+            llvm::GlobalValue::InternalLinkage, func.vector_name, llvm_module);
+
+        define_builtin_vector_function(llvm_func, func, machine);
+        defined_funcs.push_back(llvm_func);
+    }
+
+    // kept until vectorizers add calls to them
+    if(!defined_funcs.empty())
+        llvm::appendToCompilerUsed(llvm_module, defined_funcs);
+}
+
+bool finalize_vector_math_functions(
+    llvm::Module              &llvm_module,
+    const llvm::TargetMachine &machine,
+    VectorMathLibrary          library)
+{
+    if(library != VectorMathLibrary::Builtin)
+        return false;
+
+    bool is_any_called = false;
+    std::set<llvm::Function *> funcs;
+    for(auto &func : get_builtin_vector_functions())
+    {
+        auto llvm_func = llvm_module.getFunction(func.vector_name);
+        if(!llvm_func)
+            continue;
+        funcs.insert(llvm_func);
+
+        // intrinsics may be introduced by optimization
+        if(is_called(*llvm_func))
+        {
+            if(llvm_func->isDeclaration())
+                define_builtin_vector_function(llvm_func, func, machine);
+            is_any_called = true;
+        }
+    }
+
+    remove_from_compiler_used(llvm_module, funcs);
+    for(auto func : funcs)
+    {
+        if(func->use_empty())
+            func->eraseFromParent();
+    }
+    return is_any_called;
+}
+
+void load_vector_math_library(VectorMathLibrary library)
+{
+    if(library != VectorMathLibrary::LibMVec)
+        return;
+
+    static std::once_flag load_flag;
+    static std::string load_err;
+    std::call_once(load_flag, []
+    {
+        llvm::sys::DynamicLibrary::LoadLibraryPermanently(
+            "libmvec.so.1", &load_err);
+    });
+    if(!load_err.empty())
+        throw CujException("failed to load libmvec: " + load_err);
+}
+
+CUJ_NAMESPACE_END(cuj::gen)
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
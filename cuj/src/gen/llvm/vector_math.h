@@ -0,0 +1,49 @@
+#pragma once
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4141)
+#pragma warning(disable: 4244)
+#pragma warning(disable: 4624)
+#pragma warning(disable: 4626)
+#pragma warning(disable: 4996)
+#endif
+
+#include <llvm/ADT/Triple.h>
+#include <llvm/Analysis/TargetLibraryInfo.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <cuj/gen/option.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+// library info mapping llvm math intrinsics to their vector variants.
+// returns nullptr for VectorMathLibrary::None
+Box<llvm::TargetLibraryInfoImpl> create_vector_math_library_info(
+    const llvm::Triple &triple, VectorMathLibrary library);
+
+// defines builtin vector functions that vectorizers may call, before the
+// module is optimized. they use cpu and features of given target machine
+void define_vector_math_functions(
+    llvm::Module              &llvm_module,
+    const llvm::TargetMachine &machine,
+    VectorMathLibrary          library);
+
+// called after optimization. removes builtin vector functions not called by
+// vectorized code, and defines called ones that are still declarations.
+// returns whether any of them is called
+bool finalize_vector_math_functions(
+    llvm::Module              &llvm_module,
+    const llvm::TargetMachine &machine,
+    VectorMathLibrary          library);
+
+// loads external vector library into current process,
+// so that jit can resolve its symbols. thread-safe
+void load_vector_math_library(VectorMathLibrary library);
+
+CUJ_NAMESPACE_END(cuj::gen)
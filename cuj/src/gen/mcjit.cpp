@@ -7,204 +7,589 @@
 #pragma warning(disable: 4996)
 #endif
 
-#include <cmath>
-
-#include <llvm/Analysis/TargetTransformInfo.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Config/llvm-config.h>
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
+#include <llvm/ExecutionEngine/JITEventListener.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/LegacyPassManager.h>
+#include <llvm/MC/SubtargetFeature.h>
+#include <llvm/Object/ObjectFile.h>
+#include <llvm/Object/SymbolSize.h>
+#include <llvm/Support/Format.h>
 #include <llvm/Support/Host.h>
-#include <llvm/Support/TargetRegistry.h>
-#include <llvm/Support/TargetSelect.h>
-#include <llvm/Target/TargetMachine.h>
-#include <llvm/Target/TargetOptions.h>
-#include <llvm/Transforms/IPO/PassManagerBuilder.h>
-#include <llvm/Transforms/IPO.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
 
+#include <cuj/core/hash.h>
 #include <cuj/gen/llvm.h>
 #include <cuj/gen/mcjit.h>
 
-#include "llvm/helper.h"
+#include "llvm/compile_stats.h"
+#include "llvm/native_module.h"
+#include "llvm/vector_math.h"
 
 CUJ_NAMESPACE_BEGIN(cuj::gen)
 
 namespace
 {
 
-    void assert_fail(
-        const char *message,
-        const char *file,
-        int32_t     line,
-        const char *function)
+    // cached objects are looked up before llvm ir is generated, so this
+    // only stores the object compiled by llvm::ExecutionEngine
+    class ObjectCacheAdapter : public llvm::ObjectCache
     {
-        std::cerr << "assertion failed. "
-                  << "file: " << file << ", "
-                  << "line: " << line << ", "
-                  << "func: " << function << ", "
-                  << "message: " << message;
-        std::abort();
-    }
+    public:
+
+        ObjectCacheAdapter(RC<gen::ObjectCache> cache, std::string key)
+            : cache_(std::move(cache)), key_(std::move(key))
+        {
+            
+        }
 
-    struct LLVMModuleData
+        void notifyObjectCompiled(
+            const llvm::Module *, llvm::MemoryBufferRef obj) override
+        {
+            cache_->store(key_, obj.getBufferStart(), obj.getBufferSize());
+        }
+
+        std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *) override
+        {
+            return nullptr;
+        }
+
+    private:
+
+        RC<gen::ObjectCache> cache_;
+        std::string          key_;
+    };
+
+    class CodeSizeListener : public llvm::JITEventListener
     {
-        Box<llvm::LLVMContext>  llvm_context;
-        Box<llvm::Module>       llvm_module;
-        llvm::TargetMachine    *machine;
-        llvm::CodeGenOpt::Level codegen_opt;
+    public:
+
+        explicit CodeSizeListener(std::map<std::string, size_t> &code_sizes)
+            : code_sizes_(code_sizes)
+        {
+            
+        }
+
+        void notifyObjectLoaded(
+            ObjectKey,
+            const llvm::object::ObjectFile &obj,
+            const llvm::RuntimeDyld::LoadedObjectInfo &) override
+        {
+            for(auto &[symbol, size] : llvm::object::computeSymbolSizes(obj))
+            {
+                auto type = symbol.getType();
+                if(!type)
+                {
+                    llvm::consumeError(type.takeError());
+                    continue;
+                }
+                if(*type != llvm::object::SymbolRef::ST_Function)
+                    continue;
+
+                auto name = symbol.getName();
+                if(!name)
+                {
+                    llvm::consumeError(name.takeError());
+                    continue;
+                }
+
+                // mach-o symbols have a global prefix '_'
+                auto symbol_name = *name;
+                if(obj.isMachO())
+                    symbol_name.consume_front("_");
+                code_sizes_[symbol_name.str()] += size;
+            }
+        }
+
+    private:
+
+        std::map<std::string, size_t> &code_sizes_;
     };
 
-    llvm::TargetMachine *get_native_target_machine(
-        llvm::CodeGenOpt::Level codegen_opt)
+    std::string to_object_cache_key(const std::string &key_src)
     {
-        auto target_triple = llvm::sys::getDefaultTargetTriple();
+        const auto hash = llvm::SHA1::hash(llvm::ArrayRef<uint8_t>(
+            reinterpret_cast<const uint8_t *>(key_src.data()), key_src.size()));
 
-        std::string err;
-        auto target = llvm::TargetRegistry::lookupTarget(target_triple, err);
-        if(!target)
-            throw CujException(err);
+        std::string ret;
+        for(uint8_t b : hash)
+        {
+            constexpr char HEX[] = "0123456789abcdef";
+            ret.push_back(HEX[b >> 4]);
+            ret.push_back(HEX[b & 0xf]);
+        }
+        return ret;
+    }
+
+    // keys of objects compiled from prog, one for each partition.
+    // variant distinguishes modules transformed after ir generation.
+    // structural hash ignores auto-generated function names, which are
+    // symbols of the objects, so they are added separately
+    std::vector<std::string> get_object_cache_keys(
+        const core::Prog &prog, const Options &opts, const char *variant)
+    {
+        const auto [cpu, cpu_features] = get_native_cpu(opts);
+
+        std::string key_src;
+        llvm::raw_string_ostream ss(key_src);
+        ss << LLVM_VERSION_STRING << "\n"
+           << llvm::sys::getDefaultTargetTriple() << "\n"
+           << cpu << "\n"
+           << cpu_features << "\n"
+           << static_cast<int>(opts.opt_level) << " "
+           << opts.fast_math << " "
+           << opts.approx_math_func << " "
+           << static_cast<int>(opts.native_math_precision) << " "
+           << static_cast<int>(opts.vector_math_library) << " "
+           << opts.cpu_kernel_simd_width << " "
+           << opts.enable_assert << "\n"
+           << variant << "\n"
+           << llvm::format_hex(core::structural_hash(prog), 18) << "\n";
+        for(auto &func : prog.funcs)
+            ss << func->name << "\n";
+        ss.flush();
+
+        if(opts.codegen_threads <= 1)
+            return { to_object_cache_key(key_src) };
+
+        std::vector<std::string> keys;
+        for(int i = 0; i < opts.codegen_threads; ++i)
+        {
+            keys.push_back(to_object_cache_key(
+                key_src + "partition " + std::to_string(i) + "/" +
+                std::to_string(opts.codegen_threads)));
+        }
+        return keys;
+    }
+
+    using ObjectFile = llvm::object::OwningBinary<llvm::object::ObjectFile>;
 
-        return target->createTargetMachine(
-            target_triple, "generic", {},
-            {}, {}, {}, codegen_opt, true);
+    ObjectFile create_object_file(std::unique_ptr<llvm::MemoryBuffer> object)
+    {
+        auto object_file = llvm::object::ObjectFile::createObjectFile(
+            object->getMemBufferRef());
+        if(!object_file)
+            throw CujException(llvm::toString(object_file.takeError()));
+        return ObjectFile(std::move(*object_file), std::move(object));
+    }
+
+    std::unique_ptr<llvm::MemoryBuffer> to_memory_buffer(
+        const std::vector<char> &data)
+    {
+        return llvm::MemoryBuffer::getMemBufferCopy(
+            llvm::StringRef(data.data(), data.size()));
     }
 
-    void do_llvm_optimize(
-        llvm::Module *mod, llvm::TargetMachine *tm, const Options &opts)
+    // cached_object is used when given, and the compiled object is
+    // stored into object_cache otherwise
+    ObjectFile compile_partition(
+        const llvm::SmallVector<char, 0>       &bitcode,
+        const LLVMModuleData                   &llvm_mod,
+        const Options                          &opts,
+        gen::ObjectCache                       *object_cache,
+        const std::string                      &key,
+        const std::optional<std::vector<char>> &cached_object,
+        std::string                            &llvm_ir,
+        CompileStats                           &stats)
     {
-        llvm::PassManagerBuilder pass_mgr_builder;
-        pass_mgr_builder.OptLevel = static_cast<int>(opts.opt_level);
-        pass_mgr_builder.Inliner = llvm::createFunctionInliningPass(
-            pass_mgr_builder.OptLevel, 0, false);
-        pass_mgr_builder.SLPVectorize = true;
-        pass_mgr_builder.LoopVectorize = true;
-        if(opts.opt_level == OptimizationLevel::O2 ||
-           opts.opt_level == OptimizationLevel::O3)
-            pass_mgr_builder.MergeFunctions = true;
+        // llvm context is not thread-safe.
+        // each partition is loaded into its own context
+
+        llvm::LLVMContext context;
+        auto mod = llvm::parseBitcodeFile(llvm::MemoryBufferRef(
+            llvm::StringRef(bitcode.data(), bitcode.size()), "partition"),
+            context);
+        if(!mod)
+            throw CujException(llvm::toString(mod.takeError()));
+
+        std::unique_ptr<llvm::MemoryBuffer> object;
+        if(cached_object)
+        {
+            object = to_memory_buffer(*cached_object);
+            stats.ir_instruction_count_after_opt += count_instructions(**mod);
+        }
         else
-            pass_mgr_builder.MergeFunctions = false;
-        tm->adjustPassManager(pass_mgr_builder);
-
-        llvm::legacy::FunctionPassManager fp_mgr(mod);
-        pass_mgr_builder.populateFunctionPassManager(fp_mgr);
-        fp_mgr.doInitialization();
-        for(auto &f : mod->functions())
-            fp_mgr.run(f);
-        fp_mgr.doFinalization();
-
-        llvm::legacy::PassManager passes;
-        passes.add(
-            createTargetTransformInfoWrapperPass(tm->getTargetIRAnalysis()));
-        pass_mgr_builder.populateModulePassManager(passes);
-        passes.run(*mod);
+        {
+            Box<llvm::TargetMachine> machine(get_native_target_machine(
+                llvm_mod.codegen_opt, llvm_mod.cpu, llvm_mod.cpu_features));
+            do_llvm_optimize(mod->get(), machine.get(), opts, &stats);
+
+            PhaseTimer codegen_timer;
+            llvm::SmallVector<char, 0> object_data;
+            llvm::raw_svector_ostream object_stream(object_data);
+            llvm::legacy::PassManager passes;
+            llvm::MCContext *mc_context;
+            if(machine->addPassesToEmitMC(passes, mc_context, object_stream))
+                throw CujException("target doesn't support object emission");
+            passes.run(**mod);
+            stats.codegen_time += codegen_timer.get_seconds();
+
+            if(object_cache)
+                object_cache->store(key, object_data.data(), object_data.size());
+            object = llvm::MemoryBuffer::getMemBufferCopy(llvm::StringRef(
+                object_data.data(), object_data.size()));
+        }
+
+        llvm::raw_string_ostream ss(llvm_ir);
+        ss << **mod;
+        ss.flush();
+
+        return create_object_file(std::move(object));
     }
 
-    LLVMModuleData build_llvm_module(
-        const dsl::Module &mod, const Options &opts)
+    // keys and cached_objects are empty when there is no object cache
+    std::vector<ObjectFile> compile_partitions(
+        LLVMModuleData                                      &llvm_mod,
+        const Options                                       &opts,
+        gen::ObjectCache                                    *object_cache,
+        const std::vector<std::string>                      &keys,
+        const std::vector<std::optional<std::vector<char>>> &cached_objects,
+        std::string                                         &llvm_ir,
+        CompileStats                                        &stats)
     {
-        std::once_flag init_mcjit;
-        std::call_once(init_mcjit, [] 
+        std::vector<llvm::SmallVector<char, 0>> bitcodes;
+        llvm::SplitModule(
+            *llvm_mod.llvm_module, static_cast<unsigned>(opts.codegen_threads),
+            [&](std::unique_ptr<llvm::Module> partition)
         {
-            llvm::InitializeNativeTarget();
-            llvm::InitializeNativeTargetAsmPrinter();
-            LLVMLinkInMCJIT();
+            llvm::raw_svector_ostream ss(bitcodes.emplace_back());
+            llvm::WriteBitcodeToFile(*partition, ss);
         });
 
-        const llvm::CodeGenOpt::Level codegen_opt =
-            llvm_helper::get_codegen_opt_level(opts.opt_level);
-        auto target_machine = get_native_target_machine(codegen_opt);
-        auto data_layout = target_machine->createDataLayout();
-
-        LLVMIRGenerator llvm_ir_gen;
-        llvm_ir_gen.set_target(LLVMIRGenerator::Target::Native);
-        if(opts.fast_math)
-            llvm_ir_gen.use_fast_math();
-        if(opts.approx_math_func)
-            llvm_ir_gen.use_approx_math_func();
-        if(!opts.enable_assert)
-            llvm_ir_gen.disable_assert();
-        llvm_ir_gen.set_data_layout(&data_layout);
-        llvm_ir_gen.generate(mod);
-
-        do_llvm_optimize(llvm_ir_gen.get_llvm_module(), target_machine, opts);
-
-        LLVMModuleData ret;
-        std::tie(ret.llvm_context, ret.llvm_module) =
-            llvm_ir_gen.get_data_ownership();
-        ret.codegen_opt = codegen_opt;
-        ret.machine = target_machine;
+        // SplitModule gives one module per thread, matching the keys
+        if(object_cache && keys.size() != bitcodes.size())
+            throw CujException("unexpected number of module partitions");
 
-        return ret;
+        struct PartitionResult
+        {
+            std::string        llvm_ir;
+            ObjectFile         object;
+            CompileStats       stats;
+            std::exception_ptr exception;
+        };
+
+        static const std::optional<std::vector<char>> no_cached_object;
+        static const std::string                      no_key;
+
+        std::vector<PartitionResult> results(bitcodes.size());
+        {
+            llvm::ThreadPool thread_pool(llvm::hardware_concurrency(
+                static_cast<unsigned>(opts.codegen_threads)));
+            for(size_t i = 0; i < bitcodes.size(); ++i)
+            {
+                thread_pool.async([&, i]
+                {
+                    auto &result = results[i];
+                    try
+                    {
+                        result.object = compile_partition(
+                            bitcodes[i], llvm_mod, opts, object_cache,
+                            object_cache ? keys[i] : no_key,
+                            object_cache ? cached_objects[i] : no_cached_object,
+                            result.llvm_ir, result.stats);
+                    }
+                    catch(...)
+                    {
+                        result.exception = std::current_exception();
+                    }
+                });
+            }
+            thread_pool.wait();
+        }
+
+        std::vector<ObjectFile> objects;
+        for(auto &result : results)
+        {
+            if(result.exception)
+                std::rethrow_exception(result.exception);
+            llvm_ir += result.llvm_ir;
+            accumulate_stats(stats, result.stats);
+            objects.push_back(std::move(result.object));
+        }
+        return objects;
+    }
+
+    struct CompiledEngine
+    {
+        std::string                llvm_ir;
+        Box<llvm::LLVMContext>     llvm_context;
+        Box<llvm::ObjectCache>     object_cache;
+        Box<llvm::ExecutionEngine> exec_engine;
+    };
+
+    // objects are looked up in the cache by keys of prog, and build_module
+    // is called to generate llvm ir only when some of them are missing.
+    // llvm ir is left empty when all of them are found.
+    // stats is optional
+    CompiledEngine create_engine(
+        const core::Prog                       &prog,
+        const char                             *variant,
+        const std::function<LLVMModuleData()>  &build_module,
+        const Options                          &opts,
+        const RC<gen::ObjectCache>             &object_cache,
+        CompileStats                           *stats,
+        const std::map<std::string, void *>    &extra_symbols = {})
+    {
+        CompiledEngine result;
+        CompileStats local_stats;
+        if(!stats)
+            stats = &local_stats;
+
+        load_vector_math_library(opts.vector_math_library);
+
+        std::vector<std::string>                      keys;
+        std::vector<std::optional<std::vector<char>>> cached_objects;
+        bool is_all_cached = false;
+        if(object_cache)
+        {
+            keys = get_object_cache_keys(prog, opts, variant);
+            for(auto &key : keys)
+                cached_objects.push_back(object_cache->load(key));
+            is_all_cached = std::all_of(
+                cached_objects.begin(), cached_objects.end(),
+                [](auto &obj) { return obj.has_value(); });
+        }
+
+        LLVMModuleData llvm_mod;
+        std::vector<ObjectFile> objects;
+        if(is_all_cached)
+        {
+            llvm_mod = create_empty_llvm_module(opts);
+            for(auto &obj : cached_objects)
+                objects.push_back(create_object_file(to_memory_buffer(*obj)));
+        }
+        else if(opts.codegen_threads > 1)
+        {
+            // partitions are compiled into objects, leaving an empty module
+            // for creating the execution engine
+
+            llvm_mod = build_module();
+            objects = compile_partitions(
+                llvm_mod, opts, object_cache.get(), keys, cached_objects,
+                result.llvm_ir, *stats);
+
+            auto empty_module = newBox<llvm::Module>(
+                "cuj_partitions", *llvm_mod.llvm_context);
+            empty_module->setDataLayout(llvm_mod.llvm_module->getDataLayout());
+            empty_module->setTargetTriple(
+                llvm_mod.llvm_module->getTargetTriple());
+            llvm_mod.llvm_module = std::move(empty_module);
+        }
+        else
+        {
+            llvm_mod = build_module();
+            if(object_cache)
+            {
+                result.object_cache = newBox<ObjectCacheAdapter>(
+                    object_cache, keys.front());
+            }
+
+            do_llvm_optimize(
+                llvm_mod.llvm_module.get(), llvm_mod.machine, opts, stats);
+
+            llvm::raw_string_ostream ss(result.llvm_ir);
+            ss << *llvm_mod.llvm_module;
+            ss.flush();
+        }
+        result.llvm_context = std::move(llvm_mod.llvm_context);
+
+        std::string err;
+        llvm::EngineBuilder engine_builder(std::move(llvm_mod.llvm_module));
+        engine_builder.setErrorStr(&err);
+        engine_builder.setOptLevel(llvm_mod.codegen_opt);
+        engine_builder.setMCPU(llvm_mod.cpu);
+        if(!llvm_mod.cpu_features.empty())
+        {
+            llvm::SubtargetFeatures features(llvm_mod.cpu_features);
+            engine_builder.setMAttrs(features.getFeatures());
+        }
+
+        auto exec_engine = engine_builder.create(llvm_mod.machine);
+        if(!exec_engine)
+            throw CujException(err);
+        result.exec_engine.reset(exec_engine);
+
+        if(result.object_cache)
+            exec_engine->setObjectCache(result.object_cache.get());
+
+        CodeSizeListener code_size_listener(stats->function_code_sizes);
+        exec_engine->RegisterJITEventListener(&code_size_listener);
+        CUJ_SCOPE_EXIT
+        {
+            exec_engine->UnregisterJITEventListener(&code_size_listener);
+        };
+
+        PhaseTimer codegen_timer;
+        for(auto &object : objects)
+            exec_engine->addObjectFile(std::move(object));
+
+        for(auto &[name, func] : get_native_intrinsic_functions())
+            exec_engine->addGlobalMapping(name, reinterpret_cast<uint64_t>(func));
+        for(auto &[name, addr] : extra_symbols)
+            exec_engine->addGlobalMapping(name, reinterpret_cast<uint64_t>(addr));
+
+        exec_engine->finalizeObject();
+        stats->codegen_time += codegen_timer.get_seconds();
+
+        return result;
     }
 
-    void add_native_intrinsic_functions(llvm::ExecutionEngine &ee)
+    constexpr char TIER_TABLE_NAME[] = "__cuj_tier_table";
+    constexpr char TIER_NAMES_NAME[] = "__cuj_tier_names";
+
+    // each defined function is replaced with a stub calling its
+    // implementation through TIER_TABLE_NAME[i]. names of these functions
+    // are stored in TIER_NAMES_NAME in table order, so that they are also
+    // available when the object is loaded from cache
+    void add_tier_stubs(llvm::Module &llvm_module)
     {
-#define ADD_GLOBAL_FUNC(NAME, FUNC) \
-        ee.addGlobalMapping(#NAME, reinterpret_cast<uint64_t>(FUNC))
-
-        auto *f32_exp10    = +[](float x)            { return std::pow(10.0f, x); };
-        auto *f32_rsqrt    = +[](float x)            { return 1 / std::sqrt(x); };
-        auto *f32_isfinite = +[](float x) -> int32_t { return std::isfinite(x); };
-        auto *f32_isinf    = +[](float x) -> int32_t { return std::isinf(x); };
-        auto *f32_isnan    = +[](float x) -> int32_t { return std::isnan(x); };
-        
-        auto *f64_exp10    = +[](double x)            { return std::pow(10.0, x); };
-        auto *f64_rsqrt    = +[](double x)            { return 1 / std::sqrt(x); };
-        auto *f64_isfinite = +[](double x) -> int32_t { return std::isfinite(x); };
-        auto *f64_isinf    = +[](double x) -> int32_t { return std::isinf(x); };
-        auto *f64_isnan    = +[](double x) -> int32_t { return std::isnan(x); };
-
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_mod,      &::fmodf);
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_rem,      &::remainderf);
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_exp10,    f32_exp10);
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_rsqrt,    f32_rsqrt);
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_tan,      &::tanf);
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_asin,     &::asinf);
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_acos,     &::acosf);
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_atan,     &::atanf);
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_atan2,    &::atan2f);
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_isfinite, f32_isfinite);
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_isinf,    f32_isinf);
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f32_isnan,    f32_isnan);
-
-        using DD  = double(*)(double);
-        using DDD = double(*)(double, double);
-
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_mod,      static_cast<DDD>(&::fmod));
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_rem,      static_cast<DDD>(&::remainder));
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_exp10,    f64_exp10);
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_rsqrt,    f64_rsqrt);
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_tan,      static_cast<DD>(&::tan));
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_asin,     static_cast<DD>(&::asin));
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_acos,     static_cast<DD>(&::acos));
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_atan,     static_cast<DD>(&::atan));
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_atan2,    static_cast<DDD>(&::atan2));
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_isfinite, f64_isfinite);
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_isinf,    f64_isinf);
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_f64_isnan,    f64_isnan);
-
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_print,       printf);
-        ADD_GLOBAL_FUNC(__cuj_intrinsic_assert_fail, assert_fail);
-
-#undef ADD_GLOBAL_FUNC
+        std::vector<llvm::Function *> funcs;
+        for(auto &f : llvm_module.functions())
+        {
+            if(!f.isDeclaration() && !f.hasLocalLinkage())
+                funcs.push_back(&f);
+        }
+
+        auto &context = llvm_module.getContext();
+        auto i8_ptr_type = llvm::Type::getInt8PtrTy(context);
+        auto table_type = llvm::ArrayType::get(i8_ptr_type, funcs.size());
+        auto table = new llvm::GlobalVariable(
+            llvm_module, table_type, false,
+            llvm::GlobalValue::ExternalLinkage, nullptr, TIER_TABLE_NAME);
+        const auto ptr_align =
+            llvm_module.getDataLayout().getPointerABIAlignment(0);
+
+        std::vector<std::string> names;
+        for(size_t i = 0; i < funcs.size(); ++i)
+        {
+            auto impl = funcs[i];
+            auto func_type = impl->getFunctionType();
+            names.push_back(impl->getName().str());
+
+            impl->setName(names.back() + ".tier_impl");
+            impl->setLinkage(llvm::GlobalValue::InternalLinkage);
+
+            auto stub = llvm::Function::Create(
+                func_type, llvm::GlobalValue::ExternalLinkage,
+                names.back(), &llvm_module);
+            stub->copyAttributesFrom(impl);
+            impl->replaceAllUsesWith(stub);
+
+            llvm::IRBuilder<> builder(
+                llvm::BasicBlock::Create(context, "entry", stub));
+            auto slot = builder.CreateConstInBoundsGEP2_32(
+                table_type, table, 0, static_cast<unsigned>(i));
+            auto impl_ptr = builder.CreateAlignedLoad(
+                i8_ptr_type, slot, ptr_align);
+            impl_ptr->setAtomic(llvm::AtomicOrdering::Acquire);
+
+            std::vector<llvm::Value *> args;
+            for(auto &arg : stub->args())
+                args.push_back(&arg);
+            auto call = builder.CreateCall(
+                func_type,
+                builder.CreateBitCast(impl_ptr, func_type->getPointerTo()),
+                args);
+            call->setAttributes(stub->getAttributes());
+            call->setTailCallKind(llvm::CallInst::TCK_MustTail);
+
+            if(func_type->getReturnType()->isVoidTy())
+                builder.CreateRetVoid();
+            else
+                builder.CreateRet(call);
+        }
+
+        // created after replaceAllUsesWith to keep referring to impls
+        std::vector<llvm::Constant *> table_init;
+        for(auto impl : funcs)
+        {
+            table_init.push_back(
+                llvm::ConstantExpr::getBitCast(impl, i8_ptr_type));
+        }
+        table->setInitializer(llvm::ConstantArray::get(table_type, table_init));
+
+        // null-terminated names, ended by an empty one
+        std::string names_data;
+        for(auto &name : names)
+            names_data += name + '\0';
+        auto names_init = llvm::ConstantDataArray::getString(context, names_data);
+        new llvm::GlobalVariable(
+            llvm_module, names_init->getType(), true,
+            llvm::GlobalValue::ExternalLinkage, names_init, TIER_NAMES_NAME);
+    }
+
+    std::vector<std::string> get_tier_function_names(
+        llvm::ExecutionEngine &engine)
+    {
+        auto names_data = reinterpret_cast<const char *>(
+            engine.getGlobalValueAddress(TIER_NAMES_NAME));
+        if(!names_data)
+            throw CujException("tier stubs are not found");
+
+        std::vector<std::string> names;
+        while(*names_data)
+        {
+            names.emplace_back(names_data);
+            names_data += names.back().size() + 1;
+        }
+        return names;
+    }
+
+    // global variables of optimized code are defined in stub module
+    void extract_global_variables(llvm::Module &llvm_module)
+    {
+        for(auto &var : llvm_module.globals())
+        {
+            if(var.isDeclaration() || var.hasLocalLinkage())
+                continue;
+            var.setInitializer(nullptr);
+            var.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        }
     }
 
 } // namespace anonymous
 
 struct MCJIT::MCJITData
 {
-    std::string                llvm_ir;
-    Box<llvm::LLVMContext>     llvm_context;
-    Box<llvm::ExecutionEngine> exec_engine;
+    CompiledEngine engine;
+
+    // tiered compilation
+
+    CompiledEngine     optimized_engine;
+    std::atomic<bool>  is_optimized = false;
+    std::atomic<bool>  is_finished  = false; // optimized or failed
+    std::exception_ptr optimization_error;
+    std::thread        optimizer;
+
+    ~MCJITData()
+    {
+        if(optimizer.joinable())
+            optimizer.join();
+    }
 };
 
 MCJIT::MCJIT(MCJIT &&other) noexcept
 {
     std::swap(opts_, other.opts_);
+    std::swap(object_cache_, other.object_cache_);
     std::swap(llvm_data_, other.llvm_data_);
 }
 
 MCJIT &MCJIT::operator=(MCJIT &&other) noexcept
 {
     std::swap(opts_, other.opts_);
+    std::swap(object_cache_, other.object_cache_);
     std::swap(llvm_data_, other.llvm_data_);
     return *this;
 }
@@ -219,48 +604,145 @@ void MCJIT::set_options(const Options &opts)
     opts_ = opts;
 }
 
-void MCJIT::generate(const dsl::Module &mod)
+void MCJIT::set_object_cache(RC<ObjectCache> cache)
+{
+    object_cache_ = std::move(cache);
+}
+
+CompileStats MCJIT::generate(const dsl::Module &mod)
 {
     delete llvm_data_;
     llvm_data_ = new MCJITData;
-    
-    auto llvm_mod = build_llvm_module(mod, opts_);
-    llvm_data_->llvm_context = std::move(llvm_mod.llvm_context);
 
-    llvm::raw_string_ostream ss(llvm_data_->llvm_ir);
-    ss << *llvm_mod.llvm_module;
-    ss.flush();
+    PhaseTimer total_timer;
+    CompileStats stats;
+    stats.trace_time = mod.get_trace_time();
 
-    std::string err;
-    llvm::EngineBuilder engine_builder(std::move(llvm_mod.llvm_module));
-    engine_builder.setErrorStr(&err);
-    engine_builder.setOptLevel(llvm_mod.codegen_opt);
+    // the program is also used as the key of cached objects
+    PhaseTimer prog_timer;
+    auto prog = mod._generate_prog();
+    stats.generate_prog_time += prog_timer.get_seconds();
 
-    auto exec_engine = engine_builder.create(llvm_mod.machine);
-    if(!exec_engine)
-        throw CujException(err);
-    llvm_data_->exec_engine.reset(exec_engine);
+    if(!opts_.tiered_compilation)
+    {
+        llvm_data_->engine = create_engine(
+            prog, "", [&]
+        {
+            return build_llvm_module(prog, opts_, &stats);
+        },
+            opts_, object_cache_, &stats);
+        llvm_data_->is_optimized = true;
+        llvm_data_->is_finished  = true;
+
+        stats.total_time  = total_timer.get_seconds();
+        stats.peak_memory = get_peak_memory();
+        return stats;
+    }
 
-    add_native_intrinsic_functions(*llvm_data_->exec_engine);
+    // unoptimized code is called through stubs
+    // until optimized code is ready
 
-    llvm_data_->exec_engine->finalizeObject();
+    auto fast_opts = opts_;
+    fast_opts.opt_level = OptimizationLevel::O0;
+    llvm_data_->engine = create_engine(
+        prog, "tier stubs", [&]
+    {
+        auto llvm_mod = build_llvm_module(prog, fast_opts, &stats);
+        add_tier_stubs(*llvm_mod.llvm_module);
+        return llvm_mod;
+    },
+        fast_opts, object_cache_, &stats);
+    auto &fast_engine = *llvm_data_->engine.exec_engine;
+
+    auto func_names = get_tier_function_names(fast_engine);
+    auto table = reinterpret_cast<void **>(
+        fast_engine.getGlobalValueAddress(TIER_TABLE_NAME));
+    std::map<std::string, void *> var_addresses;
+    for(auto &var : prog.global_vars)
+    {
+        var_addresses[var->symbol_name] = reinterpret_cast<void *>(
+            fast_engine.getGlobalValueAddress(var->symbol_name));
+    }
+
+    // prog keeps traced functions alive after the dsl module is destroyed
+
+    llvm_data_->optimizer = std::thread(
+        [data           = llvm_data_,
+         prog           = std::move(prog),
+         opts           = opts_,
+         object_cache   = object_cache_,
+         func_names     = std::move(func_names),
+         table,
+         var_addresses  = std::move(var_addresses)]() mutable
+    {
+        try
+        {
+            data->optimized_engine = create_engine(
+                prog, "tier impls", [&]
+            {
+                auto llvm_mod = build_llvm_module(prog, opts);
+                extract_global_variables(*llvm_mod.llvm_module);
+                return llvm_mod;
+            },
+                opts, object_cache, nullptr, var_addresses);
+            auto &engine = *data->optimized_engine.exec_engine;
+            for(size_t i = 0; i < func_names.size(); ++i)
+            {
+                auto addr = reinterpret_cast<void *>(
+                    engine.getFunctionAddress(func_names[i]));
+                if(addr)
+                {
+                    std::atomic_ref<void *>(table[i]).store(
+                        addr, std::memory_order_release);
+                }
+            }
+            data->is_optimized = true;
+        }
+        catch(...)
+        {
+            // unoptimized code is kept in use, and the error is
+            // reported by wait_for_optimization
+            data->optimization_error = std::current_exception();
+        }
+        data->is_finished = true;
+        data->is_finished.notify_all();
+    });
+
+    stats.total_time  = total_timer.get_seconds();
+    stats.peak_memory = get_peak_memory();
+    return stats;
+}
+
+bool MCJIT::is_optimized() const
+{
+    return llvm_data_->is_optimized;
+}
+
+void MCJIT::wait_for_optimization() const
+{
+    llvm_data_->is_finished.wait(false);
+    if(llvm_data_->optimization_error)
+        std::rethrow_exception(llvm_data_->optimization_error);
 }
 
 const std::string &MCJIT::get_llvm_string() const
 {
-    return llvm_data_->llvm_ir;
+    if(opts_.tiered_compilation && llvm_data_->is_optimized &&
+       llvm_data_->optimized_engine.exec_engine)
+        return llvm_data_->optimized_engine.llvm_ir;
+    return llvm_data_->engine.llvm_ir;
 }
 
 void *MCJIT::get_function_impl(const std::string &symbol_name) const
 {
     return reinterpret_cast<void *>(
-        llvm_data_->exec_engine->getFunctionAddress(symbol_name));
+        llvm_data_->engine.exec_engine->getFunctionAddress(symbol_name));
 }
 
 void *MCJIT::get_global_variable_impl(const std::string &symbol_name) const
 {
     return reinterpret_cast<void *>(
-        llvm_data_->exec_engine->getGlobalValueAddress(symbol_name));
+        llvm_data_->engine.exec_engine->getGlobalValueAddress(symbol_name));
 }
 
 CUJ_NAMESPACE_END(cuj::gen)
@@ -0,0 +1,67 @@
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#include <cuj/gen/object_cache.h>
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+DirectoryObjectCache::DirectoryObjectCache(std::string directory)
+    : directory_(std::move(directory))
+{
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if(ec)
+    {
+        throw CujException(
+            "failed to create object cache directory: " + directory_);
+    }
+}
+
+std::optional<std::vector<char>> DirectoryObjectCache::load(const std::string &key)
+{
+    const auto filename = std::filesystem::path(directory_) / (key + ".o");
+    std::ifstream fin(filename, std::ios::in | std::ios::binary);
+    if(!fin)
+        return std::nullopt;
+
+    std::vector<char> ret(
+        (std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+    if(fin.bad() || ret.empty())
+        return std::nullopt;
+    return ret;
+}
+
+void DirectoryObjectCache::store(
+    const std::string &key, const char *data, size_t size)
+{
+    // write to a temporary file first so that other processes
+    // never read a partially written object
+
+    const auto dir = std::filesystem::path(directory_);
+    const auto filename = dir / (key + ".o");
+    auto tmp_filename = filename;
+    tmp_filename += ".tmp" + std::to_string(std::random_device{}());
+
+    {
+        std::ofstream fout(
+            tmp_filename, std::ios::out | std::ios::binary | std::ios::trunc);
+        if(!fout)
+            return;
+        fout.write(data, static_cast<std::streamsize>(size));
+        if(!fout)
+        {
+            fout.close();
+            std::error_code ec;
+            std::filesystem::remove(tmp_filename, ec);
+            return;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_filename, filename, ec);
+    if(ec)
+        std::filesystem::remove(tmp_filename, ec);
+}
+
+CUJ_NAMESPACE_END(cuj::gen)
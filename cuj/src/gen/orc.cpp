@@ -0,0 +1,170 @@
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4141)
+#pragma warning(disable: 4244)
+#pragma warning(disable: 4624)
+#pragma warning(disable: 4626)
+#pragma warning(disable: 4996)
+#endif
+
+#include <llvm/ExecutionEngine/Orc/CompileOnDemandLayer.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/MC/SubtargetFeature.h>
+
+#include <cuj/gen/llvm.h>
+#include <cuj/gen/orc.h>
+
+#include "llvm/native_module.h"
+#include "llvm/vector_math.h"
+
+CUJ_NAMESPACE_BEGIN(cuj::gen)
+
+namespace
+{
+
+    void check_llvm_error(llvm::Error err)
+    {
+        if(err)
+            throw CujException(llvm::toString(std::move(err)));
+    }
+
+} // namespace anonymous
+
+struct OrcJIT::OrcJITData
+{
+    std::string                llvm_ir;
+    Box<llvm::TargetMachine>   machine;
+    Box<llvm::orc::LLLazyJIT>  jit;
+};
+
+OrcJIT::OrcJIT(OrcJIT &&other) noexcept
+{
+    std::swap(opts_, other.opts_);
+    std::swap(llvm_data_, other.llvm_data_);
+}
+
+OrcJIT &OrcJIT::operator=(OrcJIT &&other) noexcept
+{
+    std::swap(opts_, other.opts_);
+    std::swap(llvm_data_, other.llvm_data_);
+    return *this;
+}
+
+OrcJIT::~OrcJIT()
+{
+    delete llvm_data_;
+}
+
+void OrcJIT::set_options(const Options &opts)
+{
+    opts_ = opts;
+}
+
+void OrcJIT::generate(const dsl::Module &mod)
+{
+    delete llvm_data_;
+    llvm_data_ = new OrcJITData;
+
+    load_vector_math_library(opts_.vector_math_library);
+
+    auto llvm_mod = build_llvm_module(mod, opts_);
+    llvm_data_->machine.reset(llvm_mod.machine);
+
+    llvm::raw_string_ostream ss(llvm_data_->llvm_ir);
+    ss << *llvm_mod.llvm_module;
+    ss.flush();
+
+    // create jit
+
+    llvm::orc::JITTargetMachineBuilder machine_builder(
+        llvm_data_->machine->getTargetTriple());
+    machine_builder.setCPU(llvm_mod.cpu);
+    machine_builder.setCodeGenOptLevel(llvm_mod.codegen_opt);
+    if(!llvm_mod.cpu_features.empty())
+    {
+        llvm::SubtargetFeatures features(llvm_mod.cpu_features);
+        machine_builder.addFeatures(features.getFeatures());
+    }
+
+    auto jit = llvm::orc::LLLazyJITBuilder()
+        .setJITTargetMachineBuilder(std::move(machine_builder))
+        .create();
+    if(!jit)
+        throw CujException(llvm::toString(jit.takeError()));
+    llvm_data_->jit = std::move(*jit);
+    auto &lazy_jit = *llvm_data_->jit;
+
+    // only the requested function is extracted into a new partition.
+    // optimization is done per partition when it is materialized
+
+    lazy_jit.setPartitionFunction(
+        llvm::orc::CompileOnDemandLayer::compileRequested);
+
+    lazy_jit.getIRTransformLayer().setTransform(
+        [machine = llvm_data_->machine.get(), opts = opts_](
+            llvm::orc::ThreadSafeModule                     tsm,
+            const llvm::orc::MaterializationResponsibility &)
+            -> llvm::Expected<llvm::orc::ThreadSafeModule>
+    {
+        tsm.withModuleDo([&](llvm::Module &m)
+        {
+            do_llvm_optimize(&m, machine, opts);
+        });
+        return tsm;
+    });
+
+    // symbols outside the module
+
+    auto &main_dylib = lazy_jit.getMainJITDylib();
+
+    llvm::orc::SymbolMap intrinsic_symbols;
+    for(auto &[name, func] : get_native_intrinsic_functions())
+    {
+        intrinsic_symbols[lazy_jit.mangleAndIntern(name)] =
+            llvm::JITEvaluatedSymbol(
+                llvm::pointerToJITTargetAddress(func),
+                llvm::JITSymbolFlags::Exported);
+    }
+    check_llvm_error(main_dylib.define(
+        llvm::orc::absoluteSymbols(std::move(intrinsic_symbols))));
+
+    auto process_symbols =
+        llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+            lazy_jit.getDataLayout().getGlobalPrefix());
+    if(!process_symbols)
+        throw CujException(llvm::toString(process_symbols.takeError()));
+    main_dylib.addGenerator(std::move(*process_symbols));
+
+    // add module
+
+    check_llvm_error(lazy_jit.addLazyIRModule(llvm::orc::ThreadSafeModule(
+        std::move(llvm_mod.llvm_module), std::move(llvm_mod.llvm_context))));
+}
+
+const std::string &OrcJIT::get_llvm_string() const
+{
+    return llvm_data_->llvm_ir;
+}
+
+void *OrcJIT::get_function_impl(const std::string &symbol_name) const
+{
+    auto sym = llvm_data_->jit->lookup(symbol_name);
+    if(!sym)
+    {
+        llvm::consumeError(sym.takeError());
+        return nullptr;
+    }
+    return llvm::jitTargetAddressToPointer<void *>(sym->getAddress());
+}
+
+void *OrcJIT::get_global_variable_impl(const std::string &symbol_name) const
+{
+    return get_function_impl(symbol_name);
+}
+
+CUJ_NAMESPACE_END(cuj::gen)
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
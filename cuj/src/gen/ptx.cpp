@@ -23,6 +23,8 @@
 #include <cuj/gen/llvm.h>
 #include <cuj/gen/ptx.h>
 
+#include "llvm/compile_stats.h"
+
 CUJ_NAMESPACE_BEGIN(cuj::gen)
 
 namespace
@@ -36,7 +38,7 @@ namespace
     };
 
     IntermediateModule construct_intermediate_module(
-        const dsl::Module &mod, const Options opts)
+        const dsl::Module &mod, const Options opts, CompileStats &stats)
     {
         static std::once_flag init_nvptx_target_flag;
         std::call_once(init_nvptx_target_flag, [] 
@@ -83,12 +85,22 @@ namespace
             ir_gen.disable_assert();
         ir_gen.set_target(LLVMIRGenerator::Target::PTX);
         ir_gen.set_data_layout(&data_layout);
-        ir_gen.generate(mod);
+
+        PhaseTimer prog_timer;
+        auto prog = mod._generate_prog();
+        stats.generate_prog_time += prog_timer.get_seconds();
+
+        PhaseTimer ir_timer;
+        ir_gen.generate(std::move(prog));
+        stats.ir_generation_time += ir_timer.get_seconds();
 
         auto llvm_module = ir_gen.get_llvm_module();
         llvm_module->setTargetTriple(target_triple);
         llvm_module->setDataLayout(data_layout);
 
+        stats.ir_instruction_count_before_opt += count_instructions(*llvm_module);
+        stats.local_alloca_count += count_allocas(*llvm_module);
+
         llvm::PassManagerBuilder pass_mgr_builder;
         switch(opts.opt_level)
         {
@@ -106,6 +118,7 @@ namespace
         machine->adjustPassManager(pass_mgr_builder);
 
         {
+            PhaseTimer timer;
             llvm::legacy::FunctionPassManager fp_mgr(llvm_module);
             fp_mgr.add(createTargetTransformInfoWrapperPass(
                 machine->getTargetIRAnalysis()));
@@ -114,16 +127,21 @@ namespace
             for(auto &f : llvm_module->functions())
                 fp_mgr.run(f);
             fp_mgr.doFinalization();
+            stats.function_pass_time += timer.get_seconds();
         }
 
         {
+            PhaseTimer timer;
             llvm::legacy::PassManager passes;
             passes.add(createTargetTransformInfoWrapperPass(
                 machine->getTargetIRAnalysis()));
             pass_mgr_builder.populateModulePassManager(passes);
             passes.run(*llvm_module);
+            stats.module_pass_time += timer.get_seconds();
         }
 
+        stats.ir_instruction_count_after_opt += count_instructions(*llvm_module);
+
         IntermediateModule result;
         std::tie(result.llvm_context, result.llvm_module) =
             ir_gen.get_data_ownership();
@@ -139,15 +157,20 @@ void PTXGenerator::set_options(const Options &opts)
     opts_ = opts;
 }
 
-void PTXGenerator::generate(const dsl::Module &mod)
+CompileStats PTXGenerator::generate(const dsl::Module &mod)
 {
-    auto im = construct_intermediate_module(mod, opts_);
+    PhaseTimer total_timer;
+    CompileStats stats;
+    stats.trace_time = mod.get_trace_time();
+
+    auto im = construct_intermediate_module(mod, opts_, stats);
 
     llvm_ir_ = {};
     llvm::raw_string_ostream ir_stream(llvm_ir_);
     ir_stream << *im.llvm_module;
     ir_stream.flush();
 
+    PhaseTimer codegen_timer;
     llvm::legacy::PassManager passes;
     llvm::SmallString<8> output_buf;
     llvm::raw_svector_ostream output_stream(output_buf);
@@ -159,6 +182,11 @@ void PTXGenerator::generate(const dsl::Module &mod)
 
     ptx_.resize(output_buf.size());
     std::memcpy(ptx_.data(), output_buf.data(), output_buf.size());
+    stats.codegen_time = codegen_timer.get_seconds();
+
+    stats.total_time  = total_timer.get_seconds();
+    stats.peak_memory = get_peak_memory();
+    return stats;
 }
 
 const std::string &PTXGenerator::get_llvm_ir() const
@@ -46,6 +46,21 @@ namespace
         unreachable();
     }
 
+    const char *reduce_op_to_str(core::VectorReduce::Op op)
+    {
+        switch(op)
+        {
+        case core::VectorReduce::Op::Add:        return "add";
+        case core::VectorReduce::Op::Mul:        return "mul";
+        case core::VectorReduce::Op::Min:        return "min";
+        case core::VectorReduce::Op::Max:        return "max";
+        case core::VectorReduce::Op::BitwiseAnd: return "and";
+        case core::VectorReduce::Op::BitwiseOr:  return "or";
+        case core::VectorReduce::Op::BitwiseXOr: return "xor";
+        }
+        unreachable();
+    }
+
     const char *builtin_type_to_str(core::Builtin builtin)
     {
         switch(builtin)
@@ -137,11 +152,25 @@ void Printer::print(TextBuilder &b, const core::Func &func)
     }
 
     auto &args = func.argument_types;
+    for(auto [attrib, name] : {
+        std::pair{ core::Func::Attribute::AlwaysInline, "always_inline" },
+        std::pair{ core::Func::Attribute::NoInline,     "noinline"      },
+        std::pair{ core::Func::Attribute::Cold,         "cold"          },
+        std::pair{ core::Func::Attribute::Hot,          "hot"           },
+        std::pair{ core::Func::Attribute::ReadNone,     "readnone"      },
+        std::pair{ core::Func::Attribute::ReadOnly,     "readonly"      },
+        std::pair{ core::Func::Attribute::NoUnwind,     "nounwind"      } })
+    {
+        if(func.has_attribute(attrib))
+            b.append("[", name, "] ");
+    }
     b.append("function ", func.name, "(");
     for(size_t i = 0; i < func.argument_types.size(); ++i)
     {
         if(i > 0)
             b.append(", ");
+        if(args[i].is_restrict)
+            b.append("restrict ");
         if(args[i].is_reference)
             b.append("ref ");
         print(b, *args[i].type);
@@ -230,6 +259,10 @@ void Printer::print(TextBuilder &b, const core::If &stat)
     b.append("if(");
     print(b, stat.cond);
     b.append(")");
+    if(stat.likelihood == core::If::Likelihood::Likely)
+        b.append(" [likely]");
+    else if(stat.likelihood == core::If::Likelihood::Unlikely)
+        b.append(" [unlikely]");
     b.new_line();
     b.with_indent([&]
     {
@@ -248,6 +281,34 @@ void Printer::print(TextBuilder &b, const core::If &stat)
 void Printer::print(TextBuilder &b, const core::Loop &stat)
 {
     b.append("loop");
+
+    std::vector<std::string> hints;
+    if(stat.hints.unroll_count)
+        hints.push_back("unroll(" + std::to_string(stat.hints.unroll_count) + ")");
+    if(stat.hints.unroll_full)
+        hints.push_back("unroll_full");
+    if(stat.hints.unroll_disable)
+        hints.push_back("unroll_disable");
+    if(stat.hints.vectorize_width)
+        hints.push_back("vectorize_width(" + std::to_string(stat.hints.vectorize_width) + ")");
+    if(stat.hints.interleave_count)
+        hints.push_back("interleave(" + std::to_string(stat.hints.interleave_count) + ")");
+    if(stat.hints.independent)
+        hints.push_back("independent");
+    if(stat.hints.trip_count_multiple)
+        hints.push_back("trip_multiple(" + std::to_string(stat.hints.trip_count_multiple) + ")");
+    if(!hints.empty())
+    {
+        b.append(" [");
+        for(size_t i = 0; i < hints.size(); ++i)
+        {
+            if(i > 0)
+                b.append(", ");
+            b.append(hints[i]);
+        }
+        b.append("]");
+    }
+
     b.new_line();
     b.with_indent([&]
     {
@@ -377,7 +438,7 @@ void Printer::print(TextBuilder &b, const core::NullPtr &null_ptr)
 void Printer::print(TextBuilder &b, const core::ArithmeticCast &cast)
 {
     b.append("cast<");
-    print(b, cast.dst_type->as<core::Builtin>());
+    print(b, *cast.dst_type);
     b.append(">(");
     print(b, *cast.src_val);
     b.append(")");
@@ -454,6 +515,17 @@ void Printer::print(TextBuilder &b, const core::Unary &unary)
     print(b, *unary.val);
 }
 
+void Printer::print(TextBuilder &b, const core::Select &select)
+{
+    b.append("select(");
+    print(b, *select.cond);
+    b.append(", ");
+    print(b, *select.true_val);
+    b.append(", ");
+    print(b, *select.false_val);
+    b.append(")");
+}
+
 void Printer::print(TextBuilder &b, const core::CallFunc &call)
 {
     if(call.contextless_func)
@@ -494,6 +566,61 @@ void Printer::print(TextBuilder &b, const core::GlobalConstAddr &global_const_ad
     b.append("]");
 }
 
+void Printer::print(TextBuilder &b, const core::MakeVector &make)
+{
+    print(b, *make.vector_type);
+    b.append("(");
+    for(size_t i = 0; i < make.elements.size(); ++i)
+    {
+        if(i > 0)
+            b.append(", ");
+        print(b, *make.elements[i]);
+    }
+    b.append(")");
+}
+
+void Printer::print(TextBuilder &b, const core::VectorExtract &extract)
+{
+    print(b, *extract.vector);
+    b.append("[");
+    print(b, *extract.index);
+    b.append("]");
+}
+
+void Printer::print(TextBuilder &b, const core::VectorInsert &insert)
+{
+    b.append("insert(");
+    print(b, *insert.vector);
+    b.append(", ");
+    print(b, *insert.index);
+    b.append(", ");
+    print(b, *insert.element);
+    b.append(")");
+}
+
+void Printer::print(TextBuilder &b, const core::VectorShuffle &shuffle)
+{
+    b.append("shuffle<");
+    for(size_t i = 0; i < shuffle.indices.size(); ++i)
+    {
+        if(i > 0)
+            b.append(", ");
+        b.append(shuffle.indices[i]);
+    }
+    b.append(">(");
+    print(b, *shuffle.lhs);
+    b.append(", ");
+    print(b, *shuffle.rhs);
+    b.append(")");
+}
+
+void Printer::print(TextBuilder &b, const core::VectorReduce &reduce)
+{
+    b.append("reduce_", reduce_op_to_str(reduce.op), "(");
+    print(b, *reduce.vector);
+    b.append(")");
+}
+
 void Printer::print(TextBuilder &b, const core::Type &type)
 {
     type.match([&](auto &t) { print(b, t); });
@@ -530,4 +657,11 @@ void Printer::print(TextBuilder &b, const core::Pointer &p)
     b.append(">");
 }
 
+void Printer::print(TextBuilder &b, const core::Vector &v)
+{
+    b.append("vec<");
+    print(b, *v.element);
+    b.append(", ", v.size, ">");
+}
+
 CUJ_NAMESPACE_END(cuj)
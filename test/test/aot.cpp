@@ -0,0 +1,105 @@
+#include <filesystem>
+
+#include <llvm/Support/DynamicLibrary.h>
+
+#include "test.h"
+
+TEST_CASE("aot")
+{
+    SECTION("object and header")
+    {
+        ScopedModule mod;
+
+        auto scale = allocate_global_memory<f32>("scale");
+        auto add = function("add", [](i32 a, i32 b) { return a + b; });
+        auto scaled = function([&](f32 x) { return x * scale.get_reference(); });
+        auto scaled_tan = function("scaled_tan", [&](f32 x)
+        {
+            return scaled(cstd::tan(x));
+        });
+
+        Options opts;
+        opts.native_cpu = "generic";
+
+        AOTCompiler aot;
+        aot.set_options(opts);
+        aot.generate(mod);
+
+        REQUIRE(!aot.get_object().empty());
+
+        auto &header = aot.get_c_header();
+        REQUIRE(header.find("extern float scale;") != std::string::npos);
+        REQUIRE(header.find("int32_t add(int32_t a0, int32_t a1);") != std::string::npos);
+        REQUIRE(header.find("float scaled_tan(float a0);") != std::string::npos);
+
+        // auto-named functions are internal
+        REQUIRE(header.find("__cuj_auto_function_name") == std::string::npos);
+        REQUIRE(aot.get_llvm_string().find("__cuj_auto_function_name") == std::string::npos);
+
+        // intrinsics are resolved to c library functions
+        REQUIRE(aot.get_llvm_string().find("__cuj_intrinsic") == std::string::npos);
+
+        const auto lib_dir =
+            std::filesystem::temp_directory_path() / "cuj_test_aot";
+        std::filesystem::create_directories(lib_dir);
+        CUJ_SCOPE_EXIT{ std::filesystem::remove_all(lib_dir); };
+
+        const auto lib_path = lib_dir / "cuj_test_aot.a";
+        aot.write_static_library(lib_path.string());
+        REQUIRE(std::filesystem::file_size(lib_path) > aot.get_object().size());
+    }
+
+    SECTION("shared library")
+    {
+        ScopedModule mod;
+
+        auto twice = function([](i32 x) { return x + x; });
+        function("add", [&](i32 a, i32 b) { return twice(a) + b; });
+
+        AOTCompiler aot;
+        aot.generate(mod);
+
+        const auto lib_dir =
+            std::filesystem::temp_directory_path() / "cuj_test_aot_shared";
+        std::filesystem::create_directories(lib_dir);
+        CUJ_SCOPE_EXIT{ std::filesystem::remove_all(lib_dir); };
+
+        const auto lib_path = lib_dir / "cuj_test_aot_shared.so";
+        aot.write_shared_library(lib_path.string());
+
+        std::string err;
+        auto lib = llvm::sys::DynamicLibrary::getPermanentLibrary(
+            lib_path.string().c_str(), &err);
+        INFO(err);
+        REQUIRE(lib.isValid());
+
+        auto add = reinterpret_cast<int32_t(*)(int32_t, int32_t)>(
+            lib.getAddressOfSymbol("add"));
+        REQUIRE(add);
+        if(add)
+            REQUIRE(add(3, 4) == 10);
+    }
+
+    SECTION("aggregate arguments")
+    {
+        ScopedModule mod;
+
+        function("swap", [](arr<i32, 2> a)
+        {
+            arr<i32, 2> ret;
+            ret[0] = a[1];
+            ret[1] = a[0];
+            return ret;
+        });
+
+        AOTCompiler aot;
+        aot.generate(mod);
+
+        // aggregates are passed by pointer to follow the c abi
+        auto &header = aot.get_c_header();
+        REQUIRE(header.find("void swap(cuj_array_0 * ret, const cuj_array_0 * a0);") != std::string::npos);
+
+        auto &ir = aot.get_llvm_string();
+        REQUIRE(ir.find("void @swap([2 x i32]*") != std::string::npos);
+    }
+}
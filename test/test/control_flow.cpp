@@ -92,6 +92,95 @@ TEST_CASE("control flow")
             5, 0 + 1 + 2 + 3 + 4);
     }
 
+    SECTION("loop hints")
+    {
+        mcjit_require(
+            [](i32 n)
+        {
+            i32 ret = 0;
+            $forrange_with_hints(i, 0, n, LoopHints{
+                .unroll_count = 4, .trip_count_multiple = 4 })
+            {
+                ret = ret + i;
+            };
+            return ret;
+        },
+            8, 0 + 1 + 2 + 3 + 4 + 5 + 6 + 7);
+
+        mcjit_require(
+            [](i32 n)
+        {
+            arr<i32, 16> a;
+            $forrange_with_hints(i, 0, 16, LoopHints{
+                .vectorize_width = 4, .interleave_count = 2, .independent = true })
+            {
+                a[i] = i * n;
+            };
+            i32 ret = 0, i = 0;
+            $while_with_hints(i < 16, LoopHints{ .unroll_disable = true })
+            {
+                i = i + 1;
+                $if(i % 2 == 0)
+                {
+                    $continue;
+                };
+                ret = ret + a[i - 1];
+            };
+            return ret;
+        },
+            2, 2 * (0 + 2 + 4 + 6 + 8 + 10 + 12 + 14));
+
+        ScopedModule mod;
+        auto sum = function([](ptr<i32> a)
+        {
+            i32 ret = 0;
+            $forrange_with_hints(i, 0, 16, LoopHints{ .unroll_full = true })
+            {
+                ret = ret + a[i];
+            };
+            return ret;
+        });
+        auto scale = function([](ptr<f32> a, i32 n)
+        {
+            $forrange_with_hints(i, 0, n, LoopHints{
+                .vectorize_width = 4, .independent = true })
+            {
+                a[i] = a[i] * 2.0f;
+            };
+        });
+
+        // O0 keeps the loop metadata in the final ir
+        Options opts;
+        opts.opt_level = OptimizationLevel::O0;
+
+        MCJIT mcjit;
+        mcjit.set_options(opts);
+        mcjit.generate(mod);
+
+        auto &ir = mcjit.get_llvm_string();
+        REQUIRE(ir.find("llvm.loop.unroll.full") != std::string::npos);
+        REQUIRE(ir.find("llvm.loop.vectorize.width") != std::string::npos);
+        REQUIRE(ir.find("llvm.loop.parallel_accesses") != std::string::npos);
+
+        auto sum_func = mcjit.get_function(sum);
+        auto scale_func = mcjit.get_function(scale);
+        REQUIRE(sum_func);
+        REQUIRE(scale_func);
+        if(sum_func && scale_func)
+        {
+            int32_t a[16];
+            float b[7];
+            for(int i = 0; i < 16; ++i)
+                a[i] = i;
+            for(int i = 0; i < 7; ++i)
+                b[i] = static_cast<float>(i);
+            REQUIRE(sum_func(a) == 120);
+            scale_func(b, 7);
+            for(int i = 0; i < 7; ++i)
+                REQUIRE(b[i] == 2.0f * i);
+        }
+    }
+
     SECTION("while")
     {
         mcjit_require(
@@ -159,4 +248,87 @@ TEST_CASE("control flow")
             REQUIRE(f(3) == 301);
         });
     }
+
+    SECTION("branch hints")
+    {
+        auto select = [](i32 i)
+        {
+            var ret = 0;
+            $if_unlikely(i == 1)
+            {
+                ret = 100;
+            }
+            $elif_likely(i == 2)
+            {
+                ret = 200;
+            }
+            $else
+            {
+                ret = 300;
+            };
+            return ret;
+        };
+
+        with_mcjit(select, [](auto f)
+        {
+            REQUIRE(f(1) == 100);
+            REQUIRE(f(2) == 200);
+            REQUIRE(f(3) == 300);
+        });
+
+        {
+            ScopedModule mod;
+            function(select);
+
+            // O0 keeps the branch weights in the final ir
+            Options opts;
+            opts.opt_level = OptimizationLevel::O0;
+
+            MCJIT mcjit;
+            mcjit.set_options(opts);
+            mcjit.generate(mod);
+
+            auto &ir = mcjit.get_llvm_string();
+            REQUIRE(ir.find("!prof") != std::string::npos);
+            REQUIRE(ir.find("branch_weights") != std::string::npos);
+            REQUIRE(ir.find("i32 1, i32 2000") != std::string::npos);
+            REQUIRE(ir.find("i32 2000, i32 1") != std::string::npos);
+        }
+
+        mcjit_require(
+            [](i32 n)
+        {
+            var y = 0;
+            $while_likely(n > 0)
+            {
+                y = y + n;
+                n = n - 1;
+            };
+            return y;
+        }, 4, 10);
+    }
+
+    SECTION("short circuit")
+    {
+        auto test = [](bool is_and)
+        {
+            return [is_and](i32 x)
+            {
+                i32 rhs_count = 0;
+                auto rhs = [&]
+                {
+                    rhs_count = rhs_count + 1;
+                    return x > 1;
+                };
+                boolean result = is_and ? $and(x > 0, rhs()) : $or(x > 0, rhs());
+                return rhs_count * 10 + i32(result);
+            };
+        };
+
+        mcjit_require(test(true), -1, 0);
+        mcjit_require(test(true), 1, 10);
+        mcjit_require(test(true), 2, 11);
+        mcjit_require(test(false), -1, 10);
+        mcjit_require(test(false), 1, 1);
+    }
 }
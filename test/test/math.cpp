@@ -1,5 +1,23 @@
+#include <limits>
+
 #include "test.h"
 
+namespace
+{
+
+    template<typename T>
+    double ulp_distance(T a, T expected)
+    {
+        if(a == expected || (std::isnan(a) && std::isnan(expected)))
+            return 0;
+        const T abs_expected = std::abs(expected);
+        const T ulp = std::nextafter(
+            abs_expected, std::numeric_limits<T>::infinity()) - abs_expected;
+        return std::abs(static_cast<double>(a) - static_cast<double>(expected)) / ulp;
+    }
+
+} // namespace anonymous
+
 TEST_CASE("math")
 {
     SECTION("mcjit.f32")
@@ -93,6 +111,330 @@ TEST_CASE("math")
         mcjit_require([](f64 x) { return i32(cstd::isnan(x)); }, f64_nan, 1);
     }
 
+    SECTION("mcjit.in-ir")
+    {
+        for(auto precision : { MathPrecision::Precise, MathPrecision::Fast })
+        {
+            ScopedModule mod;
+
+            auto apply_f32 = function([](ptr<f32> x, ptr<f32> y, i32 n)
+            {
+                $forrange(i, 0, n)
+                {
+                    y[i * 6 + 0] = cstd::tan(x[i]);
+                    y[i * 6 + 1] = cstd::asin(x[i]);
+                    y[i * 6 + 2] = cstd::acos(x[i]);
+                    y[i * 6 + 3] = cstd::atan(x[i] * 8.0f);
+                    y[i * 6 + 4] = cstd::atan2(x[i], f32(-0.3f));
+                    y[i * 6 + 5] = cstd::exp10(x[i] * 30.0f);
+                };
+            });
+
+            auto apply_f64 = function([](ptr<f64> x, ptr<f64> y, i32 n)
+            {
+                $forrange(i, 0, n)
+                {
+                    y[i * 7 + 0] = cstd::tan(x[i]);
+                    y[i * 7 + 1] = cstd::asin(x[i]);
+                    y[i * 7 + 2] = cstd::acos(x[i]);
+                    y[i * 7 + 3] = cstd::atan(x[i] * 8.0);
+                    y[i * 7 + 4] = cstd::atan2(x[i], f64(-0.3));
+                    y[i * 7 + 5] = cstd::exp10(x[i] * 300.0);
+                    y[i * 7 + 6] = cstd::rsqrt(x[i] + 1.0);
+                };
+            });
+
+            Options opts;
+            opts.native_math_precision = precision;
+
+            MCJIT mcjit;
+            mcjit.set_options(opts);
+            mcjit.generate(mod);
+
+            auto apply_f32_func = mcjit.get_function(apply_f32);
+            auto apply_f64_func = mcjit.get_function(apply_f64);
+            REQUIRE(apply_f32_func);
+            REQUIRE(apply_f64_func);
+            if(!apply_f32_func || !apply_f64_func)
+                continue;
+
+            // documented error bounds: a few ulps for Precise, and relative
+            // error of 1e-5 (f32) and 1e-10 (f64) for Fast
+            constexpr int N = 4000;
+            std::vector<float>  x32(N), y32(N * 6);
+            std::vector<double> x64(N), y64(N * 7);
+            for(int i = 0; i < N; ++i)
+            {
+                x64[i] = -1.0 + (i + 0.5) * 2.0 / N;
+                x32[i] = static_cast<float>(x64[i]);
+            }
+            apply_f32_func(x32.data(), y32.data(), N);
+            apply_f64_func(x64.data(), y64.data(), N);
+
+            const bool is_fast = precision == MathPrecision::Fast;
+            auto error = [&](auto value, auto expected)
+            {
+                if(!is_fast)
+                    return ulp_distance(value, expected);
+                return std::abs(static_cast<double>(value) - expected) /
+                       std::abs(static_cast<double>(expected));
+            };
+
+            const char *names_f32[] = { "tan", "asin", "acos", "atan", "atan2", "exp10" };
+            const char *names_f64[] = { "tan", "asin", "acos", "atan", "atan2", "exp10", "rsqrt" };
+            double max_err_f32[6] = {}, max_err_f64[7] = {};
+            for(int i = 0; i < N; ++i)
+            {
+                const float  a = x32[i];
+                const double b = x64[i];
+                const float expected_f32[] = {
+                    std::tan(a), std::asin(a), std::acos(a), std::atan(a * 8.0f),
+                    std::atan2(a, -0.3f), std::pow(10.0f, a * 30.0f)
+                };
+                const double expected_f64[] = {
+                    std::tan(b), std::asin(b), std::acos(b), std::atan(b * 8.0),
+                    std::atan2(b, -0.3), std::pow(10.0, b * 300.0),
+                    1.0 / std::sqrt(b + 1.0)
+                };
+                for(int j = 0; j < 6; ++j)
+                {
+                    max_err_f32[j] = (std::max)(
+                        max_err_f32[j], error(y32[i * 6 + j], expected_f32[j]));
+                }
+                for(int j = 0; j < 7; ++j)
+                {
+                    max_err_f64[j] = (std::max)(
+                        max_err_f64[j], error(y64[i * 7 + j], expected_f64[j]));
+                }
+            }
+
+            for(int j = 0; j < 6; ++j)
+            {
+                INFO("f32 " << names_f32[j]);
+                REQUIRE(max_err_f32[j] <= (is_fast ? 1e-5 : 4));
+            }
+            for(int j = 0; j < 7; ++j)
+            {
+                INFO("f64 " << names_f64[j]);
+                REQUIRE(max_err_f64[j] <= (is_fast ? 1e-10 : 4));
+            }
+        }
+    }
+
+    SECTION("mcjit.in-ir.tan")
+    {
+        for(auto precision : { MathPrecision::Precise, MathPrecision::Fast })
+        {
+            ScopedModule mod;
+
+            auto tan_f32 = function([](f32 x) { return cstd::tan(x); });
+            auto tan_f64 = function([](f64 x) { return cstd::tan(x); });
+
+            Options opts;
+            opts.native_math_precision = precision;
+
+            MCJIT mcjit;
+            mcjit.set_options(opts);
+            mcjit.generate(mod);
+
+            auto tan_f32_func = mcjit.get_function(tan_f32);
+            auto tan_f64_func = mcjit.get_function(tan_f64);
+            REQUIRE(tan_f32_func);
+            REQUIRE(tan_f64_func);
+            if(!tan_f32_func || !tan_f64_func)
+                continue;
+
+            const bool is_fast = precision == MathPrecision::Fast;
+            const double max_ulp_f32 = is_fast ? 128 : 4;
+            const double max_ulp_f64 = is_fast ? 131072 : 4;
+
+            // arguments near multiples of pi/2, and large ones including
+            // those reduced by payne-hanek method
+            const double args[] = {
+                0.0, 1e-20, -0.3, 0.7, 1.5707963, -1.5707964, 3.1415926,
+                4.712388980384690, 100.5, -12345.678, 1e6 + 0.3, 2.6e8,
+                -3e8, 1e10, 1e30, -1e100, 1e300, 1.7e308
+            };
+            for(double arg : args)
+            {
+                const float a = static_cast<float>(arg);
+                REQUIRE(ulp_distance(tan_f32_func(a), std::tan(a)) <= max_ulp_f32);
+                REQUIRE(ulp_distance(tan_f64_func(arg), std::tan(arg)) <= max_ulp_f64);
+            }
+            REQUIRE(std::isnan(tan_f32_func(std::numeric_limits<float>::infinity())));
+            REQUIRE(std::isnan(tan_f64_func(std::numeric_limits<double>::quiet_NaN())));
+        }
+    }
+
+    SECTION("mcjit.in-ir.vectorize")
+    {
+        ScopedModule mod;
+
+        auto apply = function([](ptr<f32> x, ptr<f32> y, i32 n)
+        {
+            $forrange(i, 0, n)
+            {
+                y[i] = cstd::tan(x[i]) + cstd::asin(x[i]) +
+                       cstd::atan2(x[i], f32(-0.3f)) + cstd::exp10(x[i]);
+            };
+        });
+
+        Options opts;
+        opts.opt_level = OptimizationLevel::O3;
+        opts.native_math_precision = MathPrecision::Precise;
+
+        MCJIT mcjit;
+        mcjit.set_options(opts);
+        mcjit.generate(mod);
+
+        // in-ir functions contain no calls, so the loop can be widened
+        auto &ir = mcjit.get_llvm_string();
+        REQUIRE((ir.find("vector.body") != std::string::npos ||
+                 ir.find("<4 x float>") != std::string::npos));
+
+        auto apply_func = mcjit.get_function(apply);
+        REQUIRE(apply_func);
+        if(apply_func)
+        {
+            constexpr int N = 19;
+            float x[N], y[N];
+            for(int i = 0; i < N; ++i)
+                x[i] = 0.1f * static_cast<float>(i - N / 2);
+            apply_func(x, y, N);
+            for(int i = 0; i < N; ++i)
+            {
+                const float a = x[i];
+                REQUIRE(y[i] == Approx(
+                    std::tan(a) + std::asin(a) + std::atan2(a, -0.3f) +
+                    std::pow(10.0f, a)).margin(1e-5));
+            }
+        }
+    }
+
+    SECTION("mcjit.vector")
+    {
+        ScopedModule mod;
+
+        auto apply_f32 = function([](ptr<f32> x, ptr<f32> y, i32 n)
+        {
+            $forrange(i, 0, n)
+            {
+                y[i * 4 + 0] = cstd::sin(x[i]);
+                y[i * 4 + 1] = cstd::exp(x[i] * 0.1f);
+                y[i * 4 + 2] = cstd::log(cstd::abs(x[i]) + 0.5f);
+                y[i * 4 + 3] = cstd::pow(cstd::abs(x[i]), f32(1.37f));
+            };
+        });
+
+        auto apply_f64 = function([](ptr<f64> x, ptr<f64> y, i32 n)
+        {
+            $forrange(i, 0, n)
+            {
+                y[i * 4 + 0] = cstd::sin(x[i]);
+                y[i * 4 + 1] = cstd::exp(x[i] * 0.1);
+                y[i * 4 + 2] = cstd::log(cstd::abs(x[i]) + 0.5);
+                y[i * 4 + 3] = cstd::pow(cstd::abs(x[i]), f64(1.37));
+            };
+        });
+
+        Options opts;
+        opts.vector_math_library = VectorMathLibrary::Builtin;
+
+        MCJIT mcjit;
+        mcjit.set_options(opts);
+        mcjit.generate(mod);
+
+        // vector functions are inlined into vectorized loops
+        REQUIRE(mcjit.get_llvm_string().find("@__cuj_vmath_") == std::string::npos);
+
+        auto apply_f32_func = mcjit.get_function(apply_f32);
+        auto apply_f64_func = mcjit.get_function(apply_f64);
+        REQUIRE(apply_f32_func);
+        REQUIRE(apply_f64_func);
+        if(apply_f32_func && apply_f64_func)
+        {
+            // 1e9 takes the large argument reduction for sin
+            constexpr int N = 37;
+            float  x32[N], y32[N * 4];
+            double x64[N], y64[N * 4];
+            for(int i = 0; i < N; ++i)
+            {
+                x64[i] = i == N / 2 ? 1e9 : 0.7 * (i - N / 2);
+                x32[i] = static_cast<float>(x64[i]);
+            }
+            apply_f32_func(x32, y32, N);
+            apply_f64_func(x64, y64, N);
+
+            for(int i = 0; i < N; ++i)
+            {
+                const float  a = x32[i];
+                const double b = x64[i];
+                REQUIRE(y32[i * 4 + 0] == Approx(std::sin(a)).margin(1e-6));
+                REQUIRE(y32[i * 4 + 1] == Approx(std::exp(a * 0.1f)));
+                REQUIRE(y32[i * 4 + 2] == Approx(std::log(std::abs(a) + 0.5f)).margin(1e-6));
+                REQUIRE(y32[i * 4 + 3] == Approx(std::pow(std::abs(a), 1.37f)));
+                REQUIRE(y64[i * 4 + 0] == Approx(std::sin(b)).margin(1e-12));
+                REQUIRE(y64[i * 4 + 1] == Approx(std::exp(b * 0.1)));
+                REQUIRE(y64[i * 4 + 2] == Approx(std::log(std::abs(b) + 0.5)).margin(1e-12));
+                REQUIRE(y64[i * 4 + 3] == Approx(std::pow(std::abs(b), 1.37)));
+            }
+        }
+    }
+
+    SECTION("mcjit.select")
+    {
+        mcjit_require(
+            [](i32 a, i32 b)
+        {
+            return cstd::select(a < b, a, b);
+        }, 3, 2, 2);
+
+        mcjit_require(
+            [](f32 x)
+        {
+            vec<float, 4> v(x, -x, 2.0f * x, -2.0f * x);
+            vec<float, 4> zero(0.0f);
+            return cstd::select(v > zero, v, zero).reduce_add();
+        }, 1.5f, 1.5f + 3.0f);
+
+        mcjit_require(
+            [](boolean c)
+        {
+            arr<i32, 2> a, b;
+            a[0] = 1; a[1] = 2;
+            b[0] = 3; b[1] = 4;
+            var r = cstd::select(c, a, b);
+            return r[0] * 10 + r[1];
+        }, false, 34);
+    }
+
+    SECTION("mcjit.bit")
+    {
+        using U1 = i32(*)(u32);
+        using I1 = i32(*)(i32);
+
+        mcjit_require(U1(&cstd::popcount), 0xf0u, 4);
+        mcjit_require(U1(&cstd::clz), 1u, 31);
+        mcjit_require(U1(&cstd::clz), 0u, 32);
+        mcjit_require(I1(&cstd::ctz), 8, 3);
+        mcjit_require(I1(&cstd::ctz), 0, 32);
+
+        mcjit_require([](u32 x) { return cstd::bswap(x); }, 0x12345678u, 0x78563412u);
+        mcjit_require([](u32 x, i32 n) { return cstd::rotl(x, n); }, 0x80000001u, 1, 3u);
+        mcjit_require([](u32 x, i32 n) { return cstd::rotr(x, n); }, 1u, 33, 0x80000000u);
+
+        mcjit_require([](i32 a, i32 b) { return cstd::mul_hi(a, b); }, -2, 3, -1);
+        mcjit_require(
+            [](u64 a, u64 b) { return cstd::mul_hi(a, b); },
+            ~uint64_t(0), ~uint64_t(0), ~uint64_t(0) - 1);
+
+        mcjit_require([](i32 a, i32 b) { return cstd::add_sat(a, b); }, INT32_MAX, 1, INT32_MAX);
+        mcjit_require([](i32 a, i32 b) { return cstd::add_sat(a, b); }, INT32_MIN, -1, INT32_MIN);
+        mcjit_require([](u32 a, u32 b) { return cstd::add_sat(a, b); }, 4000000000u, 400000000u, UINT32_MAX);
+
+        mcjit_require([](f32 a, f32 b, f32 c) { return cstd::fma(a, b, c); }, 2.0f, 3.0f, 1.0f, 7.0f);
+    }
+
 #if CUJ_ENABLE_CUDA
 
     SECTION("cuda.f32")
@@ -1,3 +1,7 @@
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
 #include "test.h"
 
 #define CHECK_C_FUNC_TYPE_DEFAULT(TYPE, FUNC)                                   \
@@ -40,6 +44,29 @@ namespace
     CUJ_CLASS(A, a, b, c);
     CUJ_CLASS(B, arr, ptr);
 
+    class CountingObjectCache : public ObjectCache
+    {
+    public:
+
+        RC<ObjectCache> cache;
+        int             hit_count   = 0;
+        int             miss_count  = 0;
+        int             store_count = 0;
+
+        std::optional<std::vector<char>> load(const std::string &key) override
+        {
+            auto ret = cache->load(key);
+            ++(ret ? hit_count : miss_count);
+            return ret;
+        }
+
+        void store(const std::string &key, const char *data, size_t size) override
+        {
+            ++store_count;
+            cache->store(key, data, size);
+        }
+    };
+
 } // namespace anonymous
 
 TEST_CASE("mcjit")
@@ -81,4 +108,651 @@ TEST_CASE("mcjit")
             REQUIRE(func_addr() == 5);
         }
     }
+
+    SECTION("restrict argument")
+    {
+        ScopedModule mod;
+
+        auto add = function("restrict_add", [](ptr<f32> a, ptr<f32> b, ptr<f32> c, i32 n)
+        {
+            $forrange(i, 0, n)
+            {
+                c[i] = a[i] + b[i];
+            };
+        });
+        add.set_argument_restrict(0);
+        add.set_argument_restrict(1);
+        add.set_argument_restrict(2);
+        REQUIRE_THROWS_AS(add.set_argument_restrict(3), CujException);
+
+        MCJIT mcjit;
+        mcjit.generate(mod);
+
+        // all pointer parameters are noalias, so the vectorized loop needs
+        // no runtime alias checks
+        auto &ir = mcjit.get_llvm_string();
+        const size_t def_pos = ir.find("@restrict_add(");
+        REQUIRE(def_pos != std::string::npos);
+        const std::string signature =
+            ir.substr(def_pos, ir.find('\n', def_pos) - def_pos);
+        int noalias_count = 0;
+        for(size_t pos = signature.find("noalias"); pos != std::string::npos;
+            pos = signature.find("noalias", pos + 1))
+            ++noalias_count;
+        REQUIRE(noalias_count == 3);
+        REQUIRE(ir.find("vector.memcheck") == std::string::npos);
+
+        auto c_add = mcjit.get_function(add);
+        REQUIRE(c_add);
+        if(c_add)
+        {
+            float a[3] = { 1, 2, 3 }, b[3] = { 4, 5, 6 }, c[3] = {};
+            c_add(a, b, c, 3);
+            REQUIRE(c[0] == 5.0f);
+            REQUIRE(c[1] == 7.0f);
+            REQUIRE(c[2] == 9.0f);
+        }
+    }
+
+    SECTION("function attributes")
+    {
+        ScopedModule mod;
+
+        auto square = function("attrib_square", [](i32 x) { return x * x; });
+        square.add_attribute(FunctionAttribute::AlwaysInline);
+        square.add_attribute(FunctionAttribute::ReadNone);
+        square.add_attribute(FunctionAttribute::NoUnwind);
+        REQUIRE_THROWS_AS(
+            square.add_attribute(FunctionAttribute::NoInline), CujException);
+
+        auto fail = function("attrib_fail", [] { });
+        fail.add_attribute(FunctionAttribute::Cold);
+        fail.add_attribute(FunctionAttribute::NoInline);
+
+        auto sum = function("attrib_sum", [&](i32 a, i32 b)
+        {
+            $if(a < 0)
+            {
+                fail();
+            };
+            return square(a) + square(b);
+        });
+
+        MCJIT mcjit;
+        mcjit.generate(mod);
+        auto &ir = mcjit.get_llvm_string();
+        REQUIRE(ir.find("alwaysinline") != std::string::npos);
+        REQUIRE(ir.find("cold") != std::string::npos);
+
+        auto c_sum = mcjit.get_function(sum);
+        REQUIRE(c_sum);
+        if(c_sum)
+            REQUIRE(c_sum(3, 4) == 25);
+    }
+
+    SECTION("native cpu")
+    {
+        ScopedModule mod;
+
+        Function func = [](f32 a, f32 b, f32 c)
+        {
+            return a * b + c;
+        };
+
+        Options opts;
+        opts.native_cpu = "generic";
+
+        MCJIT generic_mcjit;
+        generic_mcjit.set_options(opts);
+        generic_mcjit.generate(mod);
+
+        MCJIT host_mcjit;
+        host_mcjit.generate(mod);
+
+        auto generic_func = generic_mcjit.get_function(func);
+        auto host_func = host_mcjit.get_function(func);
+
+        REQUIRE(generic_func);
+        REQUIRE(host_func);
+        if(generic_func && host_func)
+        {
+            REQUIRE(generic_func(2, 3, 4) == Approx(10));
+            REQUIRE(host_func(2, 3, 4) == Approx(10));
+        }
+    }
+
+    SECTION("object cache")
+    {
+        const auto cache_dir =
+            std::filesystem::temp_directory_path() / "cuj_test_object_cache";
+        std::filesystem::remove_all(cache_dir);
+        CUJ_SCOPE_EXIT{ std::filesystem::remove_all(cache_dir); };
+
+        auto cache = newRC<CountingObjectCache>();
+        cache->cache = newRC<DirectoryObjectCache>(cache_dir.string());
+
+        for(int i = 0; i < 2; ++i)
+        {
+            ScopedModule mod;
+
+            auto add = function("add", [](i32 a, i32 b) { return a + b; });
+
+            MCJIT mcjit;
+            mcjit.set_object_cache(cache);
+            auto stats = mcjit.generate(mod);
+
+            auto add_func = mcjit.get_function(add);
+            REQUIRE(add_func);
+            if(add_func)
+                REQUIRE(add_func(1, 2) == 3);
+
+            // the first compilation misses and stores the object,
+            // and the second one is loaded from the cache
+            REQUIRE(cache->hit_count == i);
+            REQUIRE(cache->miss_count == 1);
+            REQUIRE(cache->store_count == 1);
+
+            // the cache is checked before llvm ir generation
+            REQUIRE(mcjit.get_llvm_string().empty() == (i == 1));
+            REQUIRE((stats.ir_instruction_count_before_opt == 0) == (i == 1));
+        }
+
+        REQUIRE(std::distance(
+            std::filesystem::directory_iterator(cache_dir),
+            std::filesystem::directory_iterator()) == 1);
+
+        // different programs and options have different keys
+        {
+            ScopedModule mod;
+
+            auto add = function("add", [](i32 a, i32 b) { return a + b + 1; });
+
+            MCJIT mcjit;
+            mcjit.set_object_cache(cache);
+            mcjit.generate(mod);
+
+            auto add_func = mcjit.get_function(add);
+            REQUIRE(add_func);
+            if(add_func)
+                REQUIRE(add_func(1, 2) == 4);
+            REQUIRE(cache->miss_count == 2);
+        }
+        {
+            ScopedModule mod;
+
+            auto add = function("add", [](i32 a, i32 b) { return a + b; });
+
+            Options opts;
+            opts.opt_level = OptimizationLevel::O1;
+
+            MCJIT mcjit;
+            mcjit.set_options(opts);
+            mcjit.set_object_cache(cache);
+            mcjit.generate(mod);
+            REQUIRE(cache->miss_count == 3);
+        }
+
+        // partitions and tiered compilation
+        for(int i = 0; i < 2; ++i)
+        {
+            ScopedModule mod;
+
+            auto global_i32 = allocate_global_memory<i32>("global_i32");
+            // auto-generated names are symbols of the objects, so they
+            // are part of the key. named functions don't depend on them
+            auto twice = function("twice", [](i32 x) { return x + x; });
+            auto f = function("f", [&](i32 x)
+            {
+                return twice(x) + global_i32.get_reference();
+            });
+
+            Options opts;
+            opts.codegen_threads    = 2;
+            opts.tiered_compilation = true;
+
+            MCJIT mcjit;
+            mcjit.set_options(opts);
+            mcjit.set_object_cache(cache);
+            mcjit.generate(mod);
+
+            auto global_ptr = mcjit.get_global_variable(global_i32);
+            auto f_func = mcjit.get_function(f);
+            REQUIRE(global_ptr);
+            REQUIRE(f_func);
+            if(!global_ptr || !f_func)
+                continue;
+
+            *global_ptr = 5;
+            REQUIRE(f_func(3) == 11);
+            mcjit.wait_for_optimization();
+            REQUIRE(mcjit.is_optimized());
+            REQUIRE(f_func(3) == 11);
+        }
+
+        // 2 partitions of stub and optimized modules each
+        REQUIRE(cache->miss_count == 3 + 4);
+        REQUIRE(cache->hit_count == 1 + 4);
+    }
+
+    SECTION("parallel codegen")
+    {
+        ScopedModule mod;
+
+        auto global_i32 = allocate_global_memory<i32>();
+        std::vector<Function<i32(i32)>> funcs;
+        for(int i = 0; i < 8; ++i)
+        {
+            funcs.push_back(function([&, i](i32 x)
+            {
+                i32 result = x + i + global_i32.get_reference();
+                if(i > 0)
+                    result = result + funcs[i - 1](x);
+                return result;
+            }));
+        }
+
+        Options opts;
+        opts.codegen_threads = 4;
+
+        MCJIT mcjit;
+        mcjit.set_options(opts);
+        mcjit.generate(mod);
+
+        auto global_ptr = mcjit.get_global_variable(global_i32);
+        auto last_func = mcjit.get_function(funcs.back());
+        REQUIRE(global_ptr);
+        REQUIRE(last_func);
+        if(global_ptr && last_func)
+        {
+            *global_ptr = 1;
+            REQUIRE(last_func(1) == 8 * 2 + 28);
+        }
+    }
+
+    SECTION("parallel codegen with vector math")
+    {
+        ScopedModule mod;
+
+        // every partition defines its own vector sin
+        auto make_func = [](int i)
+        {
+            return function([i](ptr<f32> x, ptr<f32> y, i32 n)
+            {
+                $forrange(j, 0, n)
+                {
+                    y[j] = cstd::sin(x[j]) + f32(static_cast<float>(i));
+                };
+            });
+        };
+        std::vector<decltype(make_func(0))> funcs;
+        for(int i = 0; i < 4; ++i)
+            funcs.push_back(make_func(i));
+
+        Options opts;
+        opts.codegen_threads = 2;
+        opts.vector_math_library = VectorMathLibrary::Builtin;
+
+        MCJIT mcjit;
+        mcjit.set_options(opts);
+        mcjit.generate(mod);
+
+        constexpr int N = 21;
+        float x[N], y[N];
+        for(int j = 0; j < N; ++j)
+            x[j] = 0.3f * static_cast<float>(j - N / 2);
+
+        for(int i = 0; i < 4; ++i)
+        {
+            auto c_func = mcjit.get_function(funcs[i]);
+            REQUIRE(c_func);
+            if(!c_func)
+                continue;
+            c_func(x, y, N);
+            for(int j = 0; j < N; ++j)
+                REQUIRE(y[j] == Approx(std::sin(x[j]) + static_cast<float>(i)).margin(1e-6));
+        }
+    }
+
+    SECTION("tiered compilation")
+    {
+        ScopedModule mod;
+
+        auto global_i32 = allocate_global_memory<i32>();
+        auto square = function([](i32 x) { return x * x; });
+        auto sum_squares = function([&](i32 a, i32 b)
+        {
+            return square(a) + square(b) + global_i32.get_reference();
+        });
+
+        Options opts;
+        opts.tiered_compilation = true;
+
+        MCJIT mcjit;
+        mcjit.set_options(opts);
+        mcjit.generate(mod);
+
+        auto global_ptr = mcjit.get_global_variable(global_i32);
+        auto sum_squares_func = mcjit.get_function(sum_squares);
+        REQUIRE(global_ptr);
+        REQUIRE(sum_squares_func);
+        if(global_ptr && sum_squares_func)
+        {
+            *global_ptr = 1;
+            REQUIRE(sum_squares_func(2, 3) == 14);
+            mcjit.wait_for_optimization();
+            REQUIRE(mcjit.is_optimized());
+            REQUIRE(mcjit.get_function(sum_squares) == sum_squares_func);
+            REQUIRE(sum_squares_func(2, 3) == 14);
+        }
+    }
+
+    SECTION("compile stats")
+    {
+        ScopedModule mod;
+
+        auto sum = function("sum", [](ptr<i32> data, i32 n)
+        {
+            i32 result = 0;
+            $forrange(i, 0, n)
+            {
+                result = result + data[i];
+            };
+            return result;
+        });
+
+        MCJIT mcjit;
+        const CompileStats stats = mcjit.generate(mod);
+
+        REQUIRE(stats.trace_time > 0);
+        REQUIRE(stats.total_time >= stats.codegen_time);
+        REQUIRE(stats.ir_instruction_count_before_opt > 0);
+        REQUIRE(stats.ir_instruction_count_after_opt > 0);
+        REQUIRE(stats.local_alloca_count > 0);
+        REQUIRE(stats.function_code_sizes.contains("sum"));
+        REQUIRE(stats.peak_memory > 0);
+    }
+
+    SECTION("jit service")
+    {
+        JITService service(1);
+
+        auto make_module = [](int n, Function<i32(i32)> &func)
+        {
+            Module mod;
+            Module::set_current_module(&mod);
+            func = function([n](i32 x) { return x + n; });
+            Module::set_current_module(nullptr);
+            return mod;
+        };
+
+        Function<i32(i32)> add1, add2;
+        auto mod1 = make_module(1, add1);
+        auto mod2 = make_module(2, add2);
+
+        std::stop_source cancel;
+        cancel.request_stop();
+
+        auto future1 = service.submit(std::move(mod1));
+        auto future2 = service.submit(
+            std::move(mod2), {}, JITService::Priority::High, cancel.get_token());
+
+        auto compiled1 = future1.get();
+        auto add1_func = compiled1.get_function(add1);
+        REQUIRE(add1_func);
+        if(add1_func)
+            REQUIRE(add1_func(2) == 3);
+
+        REQUIRE_THROWS_AS(future2.get(), CujException);
+    }
+
+    SECTION("cpu kernel")
+    {
+        for(int simd_width : { 0, 1, 8 })
+        {
+            ScopedModule mod;
+
+            auto fill = kernel([](ptr<i32> output, i32 width, i32 height)
+            {
+                var x = cstd::block_idx_x() * cstd::block_dim_x() + cstd::thread_idx_x();
+                var y = cstd::block_idx_y() * cstd::block_dim_y() + cstd::thread_idx_y();
+                $if(x < width & y < height)
+                {
+                    var idx = y * width + x;
+                    $if(x % 3 == 0)
+                    {
+                        output[idx] = output[idx] + idx;
+                    }
+                    $else
+                    {
+                        output[idx] = output[idx] + 2 * idx;
+                    };
+                };
+            });
+
+            Options opts;
+            opts.cpu_kernel_simd_width = simd_width;
+
+            MCJIT mcjit;
+            mcjit.set_options(opts);
+            mcjit.generate(mod);
+
+            // divergent $if runs in spmd form with masked memory accesses
+            if(simd_width == 8)
+            {
+                auto &ir = mcjit.get_llvm_string();
+                REQUIRE(ir.find("<8 x i1>") != std::string::npos);
+            }
+
+            auto fill_func = mcjit.get_kernel(fill);
+            REQUIRE(fill_func);
+            if(!fill_func)
+                continue;
+
+            constexpr int WIDTH = 100, HEIGHT = 37;
+            std::vector<int32_t> output(WIDTH * HEIGHT);
+
+            CPULauncher launcher(4);
+            launcher.launch(
+                fill_func, { (WIDTH + 15) / 16, (HEIGHT + 7) / 8 }, { 16, 8 },
+                output.data(), WIDTH, HEIGHT);
+
+            bool correct = true;
+            for(int i = 0; i < WIDTH * HEIGHT; ++i)
+                correct &= output[i] == (i % WIDTH % 3 == 0 ? i : 2 * i);
+            REQUIRE(correct);
+
+            REQUIRE_THROWS_AS(
+                launcher.launch(
+                    fill_func, { 0, 1 }, { 16, 8 }, output.data(), WIDTH, HEIGHT),
+                CujException);
+        }
+    }
+
+    SECTION("divergent cpu kernel")
+    {
+        // steps to reach 1 and odd values reached
+        auto collatz_counts = [](int i)
+        {
+            int x = i + 1, count = 0, odd = 0;
+            while(x != 1)
+            {
+                x = x % 2 == 0 ? x / 2 : 3 * x + 1;
+                ++count;
+                if(x % 2 == 0)
+                    continue;
+                ++odd;
+            }
+            return std::make_pair(count, odd);
+        };
+
+        auto expected_output = [&](int i)
+        {
+            auto [count, odd] = collatz_counts(i);
+            constexpr int weights[] = { 1, 10, 100, 1000 };
+            int ret = count * weights[i % 4] + odd * 1000000;
+            switch(i % 4)
+            {
+            case 0: ret += 1; [[fallthrough]];
+            case 1: ret += 2; break;
+            case 2: ret += 4; break;
+            default: ret += 8; break;
+            }
+            return ret;
+        };
+
+        constexpr int N = 75, BLOCK_SIZE = 13;
+
+        std::vector<int32_t> scalar_output;
+        for(int simd_width : { 0, 4, 8 })
+        {
+            ScopedModule mod;
+
+            auto collatz_step = function([](i32 x)
+            {
+                i32 ret;
+                $if(x % 2 == 0)
+                {
+                    ret = x / 2;
+                }
+                $else
+                {
+                    ret = 3 * x + 1;
+                };
+                return ret;
+            });
+
+            auto collatz = kernel([&](ptr<i32> output, ptr<i32> counter, i32 n)
+            {
+                var i = cstd::block_idx_x() * cstd::block_dim_x() + cstd::thread_idx_x();
+                $if(i >= n)
+                {
+                    $return();
+                };
+
+                i32 x = i + 1, count = 0, odd = 0;
+                $loop
+                {
+                    $if(x == 1)
+                    {
+                        $break;
+                    };
+                    x = collatz_step(x);
+                    count = count + 1;
+                    $if(x % 2 == 0)
+                    {
+                        $continue;
+                    };
+                    odd = odd + 1;
+                };
+
+                arr<i32, 4> weights;
+                weights[0] = 1;
+                weights[1] = 10;
+                weights[2] = 100;
+                weights[3] = 1000;
+                i32 ret = count * weights[i % 4] + odd * 1000000;
+
+                $switch(i % 4)
+                {
+                    $case(0) { ret = ret + 1; $fallthrough; };
+                    $case(1) { ret = ret + 2; };
+                    $case(2) { ret = ret + 4; };
+                    $default { ret = ret + 8; };
+                };
+
+                $if(odd * 2 > count)
+                {
+                    cstd::atomic_add(counter, 1);
+                };
+                output[i] = ret;
+            });
+
+            Options opts;
+            opts.cpu_kernel_simd_width = simd_width;
+
+            MCJIT mcjit;
+            mcjit.set_options(opts);
+            mcjit.generate(mod);
+
+            if(simd_width == 8)
+            {
+                auto &ir = mcjit.get_llvm_string();
+                REQUIRE(ir.find("<8 x i1>") != std::string::npos);
+            }
+
+            auto collatz_func = mcjit.get_kernel(collatz);
+            REQUIRE(collatz_func);
+            if(!collatz_func)
+                continue;
+
+            std::vector<int32_t> output(N + 1, -1);
+            int32_t counter = 0;
+
+            CPULauncher launcher(4);
+            launcher.launch(
+                collatz_func, { (N + BLOCK_SIZE - 1) / BLOCK_SIZE }, { BLOCK_SIZE },
+                output.data(), &counter, N);
+
+            bool correct = output[N] == -1;
+            int expected_counter = 0;
+            for(int i = 0; i < N; ++i)
+            {
+                correct &= output[i] == expected_output(i);
+                auto [count, odd] = collatz_counts(i);
+                expected_counter += odd * 2 > count ? 1 : 0;
+            }
+            REQUIRE(correct);
+            REQUIRE(counter == expected_counter);
+
+            if(simd_width == 0)
+                scalar_output = output;
+            else
+                REQUIRE(output == scalar_output);
+        }
+    }
+
+    SECTION("specialization cache")
+    {
+        SpecializationCache<int, int32_t(int32_t)> cache(2);
+        std::atomic<int> trace_count = 0;
+
+        auto get_pow = [&](int n)
+        {
+            return cache.get(n, [&]
+            {
+                ++trace_count;
+                return function([n](i32 x)
+                {
+                    i32 result = 1;
+                    for(int i = 0; i < n; ++i)
+                        result = result * x;
+                    return result;
+                });
+            });
+        };
+
+        auto pow2 = get_pow(2);
+        REQUIRE(pow2(3) == 9);
+        REQUIRE(get_pow(2) == pow2);
+        REQUIRE(trace_count == 1);
+
+        REQUIRE(get_pow(3)(2) == 8);
+        REQUIRE(get_pow(4)(2) == 16);
+        REQUIRE(trace_count == 3);
+        REQUIRE(cache.size() == 2);
+        REQUIRE(!cache.find(2));
+        REQUIRE(cache.find(3));
+
+        // concurrent misses on the same key are compiled once
+        std::vector<std::thread> threads;
+        std::vector<int32_t(*)(int32_t)> results(4);
+        for(int i = 0; i < 4; ++i)
+            threads.emplace_back([&, i] { results[i] = get_pow(5); });
+        for(auto &t : threads)
+            t.join();
+        REQUIRE(trace_count == 4);
+        for(auto f : results)
+            REQUIRE(f == results[0]);
+        REQUIRE(results[0](2) == 32);
+    }
 }
@@ -110,4 +110,140 @@ TEST_CASE("misc")
             return bitcast<u64>(c[1].address()) - bitcast<u64>(c[0].address());
         }, 128);
     }
+
+    SECTION("memory hints")
+    {
+        with_mcjit(
+            [](ptr<f32> src, ptr<f32> dst)
+        {
+            var a = cstd::assume_aligned(src, 16);
+            var b = cstd::assume_aligned(dst, 16);
+            cstd::prefetch(a);
+            cstd::prefetch(b, 0, true);
+            for(int i = 0; i < 3; ++i)
+                cstd::store_nontemporal(b + i, a[i] * 2.0f);
+            cstd::store_nontemporal(b + 3, a[3]);
+        },
+            [](auto f)
+        {
+            alignas(16) float src[4] = { 1, 2, 3, 4 };
+            alignas(16) float dst[4] = { 0, 0, 0, 0 };
+            f(src, dst);
+            REQUIRE(dst[0] == 2.0f);
+            REQUIRE(dst[1] == 4.0f);
+            REQUIRE(dst[2] == 6.0f);
+            REQUIRE(dst[3] == 4.0f);
+        });
+    }
+
+    SECTION("atomic")
+    {
+        with_mcjit(
+            [](ptr<i32> a, ptr<u64> b, ptr<f64> c)
+        {
+            var old = cstd::atomic_add(a, 3, cstd::MemoryOrder::Relaxed);
+            cstd::atomic_max(a, 10, cstd::MemoryOrder::AcqRel);
+            cstd::atomic_xor(
+                a, 1, cstd::MemoryOrder::SeqCst, cstd::MemoryScope::Block);
+            cstd::atomic_min(b, u64(2));
+            cstd::atomic_add(c, 0.5, cstd::MemoryOrder::Relaxed);
+            cstd::atomic_fence(cstd::MemoryOrder::Release);
+            cstd::atomic_store(
+                b + 1, cstd::atomic_load(b, cstd::MemoryOrder::Acquire),
+                cstd::MemoryOrder::Release);
+            return old + cstd::atomic_cmpxchg(a, 11, 20);
+        },
+            [](auto f)
+        {
+            int32_t a = 4;
+            uint64_t b[2] = { 5, 0 };
+            double c = 1;
+            REQUIRE(f(&a, b, &c) == 4 + 11);
+            REQUIRE(a == 20);
+            REQUIRE(b[0] == 2);
+            REQUIRE(b[1] == 2);
+            REQUIRE(c == 1.5);
+        });
+    }
+
+    SECTION("structural hash")
+    {
+        ScopedModule mod;
+
+        auto make_func = [](int32_t c)
+        {
+            return function<i32>([c](i32 x)
+            {
+                cxx<S> s;
+                s.a[0] = x;
+                $if(x > 0)
+                {
+                    $return(s.a[0] + c);
+                };
+                $return(s.a[0] * c);
+            });
+        };
+        auto f0 = make_func(1);
+        auto f1 = make_func(1);
+        auto f2 = make_func(2);
+
+        auto &func0 = *f0._get_context()->get_core_func();
+        auto &func1 = *f1._get_context()->get_core_func();
+        auto &func2 = *f2._get_context()->get_core_func();
+
+        REQUIRE(core::structural_hash(func0) == core::structural_hash(func1));
+        REQUIRE(core::structural_equal(func0, func1));
+        REQUIRE(core::structural_hash(func0) != core::structural_hash(func2));
+        REQUIRE(!core::structural_equal(func0, func2));
+
+        auto prog = mod._generate_prog();
+        REQUIRE(core::structural_equal(prog, mod._generate_prog()));
+        REQUIRE(core::structural_hash(prog) ==
+                core::structural_hash(mod._generate_prog()));
+    }
+
+    SECTION("structural hash of recursive types")
+    {
+        // struct X { X *p; }, with a pointer and a struct type per node
+        auto make_struct = [](std::array<core::Type, 2> &types)
+        {
+            types[0] = core::Struct{ { &types[1] } };
+            types[1] = core::Pointer{};
+        };
+        auto link = [](std::array<core::Type, 2> &from, const core::Type &to)
+        {
+            from[1].as<core::Pointer>().pointed = &to;
+        };
+
+        // A { A * }, A2 { A2 * }, B { C * }, C { B * }
+        std::array<core::Type, 2> a, a2, b, c;
+        make_struct(a);
+        make_struct(a2);
+        make_struct(b);
+        make_struct(c);
+        link(a, a[0]);
+        link(a2, a2[0]);
+        link(b, c[0]);
+        link(c, b[0]);
+
+        auto equal = [](const core::Type &x, const core::Type &y)
+        {
+            return core::structural_equal(&x, &y);
+        };
+        auto hash = [](const core::Type &x)
+        {
+            return core::structural_hash(&x);
+        };
+
+        REQUIRE(equal(a[0], a2[0]));
+        REQUIRE(hash(a[0]) == hash(a2[0]));
+
+        REQUIRE(equal(b[0], c[0]));
+        REQUIRE(hash(b[0]) == hash(c[0]));
+
+        // back references of a and b are at different depths
+        REQUIRE(!equal(a[0], b[0]));
+        REQUIRE(!equal(b[0], a[0]));
+        REQUIRE(hash(a[0]) != hash(b[0]));
+    }
 }
@@ -247,3 +247,136 @@ TEST_CASE("operator")
         mcjit_require([](i32 x) { return i32(!(x != 0)); }, 0, 1);
     }
 }
+
+TEST_CASE("vector")
+{
+    SECTION("elementwise")
+    {
+        with_mcjit(
+            [](ptr<f32> a, ptr<f32> b)
+        {
+            vec<float, 4> x(a[0], a[1], a[2], a[3]);
+            vec<float, 4> y(b[0], b[1], b[2], b[3]);
+            var z = x * y + 1.0f * x - y;
+            for(int i = 0; i < 4; ++i)
+                a[i] = z[i];
+        },
+            [](auto f)
+        {
+            float a[4] = { 1, 2, 3, 4 };
+            float b[4] = { 5, 6, 7, 8 };
+            f(a, b);
+            REQUIRE(a[0] == Approx(1 * 5 + 1 - 5));
+            REQUIRE(a[1] == Approx(2 * 6 + 2 - 6));
+            REQUIRE(a[2] == Approx(3 * 7 + 3 - 7));
+            REQUIRE(a[3] == Approx(4 * 8 + 4 - 8));
+        });
+    }
+
+    SECTION("compare")
+    {
+        mcjit_require([](i32 a)
+        {
+            vec<int32_t, 4> x(a, a + 1, a + 2, a + 3);
+            var m = x > vec<int32_t, 4>(2);
+            return i32(m.any()) + 2 * i32(m.all());
+        }, 0, 1);
+        mcjit_require([](i32 a)
+        {
+            vec<int32_t, 4> x(a, a + 1, a + 2, a + 3);
+            var m = x > vec<int32_t, 4>(2);
+            return i32(m.any()) + 2 * i32(m.all());
+        }, 3, 3);
+        mcjit_require([](i32 a)
+        {
+            vec<int32_t, 4> x(a, a + 1, a + 2, a + 3);
+            var m = x > vec<int32_t, 4>(2);
+            return i32(m.any()) + 2 * i32(m.all());
+        }, -5, 0);
+    }
+
+    SECTION("shuffle")
+    {
+        mcjit_require([](i32 a)
+        {
+            vec<int32_t, 4> x(a, a + 1, a + 2, a + 3);
+            var y = x.shuffle<3, 2, 1, 0>();
+            var z = x.shuffle<1, 6>(y);
+            return z[0] * 10 + z[1];
+        }, 1, 2 * 10 + 2);
+    }
+
+    SECTION("reduce")
+    {
+        mcjit_require([](f32 a)
+        {
+            vec<float, 4> x(a, 2.0f * a, 3.0f * a, 4.0f * a);
+            return x.reduce_add();
+        }, 1.5f, 15.0f);
+        mcjit_require([](i32 a)
+        {
+            vec<int32_t, 4> x(a, a - 3, a + 5, a);
+            return x.reduce_min() * 100 + x.reduce_max();
+        }, 4, 1 * 100 + 9);
+        mcjit_require([](u32 a)
+        {
+            vec<uint32_t, 2> x(a, a << 1u);
+            return x.reduce_or();
+        }, 5u, 15u);
+    }
+
+    SECTION("insert")
+    {
+        mcjit_require([](i32 a, i32 i)
+        {
+            var x = vec<int32_t, 4>(0);
+            x.set(i, a);
+            ref y = x;
+            y.set(0, y[0] + 1);
+            return x.reduce_add() * 10 + x[i];
+        }, 7, 2, 8 * 10 + 7);
+    }
+
+    SECTION("masked load/store")
+    {
+        with_mcjit(
+            [](ptr<i32> a, i32 n)
+        {
+            vec<int32_t, 4> lane(0, 1, 2, 3);
+            var mask = lane < vec<int32_t, 4>(n);
+            var x = cstd::masked_load(a, mask, vec<int32_t, 4>(-1));
+            cstd::masked_store(a + 4, mask, x + vec<int32_t, 4>(10));
+        },
+            [](auto f)
+        {
+            int32_t a[8] = { 1, 2, 3, 4, 0, 0, 0, 0 };
+            f(a, 3);
+            REQUIRE(a[4] == 11);
+            REQUIRE(a[5] == 12);
+            REQUIRE(a[6] == 13);
+            REQUIRE(a[7] == 0);
+        });
+    }
+
+    SECTION("gather/scatter")
+    {
+        with_mcjit(
+            [](ptr<f32> a, ptr<f32> b)
+        {
+            vec<int32_t, 4> idx(3, 0, 2, 1);
+            vec<bool, 4> mask(true, true, false, true);
+            var x = cstd::gather(a, idx, mask);
+            cstd::scatter(b, idx, mask, x * 2.0f);
+        },
+            [](auto f)
+        {
+            float a[4] = { 1, 2, 3, 4 };
+            float b[4] = { 0, 0, 0, 0 };
+            f(a, b);
+            REQUIRE(b[0] == 2.0f);
+            REQUIRE(b[1] == 4.0f);
+            REQUIRE(b[2] == 0.0f);
+            REQUIRE(b[3] == 8.0f);
+        });
+    }
+}
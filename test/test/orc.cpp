@@ -0,0 +1,91 @@
+#include "test.h"
+
+TEST_CASE("orc jit")
+{
+    SECTION("lazy function")
+    {
+        ScopedModule mod;
+
+        auto global_i32 = allocate_global_memory<i32>();
+
+        Function add = [](i32 a, i32 b)
+        {
+            return a + b;
+        };
+
+        Function add_global = [&](i32 a)
+        {
+            return add(a, global_i32.get_reference());
+        };
+
+        Function unused = [](f64 x)
+        {
+            return cstd::sin(x) + cstd::atan2(x, x);
+        };
+
+        OrcJIT jit;
+        jit.generate(mod);
+
+        auto global_addr = jit.get_global_variable(global_i32);
+        auto add_global_addr = jit.get_function(add_global);
+
+        REQUIRE(global_addr);
+        REQUIRE(add_global_addr);
+        if(global_addr && add_global_addr)
+        {
+            *global_addr = 5;
+            REQUIRE(add_global_addr(3) == 8);
+        }
+
+        REQUIRE(jit.get_function<int32_t(int32_t)>("no_such_function") == nullptr);
+    }
+
+    SECTION("vector math")
+    {
+        ScopedModule mod;
+
+        // each function is materialized in a separate module defining
+        // its own vector sin
+        auto sin_add = function([](ptr<f32> x, ptr<f32> y, i32 n)
+        {
+            $forrange(i, 0, n)
+            {
+                y[i] = cstd::sin(x[i]) + 1.0f;
+            };
+        });
+
+        auto sin_mul = function([](ptr<f32> x, ptr<f32> y, i32 n)
+        {
+            $forrange(i, 0, n)
+            {
+                y[i] = cstd::sin(x[i]) * 2.0f;
+            };
+        });
+
+        Options opts;
+        opts.vector_math_library = VectorMathLibrary::Builtin;
+
+        OrcJIT jit;
+        jit.set_options(opts);
+        jit.generate(mod);
+
+        auto sin_add_addr = jit.get_function(sin_add);
+        auto sin_mul_addr = jit.get_function(sin_mul);
+        REQUIRE(sin_add_addr);
+        REQUIRE(sin_mul_addr);
+        if(sin_add_addr && sin_mul_addr)
+        {
+            constexpr int N = 21;
+            float x[N], y_add[N], y_mul[N];
+            for(int i = 0; i < N; ++i)
+                x[i] = 0.3f * static_cast<float>(i - N / 2);
+            sin_add_addr(x, y_add, N);
+            sin_mul_addr(x, y_mul, N);
+            for(int i = 0; i < N; ++i)
+            {
+                REQUIRE(y_add[i] == Approx(std::sin(x[i]) + 1.0f).margin(1e-6));
+                REQUIRE(y_mul[i] == Approx(std::sin(x[i]) * 2.0f).margin(1e-6));
+            }
+        }
+    }
+}